@@ -1,6 +1,9 @@
 #ifndef AUDIO_EXPORTER_HPP
 #define AUDIO_EXPORTER_HPP
 
+#include "audio_effects.hpp"
+#include "resampler.hpp"
+
 #include <string>
 #include <vector>
 #include <functional>
@@ -15,6 +18,12 @@ enum class ExportFormat {
     FLAC
 };
 
+enum class NormalizationMode {
+    None,
+    Loudness,
+    Peak
+};
+
 struct ExportOptions {
     ExportFormat format = ExportFormat::WAV;
     std::string output_path;
@@ -22,42 +31,104 @@ struct ExportOptions {
     int channels = 2;
     int mp3_bitrate = 320;
     int flac_compression_level = 5;
+    double volume = 1.0;
+    AudioEffect effect = AudioEffect::None;
+    int interpolation_filter_length = 0;
+
+    // When non-zero the module is rendered at this rate and resampled to
+    // sample_rate, e.g. one 96 kHz render feeding 48 and 44.1 kHz outputs.
+    int render_sample_rate = 0;
+    ResamplerQuality resampler_quality = ResamplerQuality::Balanced;
+
+    // Loudness targets integrated LUFS, Peak targets the true-peak ceiling.
+    // Without the limiter, loudness gain is capped so the true peak stays
+    // under peak_ceiling_db.
+    NormalizationMode normalization = NormalizationMode::None;
+    double target_lufs = -14.0;
+    double peak_ceiling_db = -1.0;
+    bool limiter = false;
     
     std::function<bool(std::size_t, std::size_t)> progress_callback;
+
+    int effective_render_rate() const noexcept { return render_sample_rate > 0 ? render_sample_rate : sample_rate; }
+};
+
+struct ExportStats {
+    double audio_seconds = 0.0;
+    double wall_seconds = 0.0;
+    double render_seconds = 0.0;
+    double effect_seconds = 0.0;
+    double encode_seconds = 0.0;
+    double io_seconds = 0.0;
+    double analysis_seconds = 0.0;
+    double resample_seconds = 0.0;
+    bool normalized = false;
+    double measured_lufs = 0.0;
+    double measured_true_peak_db = 0.0;
+    double applied_gain_db = 0.0;
+    std::uint64_t bytes_written = 0;
+    // High-water mark of the whole process (getrusage), not of this export
+    // alone: inside the player or next to other jobs it includes their memory.
+    std::uint64_t process_peak_rss_bytes = 0;
+
+    double realtime_factor() const;
+    double write_megabytes_per_second() const;
+    std::string summary() const;
+    std::string to_json() const;
+
+    static std::uint64_t read_process_peak_rss_bytes();
 };
 
 class AudioExporter {
 public:
-    AudioExporter() = default;
-    ~AudioExporter() = default;
+    AudioExporter();
+    ~AudioExporter();
+
+    AudioExporter(const AudioExporter&) = delete;
+    AudioExporter& operator=(const AudioExporter&) = delete;
 
     bool export_audio(const std::vector<float>& audio_data,
                      const ExportOptions& options,
                      std::string& error_message);
 
+    // Streaming interface: begin() opens the output, write() encodes
+    // interleaved samples as they arrive, finish() finalizes the file.
+    // abort() closes and removes a partially written file.
+    bool begin(const ExportOptions& options, std::string& error_message);
+    bool write(const float* samples, std::size_t sample_count, std::string& error_message);
+    bool finish(std::string& error_message);
+    void abort();
+
     static bool is_format_supported(ExportFormat format);
     
     static std::string get_extension(ExportFormat format);
     
     static std::string get_format_name(ExportFormat format);
 
+    const ExportStats& stats() const noexcept { return stats_; }
+
 private:
-    bool export_wav(const std::vector<float>& audio_data,
-                   const ExportOptions& options,
-                   std::string& error_message);
-    
-    bool export_mp3(const std::vector<float>& audio_data,
-                   const ExportOptions& options,
-                   std::string& error_message);
-    
-    bool export_flac(const std::vector<float>& audio_data,
-                    const ExportOptions& options,
-                    std::string& error_message);
-    
+    struct EncoderState;
+
+    bool begin_wav(std::string& error_message);
+    bool write_wav(const float* samples, std::size_t sample_count, std::string& error_message);
+    bool finish_wav(std::string& error_message);
+
+    bool begin_mp3(std::string& error_message);
+    bool write_mp3(const float* samples, std::size_t sample_count, std::string& error_message);
+    bool finish_mp3(std::string& error_message);
+
+    bool begin_flac(std::string& error_message);
+    bool write_flac(const float* samples, std::size_t sample_count, std::string& error_message);
+    bool finish_flac(std::string& error_message);
+
     static std::int16_t float_to_int16(float sample);
     
     static void write_le16(std::vector<std::uint8_t>& buffer, std::uint16_t value);
     static void write_le32(std::vector<std::uint8_t>& buffer, std::uint32_t value);
+
+    ExportStats stats_;
+    std::unique_ptr<EncoderState> state_;
 };
 
 } 
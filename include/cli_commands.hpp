@@ -0,0 +1,44 @@
+#pragma once
+
+#include "audio_exporter.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace tracker {
+
+// Each output spec is "path[@rate]"; the format follows the extension and the
+// rate defaults to options.sample_rate. Several outputs share one render.
+int run_export_command(const std::filesystem::path& module_path, ExportOptions options,
+                       const std::vector<std::string>& output_specs, bool json_output);
+
+struct IndexCommandOptions {
+    bool content_detection = false;
+    bool durations = true;
+    // Also renders each module's SongEnvelope for the player's position bar.
+    bool envelopes = false;
+    std::size_t jobs = 0;
+    std::uint64_t memory_cap_megabytes = 256;
+    bool watch = false;
+};
+
+// Updates the library index under the cache directory from the given roots,
+// reparsing only files whose size or mtime changed since the last run. With
+// content detection every file is probed and non-modules are recorded too.
+// With watch set it then keeps running, applying inotify changes under the
+// roots to the index as they happen.
+int run_index_command(const std::vector<std::filesystem::path>& roots, const IndexCommandOptions& options,
+                      bool json_output);
+
+// Lists the groups of identical modules recorded by the last --index run
+// and the space that removing all but one copy of each would free.
+int run_duplicates_command(bool json_output);
+
+// Filters the library index with a LibraryQuery expression, e.g.
+// "channels=4 format=mod duration<3:00 artist~jester sort:-duration".
+int run_query_command(const std::string& expression, bool json_output);
+
+}
@@ -5,6 +5,7 @@
 #include <fstream>
 #include <filesystem>
 #include <iostream>
+#include <vector>
 
 namespace tracker {
 
@@ -22,6 +23,14 @@ public:
     
     void set_volume(double volume) { volume_ = volume; }
     void set_theme(const std::string& theme) { theme_ = theme; }
+
+    // Directories scanned recursively by the library indexer.
+    const std::vector<std::string>& get_library_roots() const { return library_roots_; }
+    void add_library_root(const std::string& root);
+
+    // Probe file contents with libopenmpt instead of trusting extensions.
+    bool get_content_detection() const { return content_detection_; }
+    void set_content_detection(bool enabled) { content_detection_ = enabled; }
     
 private:
     std::filesystem::path get_config_path() const;
@@ -29,6 +38,8 @@ private:
     
     double volume_{1.0};
     std::string theme_{"dark"};
+    std::vector<std::string> library_roots_;
+    bool content_detection_{false};
 };
 
 } 
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tracker {
+
+struct DirectoryChange {
+    enum class Kind {
+        Upsert,
+        Removed
+    };
+
+    std::filesystem::path path;
+    Kind kind = Kind::Upsert;
+    bool is_directory = false;
+};
+
+// Watches directories with inotify on a background thread. Events are
+// coalesced per path until the tree has been quiet for kQuietPeriod (or
+// kMaxDelay has passed), then each path is reported once with its state at
+// that moment, so a burst of writes to a download yields one Upsert. An
+// Upsert of a watched root means events were dropped and it should be
+// rescanned.
+class DirectoryWatcher {
+public:
+    using Callback = std::function<void(std::vector<DirectoryChange> changes)>;
+
+    static constexpr auto kQuietPeriod = std::chrono::milliseconds(100);
+    static constexpr auto kMaxDelay = std::chrono::milliseconds(1000);
+
+    DirectoryWatcher() = default;
+    ~DirectoryWatcher();
+
+    DirectoryWatcher(const DirectoryWatcher&) = delete;
+    DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+    // Recursive watches also follow directories created later.
+    bool start(const std::vector<std::filesystem::path>& directories, bool recursive, Callback callback,
+               std::string& error_message);
+    void stop();
+    bool running() const { return thread_.joinable(); }
+
+private:
+    struct State;
+
+    static void run(const std::shared_ptr<State>& state);
+
+    std::shared_ptr<State> state_;
+    std::thread thread_;
+};
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "library_index.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tracker {
+
+struct DuplicateGroup {
+    std::uint32_t id = 0;
+    std::uint64_t size = 0;
+    std::uint64_t content_hash = 0;
+    std::vector<std::string> paths;
+
+    // Everything but one copy could be removed.
+    std::uint64_t reclaimable_bytes() const { return paths.size() > 1 ? size * (paths.size() - 1) : 0; }
+};
+
+struct DuplicateStats {
+    std::size_t files = 0;
+    std::size_t size_matches = 0;
+    std::size_t partial_hashed = 0;
+    std::size_t partial_matches = 0;
+    std::size_t full_hashed = 0;
+    std::size_t hashes_reused = 0;
+    std::size_t groups = 0;
+    std::size_t duplicate_files = 0;
+    std::uint64_t reclaimable_bytes = 0;
+    std::uint64_t bytes_read = 0;
+    double elapsed_seconds = 0.0;
+};
+
+// Finds listed modules with identical contents in three passes, each run
+// only on what the previous one could not tell apart: equal sizes, then a
+// hash of the first and last kPartialBytes, then a hash of the whole file.
+// Files are mapped rather than read and hashed on a work-stealing pool. A
+// record's content_hash stands in for the full hash while its mtime still
+// matches the file.
+class DuplicateFinder {
+public:
+    static constexpr std::size_t kPartialBytes = 4096;
+
+    explicit DuplicateFinder(std::size_t threads = 0) : threads_(threads) {}
+
+    // Stamps duplicate_group on every record (0 for unique files) and
+    // returns the groups, most reclaimable space first.
+    std::vector<DuplicateGroup> find(std::vector<LibraryRecord>& records);
+
+    const DuplicateStats& stats() const noexcept { return stats_; }
+
+    // Rebuilds the groups stored by a previous find() from an index.
+    static std::vector<DuplicateGroup> groups_from_index(const LibraryIndex& index);
+
+    // Hashes the mapped file; partial hashes cover only its head and tail.
+    // Fails if the file's size no longer matches.
+    static bool hash_file(const std::string& path, std::uint64_t size, bool partial, std::uint64_t& hash,
+                          std::int64_t& mtime_ns);
+
+private:
+    std::size_t threads_;
+    DuplicateStats stats_;
+};
+
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "audio_exporter.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tracker {
+
+enum class ExportJobState {
+    Queued,
+    Running,
+    Completed,
+    Failed,
+    Cancelled
+};
+
+struct ExportJobInfo {
+    int id{0};
+    std::string output_path;
+    ExportFormat format{ExportFormat::WAV};
+    ExportJobState state{ExportJobState::Queued};
+    double progress{0.0};
+    double elapsed_seconds{0.0};
+    double realtime_factor{0.0};
+    std::string error_message;
+    ExportStats stats;
+};
+
+// Renders one job; progress is reported through options.progress_callback.
+using ExportRenderFunction = std::function<bool(const std::string& module_path, const ExportOptions& options,
+                                                ExportStats& stats, std::string& error_message)>;
+
+class ExportJobManager {
+public:
+    explicit ExportJobManager(std::string module_path, std::size_t worker_count = 2, std::size_t max_pending = 8);
+    ExportJobManager(std::string module_path, ExportRenderFunction render, std::size_t worker_count,
+                     std::size_t max_pending);
+    ~ExportJobManager();
+
+    ExportJobManager(const ExportJobManager&) = delete;
+    ExportJobManager& operator=(const ExportJobManager&) = delete;
+
+    int submit(ExportOptions options, std::string& error_message);
+    // Jobs already queued keep the module they were submitted for.
+    void set_module_path(std::string module_path);
+    bool cancel(int job_id);
+    void cancel_all();
+
+    std::vector<ExportJobInfo> jobs() const;
+    std::vector<ExportJobInfo> take_finished();
+    std::size_t active_count() const;
+
+    static bool is_finished(ExportJobState state);
+    static std::string state_name(ExportJobState state);
+
+    static constexpr std::size_t kHistoryLimit = 16;
+
+private:
+    struct Job {
+        int id{0};
+        std::string module_path;
+        ExportOptions options;
+        std::atomic<ExportJobState> state{ExportJobState::Queued};
+        std::atomic<std::size_t> current{0};
+        std::atomic<std::size_t> total{0};
+        std::atomic<bool> cancel_requested{false};
+        std::chrono::steady_clock::time_point started_at{};
+        std::chrono::steady_clock::time_point finished_at{};
+        std::string error_message;
+        ExportStats stats;
+    };
+
+    void worker_loop();
+    ExportJobInfo describe_locked(const Job& job) const;
+    void prune_history_locked();
+
+    std::string module_path_;
+    ExportRenderFunction render_;
+    std::size_t max_pending_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable queue_cv_;
+    std::deque<std::shared_ptr<Job>> queue_;
+    std::vector<std::shared_ptr<Job>> jobs_;
+    std::vector<ExportJobInfo> finished_;
+    std::vector<std::thread> workers_;
+    bool shutting_down_{false};
+    int next_id_{1};
+
+};
+
+}
@@ -1,25 +1,128 @@
 #pragma once
 
+#include "directory_watcher.hpp"
+#include "module_detection.hpp"
+
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <list>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
 #include <vector>
 
 namespace tracker {
 
+// "12.3 KB"-style label used by the browser's size column.
+std::string format_file_size(std::uint64_t bytes);
+
+// Case-folded sort key in which each digit run is prefixed by its length,
+// so plain byte comparison orders "track2" before "track10".
+std::string make_collation_key(std::string_view name);
+
+enum class SortMode {
+    Name,
+    Size,
+    Modified,
+    Duration,
+    Channels
+};
+
+struct EntryMetadata {
+    std::uint32_t duration_ms = 0;
+    std::uint16_t channels = 0;
+    // Copies of this file across the library, itself included; 0 if unique.
+    std::uint32_t duplicate_count = 0;
+};
+
+// Supplies duration and channel count (normally from the library index).
+// Called from the scan thread.
+using MetadataLookup = std::function<bool(const std::filesystem::path& path, EntryMetadata& metadata)>;
+
 struct FileEntry {
     std::filesystem::path path;
     std::string display_name;
     bool is_directory;
     std::size_t size;
+    // Formatted once when the entry is created, on the scan thread, rather
+    // than on every frame or comparison.
+    std::string size_label;
+    std::string collation_key;
+    std::int64_t mtime_ns = 0;
+    std::uint32_t duration_ms = 0;
+    std::uint16_t channels = 0;
+    std::uint32_t duplicate_count = 0;
     
     FileEntry(const std::filesystem::path& p, const std::string& name, bool is_dir, std::size_t sz = 0)
-        : path(p), display_name(name), is_directory(is_dir), size(sz) {}
+        : path(p), display_name(name), is_directory(is_dir), size(sz),
+          size_label(is_dir ? "<DIR>" : format_file_size(sz)), collation_key(make_collation_key(name)) {}
+};
+
+struct ScanProgress {
+    std::size_t entries_seen{0};
+    std::size_t entries_listed{0};
+    bool scanning{false};
 };
 
+// Directory listings are read on a background thread. Entries arrive in
+// sorted batches that the UI thread merges in with poll(); navigating away
+// cancels the scan in flight without waiting for it.
 class FileBrowser {
 public:
+    static constexpr std::size_t kDefaultListingCacheCapacity = 16;
+
     FileBrowser();
     explicit FileBrowser(const std::filesystem::path& start_path);
+    ~FileBrowser();
+
+    FileBrowser(const FileBrowser&) = delete;
+    FileBrowser& operator=(const FileBrowser&) = delete;
+
+    // Invoked from the scan thread whenever a batch is ready or the scan
+    // ends; the UI uses it to wake its event loop.
+    void set_update_callback(std::function<void()> callback);
+
+    // With a detector, files are listed by probing their contents instead
+    // of by extension. Rescans the current directory.
+    void set_detector(std::shared_ptr<const ModuleDetector> detector);
+
+    // Rescans the current directory so entries pick up the metadata.
+    void set_metadata_lookup(MetadataLookup lookup);
+
+    // Directories stay first; size, mtime, duration and channels sort
+    // largest/newest first. Re-sorts in place, keeping the selection.
+    void set_sort_mode(SortMode mode);
+    SortMode sort_mode() const { return sort_mode_; }
+    static const char* sort_mode_name(SortMode mode);
+
+    // Sorts entries[first, end) by sorting an index permutation, so each
+    // entry is moved once instead of on every swap.
+    static void sort_file_entries(std::vector<FileEntry>& entries, std::size_t first, SortMode mode);
+
+    // Watches the current directory with inotify; created, deleted and
+    // rewritten files are applied to the listing by poll() without a
+    // rescan, keeping the selection on the same entry.
+    void set_watching(bool enabled);
+    bool watching() const { return watching_; }
+
+    // Completed listings of recently visited directories, most recent
+    // first. Returning to one whose mtime is unchanged restores its entries
+    // and selection without a scan; watcher changes drop the affected
+    // listings. A capacity of 0 disables the cache.
+    void set_listing_cache_capacity(std::size_t capacity);
+    std::size_t listing_cache_size() const { return listing_cache_.size(); }
+    std::size_t listing_cache_hits() const { return listing_cache_hits_; }
+
+    // Merges batches and watcher changes delivered since the last call. Returns true when the
+    // entry list or error state changed.
+    bool poll();
+    bool scanning() const;
+    ScanProgress scan_progress() const;
+    void cancel_scan();
     
     void navigate_to(const std::filesystem::path& path);
     void navigate_up();
@@ -39,18 +142,61 @@ public:
     
     std::filesystem::path get_selected_file() const;
     
+    // Extension check; also accepts Amiga-style prefixes such as "mod.name".
     static bool is_module_file(const std::filesystem::path& path);
     
 private:
+    struct ScanState;
+    struct WatchState;
+
+    struct CachedListing {
+        std::filesystem::path directory;
+        std::int64_t mtime_ns = 0;
+        SortMode sort_mode = SortMode::Name;
+        // Without the ".." entry.
+        std::vector<FileEntry> entries;
+        std::size_t entries_seen = 0;
+        std::filesystem::path selected;
+    };
+
     void refresh();
+    bool restore_listing(std::int64_t mtime_ns);
+    void cache_listing(const ScanState& scan);
+    void remember_selection();
+    void forget_listings(const std::filesystem::path& path, bool subdirectories);
+    void start_watch();
+    bool poll_scan();
+    bool apply_watch_changes();
     void clear_error();
+    void merge_batch(std::vector<FileEntry> batch);
+    void reap_finished_scans();
+    
+    static void run_scan(const std::shared_ptr<ScanState>& state);
+    static void handle_watch_changes(const std::shared_ptr<WatchState>& state, std::vector<DirectoryChange> changes);
+    static bool compare_entries(const FileEntry& a, const FileEntry& b, SortMode mode);
+    void sort_entries();
     
     std::filesystem::path current_path_;
     std::vector<FileEntry> entries_;
     std::size_t selected_index_{0};
     std::string error_message_;
+    std::size_t entries_seen_{0};
+    std::function<void()> update_callback_;
+    std::shared_ptr<const ModuleDetector> detector_;
+    MetadataLookup metadata_lookup_;
+    SortMode sort_mode_{SortMode::Name};
+    std::shared_ptr<ScanState> scan_;
+    std::thread scan_thread_;
+    std::vector<std::pair<std::shared_ptr<ScanState>, std::thread>> retired_scans_;
+    bool watching_{false};
+    std::shared_ptr<WatchState> watch_;
+    DirectoryWatcher watcher_;
+    std::list<CachedListing> listing_cache_;
+    std::size_t listing_cache_capacity_{kDefaultListingCacheCapacity};
+    std::size_t listing_cache_hits_{0};
     
     static const std::vector<std::string> module_extensions_;
+    static const std::vector<std::string> amiga_prefixes_;
 };
 
 } 
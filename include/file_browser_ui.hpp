@@ -1,12 +1,32 @@
 #pragma once
 
 #include "file_browser.hpp"
+#include "library_index.hpp"
+#include "playlist.hpp"
+#include <ftxui/dom/elements.hpp>
+#include <functional>
+#include <memory>
 #include <optional>
 #include <string>
 
 namespace tracker {
 
+// Receives the highlighted module, or an empty path, whenever the selection
+// moves while previewing is switched on.
+using PreviewCallback = std::function<void(const std::filesystem::path& path)>;
 
-std::optional<std::filesystem::path> run_file_browser_ui(const std::filesystem::path& start_dir);
+// A detector switches the listing to content probing; the library index
+// supplies duration and channel counts for sorting. With a queue, files,
+// directories and search results can be appended to it before one is
+// picked to play.
+std::optional<std::filesystem::path> run_file_browser_ui(const std::filesystem::path& start_dir,
+                                                         std::shared_ptr<const ModuleDetector> detector = nullptr,
+                                                         std::shared_ptr<const LibraryIndex> library = nullptr,
+                                                         PreviewCallback preview = nullptr,
+                                                         std::shared_ptr<Playlist> queue = nullptr);
+
+// Builds rows [begin, end) of the listing; the UI passes the visible window.
+ftxui::Element render_file_entries(const std::vector<FileEntry>& entries, std::size_t selected,
+                                   std::size_t begin, std::size_t end);
 
 }
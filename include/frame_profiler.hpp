@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace tracker {
+
+// Distribution of the last kWindow samples in logarithmic buckets, four per
+// doubling, so a percentile is a walk over the buckets rather than a sort.
+// Percentiles report the upper edge of their bucket, i.e. within ~19%.
+class RollingHistogram {
+public:
+    static constexpr std::size_t kWindow = 240;
+    static constexpr std::size_t kBuckets = 128;
+
+    void add(std::uint64_t value);
+    // Upper bound of the value below which `fraction` of the window lies;
+    // 0 when empty.
+    std::uint64_t percentile(double fraction) const;
+    std::size_t size() const noexcept { return size_; }
+
+private:
+    static std::size_t bucket_for(std::uint64_t value);
+    static std::uint64_t bucket_limit(std::size_t bucket);
+
+    std::array<std::uint32_t, kBuckets> counts_{};
+    std::array<std::uint8_t, kWindow> ring_{};
+    std::size_t next_{0};
+    std::size_t size_{0};
+};
+
+// Per-phase frame timings in microseconds plus terminal bytes per frame.
+class FrameProfiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct PhaseSummary {
+        std::string name;
+        std::uint64_t p50_us{0};
+        std::uint64_t p99_us{0};
+    };
+
+    // Records the time from construction to destruction against a phase.
+    class Scope {
+    public:
+        Scope(FrameProfiler &profiler, std::size_t phase) : profiler_(profiler), phase_(phase), start_(Clock::now()) {}
+        ~Scope() { profiler_.record(phase_, Clock::now() - start_); }
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        FrameProfiler &profiler_;
+        std::size_t phase_;
+        Clock::time_point start_;
+    };
+
+    std::size_t add_phase(std::string name);
+    void record(std::size_t phase, Clock::duration elapsed);
+    void record_bytes(std::uint64_t bytes);
+
+    std::vector<PhaseSummary> summary() const;
+    std::uint64_t bytes_percentile(double fraction) const { return bytes_.percentile(fraction); }
+    std::size_t frames() const noexcept { return bytes_.size(); }
+
+private:
+    std::vector<std::string> names_;
+    std::vector<RollingHistogram> phases_;
+    RollingHistogram bytes_;
+};
+
+// Forwards everything to another stream buffer while counting the bytes and
+// the time spent in sync(), which is where a terminal write actually
+// happens. Not thread-safe; meant to wrap std::cout for the thread that
+// draws.
+class CountingStreambuf : public std::streambuf {
+public:
+    explicit CountingStreambuf(std::streambuf *target) : target_(target) {}
+
+    // Bytes written and time spent flushing since the previous call.
+    std::uint64_t take_bytes();
+    FrameProfiler::Clock::duration take_flush_time();
+    // When the last flush finished, or the epoch if none has yet.
+    FrameProfiler::Clock::time_point last_flush() const noexcept { return last_flush_; }
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char *data, std::streamsize count) override;
+    int sync() override;
+
+private:
+    std::streambuf *target_;
+    std::uint64_t bytes_{0};
+    FrameProfiler::Clock::duration flush_time_{};
+    FrameProfiler::Clock::time_point last_flush_{};
+};
+
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tracker {
+
+struct LibraryRecord {
+    static constexpr std::uint32_t kMetadataValid = 1u << 0;
+    // Set when the file was classified by content probing; kDetectedModule
+    // then holds the verdict. Unprobed records were listed by extension.
+    static constexpr std::uint32_t kProbed = 1u << 1;
+    static constexpr std::uint32_t kDetectedModule = 1u << 2;
+    // The reader tried to render a song envelope, which may still be empty
+    // if the module did not play.
+    static constexpr std::uint32_t kEnvelopeChecked = 1u << 3;
+
+    static bool is_listed_module(std::uint32_t flags) {
+        return (flags & kProbed) == 0 || (flags & kDetectedModule) != 0;
+    }
+
+    std::string path;
+    std::uint64_t size = 0;
+    std::int64_t mtime_ns = 0;
+    std::uint64_t content_hash = 0;
+    std::string format;
+    std::string title;
+    std::string artist;
+    std::string tracker;
+    std::uint16_t channels = 0;
+    std::uint16_t patterns = 0;
+    std::uint32_t duration_ms = 0;
+    std::uint32_t flags = 0;
+    // Listed modules with identical contents share a non-zero group.
+    std::uint32_t duplicate_group = 0;
+    // SongEnvelope levels, one byte per bucket.
+    std::string envelope;
+};
+
+// Read-only view of the on-disk library index. The file is mapped whole and
+// entries hand out string_views into the mapping, so opening a large index
+// costs one mmap plus a bounds check per record. Records are sorted by path.
+class LibraryIndex {
+public:
+    struct Entry {
+        std::string_view path;
+        std::string_view format;
+        std::string_view title;
+        std::string_view artist;
+        std::string_view tracker;
+        std::uint64_t size;
+        std::int64_t mtime_ns;
+        std::uint64_t content_hash;
+        std::uint16_t channels;
+        std::uint16_t patterns;
+        std::uint32_t duration_ms;
+        std::uint32_t flags;
+        std::uint32_t duplicate_group;
+        std::string_view envelope;
+
+        LibraryRecord to_record() const;
+    };
+
+    LibraryIndex() = default;
+    ~LibraryIndex();
+
+    LibraryIndex(LibraryIndex&& other) noexcept;
+    LibraryIndex& operator=(LibraryIndex&& other) noexcept;
+    LibraryIndex(const LibraryIndex&) = delete;
+    LibraryIndex& operator=(const LibraryIndex&) = delete;
+
+    bool open(const std::filesystem::path& file, std::string& error_message);
+    void close();
+    bool is_open() const noexcept { return data_ != nullptr; }
+
+    std::size_t size() const noexcept { return record_count_; }
+    Entry entry(std::size_t index) const;
+    std::optional<std::size_t> find(std::string_view path) const;
+
+    // Writes to a temporary file and renames it over the target, so readers
+    // holding the old mapping are unaffected.
+    static bool write(const std::filesystem::path& file, std::vector<LibraryRecord> records,
+                      std::string& error_message);
+
+    // $XDG_CACHE_HOME/cli-tracker/library.idx, falling back to ~/.cache.
+    static std::filesystem::path default_path();
+
+private:
+    const std::uint8_t* data_{nullptr};
+    std::size_t mapped_size_{0};
+    std::size_t record_count_{0};
+    const std::uint8_t* records_{nullptr};
+    const char* strings_{nullptr};
+};
+
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "directory_watcher.hpp"
+#include "duplicate_finder.hpp"
+#include "library_index.hpp"
+#include "metadata_extractor.hpp"
+#include "module_detection.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace tracker {
+
+struct IndexStats {
+    std::size_t files_seen = 0;
+    std::size_t reused = 0;
+    std::size_t parsed = 0;
+    std::size_t failed = 0;
+    std::size_t not_modules = 0;
+    std::size_t removed = 0;
+    std::size_t failed_roots = 0;
+    std::size_t duplicate_groups = 0;
+    std::size_t duplicate_files = 0;
+    std::uint64_t reclaimable_bytes = 0;
+    std::uint64_t bytes_read = 0;
+    std::uint64_t peak_bytes_in_flight = 0;
+    std::size_t threads = 0;
+    double parse_seconds = 0.0;
+    double elapsed_seconds = 0.0;
+
+    double files_per_second() const;
+    double parsed_files_per_second() const;
+};
+
+// Walks the library roots and produces a fresh record set. Files whose size
+// and mtime match the previous index are copied from it without being read.
+// With a detector every regular file is probed and the verdict is stored, so
+// non-modules are not probed again until they change. Every run ends with a
+// duplicate pass that stamps duplicate_group on the records.
+class LibraryIndexer {
+public:
+    explicit LibraryIndexer(MetadataReader reader, ExtractorOptions options = {});
+
+    void set_progress_callback(std::function<void(const IndexStats&)> callback) {
+        progress_callback_ = std::move(callback);
+    }
+
+    void set_detector(std::shared_ptr<const ModuleDetector> detector) { detector_ = std::move(detector); }
+
+    // For readers that render song envelopes: unchanged modules indexed
+    // without one are parsed again.
+    void set_envelopes(bool enabled) { envelopes_ = enabled; }
+
+    // A root that cannot be opened or stops part-way keeps its previous
+    // records for the files it did not reach; it is counted in failed_roots
+    // and described in error_message even when update() succeeds.
+    bool update(const std::vector<std::filesystem::path>& roots, const LibraryIndex& previous,
+                std::vector<LibraryRecord>& records, std::string& error_message);
+
+    // Applies watcher changes to a previous index without walking the
+    // roots: records under unchanged paths are copied, removed paths are
+    // dropped and upserted files or directories are revisited.
+    bool apply_changes(const LibraryIndex& previous, const std::vector<DirectoryChange>& changes,
+                       std::vector<LibraryRecord>& records, std::string& error_message);
+
+    const IndexStats& stats() const noexcept { return stats_; }
+    const std::vector<DuplicateGroup>& duplicates() const noexcept { return duplicates_; }
+
+    static std::uint64_t hash_content(const std::uint8_t* data, std::size_t size);
+
+private:
+    bool walk(const std::filesystem::path& root, const LibraryIndex& previous, std::vector<LibraryRecord>& records,
+              std::vector<DetectionCandidate>& pending, std::unordered_set<std::string>& seen,
+              std::string& error_message);
+    void keep_previous(const std::filesystem::path& root, const LibraryIndex& previous,
+                       std::vector<LibraryRecord>& records, std::unordered_set<std::string>& seen);
+    void process_pending(std::vector<DetectionCandidate>& pending, std::vector<LibraryRecord>& records);
+    void find_duplicates(std::vector<LibraryRecord>& records);
+    bool visit_file(const std::filesystem::path& path, const LibraryIndex& previous,
+                    std::vector<LibraryRecord>& records, std::vector<DetectionCandidate>& pending);
+    void report_progress();
+
+    MetadataExtractor extractor_;
+    std::size_t threads_;
+    std::shared_ptr<const ModuleDetector> detector_;
+    bool envelopes_{false};
+    std::function<void(const IndexStats&)> progress_callback_;
+    IndexStats stats_;
+    std::vector<DuplicateGroup> duplicates_;
+};
+
+}
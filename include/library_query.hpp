@@ -0,0 +1,112 @@
+#pragma once
+
+#include "library_index.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tracker {
+
+enum class QueryField {
+    Path,
+    Title,
+    Artist,
+    Tracker,
+    Format,
+    Channels,
+    Patterns,
+    Duration,
+    Size
+};
+
+enum class QueryOp {
+    Equal,
+    NotEqual,
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual,
+    Contains
+};
+
+struct QueryPredicate {
+    QueryField field = QueryField::Path;
+    QueryOp op = QueryOp::Equal;
+    // Lowercased for string fields; milliseconds for durations, bytes for
+    // sizes.
+    std::string text;
+    std::uint64_t number = 0;
+};
+
+// Whitespace-separated terms that must all hold, e.g.
+//   channels=4 format=mod duration<3:00 artist~"purple motion" sort:-duration limit:20
+// String fields take =, != and ~ (contains); numeric fields take the
+// comparisons. "field:value" means ~ for strings and = for numbers. Bare
+// words must occur in the path, title or artist. Durations are seconds or
+// m:ss and never match modules whose length is unknown; sizes accept k/m/g
+// suffixes.
+struct LibraryQuery {
+    std::vector<QueryPredicate> predicates;
+    std::vector<std::string> words;
+    QueryField sort_field = QueryField::Path;
+    bool descending = false;
+    std::size_t limit = 0;
+
+    static bool parse(std::string_view text, LibraryQuery& query, std::string& error_message);
+    // True when text contains a field term, i.e. it is meant for parse()
+    // rather than fuzzy search.
+    static bool is_structured(std::string_view text);
+    static const char* field_name(QueryField field);
+};
+
+// Column-wise copy of the index for filtering. Tracker, format and artist
+// are dictionary encoded, so a string predicate is evaluated once per
+// distinct value and the rows only look up their code; counts, durations
+// and sizes sit in packed arrays. Each predicate is one branch-free pass
+// over a column that ANDs into a byte mask, which the compiler vectorizes.
+class LibraryColumns {
+public:
+    explicit LibraryColumns(const LibraryIndex& index);
+
+    std::size_t size() const noexcept { return channels_.size(); }
+    std::size_t distinct_artists() const noexcept { return artist_.values.size(); }
+
+    // Matching rows of the index in the query's sort order.
+    std::vector<std::uint32_t> execute(const LibraryQuery& query) const;
+
+private:
+    struct Dictionary {
+        std::vector<std::string> values;
+        std::vector<std::uint32_t> codes;
+        // Position of each value in sorted order, for sorting by code.
+        std::vector<std::uint32_t> ranks;
+    };
+    struct TextSpan {
+        std::uint32_t offset;
+        std::uint32_t length;
+    };
+
+    const Dictionary* dictionary(QueryField field) const;
+    std::string_view text(const std::vector<TextSpan>& spans, std::uint32_t row) const;
+    void apply(const QueryPredicate& predicate, std::vector<std::uint8_t>& mask) const;
+    void apply_word(const std::string& word, std::vector<std::uint8_t>& mask) const;
+    void sort(std::vector<std::uint32_t>& rows, QueryField field, bool descending) const;
+
+    std::vector<std::uint8_t> listed_;
+    std::vector<std::uint16_t> channels_;
+    std::vector<std::uint16_t> patterns_;
+    std::vector<std::uint32_t> duration_ms_;
+    std::vector<std::uint64_t> size_;
+    Dictionary tracker_;
+    Dictionary format_;
+    Dictionary artist_;
+    // Lowercased paths and titles, which are mostly unique.
+    std::string text_pool_;
+    std::vector<TextSpan> paths_;
+    std::vector<TextSpan> titles_;
+};
+
+}
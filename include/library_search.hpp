@@ -0,0 +1,107 @@
+#pragma once
+
+#include "library_index.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tracker {
+
+struct SearchResult {
+    std::size_t record = 0;
+    int score = 0;
+    std::string path;
+    std::string title;
+    std::string artist;
+};
+
+// Fuzzy search over file name, title and artist. Every record's lowercased
+// text is broken into trigrams with one posting list per trigram; a query
+// keeps records sharing most of its trigrams (so typos still match) and
+// ranks them by a subsequence score.
+class LibrarySearchIndex {
+public:
+    explicit LibrarySearchIndex(std::shared_ptr<const LibraryIndex> library);
+
+    std::vector<SearchResult> search(std::string_view query, std::size_t limit) const;
+    std::size_t size() const noexcept { return text_offsets_.empty() ? 0 : text_offsets_.size() - 1; }
+
+private:
+    std::string_view text(std::uint32_t record) const;
+    std::vector<std::pair<std::uint32_t, int>> candidates(const std::vector<std::uint32_t>& trigrams) const;
+    int score(std::uint32_t record, std::string_view query, int trigram_hits) const;
+
+    std::shared_ptr<const LibraryIndex> library_;
+    std::string text_pool_;
+    std::vector<std::uint32_t> text_offsets_;
+    std::unordered_map<std::uint32_t, std::uint32_t> trigram_slots_;
+    std::vector<std::uint32_t> posting_offsets_;
+    std::vector<std::uint32_t> postings_;
+};
+
+// Runs searches on a worker thread so typing never waits on the index. Only
+// the latest submitted query is evaluated; older ones are dropped. Queries
+// with field terms ("ch=4 format=mod") are filters over LibraryColumns
+// instead of fuzzy matches.
+class LibrarySearcher {
+public:
+    LibrarySearcher();
+    ~LibrarySearcher();
+
+    LibrarySearcher(const LibrarySearcher&) = delete;
+    LibrarySearcher& operator=(const LibrarySearcher&) = delete;
+
+    // Maps the index and builds the trigram tables in the background.
+    void load(const std::filesystem::path& index_path);
+    void set_update_callback(std::function<void()> callback);
+    void submit(std::string query);
+
+    // Picks up results finished since the last call; true when they changed.
+    bool poll();
+    const std::vector<SearchResult>& results() const { return results_; }
+    // Why the last filter query could not be parsed; empty otherwise.
+    const std::string& query_error() const { return query_error_; }
+    bool loaded() const;
+    bool ready() const;
+    std::size_t indexed_count() const;
+    std::string error_message() const;
+    double last_query_milliseconds() const { return last_query_ms_; }
+
+    static constexpr std::size_t kMaxResults = 200;
+
+private:
+    void run(std::filesystem::path index_path);
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::function<void()> update_callback_;
+    std::string pending_query_;
+    std::uint64_t submitted_{0};
+    std::uint64_t completed_{0};
+    std::uint64_t taken_{0};
+    std::vector<SearchResult> completed_results_;
+    std::string completed_error_;
+    double completed_ms_{0.0};
+    bool stop_{false};
+    bool ready_{false};
+    std::size_t indexed_count_{0};
+    std::string error_message_;
+    std::thread worker_;
+
+    std::vector<SearchResult> results_;
+    std::string query_error_;
+    double last_query_ms_{0.0};
+};
+
+}
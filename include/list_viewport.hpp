@@ -0,0 +1,38 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+namespace tracker {
+
+// Tracks which slice of a long list is on screen. The window only moves
+// when the selection leaves it, so scrolling behaves like a pager and the
+// UI builds elements for the visible rows instead of the whole list.
+class ListViewport {
+public:
+    void update(std::size_t count, std::size_t selected, std::size_t rows) {
+        rows_ = std::max<std::size_t>(rows, 1);
+        if (selected < first_) {
+            first_ = selected;
+        } else if (selected >= first_ + rows_) {
+            first_ = selected + 1 - rows_;
+        }
+        first_ = std::min(first_, count > rows_ ? count - rows_ : 0);
+    }
+
+    std::size_t first() const noexcept { return first_; }
+    std::size_t rows() const noexcept { return rows_; }
+
+    // Range of items to build, padded by `margin` rows on both sides so a
+    // slightly wrong row estimate never shows a gap.
+    std::size_t begin(std::size_t margin) const noexcept { return first_ > margin ? first_ - margin : 0; }
+    std::size_t end(std::size_t count, std::size_t margin) const noexcept {
+        return std::min(count, first_ + rows_ + margin);
+    }
+
+private:
+    std::size_t first_{0};
+    std::size_t rows_{1};
+};
+
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace tracker {
+
+// ITU-R BS.1770-4 integrated loudness and true-peak measurement for
+// interleaved stereo. Gating uses 400 ms blocks with 75% overlap, an absolute
+// gate at -70 LUFS and a relative gate 10 LU below the ungated level.
+class LoudnessMeter {
+public:
+    explicit LoudnessMeter(int sample_rate);
+
+    void process(const float* interleaved_stereo, std::size_t frame_count);
+
+    // Negative infinity when every block falls below the absolute gate.
+    double integrated_lufs() const;
+    double true_peak() const noexcept { return true_peak_; }
+    double true_peak_db() const;
+
+private:
+    struct Biquad {
+        double b0, b1, b2, a1, a2;
+        double z1{0.0};
+        double z2{0.0};
+
+        double process(double input) {
+            double output = b0 * input + z1;
+            z1 = b1 * input - a1 * output + z2;
+            z2 = b2 * input - a2 * output;
+            return output;
+        }
+    };
+
+    static constexpr std::size_t kOversample = 4;
+    static constexpr std::size_t kTapsPerPhase = 12;
+
+    double oversampled_peak(std::size_t channel, float sample);
+
+    std::array<Biquad, 2> shelf_;
+    std::array<Biquad, 2> highpass_;
+
+    std::size_t sub_block_frames_;
+    std::size_t sub_block_position_{0};
+    double sub_block_energy_{0.0};
+    std::vector<double> sub_block_energies_;
+
+    std::array<float, kOversample * kTapsPerPhase> interpolation_taps_{};
+    std::array<std::array<float, kTapsPerPhase>, 2> history_{};
+    std::size_t history_position_{0};
+    double true_peak_{0.0};
+};
+
+// Lookahead peak limiter for a signal that is fully available up front, such
+// as the spill file of a two-pass export. Frames must be processed in order.
+class PeakLimiter {
+public:
+    PeakLimiter(int sample_rate, float ceiling);
+
+    void process(const float* interleaved_stereo, std::size_t total_frames, std::size_t start_frame,
+                 std::size_t frame_count, float gain, float* output);
+
+private:
+    std::size_t lookahead_frames_;
+    float ceiling_;
+    float attack_coeff_;
+    float release_coeff_;
+    float envelope_{1.0f};
+    std::size_t next_frame_{0};
+    std::deque<std::pair<std::size_t, float>> window_;
+};
+
+double decibels_to_gain(double decibels);
+double gain_to_decibels(double gain);
+
+}
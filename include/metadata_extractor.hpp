@@ -0,0 +1,63 @@
+#pragma once
+
+#include "library_index.hpp"
+#include "module_detection.hpp"
+#include "work_stealing_pool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace tracker {
+
+// Fills the metadata fields of a record from the raw file contents. Returns
+// false when the file cannot be parsed; the record is still indexed so an
+// unchanged broken file is not reparsed on every run. Called concurrently.
+using MetadataReader = std::function<bool(const std::uint8_t* data, std::size_t size, LibraryRecord& record,
+                                          std::string& error_message)>;
+
+struct ExtractorOptions {
+    std::size_t threads = 0;
+    // Upper bound on file bytes held in memory across all workers. A file
+    // larger than the cap is still read, just never alongside another.
+    std::uint64_t memory_cap_bytes = 256ull * 1024 * 1024;
+};
+
+struct ExtractorStats {
+    std::size_t parsed = 0;
+    std::size_t failed = 0;
+    std::uint64_t bytes_read = 0;
+    std::uint64_t peak_bytes_in_flight = 0;
+    std::size_t threads = 0;
+    double elapsed_seconds = 0.0;
+
+    double files_per_second() const;
+};
+
+// Reads, hashes and parses files on a work-stealing pool.
+class MetadataExtractor {
+public:
+    explicit MetadataExtractor(MetadataReader reader, ExtractorOptions options = {});
+
+    // Called after every file with the number finished so far; serialized.
+    void set_progress_callback(std::function<void(std::size_t done)> callback) {
+        progress_callback_ = std::move(callback);
+    }
+
+    // records[i] is produced from candidates[i]. detected_flags is OR-ed
+    // into every record.
+    void extract(const std::vector<DetectionCandidate>& candidates, std::uint32_t detected_flags,
+                 std::vector<LibraryRecord>& records);
+
+    const ExtractorStats& stats() const noexcept { return stats_; }
+
+private:
+    MetadataReader reader_;
+    ExtractorOptions options_;
+    std::function<void(std::size_t)> progress_callback_;
+    ExtractorStats stats_;
+};
+
+}
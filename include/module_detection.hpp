@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace tracker {
+
+enum class ProbeResult {
+    NotModule,
+    Module,
+    NeedMoreData
+};
+
+// Classifies a file from its first bytes. The player supplies one backed by
+// openmpt::probe_file_header; tests can pass a fake.
+using HeaderProbe =
+    std::function<ProbeResult(const std::uint8_t* header, std::size_t size, std::uint64_t file_size)>;
+
+struct DetectionCandidate {
+    std::filesystem::path path;
+    std::uint64_t size = 0;
+    std::int64_t mtime_ns = 0;
+    bool has_module_extension = false;
+    bool is_module = false;
+    bool from_cache = false;
+};
+
+// Content-based module detection. Each file costs one pread of its first
+// kProbeBytes; batches are probed on several threads, and a cache lookup
+// (normally the library index) can answer files whose size and mtime have
+// not changed since they were last probed.
+class ModuleDetector {
+public:
+    static constexpr std::size_t kProbeBytes = 4096;
+
+    using CacheLookup = std::function<std::optional<bool>(const DetectionCandidate& candidate)>;
+
+    explicit ModuleDetector(HeaderProbe probe, std::size_t thread_count = 0);
+
+    void set_cache(CacheLookup cache) { cache_ = std::move(cache); }
+
+    // Fills is_module for every candidate. Stops early when cancelled is set.
+    void classify(std::vector<DetectionCandidate>& candidates, const std::atomic<bool>* cancelled = nullptr) const;
+    bool probe_file(const DetectionCandidate& candidate) const;
+
+    std::size_t probes_run() const noexcept { return probes_run_.load(std::memory_order_relaxed); }
+
+private:
+    HeaderProbe probe_;
+    CacheLookup cache_;
+    std::size_t thread_count_;
+    mutable std::atomic<std::size_t> probes_run_{0};
+};
+
+}
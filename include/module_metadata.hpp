@@ -0,0 +1,54 @@
+#pragma once
+
+#include "library_index.hpp"
+#include "module_detection.hpp"
+#include "pattern_cache.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tracker {
+
+// MetadataReader backed by libopenmpt; fills title, artist, tracker, format,
+// channel and pattern counts and duration from an in-memory module. Loads
+// skip sample data.
+bool read_module_metadata(const std::uint8_t* data, std::size_t size, LibraryRecord& record,
+                          std::string& error_message);
+
+// Tags, format and channel count only; also skips patterns, leaving the
+// pattern count and duration at zero.
+bool read_module_tags(const std::uint8_t* data, std::size_t size, LibraryRecord& record,
+                      std::string& error_message);
+
+// read_module_metadata plus a SongEnvelope, which needs the samples and a
+// render of the whole song; for LibraryIndexer::set_envelopes().
+bool read_module_metadata_with_envelope(const std::uint8_t* data, std::size_t size, LibraryRecord& record,
+                                        std::string& error_message);
+
+// Renders the module on its own instance at SongEnvelope::kSampleRate in mono
+// with nearest-neighbour interpolation and no volume ramping, several
+// hundred times faster than real time. Stops early when cancelled is set.
+bool render_song_envelope(const std::uint8_t* data, std::size_t size, std::vector<std::uint8_t>& levels,
+                          std::string& error_message, const std::atomic<bool>* cancelled = nullptr);
+
+// Formats every cell of every pattern on its own instance, loaded without
+// samples, along with the order list. Stops early when cancelled is set.
+bool load_pattern_cache(const std::uint8_t* data, std::size_t size, PatternCache& cache, std::string& error_message,
+                        const std::atomic<bool>* cancelled = nullptr);
+
+// The envelope the library index holds for path, if the file is unchanged.
+bool find_song_envelope(const LibraryIndex& index, const std::filesystem::path& path,
+                        std::vector<std::uint8_t>& levels);
+
+// HeaderProbe backed by openmpt::probe_file_header.
+ProbeResult probe_module_header(const std::uint8_t* header, std::size_t size, std::uint64_t file_size);
+
+// Detector whose probe results are first looked up in the library index.
+std::shared_ptr<ModuleDetector> make_module_detector(std::shared_ptr<const LibraryIndex> cache);
+
+}
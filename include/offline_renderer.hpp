@@ -0,0 +1,49 @@
+#pragma once
+
+#include "audio_exporter.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace tracker {
+
+class OfflineRenderer {
+public:
+    explicit OfflineRenderer(std::string module_path);
+
+    bool render(const ExportOptions& options, std::vector<float>& audio_data, std::string& error_message);
+
+    // Plain exports encode while rendering. Normalized exports render once
+    // into a spill file while measuring, then apply gain while encoding from
+    // it; each pass gets an equal share of the progress range, so callbacks
+    // see total = samples * progress_passes(options).
+    bool render_to_file(const ExportOptions& options, std::string& error_message);
+
+    // Renders once at options.effective_render_rate() and feeds every output
+    // concurrently, each on its own encoder thread with its own resampler.
+    // Outputs supply path, format, sample rate and encoder settings; render
+    // settings come from options. Normalization is not supported here.
+    bool render_to_files(const ExportOptions& options, const std::vector<ExportOptions>& outputs,
+                         std::string& error_message);
+
+    static std::size_t progress_passes(const ExportOptions& options);
+
+    const std::string& module_path() const noexcept { return module_path_; }
+    const ExportStats& stats() const noexcept { return stats_; }
+
+private:
+    using StartHandler = std::function<bool(std::size_t total_samples)>;
+    using ChunkHandler = std::function<bool(const float* samples, std::size_t sample_count)>;
+
+    bool render_stream(const ExportOptions& options, std::size_t pass, const StartHandler& on_start,
+                       const ChunkHandler& on_chunk, std::string& error_message);
+    bool render_normalized(const ExportOptions& options, std::string& error_message);
+    void merge_encoder_stats(const ExportStats& encoder_stats);
+
+    std::string module_path_;
+    ExportStats stats_;
+};
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace tracker {
+
+// Every pattern of a module formatted once, so any row can be drawn without
+// going back to the module. Cells are stored back to back in one string,
+// row-major per pattern, and looked up through an offset table.
+class PatternCache {
+public:
+    explicit PatternCache(int channels = 0) : channels_(channels > 0 ? channels : 0) {}
+
+    // Patterns are added in index order, each followed by exactly
+    // rows * channels() cells; a pattern without rows is a gap.
+    void begin_pattern(int rows);
+    void add_cell(std::string_view text);
+    void set_orders(std::vector<int> orders) { orders_ = std::move(orders); }
+
+    int channels() const noexcept { return channels_; }
+    int num_patterns() const noexcept { return static_cast<int>(pattern_rows_.size()); }
+    int num_orders() const noexcept { return static_cast<int>(orders_.size()); }
+    // 0 for unknown patterns.
+    int num_rows(int pattern) const noexcept;
+    // -1 for orders past the end and for separator/skip entries.
+    int order_pattern(int order) const noexcept;
+    // Empty when out of range or not filled in.
+    std::string_view cell(int pattern, int row, int channel) const noexcept;
+    std::size_t memory_bytes() const noexcept;
+
+private:
+    int channels_;
+    std::vector<int> pattern_rows_;
+    // Index of each pattern's first cell in cell_offsets_.
+    std::vector<std::uint32_t> pattern_first_cell_;
+    // Start of each cell in text_, plus one past the last.
+    std::vector<std::uint32_t> cell_offsets_{0};
+    std::string text_;
+    std::vector<int> orders_;
+};
+
+}
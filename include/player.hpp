@@ -1,14 +1,26 @@
 #pragma once
 
 #include "note_formatter.hpp"
+#include "pattern_cache.hpp"
 #include "audio_effects.hpp"
 #include "audio_exporter.hpp"
+#include "playlist.hpp"
+#include "preview_source.hpp"
+#include "resampler.hpp"
+#include "song_minimap.hpp"
 
+#include <atomic>
 #include <complex>
 #include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
 #include <libopenmpt/libopenmpt.hpp>
@@ -32,6 +44,8 @@ struct PatternRowPreview {
 };
 
 struct TransportState {
+    // Player::state_version() when this state was last written.
+    std::uint64_t version{0};
     int order{-1};
     int pattern{-1};
     int row{-1};
@@ -46,8 +60,17 @@ struct TransportState {
     std::vector<float> waveform_right;
 };
 
+struct PlaylistStatus {
+    std::size_t position{0};
+    std::size_t count{0};
+    bool shuffle{false};
+    RepeatMode repeat{RepeatMode::Off};
+};
+
 class Player {
 public:
+    using EnvelopeLookup = std::function<bool(const std::string &path, std::vector<std::uint8_t> &levels)>;
+
     Player(const std::string &path, int sample_rate = 48000, int buffer_size = 1024);
     ~Player();
 
@@ -56,6 +79,7 @@ public:
     void toggle_pause();
     void jump_to_order(int delta);
     void jump_rows(int delta_rows);
+    void jump_to_position(int order, int row);
     
     void set_volume(double volume);
     double get_volume() const noexcept;
@@ -65,10 +89,44 @@ public:
     
     bool export_to_file(const ExportOptions& options, std::string& error_message);
 
+    // The player starts on the playlist's current entry and carries on with
+    // the following ones. The next file is read and parsed on a worker
+    // thread while the current one plays, so the switch happens between
+    // two buffers.
+    void set_playlist(std::shared_ptr<Playlist> playlist);
+    bool has_playlist() const;
+    PlaylistStatus playlist_status() const;
+    bool skip_track(int direction);
+    void toggle_shuffle();
+    void cycle_repeat();
+    // UI thread: adopts the metadata of a track the playback thread moved
+    // on to. Returns true when the track changed since the last call.
+    bool poll_track_change();
+
+    // Consulted before a track's envelope is rendered, normally backed by
+    // the library index. Set before start().
+    void set_envelope_lookup(EnvelopeLookup lookup) { envelope_lookup_ = std::move(lookup); }
+    // SongEnvelope levels of the current track; empty until the lookup or
+    // the background render started with the track has finished.
+    std::vector<std::uint8_t> song_envelope() const;
+    // Every pattern of the current track, formatted on a background thread
+    // started with the track; null until that has finished.
+    std::shared_ptr<const PatternCache> pattern_cache() const;
+    // Density overview of the order list, made from the pattern cache on
+    // the same thread; null until then.
+    std::shared_ptr<const SongMinimap> song_minimap() const;
+    // Bumped whenever pattern_cache() and song_minimap() are cleared or
+    // published, so a new cache is never mistaken for the previous one.
+    std::uint64_t pattern_cache_generation() const;
+
     TransportState snapshot() const;
+    // Bumped on every change to the snapshot, i.e. once per audio buffer
+    // while playing and not at all while paused.
+    std::uint64_t state_version() const noexcept { return state_version_.load(std::memory_order_acquire); }
     const std::vector<std::string> &instrument_names() const noexcept { return instrument_names_; }
     const std::vector<std::string> &sample_names() const noexcept { return sample_names_; }
     const std::vector<std::string> &module_message_lines() const noexcept { return module_message_lines_; }
+    const std::string &module_path() const noexcept { return module_path_; }
     const std::string &title() const noexcept { return title_; }
     const std::string &tracker_name() const noexcept { return tracker_name_; }
     const std::string &artist() const noexcept { return artist_; }
@@ -80,20 +138,42 @@ public:
     int num_patterns() const noexcept { return num_patterns_; }
     int num_orders() const noexcept { return num_orders_; }
     double duration_seconds() const noexcept { return duration_seconds_; }
+    int sample_rate() const noexcept { return sample_rate_; }
+    int device_sample_rate() const noexcept { return device_sample_rate_; }
 
 private:
+    struct Track;
+
+    static std::unique_ptr<Track> load_track(const std::string &path, const std::string &fallback_title);
+    void adopt_metadata(Track &track);
+    void install_track(std::unique_ptr<Track> track);
+    bool advance_track();
+    std::unique_ptr<Track> load_entry_locked(std::size_t index, std::unique_lock<std::mutex> &lock);
+    void schedule_prefetch_locked();
+    void prefetch_loop();
+    void stop_prefetch();
+    void request_envelope();
+    void cancel_envelope();
+    void request_pattern_cache();
+    void cancel_pattern_cache();
+
     void playback_loop();
     void update_state_locked();
+    void touch_state_locked();
     void update_spectrum(const float *audio_data, std::size_t sample_count);
     void update_waveform(const float *audio_data, std::size_t sample_count);
 
 private:
+    std::string module_path_;
     std::unique_ptr<openmpt::module> module_;
     PaStream *stream_{nullptr};
     bool pa_initialized_{false};
     std::thread playback_thread_;
     int sample_rate_;
+    int device_sample_rate_{0};
     int buffer_size_;
+    std::unique_ptr<Resampler> resampler_;
+    std::vector<float> resampled_buffer_;
 
     mutable std::mutex state_mutex_;
     std::condition_variable pause_cv_;
@@ -108,6 +188,7 @@ private:
 
     mutable std::mutex module_mutex_;
     TransportState state_{};
+    std::atomic<std::uint64_t> state_version_{0};
     std::vector<std::string> instrument_names_;
     std::vector<std::string> sample_names_;
     std::vector<std::string> module_message_lines_;
@@ -137,6 +218,63 @@ private:
     mutable std::mutex waveform_mutex_;
     
     std::vector<int> channel_instruments_;
+    // Names update_state_locked() matches against; guarded by module_mutex_
+    // because the playback thread replaces them on a track change.
+    std::vector<std::string> active_instrument_names_;
+
+    mutable std::mutex playlist_mutex_;
+    std::shared_ptr<Playlist> playlist_;
+    std::thread prefetch_thread_;
+    std::condition_variable prefetch_cv_;
+    std::optional<std::size_t> prefetch_index_;
+    PlaylistEntry prefetch_entry_;
+    bool prefetch_requested_{false};
+    bool prefetch_ready_{false};
+    bool prefetch_stop_{false};
+    std::unique_ptr<Track> prefetched_;
+    // Handed from whichever thread switched tracks to poll_track_change();
+    // guarded by state_mutex_.
+    std::unique_ptr<Track> pending_track_;
+
+    EnvelopeLookup envelope_lookup_;
+    mutable std::mutex envelope_mutex_;
+    std::vector<std::uint8_t> envelope_;
+    std::shared_ptr<std::atomic<bool>> envelope_cancelled_;
+    std::thread envelope_thread_;
+
+    mutable std::mutex pattern_cache_mutex_;
+    std::shared_ptr<const PatternCache> pattern_cache_;
+    std::shared_ptr<const SongMinimap> minimap_;
+    std::uint64_t pattern_cache_generation_{0};
+    std::shared_ptr<std::atomic<bool>> pattern_cache_cancelled_;
+    std::thread pattern_cache_thread_;
+};
+
+// Keeps one output stream running for the file browser's audition preview,
+// so moving the selection only swaps the module feeding it.
+class PreviewPlayer {
+public:
+    explicit PreviewPlayer(int sample_rate = 48000, int buffer_size = 512);
+    ~PreviewPlayer();
+
+    PreviewPlayer(const PreviewPlayer&) = delete;
+    PreviewPlayer& operator=(const PreviewPlayer&) = delete;
+
+    void preview(const std::filesystem::path& path) { source_.request(path); }
+    void stop_preview() { source_.stop(); }
+    void set_volume(double volume) { source_.set_volume(volume); }
+    PreviewSource& source() noexcept { return source_; }
+
+private:
+    void output_loop();
+
+    PreviewSource source_;
+    PaStream *stream_{nullptr};
+    int buffer_size_;
+    std::unique_ptr<Resampler> resampler_;
+    std::vector<float> resampled_buffer_;
+    std::atomic<bool> stop_requested_{false};
+    std::thread output_thread_;
 };
 
 }
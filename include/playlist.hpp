@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace tracker {
+
+struct PlaylistEntry {
+    std::filesystem::path path;
+    std::string title;
+};
+
+enum class RepeatMode {
+    Off,
+    All,
+    One
+};
+
+// Entries plus the order they play in. With shuffle the order is a random
+// permutation, so every entry plays once before any repeats, and a new pass
+// never opens with the entry that closed the previous one. peek_next()
+// always agrees with the following advance(), which is what lets the
+// player load the next file ahead of time.
+class Playlist {
+public:
+    Playlist();
+    explicit Playlist(std::uint64_t seed);
+
+    // M3U/M3U8 or PLS, chosen by extension. load() appends; relative paths
+    // are resolved against the playlist's directory.
+    bool load(const std::filesystem::path& file, std::string& error_message);
+    bool save(const std::filesystem::path& file, std::string& error_message) const;
+    static bool is_playlist_file(const std::filesystem::path& path);
+
+    void add(const std::filesystem::path& path, std::string title = {});
+    // Adds the module files under directory in natural name order.
+    std::size_t add_directory(const std::filesystem::path& directory, bool recursive = true);
+    bool remove(std::size_t index);
+    void clear();
+
+    std::size_t size() const noexcept { return entries_.size(); }
+    bool empty() const noexcept { return entries_.empty(); }
+    const std::vector<PlaylistEntry>& entries() const noexcept { return entries_; }
+    std::optional<std::size_t> find(const std::filesystem::path& path) const;
+
+    std::optional<std::size_t> current() const { return current_; }
+    // 1-based position of the current entry in the play order.
+    std::size_t position() const { return current_ ? cursor_ + 1 : 0; }
+    bool select(std::size_t index);
+
+    // What advance() will return once the current entry ends.
+    std::optional<std::size_t> peek_next() const;
+    std::optional<std::size_t> advance();
+    // Explicit skips ignore RepeatMode::One.
+    std::optional<std::size_t> next();
+    std::optional<std::size_t> previous();
+
+    void set_shuffle(bool enabled);
+    bool shuffle() const noexcept { return shuffle_; }
+    void set_repeat(RepeatMode mode);
+    RepeatMode repeat() const noexcept { return repeat_; }
+    static const char* repeat_mode_name(RepeatMode mode);
+    static bool parse_repeat_mode(const std::string& name, RepeatMode& mode);
+
+private:
+    std::optional<std::size_t> step(bool honour_repeat_one);
+    void rebuild_order();
+    void prepare_next_pass();
+
+    std::vector<PlaylistEntry> entries_;
+    std::vector<std::size_t> order_;
+    // The pass that follows order_ under shuffle + repeat-all, drawn early
+    // so peek_next() can see its first entry.
+    std::vector<std::size_t> next_order_;
+    std::size_t cursor_{0};
+    std::optional<std::size_t> current_;
+    bool shuffle_{false};
+    RepeatMode repeat_{RepeatMode::Off};
+    std::mt19937_64 rng_;
+};
+
+}
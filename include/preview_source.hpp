@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace openmpt {
+class module;
+}
+
+namespace tracker {
+
+// Audio source for auditioning files from the browser. request() only
+// records the path; a loader thread picks it up once it has been stable for
+// the debounce period (kDebounce unless given), so scrolling past files
+// never loads them. Loads that are
+// overtaken by a newer request are discarded, and a finished load is
+// swapped in at a representative point with a short fade-in. render() is
+// called from the audio thread and returns silence while nothing is loaded.
+class PreviewSource {
+public:
+    static constexpr auto kDebounce = std::chrono::milliseconds(50);
+    static constexpr double kStartFraction = 0.3;
+    static constexpr double kMinSecondsForSeek = 30.0;
+    static constexpr double kFadeInSeconds = 0.02;
+
+    explicit PreviewSource(int sample_rate, std::chrono::milliseconds debounce = kDebounce);
+    ~PreviewSource();
+
+    PreviewSource(const PreviewSource&) = delete;
+    PreviewSource& operator=(const PreviewSource&) = delete;
+
+    // Invoked from the loader thread when a load finishes or fails.
+    void set_update_callback(std::function<void()> callback);
+
+    // An empty path stops the preview.
+    void request(const std::filesystem::path& path);
+    void stop() { request({}); }
+    // Loads the current request now instead of waiting out the debounce.
+    void settle();
+
+    // Fills frames of interleaved stereo; returns the frames that came from
+    // a module rather than silence.
+    std::size_t render(float* interleaved, std::size_t frames);
+
+    void set_volume(double volume) { volume_.store(volume, std::memory_order_relaxed); }
+    int sample_rate() const noexcept { return sample_rate_; }
+
+    std::filesystem::path playing_path() const;
+    std::string error_message() const;
+    bool loading() const;
+
+    // Time from request() to the first rendered block of that file.
+    double last_start_latency_milliseconds() const { return last_start_latency_ms_.load(); }
+    std::size_t loads_completed() const { return loads_completed_.load(); }
+    std::size_t loads_discarded() const { return loads_discarded_.load(); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void loader_loop();
+    bool read_file(const std::filesystem::path& path, std::uint64_t generation, std::string& data);
+    bool is_current(std::uint64_t generation) const;
+
+    const int sample_rate_;
+    const std::chrono::milliseconds debounce_;
+    std::atomic<double> volume_{1.0};
+
+    mutable std::mutex request_mutex_;
+    std::condition_variable request_cv_;
+    std::filesystem::path requested_path_;
+    Clock::time_point requested_at_{};
+    bool settled_{false};
+    std::uint64_t generation_{0};
+    std::uint64_t loaded_generation_{0};
+    bool shutdown_{false};
+    std::string error_message_;
+    std::function<void()> on_update_;
+
+    // Held by render() for the duration of a read; the loader only takes it
+    // to swap modules, never while loading.
+    mutable std::mutex module_mutex_;
+    std::unique_ptr<openmpt::module> module_;
+    std::filesystem::path playing_path_;
+    std::size_t fade_frames_{0};
+    std::size_t fade_position_{0};
+    Clock::time_point started_request_at_{};
+    bool latency_pending_{false};
+
+    std::atomic<double> last_start_latency_ms_{0.0};
+    std::atomic<std::size_t> loads_completed_{0};
+    std::atomic<std::size_t> loads_discarded_{0};
+
+    std::thread loader_thread_;
+};
+
+}
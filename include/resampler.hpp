@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tracker {
+
+enum class ResamplerQuality {
+    Fast,
+    Balanced,
+    Best
+};
+
+// Streaming rational-ratio polyphase resampler for interleaved float audio.
+// Each output frame is a dot product of one Kaiser-windowed sinc phase with
+// a contiguous run of planar history, laid out so the compiler can vectorize
+// the inner loop. Output frame 0 is aligned with input frame 0; flush()
+// drains the filter so the total output length is ceil(input * out / in).
+class Resampler {
+public:
+    Resampler(int input_rate, int output_rate, int channels = 2,
+              ResamplerQuality quality = ResamplerQuality::Balanced);
+
+    // Appends resampled frames to output and returns how many were added.
+    std::size_t process(const float* input, std::size_t frame_count, std::vector<float>& output);
+    std::size_t flush(std::vector<float>& output);
+    void reset();
+
+    int input_rate() const noexcept { return input_rate_; }
+    int output_rate() const noexcept { return output_rate_; }
+    std::size_t taps() const noexcept { return taps_; }
+    std::size_t phases() const noexcept { return phases_; }
+
+    static bool parse_quality(const std::string& name, ResamplerQuality& quality);
+    static const char* quality_name(ResamplerQuality quality);
+
+private:
+    std::size_t produce(std::vector<float>& output, std::uint64_t limit);
+    void compact();
+
+    int input_rate_;
+    int output_rate_;
+    std::size_t channels_;
+    std::uint64_t upsample_;
+    std::uint64_t downsample_;
+    std::size_t taps_;
+    std::size_t phases_;
+    std::vector<float> coefficients_;
+
+    // Planar history per channel; element 0 sits at stored index
+    // history_offset_, where stored index = input frame + taps_ / 2.
+    std::vector<std::vector<float>> history_;
+    std::uint64_t history_offset_{0};
+    std::uint64_t input_frames_{0};
+    std::uint64_t output_frames_{0};
+    std::uint64_t integer_position_{0};
+    std::uint64_t fractional_position_{0};
+};
+
+}
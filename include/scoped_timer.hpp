@@ -0,0 +1,24 @@
+#pragma once
+
+#include <chrono>
+
+namespace tracker {
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(double& accumulator)
+        : accumulator_(accumulator), start_(std::chrono::steady_clock::now()) {}
+
+    ~ScopedTimer() {
+        accumulator_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    double& accumulator_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+}
@@ -9,6 +9,8 @@ public:
     SimpleUi(Player& player);
     void run();
 private:
+    void print_header();
+
     Player& player_;
     std::atomic<bool> running_{true};
 };
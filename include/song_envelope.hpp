@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tracker {
+
+// Coarse loudness overview of a whole song for the position bar: the RMS
+// level of kBuckets equal slices, mapped from kFloorDb..0 dBFS onto 0..255.
+// Fed with a mono render at kSampleRate, which is plenty for one level per
+// slice; the song length does not have to be known up front.
+class SongEnvelope {
+public:
+    static constexpr std::size_t kBuckets = 128;
+    static constexpr int kSampleRate = 8000;
+    static constexpr double kFloorDb = -48.0;
+
+    void add(const float* mono, std::size_t frames);
+    // kBuckets levels, or none if nothing was added.
+    std::vector<std::uint8_t> finish() const;
+
+    // One level per column, each the loudest of the buckets it covers.
+    static std::vector<std::uint8_t> resample(const std::vector<std::uint8_t>& levels, std::size_t width);
+    // " " for silence, otherwise one of "▁".."█".
+    static const char* glyph(std::uint8_t level);
+
+private:
+    static constexpr std::size_t kBlockFrames = kSampleRate / 20;
+
+    std::vector<double> block_energies_;
+    double energy_{0.0};
+    std::size_t frames_{0};
+};
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "pattern_cache.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace tracker {
+
+// Overview of the order list: one column per order, kBlocks cells high,
+// each the number of notes per row in that quarter of the order's pattern
+// relative to the busiest block of the song (0..255). Worked out per
+// pattern, so orders that repeat a pattern cost nothing extra.
+class SongMinimap {
+public:
+    static constexpr int kBlocks = 4;
+
+    SongMinimap() = default;
+    explicit SongMinimap(const PatternCache &cache);
+
+    int num_orders() const noexcept { return static_cast<int>(separators_.size()); }
+    // 0 for empty blocks, separators and orders out of range.
+    std::uint8_t level(int order, int block) const noexcept;
+    // Orders without a pattern, i.e. separator and skip entries.
+    bool is_separator(int order) const noexcept;
+    // " " for 0, otherwise one of "░", "▒", "▓", "█".
+    static const char *glyph(std::uint8_t level);
+
+private:
+    std::vector<std::uint8_t> levels_;
+    std::vector<std::uint8_t> separators_;
+};
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace tracker {
+
+// Growable float buffer backed by an unlinked, memory-mapped temp file, so a
+// full-length render can be held between export passes without pinning it in
+// RAM. The file disappears when the buffer is destroyed or the process exits.
+class SpillBuffer {
+public:
+    SpillBuffer() = default;
+    ~SpillBuffer();
+
+    SpillBuffer(const SpillBuffer&) = delete;
+    SpillBuffer& operator=(const SpillBuffer&) = delete;
+
+    bool open(std::size_t capacity, std::string& error_message);
+    bool append(const float* samples, std::size_t sample_count, std::string& error_message);
+
+    // Hints the kernel that the mapping will now be read front to back.
+    void prepare_for_read();
+
+    const float* data() const noexcept { return data_; }
+    std::size_t size() const noexcept { return size_; }
+
+private:
+    bool reserve(std::size_t capacity, std::string& error_message);
+    void release();
+
+    int fd_{-1};
+    float* data_{nullptr};
+    std::size_t capacity_{0};
+    std::size_t size_{0};
+};
+
+}
@@ -2,9 +2,13 @@
 
 #include "player.hpp"
 #include "config.hpp"
+#include "export_job_manager.hpp"
+#include "frame_profiler.hpp"
 
 #include <chrono>
+#include <cstdint>
 #include <deque>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -18,17 +22,44 @@ struct RowRender {
     int pattern{0};
     int row{0};
     std::vector<std::string> channels;
+    // Note colour of each channel's cell, worked out once on entering history.
+    std::vector<std::uint8_t> colors;
+    // Pattern grid cells for this row and the channel window they were
+    // built for; history rows never change, so they are reused until the
+    // window scrolls or resizes.
+    std::vector<ftxui::Element> cells;
+    int cells_offset{-1};
+    int cells_columns{0};
+    int cells_width{0};
+};
+
+// A panel's Element from an earlier frame, reused for as long as the inputs
+// it was built from hash to the same key.
+struct PanelCache {
+    std::uint64_t key{0};
+    ftxui::Element element;
+};
+
+// Settings for slow terminals, e.g. over SSH.
+struct UiOptions {
+    // 10 fps, no oscilloscope, spectrum and meters in coarse steps.
+    bool low_bandwidth{false};
+    // 256 or 16 to quantize every colour to that palette; anything else
+    // keeps what the terminal reports.
+    int colors{0};
 };
 
 class Ui {
 public:
-    explicit Ui(Player &player, Config &config, const std::string& module_filename = "output");
+    explicit Ui(Player &player, Config &config, const std::string& module_filename = "output",
+                UiOptions options = {});
     ~Ui();
 
     void run();
 
 private:
     void reset_ui_state();
+    void on_track_changed();
     void update_history(const TransportState &state);
     ftxui::Element render(const TransportState &state);
     ftxui::Element render_playback_info(const TransportState &state) const;
@@ -36,33 +67,51 @@ private:
     ftxui::Element render_oscilloscope(const TransportState &state) const;
     ftxui::Element render_active_instruments(const TransportState &state) const;
     ftxui::Element render_pattern_grid(const TransportState &state);
+    ftxui::Element render_pattern_browser(const TransportState &state);
+    ftxui::Element render_minimap(const TransportState &state);
+    void move_browse_cursor(const PatternCache &cache, int delta_rows);
     ftxui::Element render_status_bar();
     ftxui::Element render_footer() const;
     ftxui::Element render_info_overlay(const TransportState &state);
     ftxui::Element render_about_overlay();
+    ftxui::Element render_profiler_overlay() const;
     ftxui::Element render_export_dialog();
+    ftxui::Element render_jobs_panel();
+    void start_export();
+    void poll_export_jobs();
     ftxui::Elements render_history_rows(const TransportState &state, int columns, int column_width);
     ftxui::Element render_visualizers(const TransportState &state, int columns, int column_width);
-    ftxui::Color color_for_note(const std::string &cell) const;
-    std::vector<ftxui::Decorator> decorators_for_row_index(int offset_from_center, int max_distance) const;
+    bool emphasized_row(int offset_from_center) const;
     void update_visualizer_peaks(const TransportState &state, int total_channels);
     void set_status_message(const std::string &message,
                             std::chrono::milliseconds duration = std::chrono::milliseconds(2000));
+    template <typename Build>
+    ftxui::Element cached_panel(PanelCache &cache, std::size_t phase, std::uint64_t key, Build build);
+    std::uint64_t meters_key() const;
+    int meter_steps() const;
+    void update_frame_stats(std::chrono::steady_clock::time_point now, bool active);
 
 private:
     Player &player_;
     Config &config_;
+    UiOptions options_;
     bool running_{true};
     bool info_overlay_{false};
     int info_scroll_position_{0};
     bool about_overlay_{false};
+    bool profiler_overlay_{false};
+    bool pattern_browser_{false};
+    int browse_order_{0};
+    int browse_row_{0};
+    bool minimap_{false};
+    int minimap_cursor_{0};
     bool export_dialog_{false};
     int export_format_selection_{0};
     std::string export_filename_{"output"};
-    bool export_in_progress_{false};
-    std::size_t export_current_{0};
-    std::size_t export_total_{0};
     std::string export_error_;
+    std::unique_ptr<ExportJobManager> export_jobs_;
+    bool jobs_panel_{false};
+    int jobs_selection_{0};
     std::string status_message_;
     std::chrono::steady_clock::time_point status_message_until_{};
     std::deque<RowRender> history_;
@@ -79,6 +128,30 @@ private:
     int channel_offset_{0};
     int page_columns_{4};
     double last_volume_{1.0};
+    std::uint64_t track_generation_{0};
+    std::uint64_t last_meters_key_{0};
+    PanelCache playback_panel_;
+    PanelCache instruments_panel_;
+    PanelCache visualizer_panel_;
+    PanelCache oscilloscope_panel_;
+    PanelCache pattern_panel_;
+    PanelCache minimap_panel_;
+    PanelCache status_panel_;
+    PanelCache footer_panel_;
+    // Frame statistics over the last second, shown in the info overlay.
+    std::chrono::steady_clock::time_point stats_started_{};
+    std::int64_t stats_cpu_ns_{0};
+    int stats_frames_{0};
+    int stats_panels_built_{0};
+    int stats_panels_reused_{0};
+    std::uint64_t stats_bytes_{0};
+    double frames_per_second_{0.0};
+    double ui_cpu_percent_{0.0};
+    double panels_reused_percent_{0.0};
+    double output_bytes_per_second_{0.0};
+    bool active_frame_rate_{true};
+    FrameProfiler profiler_;
+    FrameProfiler::Clock::time_point last_render_end_{};
 };
 
 }
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace tracker {
+
+// Runs task(index, worker) for every index in [0, count). Each worker starts
+// with a contiguous slice in its own deque, pops from the back of it, and
+// steals from the front of other workers' deques once it runs dry, so one
+// slow item does not hold back the rest of its slice. The calling thread
+// acts as worker 0.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(std::size_t thread_count = 0);
+
+    std::size_t thread_count() const noexcept { return thread_count_; }
+
+    void run(std::size_t count, const std::function<void(std::size_t index, std::size_t worker)>& task) const;
+
+private:
+    std::size_t thread_count_;
+};
+
+}
@@ -1,8 +1,12 @@
 #include "audio_exporter.hpp"
+#include "scoped_timer.hpp"
 #include <fstream>
 #include <cstring>
 #include <algorithm>
 #include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <sys/resource.h>
 
 #ifdef HAVE_LAME
 #include <lame/lame.h>
@@ -14,6 +18,106 @@
 
 namespace tracker {
 
+#ifdef HAVE_FLAC
+namespace {
+
+struct FlacSink {
+    std::ofstream* file;
+    ExportStats* stats;
+};
+
+FLAC__StreamEncoderWriteStatus flac_write(const FLAC__StreamEncoder*, const FLAC__byte buffer[], size_t bytes,
+                                          std::uint32_t, std::uint32_t, void* client_data) {
+    auto* sink = static_cast<FlacSink*>(client_data);
+    ScopedTimer io(sink->stats->io_seconds);
+    sink->file->write(reinterpret_cast<const char*>(buffer), static_cast<std::streamsize>(bytes));
+    sink->stats->bytes_written += bytes;
+    return *sink->file ? FLAC__STREAM_ENCODER_WRITE_STATUS_OK : FLAC__STREAM_ENCODER_WRITE_STATUS_FATAL_ERROR;
+}
+
+FLAC__StreamEncoderSeekStatus flac_seek(const FLAC__StreamEncoder*, FLAC__uint64 offset, void* client_data) {
+    auto* sink = static_cast<FlacSink*>(client_data);
+    sink->file->seekp(static_cast<std::streamoff>(offset));
+    return *sink->file ? FLAC__STREAM_ENCODER_SEEK_STATUS_OK : FLAC__STREAM_ENCODER_SEEK_STATUS_ERROR;
+}
+
+FLAC__StreamEncoderTellStatus flac_tell(const FLAC__StreamEncoder*, FLAC__uint64* offset, void* client_data) {
+    auto* sink = static_cast<FlacSink*>(client_data);
+    auto position = sink->file->tellp();
+    if (position < 0) {
+        return FLAC__STREAM_ENCODER_TELL_STATUS_ERROR;
+    }
+    *offset = static_cast<FLAC__uint64>(position);
+    return FLAC__STREAM_ENCODER_TELL_STATUS_OK;
+}
+
+}
+#endif
+
+double ExportStats::realtime_factor() const {
+    return wall_seconds > 0.0 ? audio_seconds / wall_seconds : 0.0;
+}
+
+double ExportStats::write_megabytes_per_second() const {
+    return wall_seconds > 0.0 ? static_cast<double>(bytes_written) / (1024.0 * 1024.0) / wall_seconds : 0.0;
+}
+
+std::string ExportStats::summary() const {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(1) << realtime_factor() << "x realtime, "
+        << write_megabytes_per_second() << " MB/s, "
+        << std::setprecision(2) << "render " << render_seconds << "s, effects " << effect_seconds
+        << "s, encode " << encode_seconds << "s, io " << io_seconds << "s, "
+        << std::setprecision(1) << "process peak RSS " << static_cast<double>(process_peak_rss_bytes) / (1024.0 * 1024.0) << " MB";
+    if (normalized) {
+        oss << ", " << measured_lufs << " LUFS / " << measured_true_peak_db << " dBTP, gain "
+            << std::showpos << applied_gain_db << std::noshowpos << " dB";
+    }
+    return oss.str();
+}
+
+std::string ExportStats::to_json() const {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(6)
+        << "{\"audio_seconds\":" << audio_seconds
+        << ",\"wall_seconds\":" << wall_seconds
+        << ",\"render_seconds\":" << render_seconds
+        << ",\"effect_seconds\":" << effect_seconds
+        << ",\"encode_seconds\":" << encode_seconds
+        << ",\"io_seconds\":" << io_seconds
+        << ",\"analysis_seconds\":" << analysis_seconds
+        << ",\"resample_seconds\":" << resample_seconds
+        << ",\"bytes_written\":" << bytes_written
+        << ",\"process_peak_rss_bytes\":" << process_peak_rss_bytes
+        << ",\"realtime_factor\":" << realtime_factor()
+        << ",\"write_mb_per_second\":" << write_megabytes_per_second();
+    if (normalized) {
+        // JSON has no infinity; silent input reports null loudness.
+        auto number_or_null = [&oss](double value) {
+            if (std::isfinite(value)) {
+                oss << value;
+            } else {
+                oss << "null";
+            }
+        };
+        oss << ",\"normalization\":{\"measured_lufs\":";
+        number_or_null(measured_lufs);
+        oss << ",\"measured_true_peak_db\":";
+        number_or_null(measured_true_peak_db);
+        oss << ",\"applied_gain_db\":" << applied_gain_db << "}";
+    }
+    oss << "}";
+    return oss.str();
+}
+
+std::uint64_t ExportStats::read_process_peak_rss_bytes() {
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024;
+}
+
 bool AudioExporter::is_format_supported(ExportFormat format) {
     switch (format) {
         case ExportFormat::WAV:
@@ -74,6 +178,41 @@ void AudioExporter::write_le32(std::vector<std::uint8_t>& buffer, std::uint32_t
     buffer.push_back((value >> 24) & 0xFF);
 }
 
+struct AudioExporter::EncoderState {
+    ExportOptions options;
+    std::ofstream file;
+    std::uint64_t data_bytes = 0;
+    std::vector<std::int16_t> pcm;
+#ifdef HAVE_LAME
+    lame_t lame = nullptr;
+    std::vector<float> left_channel;
+    std::vector<float> right_channel;
+    std::vector<unsigned char> mp3_buffer;
+#endif
+#ifdef HAVE_FLAC
+    FLAC__StreamEncoder* flac = nullptr;
+    FlacSink sink{};
+    std::vector<FLAC__int32> flac_pcm;
+#endif
+
+    ~EncoderState() {
+#ifdef HAVE_LAME
+        if (lame) {
+            lame_close(lame);
+        }
+#endif
+#ifdef HAVE_FLAC
+        if (flac) {
+            FLAC__stream_encoder_delete(flac);
+        }
+#endif
+    }
+};
+
+AudioExporter::AudioExporter() = default;
+
+AudioExporter::~AudioExporter() = default;
+
 bool AudioExporter::export_audio(const std::vector<float>& audio_data,
                                  const ExportOptions& options,
                                  std::string& error_message) {
@@ -81,7 +220,29 @@ bool AudioExporter::export_audio(const std::vector<float>& audio_data,
         error_message = "No audio data to export";
         return false;
     }
-    
+
+    if (!begin(options, error_message)) {
+        return false;
+    }
+
+    const std::size_t chunk_samples = 4096 * static_cast<std::size_t>(options.channels);
+    for (std::size_t i = 0; i < audio_data.size(); i += chunk_samples) {
+        if (options.progress_callback && !options.progress_callback(i, audio_data.size())) {
+            error_message = "Export cancelled by user";
+            abort();
+            return false;
+        }
+
+        if (!write(audio_data.data() + i, std::min(chunk_samples, audio_data.size() - i), error_message)) {
+            abort();
+            return false;
+        }
+    }
+
+    return finish(error_message);
+}
+
+bool AudioExporter::begin(const ExportOptions& options, std::string& error_message) {
     if (options.output_path.empty()) {
         error_message = "Output path not specified";
         return false;
@@ -91,40 +252,105 @@ bool AudioExporter::export_audio(const std::vector<float>& audio_data,
         error_message = "Format not supported (missing library)";
         return false;
     }
+
+    if (options.channels < 1 || options.channels > 2) {
+        error_message = "Unsupported channel count";
+        return false;
+    }
     
+    stats_ = ExportStats{};
+    state_ = std::make_unique<EncoderState>();
+    state_->options = options;
+
+    bool success = false;
     switch (options.format) {
         case ExportFormat::WAV:
-            return export_wav(audio_data, options, error_message);
+            success = begin_wav(error_message);
+            break;
         case ExportFormat::MP3:
-            return export_mp3(audio_data, options, error_message);
+            success = begin_mp3(error_message);
+            break;
         case ExportFormat::FLAC:
-            return export_flac(audio_data, options, error_message);
+            success = begin_flac(error_message);
+            break;
     }
-    
+
+    if (!success) {
+        state_.reset();
+    }
+    return success;
+}
+
+bool AudioExporter::write(const float* samples, std::size_t sample_count, std::string& error_message) {
+    if (!state_) {
+        error_message = "Export not started";
+        return false;
+    }
+    if (sample_count == 0) {
+        return true;
+    }
+
+    switch (state_->options.format) {
+        case ExportFormat::WAV:  return write_wav(samples, sample_count, error_message);
+        case ExportFormat::MP3:  return write_mp3(samples, sample_count, error_message);
+        case ExportFormat::FLAC: return write_flac(samples, sample_count, error_message);
+    }
+
     error_message = "Unknown export format";
     return false;
 }
 
-bool AudioExporter::export_wav(const std::vector<float>& audio_data,
-                               const ExportOptions& options,
-                               std::string& error_message) {
+bool AudioExporter::finish(std::string& error_message) {
+    if (!state_) {
+        error_message = "Export not started";
+        return false;
+    }
+
+    bool success = false;
+    switch (state_->options.format) {
+        case ExportFormat::WAV:
+            success = finish_wav(error_message);
+            break;
+        case ExportFormat::MP3:
+            success = finish_mp3(error_message);
+            break;
+        case ExportFormat::FLAC:
+            success = finish_flac(error_message);
+            break;
+    }
+
+    state_.reset();
+    return success;
+}
+
+void AudioExporter::abort() {
+    if (!state_) {
+        return;
+    }
+
+    std::string output_path = state_->options.output_path;
+    state_.reset();
+    std::remove(output_path.c_str());
+}
+
+bool AudioExporter::begin_wav(std::string& error_message) {
     try {
-        std::ofstream file(options.output_path, std::ios::binary);
-        if (!file) {
+        const ExportOptions& options = state_->options;
+        state_->file.open(options.output_path, std::ios::binary);
+        if (!state_->file) {
             error_message = "Failed to open output file";
             return false;
         }
         
-        const std::uint32_t sample_count = audio_data.size() / options.channels;
         const std::uint16_t bits_per_sample = 16;
         const std::uint32_t byte_rate = options.sample_rate * options.channels * (bits_per_sample / 8);
         const std::uint16_t block_align = options.channels * (bits_per_sample / 8);
-        const std::uint32_t data_size = sample_count * options.channels * (bits_per_sample / 8);
         
+        // Sizes are patched in finish_wav once the data length is known.
         std::vector<std::uint8_t> header;
         
         header.insert(header.end(), {'R', 'I', 'F', 'F'});
-        write_le32(header, 36 + data_size);
+        write_le32(header, 36);
         header.insert(header.end(), {'W', 'A', 'V', 'E'});
         
         header.insert(header.end(), {'f', 'm', 't', ' '});
@@ -137,31 +363,14 @@ bool AudioExporter::export_wav(const std::vector<float>& audio_data,
         write_le16(header, bits_per_sample);
         
         header.insert(header.end(), {'d', 'a', 't', 'a'});
-        write_le32(header, data_size);
-        
-        file.write(reinterpret_cast<const char*>(header.data()), header.size());
+        write_le32(header, 0);
         
-        std::vector<std::int16_t> pcm_data;
-        pcm_data.reserve(audio_data.size());
-        
-        for (std::size_t i = 0; i < audio_data.size(); ++i) {
-            if (options.progress_callback && i % 4800 == 0) {
-                if (!options.progress_callback(i, audio_data.size())) {
-                    error_message = "Export cancelled by user";
-                    file.close();
-                    std::remove(options.output_path.c_str());
-                    return false;
-                }
-            }
-            
-            pcm_data.push_back(float_to_int16(audio_data[i]));
+        {
+            ScopedTimer io(stats_.io_seconds);
+            state_->file.write(reinterpret_cast<const char*>(header.data()), header.size());
         }
-        
-        file.write(reinterpret_cast<const char*>(pcm_data.data()), 
-                  pcm_data.size() * sizeof(std::int16_t));
-        
-        file.close();
-        return true;
+        stats_.bytes_written += header.size();
+        return static_cast<bool>(state_->file);
         
     } catch (const std::exception& e) {
         error_message = std::string("WAV export failed: ") + e.what();
@@ -169,165 +378,206 @@ bool AudioExporter::export_wav(const std::vector<float>& audio_data,
     }
 }
 
-bool AudioExporter::export_mp3(const std::vector<float>& audio_data,
-                               const ExportOptions& options,
-                               std::string& error_message) {
+bool AudioExporter::write_wav(const float* samples, std::size_t sample_count, std::string& error_message) {
+    const std::uint64_t chunk_bytes = sample_count * sizeof(std::int16_t);
+    if (state_->data_bytes + chunk_bytes > 0xFFFFFFFFull - 36) {
+        error_message = "WAV output exceeds 4 GB";
+        return false;
+    }
+
+    {
+        ScopedTimer encode(stats_.encode_seconds);
+        state_->pcm.resize(sample_count);
+        for (std::size_t i = 0; i < sample_count; ++i) {
+            state_->pcm[i] = float_to_int16(samples[i]);
+        }
+    }
+    
+    {
+        ScopedTimer io(stats_.io_seconds);
+        state_->file.write(reinterpret_cast<const char*>(state_->pcm.data()), 
+                           static_cast<std::streamsize>(chunk_bytes));
+    }
+    state_->data_bytes += chunk_bytes;
+    stats_.bytes_written += chunk_bytes;
+    
+    if (!state_->file) {
+        error_message = "Failed to write output file";
+        return false;
+    }
+    return true;
+}
+
+bool AudioExporter::finish_wav(std::string& error_message) {
+    const auto data_size = static_cast<std::uint32_t>(state_->data_bytes);
+    std::vector<std::uint8_t> riff_size;
+    std::vector<std::uint8_t> data_chunk_size;
+    write_le32(riff_size, 36 + data_size);
+    write_le32(data_chunk_size, data_size);
+
+    {
+        ScopedTimer io(stats_.io_seconds);
+        state_->file.seekp(4);
+        state_->file.write(reinterpret_cast<const char*>(riff_size.data()), riff_size.size());
+        state_->file.seekp(40);
+        state_->file.write(reinterpret_cast<const char*>(data_chunk_size.data()), data_chunk_size.size());
+        state_->file.close();
+    }
+
+    if (!state_->file) {
+        error_message = "Failed to write output file";
+        return false;
+    }
+    return true;
+}
+
+bool AudioExporter::begin_mp3(std::string& error_message) {
 #ifdef HAVE_LAME
     try {
-        lame_t lame = lame_init();
-        if (!lame) {
+        const ExportOptions& options = state_->options;
+        state_->lame = lame_init();
+        if (!state_->lame) {
             error_message = "Failed to initialize LAME encoder";
             return false;
         }
         
-        lame_set_num_channels(lame, options.channels);
-        lame_set_in_samplerate(lame, options.sample_rate);
-        lame_set_brate(lame, options.mp3_bitrate);
-        lame_set_mode(lame, options.channels == 2 ? STEREO : MONO);
-        lame_set_quality(lame, 2);
+        lame_set_num_channels(state_->lame, options.channels);
+        lame_set_in_samplerate(state_->lame, options.sample_rate);
+        lame_set_brate(state_->lame, options.mp3_bitrate);
+        lame_set_mode(state_->lame, options.channels == 2 ? STEREO : MONO);
+        lame_set_quality(state_->lame, 2);
         
-        if (lame_init_params(lame) < 0) {   
+        if (lame_init_params(state_->lame) < 0) {   
             error_message = "Failed to set LAME parameters";
-            lame_close(lame);
             return false;
         }
         
-        std::ofstream file(options.output_path, std::ios::binary);
-        if (!file) {
+        state_->file.open(options.output_path, std::ios::binary);
+        if (!state_->file) {
             error_message = "Failed to open output file";
-            lame_close(lame);
             return false;
         }
+        return true;
         
-        const std::size_t sample_count = audio_data.size() / options.channels;
-        std::vector<float> left_channel(sample_count);
-        std::vector<float> right_channel(sample_count);
-        
-        for (std::size_t i = 0; i < sample_count; ++i) {
-            left_channel[i] = audio_data[i * options.channels];
-            if (options.channels == 2) {
-                right_channel[i] = audio_data[i * options.channels + 1];
-            }
-        }
-        
-        std::vector<unsigned char> result;
-        
-        const std::size_t chunk_size = 1152;
-        std::vector<unsigned char> mp3_buffer(chunk_size * 2 * 5 / 4 + 7200);
-        
-        for (std::size_t i = 0; i < sample_count; i += chunk_size) {
-            if (options.progress_callback) {
-                if (!options.progress_callback(i * options.channels, audio_data.size())) {
-                    error_message = "Export cancelled by user";
-                    file.close();
-                    lame_close(lame);
-                    std::remove(options.output_path.c_str());
-                    return false;
-                }
-            }
-            
-            std::size_t samples_to_encode = std::min(chunk_size, sample_count - i);
-            
-            int encoded_bytes = lame_encode_buffer_ieee_float(
-                lame,
-                left_channel.data() + i,
-                options.channels == 2 ? right_channel.data() + i : left_channel.data() + i,
-                samples_to_encode,
-                mp3_buffer.data(),
-                mp3_buffer.size()
-            );
-            
-            if (encoded_bytes < 0) {
-                error_message = "LAME encoding error";
-                file.close();
-                lame_close(lame);
-                return false;
-            }
-            
-            if (encoded_bytes > 0) {
-                file.write(reinterpret_cast<const char*>(mp3_buffer.data()), encoded_bytes);
-            }
+    } catch (const std::exception& e) {
+        error_message = std::string("MP3 export failed: ") + e.what();
+        return false;
+    }
+#else
+    error_message = "MP3 support not compiled (LAME library required)";
+    return false;
+#endif
+}
+
+bool AudioExporter::write_mp3(const float* samples, std::size_t sample_count, std::string& error_message) {
+#ifdef HAVE_LAME
+    const std::size_t channels = static_cast<std::size_t>(state_->options.channels);
+    const std::size_t frame_count = sample_count / channels;
+    
+    int encoded_bytes;
+    {
+        ScopedTimer encode(stats_.encode_seconds);
+        state_->left_channel.resize(frame_count);
+        state_->right_channel.resize(frame_count);
+        for (std::size_t i = 0; i < frame_count; ++i) {
+            state_->left_channel[i] = samples[i * channels];
+            state_->right_channel[i] = samples[i * channels + channels - 1];
         }
         
-        int encoded_bytes = lame_encode_flush(lame, mp3_buffer.data(), mp3_buffer.size());
+        state_->mp3_buffer.resize(frame_count * 5 / 4 + 7200);
+        encoded_bytes = lame_encode_buffer_ieee_float(
+            state_->lame,
+            state_->left_channel.data(),
+            state_->right_channel.data(),
+            static_cast<int>(frame_count),
+            state_->mp3_buffer.data(),
+            static_cast<int>(state_->mp3_buffer.size())
+        );
+    }
+    
+    if (encoded_bytes < 0) {
+        error_message = "LAME encoding error";
+        return false;
+    }
+    
+    if (encoded_bytes > 0) {
+        ScopedTimer io(stats_.io_seconds);
+        state_->file.write(reinterpret_cast<const char*>(state_->mp3_buffer.data()), encoded_bytes);
+        stats_.bytes_written += static_cast<std::uint64_t>(encoded_bytes);
+    }
+    
+    if (!state_->file) {
+        error_message = "Failed to write output file";
+        return false;
+    }
+    return true;
+#else
+    (void)samples;
+    (void)sample_count;
+    error_message = "MP3 support not compiled (LAME library required)";
+    return false;
+#endif
+}
+
+bool AudioExporter::finish_mp3(std::string& error_message) {
+#ifdef HAVE_LAME
+    state_->mp3_buffer.resize(7200);
+    int encoded_bytes;
+    {
+        ScopedTimer encode(stats_.encode_seconds);
+        encoded_bytes = lame_encode_flush(state_->lame, state_->mp3_buffer.data(),
+                                          static_cast<int>(state_->mp3_buffer.size()));
+    }
+    {
+        ScopedTimer io(stats_.io_seconds);
         if (encoded_bytes > 0) {
-            file.write(reinterpret_cast<const char*>(mp3_buffer.data()), encoded_bytes);
+            state_->file.write(reinterpret_cast<const char*>(state_->mp3_buffer.data()), encoded_bytes);
+            stats_.bytes_written += static_cast<std::uint64_t>(encoded_bytes);
         }
-        
-        file.close();
-        lame_close(lame);
-        return true;
-        
-    } catch (const std::exception& e) {
-        error_message = std::string("MP3 export failed: ") + e.what();
+        state_->file.close();
+    }
+    
+    if (!state_->file) {
+        error_message = "Failed to write output file";
         return false;
     }
+    return true;
 #else
     error_message = "MP3 support not compiled (LAME library required)";
     return false;
 #endif
 }
 
-bool AudioExporter::export_flac(const std::vector<float>& audio_data,
-                                const ExportOptions& options,
-                                std::string& error_message) {
+bool AudioExporter::begin_flac(std::string& error_message) {
 #ifdef HAVE_FLAC
     try {
-        FLAC__StreamEncoder* encoder = FLAC__stream_encoder_new();
-        if (!encoder) {
+        const ExportOptions& options = state_->options;
+        state_->flac = FLAC__stream_encoder_new();
+        if (!state_->flac) {
             error_message = "Failed to create FLAC encoder";
             return false;
         }
         
-        FLAC__stream_encoder_set_channels(encoder, options.channels);
-        FLAC__stream_encoder_set_bits_per_sample(encoder, 16);
-        FLAC__stream_encoder_set_sample_rate(encoder, options.sample_rate);
-        FLAC__stream_encoder_set_compression_level(encoder, options.flac_compression_level);
+        FLAC__stream_encoder_set_channels(state_->flac, options.channels);
+        FLAC__stream_encoder_set_bits_per_sample(state_->flac, 16);
+        FLAC__stream_encoder_set_sample_rate(state_->flac, options.sample_rate);
+        FLAC__stream_encoder_set_compression_level(state_->flac, options.flac_compression_level);
         
-        FLAC__StreamEncoderInitStatus init_status = 
-            FLAC__stream_encoder_init_file(encoder, options.output_path.c_str(), nullptr, nullptr);
+        state_->file.open(options.output_path, std::ios::binary);
+        if (!state_->file) {
+            error_message = "Failed to open output file";
+            return false;
+        }
+        
+        state_->sink = FlacSink{&state_->file, &stats_};
+        FLAC__StreamEncoderInitStatus init_status = FLAC__stream_encoder_init_stream(
+            state_->flac, flac_write, flac_seek, flac_tell, nullptr, &state_->sink);
         
         if (init_status != FLAC__STREAM_ENCODER_INIT_STATUS_OK) {
             error_message = "Failed to initialize FLAC encoder: ";
             error_message += FLAC__StreamEncoderInitStatusString[init_status];
-            FLAC__stream_encoder_delete(encoder);
             return false;
         }
-        
-        const std::size_t sample_count = audio_data.size() / options.channels;
-        std::vector<FLAC__int32> pcm_buffer(audio_data.size());
-        
-        for (std::size_t i = 0; i < audio_data.size(); ++i) {
-            pcm_buffer[i] = static_cast<FLAC__int32>(float_to_int16(audio_data[i]));
-        }
-        
-        const std::size_t chunk_size = 4096;
-        for (std::size_t i = 0; i < sample_count; i += chunk_size) {
-            if (options.progress_callback) {
-                if (!options.progress_callback(i * options.channels, audio_data.size())) {
-                    error_message = "Export cancelled by user";
-                    FLAC__stream_encoder_finish(encoder);
-                    FLAC__stream_encoder_delete(encoder);
-                    std::remove(options.output_path.c_str());
-                    return false;
-                }
-            }
-            
-            std::size_t samples_to_encode = std::min(chunk_size, sample_count - i);
-            
-            if (!FLAC__stream_encoder_process_interleaved(
-                    encoder,
-                    pcm_buffer.data() + (i * options.channels),
-                    samples_to_encode)) {
-                error_message = "FLAC encoding error";
-                FLAC__stream_encoder_finish(encoder);
-                FLAC__stream_encoder_delete(encoder);
-                return false;
-            }
-        }
-        
-        FLAC__stream_encoder_finish(encoder);
-        FLAC__stream_encoder_delete(encoder);
         return true;
         
     } catch (const std::exception& e) {
@@ -340,4 +590,63 @@ bool AudioExporter::export_flac(const std::vector<float>& audio_data,
 #endif
 }
 
+bool AudioExporter::write_flac(const float* samples, std::size_t sample_count, std::string& error_message) {
+#ifdef HAVE_FLAC
+    const std::size_t channels = static_cast<std::size_t>(state_->options.channels);
+    const double io_before = stats_.io_seconds;
+    bool encoded;
+    {
+        ScopedTimer encode(stats_.encode_seconds);
+        state_->flac_pcm.resize(sample_count);
+        for (std::size_t i = 0; i < sample_count; ++i) {
+            state_->flac_pcm[i] = static_cast<FLAC__int32>(float_to_int16(samples[i]));
+        }
+        
+        encoded = FLAC__stream_encoder_process_interleaved(
+            state_->flac,
+            state_->flac_pcm.data(),
+            static_cast<std::uint32_t>(sample_count / channels));
+    }
+    stats_.encode_seconds -= stats_.io_seconds - io_before;
+    
+    if (!encoded) {
+        error_message = "FLAC encoding error";
+        return false;
+    }
+    return true;
+#else
+    (void)samples;
+    (void)sample_count;
+    error_message = "FLAC support not compiled (libFLAC library required)";
+    return false;
+#endif
+}
+
+bool AudioExporter::finish_flac(std::string& error_message) {
+#ifdef HAVE_FLAC
+    const double io_before = stats_.io_seconds;
+    bool finished;
+    {
+        ScopedTimer encode(stats_.encode_seconds);
+        finished = FLAC__stream_encoder_finish(state_->flac);
+    }
+    stats_.encode_seconds -= stats_.io_seconds - io_before;
+    FLAC__stream_encoder_delete(state_->flac);
+    state_->flac = nullptr;
+    
+    {
+        ScopedTimer io(stats_.io_seconds);
+        state_->file.close();
+    }
+    if (!finished || !state_->file) {
+        error_message = "Failed to write output file";
+        return false;
+    }
+    return true;
+#else
+    error_message = "FLAC support not compiled (libFLAC library required)";
+    return false;
+#endif
+}
+
 } 
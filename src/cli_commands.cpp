@@ -0,0 +1,506 @@
+#include "cli_commands.hpp"
+#include "directory_watcher.hpp"
+#include "duplicate_finder.hpp"
+#include "file_browser.hpp"
+#include "library_indexer.hpp"
+#include "library_query.hpp"
+#include "module_metadata.hpp"
+#include "offline_renderer.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <utility>
+
+namespace tracker {
+
+namespace {
+
+std::string json_escape(const std::string& value) {
+    std::ostringstream oss;
+    for (unsigned char c : value) {
+        switch (c) {
+            case '"':  oss << "\\\""; break;
+            case '\\': oss << "\\\\"; break;
+            case '\n': oss << "\\n"; break;
+            case '\r': oss << "\\r"; break;
+            case '\t': oss << "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    oss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+                } else {
+                    oss << c;
+                }
+        }
+    }
+    return oss.str();
+}
+
+bool format_from_path(const std::string& path, ExportFormat& format) {
+    std::string ext = std::filesystem::path(path).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+    if (ext == ".wav") {
+        format = ExportFormat::WAV;
+    } else if (ext == ".mp3") {
+        format = ExportFormat::MP3;
+    } else if (ext == ".flac") {
+        format = ExportFormat::FLAC;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Splits "out.flac@44100" into path and rate; the suffix is only taken as a
+// rate when it is all digits, so paths containing '@' still work.
+bool parse_output_spec(const std::string& spec, int default_rate, std::string& path, int& rate) {
+    path = spec;
+    rate = default_rate;
+    std::size_t at = spec.rfind('@');
+    if (at == std::string::npos || at + 1 == spec.size()) {
+        return true;
+    }
+    std::string suffix = spec.substr(at + 1);
+    if (!std::all_of(suffix.begin(), suffix.end(), ::isdigit)) {
+        return true;
+    }
+    path = spec.substr(0, at);
+    auto [ptr, ec] = std::from_chars(suffix.data(), suffix.data() + suffix.size(), rate);
+    return ec == std::errc() && rate >= 8000 && rate <= 384000;
+}
+
+}
+
+int run_export_command(const std::filesystem::path& module_path, ExportOptions options,
+                       const std::vector<std::string>& output_specs, bool json_output) {
+    options.channels = 2;
+
+    std::string error_message;
+    bool success = !output_specs.empty();
+    if (!success) {
+        error_message = "No output specified";
+    }
+
+    std::vector<ExportOptions> outputs;
+    for (const auto& spec : output_specs) {
+        ExportOptions output = options;
+        if (!parse_output_spec(spec, options.sample_rate, output.output_path, output.sample_rate)) {
+            error_message = "Invalid output rate in " + spec;
+            success = false;
+            break;
+        }
+        if (!format_from_path(output.output_path, output.format)) {
+            error_message = "Unknown output format for " + output.output_path + " (use .wav, .mp3 or .flac)";
+            success = false;
+            break;
+        }
+        outputs.push_back(std::move(output));
+    }
+
+    int last_percent = -1;
+    if (!json_output) {
+        options.progress_callback = [&last_percent](std::size_t current, std::size_t total) {
+            int percent = total > 0 ? static_cast<int>(current * 100 / total) : 0;
+            if (percent != last_percent) {
+                last_percent = percent;
+                std::cerr << "\rExporting... " << std::setw(3) << percent << "%" << std::flush;
+            }
+            return true;
+        };
+    }
+
+    OfflineRenderer renderer(module_path.string());
+    if (success && outputs.size() == 1) {
+        outputs.front().progress_callback = options.progress_callback;
+        success = renderer.render_to_file(outputs.front(), error_message);
+    } else if (success) {
+        // The shared render runs at the highest requested rate unless one
+        // was given explicitly.
+        if (options.render_sample_rate == 0) {
+            for (const auto& output : outputs) {
+                options.render_sample_rate = std::max(options.render_sample_rate, output.sample_rate);
+            }
+        }
+        success = renderer.render_to_files(options, outputs, error_message);
+    }
+    const ExportStats& stats = renderer.stats();
+
+    if (json_output) {
+        std::cout << "{\"module\":\"" << json_escape(module_path.string()) << "\"";
+        if (!outputs.empty()) {
+            const ExportOptions& first = outputs.front();
+            std::cout << ",\"output\":\"" << json_escape(first.output_path) << "\""
+                      << ",\"format\":\"" << json_escape(AudioExporter::get_format_name(first.format)) << "\""
+                      << ",\"sample_rate\":" << first.sample_rate;
+        }
+        std::cout << ",\"render_sample_rate\":"
+                  << (outputs.size() == 1 ? outputs.front().effective_render_rate() : options.effective_render_rate())
+                  << ",\"outputs\":[";
+        for (std::size_t i = 0; i < outputs.size(); ++i) {
+            std::cout << (i > 0 ? "," : "") << "{\"path\":\"" << json_escape(outputs[i].output_path) << "\""
+                      << ",\"format\":\"" << json_escape(AudioExporter::get_format_name(outputs[i].format)) << "\""
+                      << ",\"sample_rate\":" << outputs[i].sample_rate << "}";
+        }
+        std::cout << "],\"success\":" << (success ? "true" : "false");
+        if (!success) {
+            std::cout << ",\"error\":\"" << json_escape(error_message) << "\"";
+        }
+        std::cout << ",\"stats\":" << stats.to_json() << "}" << std::endl;
+        return success ? 0 : 1;
+    }
+
+    if (last_percent >= 0) {
+        std::cerr << std::endl;
+    }
+
+    if (!success) {
+        std::cerr << "Export failed: " << error_message << std::endl;
+        return 1;
+    }
+
+    std::cout << "Exported " << module_path.filename().string() << " to ";
+    for (std::size_t i = 0; i < outputs.size(); ++i) {
+        std::cout << (i > 0 ? ", " : "") << outputs[i].output_path << " (" << outputs[i].sample_rate << " Hz)";
+    }
+    std::cout << "\n"
+              << std::fixed << std::setprecision(2)
+              << "  Audio:     " << stats.audio_seconds << " s\n"
+              << "  Wall:      " << stats.wall_seconds << " s (" << std::setprecision(1)
+              << stats.realtime_factor() << "x realtime)\n" << std::setprecision(3)
+              << "  Render:    " << stats.render_seconds << " s\n"
+              << "  Effects:   " << stats.effect_seconds << " s\n"
+              << "  Resample:  " << stats.resample_seconds << " s\n"
+              << "  Encode:    " << stats.encode_seconds << " s\n"
+              << "  I/O:       " << stats.io_seconds << " s\n" << std::setprecision(1)
+              << "  Written:   " << static_cast<double>(stats.bytes_written) / (1024.0 * 1024.0) << " MB ("
+              << stats.write_megabytes_per_second() << " MB/s)\n"
+              << "  Peak RSS:  " << static_cast<double>(stats.process_peak_rss_bytes) / (1024.0 * 1024.0)
+              << " MB (whole process)"
+              << std::endl;
+    if (stats.normalized) {
+        std::cout << std::setprecision(1)
+                  << "  Loudness:  " << stats.measured_lufs << " LUFS, true peak " << stats.measured_true_peak_db
+                  << " dBTP\n"
+                  << "  Gain:      " << std::showpos << stats.applied_gain_db << std::noshowpos << " dB"
+                  << (options.limiter ? " (limited)" : "") << "\n" << std::setprecision(3)
+                  << "  Analysis:  " << stats.analysis_seconds << " s" << std::endl;
+    }
+    return 0;
+}
+
+namespace {
+
+// Only returns if the watch cannot be set up; otherwise runs until killed.
+int watch_library(const std::vector<std::filesystem::path>& roots, LibraryIndexer& indexer,
+                  const std::filesystem::path& index_path, bool json_output) {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<DirectoryChange> queued;
+
+    std::string error_message;
+    DirectoryWatcher watcher;
+    if (!watcher.start(roots, true,
+                       [&](std::vector<DirectoryChange> changes) {
+                           {
+                               std::lock_guard lock(mutex);
+                               queued.insert(queued.end(), std::make_move_iterator(changes.begin()),
+                                             std::make_move_iterator(changes.end()));
+                           }
+                           changed.notify_one();
+                       },
+                       error_message)) {
+        std::cerr << "Watching failed: " << error_message << std::endl;
+        return 1;
+    }
+    if (!json_output) {
+        std::cerr << "Watching " << roots.size() << " library root(s) for changes (Ctrl+C to stop)" << std::endl;
+    }
+    indexer.set_progress_callback(nullptr);
+
+    while (true) {
+        std::vector<DirectoryChange> changes;
+        {
+            std::unique_lock lock(mutex);
+            changed.wait(lock, [&queued] { return !queued.empty(); });
+            changes.swap(queued);
+        }
+
+        LibraryIndex previous;
+        std::string open_error;
+        previous.open(index_path, open_error);
+        std::vector<LibraryRecord> records;
+        bool success = indexer.apply_changes(previous, changes, records, error_message);
+        const std::string walk_errors = success ? std::exchange(error_message, {}) : std::string();
+        const std::size_t record_count = records.size();
+        if (success) {
+            success = LibraryIndex::write(index_path, std::move(records), error_message);
+        }
+        const IndexStats& stats = indexer.stats();
+
+        if (json_output) {
+            std::cout << "{\"event\":\"changes\",\"success\":" << (success ? "true" : "false");
+            if (!success) {
+                std::cout << ",\"error\":\"" << json_escape(error_message) << "\"";
+            } else if (!walk_errors.empty()) {
+                std::cout << ",\"warning\":\"" << json_escape(walk_errors) << "\"";
+            }
+            std::cout << ",\"changes\":" << changes.size() << ",\"parsed\":" << stats.parsed
+                      << ",\"failed\":" << stats.failed << ",\"not_modules\":" << stats.not_modules
+                      << ",\"removed\":" << stats.removed << ",\"records\":" << record_count
+                      << ",\"elapsed_seconds\":" << stats.elapsed_seconds << "}" << std::endl;
+        } else if (!success) {
+            std::cerr << "Index update failed: " << error_message << std::endl;
+        } else {
+            std::cout << "Applied " << changes.size() << " change(s): " << stats.parsed << " parsed, "
+                      << stats.removed << " removed, " << record_count << " records" << std::endl;
+            if (!walk_errors.empty()) {
+                std::cerr << "Kept previous records for unreadable directories: " << walk_errors << std::endl;
+            }
+        }
+    }
+}
+
+}
+
+int run_index_command(const std::vector<std::filesystem::path>& roots, const IndexCommandOptions& options,
+                      bool json_output) {
+    const std::filesystem::path index_path = LibraryIndex::default_path();
+
+    std::string error_message;
+    bool success = !roots.empty();
+    if (!success) {
+        error_message = "No library roots configured (use --library-root <dir>)";
+    }
+
+    // A missing or stale-format index simply means every file is parsed.
+    LibraryIndex previous;
+    std::string open_error;
+    previous.open(index_path, open_error);
+
+    ExtractorOptions extractor_options;
+    extractor_options.threads = options.jobs;
+    extractor_options.memory_cap_bytes = options.memory_cap_megabytes * 1024 * 1024;
+    MetadataReader reader = read_module_tags;
+    if (options.envelopes) {
+        reader = read_module_metadata_with_envelope;
+    } else if (options.durations) {
+        reader = read_module_metadata;
+    }
+    LibraryIndexer indexer(std::move(reader), extractor_options);
+    indexer.set_envelopes(options.envelopes);
+    if (options.content_detection) {
+        indexer.set_detector(make_module_detector(nullptr));
+    }
+    bool showed_progress = false;
+    if (!json_output) {
+        indexer.set_progress_callback([&showed_progress](const IndexStats& progress) {
+            showed_progress = true;
+            std::cerr << "\rIndexing... " << progress.files_seen << " files" << std::flush;
+        });
+    }
+
+    std::vector<LibraryRecord> records;
+    std::string root_errors;
+    if (success) {
+        success = indexer.update(roots, previous, records, error_message);
+        if (success) {
+            root_errors = std::exchange(error_message, {});
+        }
+    }
+    if (success) {
+        success = LibraryIndex::write(index_path, std::move(records), error_message);
+    }
+    const IndexStats& stats = indexer.stats();
+
+    if (json_output) {
+        std::cout << "{\"index\":\"" << json_escape(index_path.string()) << "\",\"roots\":[";
+        for (std::size_t i = 0; i < roots.size(); ++i) {
+            std::cout << (i > 0 ? "," : "") << "\"" << json_escape(roots[i].string()) << "\"";
+        }
+        std::cout << "],\"success\":" << (success ? "true" : "false");
+        if (!success) {
+            std::cout << ",\"error\":\"" << json_escape(error_message) << "\"";
+        } else if (!root_errors.empty()) {
+            std::cout << ",\"warning\":\"" << json_escape(root_errors) << "\"";
+        }
+        std::cout << ",\"stats\":{\"files\":" << stats.files_seen << ",\"reused\":" << stats.reused
+                  << ",\"parsed\":" << stats.parsed << ",\"failed\":" << stats.failed
+                  << ",\"not_modules\":" << stats.not_modules
+                  << ",\"removed\":" << stats.removed << ",\"failed_roots\":" << stats.failed_roots
+                  << ",\"duplicate_groups\":" << stats.duplicate_groups
+                  << ",\"duplicate_files\":" << stats.duplicate_files
+                  << ",\"reclaimable_bytes\":" << stats.reclaimable_bytes << ",\"bytes_read\":" << stats.bytes_read
+                  << ",\"peak_bytes_in_flight\":" << stats.peak_bytes_in_flight << ",\"threads\":" << stats.threads
+                  << ",\"parse_seconds\":" << stats.parse_seconds
+                  << ",\"parsed_files_per_second\":" << stats.parsed_files_per_second()
+                  << ",\"elapsed_seconds\":" << stats.elapsed_seconds
+                  << ",\"files_per_second\":" << stats.files_per_second() << "}}" << std::endl;
+        if (success && options.watch) {
+            return watch_library(roots, indexer, index_path, json_output);
+        }
+        return success ? 0 : 1;
+    }
+
+    if (showed_progress) {
+        std::cerr << std::endl;
+    }
+
+    if (!success) {
+        std::cerr << "Indexing failed: " << error_message << std::endl;
+        return 1;
+    }
+    if (!root_errors.empty()) {
+        std::cerr << "Warning: " << root_errors << std::endl;
+    }
+
+    std::cout << "Indexed " << stats.files_seen << (options.content_detection ? " files" : " modules") << " into "
+              << index_path.string() << "\n"
+              << "  Reused:    " << stats.reused << "\n"
+              << "  Parsed:    " << stats.parsed << "\n"
+              << "  Failed:    " << stats.failed << "\n"
+              << "  Skipped:   " << stats.not_modules << " (not modules)\n"
+              << "  Removed:   " << stats.removed << "\n"
+              << "  Unread:    " << stats.failed_roots << " root(s) kept from the previous index\n"
+              << std::fixed << std::setprecision(1)
+              << "  Duplicate: " << stats.duplicate_files << " files in " << stats.duplicate_groups << " groups ("
+              << static_cast<double>(stats.reclaimable_bytes) / (1024.0 * 1024.0) << " MB reclaimable)\n"
+              << "  Read:      " << static_cast<double>(stats.bytes_read) / (1024.0 * 1024.0) << " MB (peak "
+              << static_cast<double>(stats.peak_bytes_in_flight) / (1024.0 * 1024.0) << " MB in flight)\n"
+              << std::setprecision(3)
+              << "  Parse:     " << stats.parse_seconds << " s on " << stats.threads << " threads ("
+              << std::setprecision(0) << stats.parsed_files_per_second() << " files/s)\n" << std::setprecision(3)
+              << "  Wall:      " << stats.elapsed_seconds << " s (" << std::setprecision(0)
+              << stats.files_per_second() << " files/s)" << std::endl;
+    if (options.watch) {
+        return watch_library(roots, indexer, index_path, json_output);
+    }
+    return 0;
+}
+
+int run_duplicates_command(bool json_output) {
+    const std::filesystem::path index_path = LibraryIndex::default_path();
+    LibraryIndex index;
+    std::string error_message;
+    if (!index.open(index_path, error_message)) {
+        if (json_output) {
+            std::cout << "{\"index\":\"" << json_escape(index_path.string()) << "\",\"success\":false,\"error\":\""
+                      << json_escape(error_message) << "\"}" << std::endl;
+        } else {
+            std::cerr << "Cannot open library index (run --index first): " << error_message << std::endl;
+        }
+        return 1;
+    }
+
+    const std::vector<DuplicateGroup> groups = DuplicateFinder::groups_from_index(index);
+    std::uint64_t reclaimable = 0;
+    std::size_t files = 0;
+    for (const auto& group : groups) {
+        reclaimable += group.reclaimable_bytes();
+        files += group.paths.size();
+    }
+
+    if (json_output) {
+        std::cout << "{\"index\":\"" << json_escape(index_path.string()) << "\",\"success\":true,\"groups\":[";
+        for (std::size_t i = 0; i < groups.size(); ++i) {
+            const auto& group = groups[i];
+            std::cout << (i > 0 ? "," : "") << "{\"size\":" << group.size
+                      << ",\"reclaimable_bytes\":" << group.reclaimable_bytes() << ",\"paths\":[";
+            for (std::size_t j = 0; j < group.paths.size(); ++j) {
+                std::cout << (j > 0 ? "," : "") << "\"" << json_escape(group.paths[j]) << "\"";
+            }
+            std::cout << "]}";
+        }
+        std::cout << "],\"duplicate_files\":" << files << ",\"reclaimable_bytes\":" << reclaimable << "}"
+                  << std::endl;
+        return 0;
+    }
+
+    if (groups.empty()) {
+        std::cout << "No duplicate modules in " << index.size() << " indexed files." << std::endl;
+        return 0;
+    }
+    std::cout << std::fixed << std::setprecision(1);
+    for (const auto& group : groups) {
+        std::cout << group.paths.size() << " copies, " << format_file_size(group.size) << " each:\n";
+        for (const auto& path : group.paths) {
+            std::cout << "  " << path << "\n";
+        }
+    }
+    std::cout << files << " files in " << groups.size() << " groups; "
+              << static_cast<double>(reclaimable) / (1024.0 * 1024.0) << " MB reclaimable" << std::endl;
+    return 0;
+}
+
+int run_query_command(const std::string& expression, bool json_output) {
+    const std::filesystem::path index_path = LibraryIndex::default_path();
+    auto fail = [&](const std::string& error_message) {
+        if (json_output) {
+            std::cout << "{\"index\":\"" << json_escape(index_path.string()) << "\",\"success\":false,\"error\":\""
+                      << json_escape(error_message) << "\"}" << std::endl;
+        } else {
+            std::cerr << error_message << std::endl;
+        }
+        return 1;
+    };
+
+    LibraryQuery query;
+    std::string error_message;
+    if (!LibraryQuery::parse(expression, query, error_message)) {
+        return fail("Invalid query: " + error_message);
+    }
+    LibraryIndex index;
+    if (!index.open(index_path, error_message)) {
+        return fail("Cannot open library index (run --index first): " + error_message);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const LibraryColumns columns(index);
+    const auto built = std::chrono::steady_clock::now();
+    const std::vector<std::uint32_t> rows = columns.execute(query);
+    const auto finished = std::chrono::steady_clock::now();
+    const double build_ms = std::chrono::duration<double, std::milli>(built - start).count();
+    const double query_ms = std::chrono::duration<double, std::milli>(finished - built).count();
+
+    if (json_output) {
+        std::cout << "{\"index\":\"" << json_escape(index_path.string()) << "\",\"success\":true,\"query\":\""
+                  << json_escape(expression) << "\",\"results\":[";
+        for (std::size_t i = 0; i < rows.size(); ++i) {
+            const LibraryIndex::Entry entry = index.entry(rows[i]);
+            std::cout << (i > 0 ? "," : "") << "{\"path\":\"" << json_escape(std::string(entry.path))
+                      << "\",\"title\":\"" << json_escape(std::string(entry.title)) << "\",\"artist\":\""
+                      << json_escape(std::string(entry.artist)) << "\",\"tracker\":\""
+                      << json_escape(std::string(entry.tracker)) << "\",\"format\":\""
+                      << json_escape(std::string(entry.format)) << "\",\"channels\":" << entry.channels
+                      << ",\"patterns\":" << entry.patterns << ",\"duration_ms\":" << entry.duration_ms
+                      << ",\"size\":" << entry.size << "}";
+        }
+        std::cout << "],\"matches\":" << rows.size() << ",\"records\":" << index.size()
+                  << ",\"build_ms\":" << build_ms << ",\"query_ms\":" << query_ms << "}" << std::endl;
+        return 0;
+    }
+
+    for (std::uint32_t row : rows) {
+        const LibraryIndex::Entry entry = index.entry(row);
+        const std::uint32_t seconds = entry.duration_ms / 1000;
+        std::cout << std::setfill(' ') << std::setw(4) << std::left << entry.format << std::right << std::setw(3)
+                  << entry.channels << "ch " << std::setw(3) << seconds / 60 << ':' << std::setfill('0')
+                  << std::setw(2) << seconds % 60 << std::setfill(' ') << "  " << entry.path;
+        if (!entry.title.empty() || !entry.artist.empty()) {
+            std::cout << "  (" << entry.title << (entry.artist.empty() ? "" : " / ") << entry.artist << ")";
+        }
+        std::cout << "\n";
+    }
+    std::cout << std::fixed << std::setprecision(2) << rows.size() << " of " << index.size() << " modules matched in "
+              << query_ms << " ms (columns built in " << build_ms << " ms)" << std::endl;
+    return 0;
+}
+
+}
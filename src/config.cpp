@@ -75,6 +75,16 @@ void Config::parse_line(const std::string& line) {
         } catch (...) {}
     } else if (key == "theme") {
         theme_ = value;
+    } else if (key == "detection") {
+        content_detection_ = value == "content";
+    } else if (key == "library_root" && !value.empty()) {
+        add_library_root(value);
+    }
+}
+
+void Config::add_library_root(const std::string& root) {
+    if (std::find(library_roots_.begin(), library_roots_.end(), root) == library_roots_.end()) {
+        library_roots_.push_back(root);
     }
 }
 
@@ -93,6 +103,14 @@ void Config::save() {
     file << "\n";
     file << "# Theme (dark, light, cyberpunk, retro)\n";
     file << "theme=" << theme_ << "\n";
+    file << "\n";
+    file << "# Module detection (extension, content)\n";
+    file << "detection=" << (content_detection_ ? "content" : "extension") << "\n";
+    file << "\n";
+    file << "# Library roots indexed by --index (one per line)\n";
+    for (const auto& root : library_roots_) {
+        file << "library_root=" << root << "\n";
+    }
 }
 
 } 
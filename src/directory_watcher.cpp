@@ -0,0 +1,207 @@
+#include "directory_watcher.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace tracker {
+
+namespace {
+
+constexpr std::uint32_t kWatchMask = IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO |
+                                     IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+}
+
+struct DirectoryWatcher::State {
+    int inotify_fd{-1};
+    int stop_pipe[2]{-1, -1};
+    bool recursive{false};
+    std::vector<std::filesystem::path> roots;
+    std::unordered_map<int, std::filesystem::path> watches;
+    Callback callback;
+
+    ~State() {
+        for (int fd : {inotify_fd, stop_pipe[0], stop_pipe[1]}) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+    }
+
+    void add_watch(const std::filesystem::path& directory) {
+        const int wd = inotify_add_watch(inotify_fd, directory.c_str(), kWatchMask);
+        if (wd < 0) {
+            return;
+        }
+        watches[wd] = directory;
+        if (!recursive) {
+            return;
+        }
+        std::error_code ec;
+        for (std::filesystem::directory_iterator it(directory, std::filesystem::directory_options::skip_permission_denied, ec), end;
+             !ec && it != end; it.increment(ec)) {
+            std::error_code type_ec;
+            if (it->is_directory(type_ec) && !it->is_symlink(type_ec)) {
+                add_watch(it->path());
+            }
+        }
+    }
+};
+
+DirectoryWatcher::~DirectoryWatcher() {
+    stop();
+}
+
+bool DirectoryWatcher::start(const std::vector<std::filesystem::path>& directories, bool recursive,
+                             Callback callback, std::string& error_message) {
+    stop();
+
+    auto state = std::make_shared<State>();
+    state->recursive = recursive;
+    state->roots = directories;
+    state->callback = std::move(callback);
+    state->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (state->inotify_fd < 0 || pipe2(state->stop_pipe, O_NONBLOCK | O_CLOEXEC) != 0) {
+        error_message = "Failed to start directory watcher: " + std::string(std::strerror(errno));
+        return false;
+    }
+    for (const auto& directory : directories) {
+        state->add_watch(directory);
+    }
+    if (state->watches.empty()) {
+        error_message = "No directories could be watched";
+        return false;
+    }
+
+    state_ = state;
+    thread_ = std::thread(run, state_);
+    return true;
+}
+
+void DirectoryWatcher::stop() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    const char byte = 0;
+    [[maybe_unused]] ssize_t written = ::write(state_->stop_pipe[1], &byte, 1);
+    thread_.join();
+    state_.reset();
+}
+
+void DirectoryWatcher::run(const std::shared_ptr<State>& state) {
+    using Clock = std::chrono::steady_clock;
+
+    // Path -> whether any event flagged it as a directory.
+    std::map<std::filesystem::path, bool> pending;
+    Clock::time_point first_event;
+    Clock::time_point last_event;
+    alignas(inotify_event) char buffer[16 * 1024];
+
+    auto flush = [&] {
+        std::vector<DirectoryChange> changes;
+        changes.reserve(pending.size());
+        for (const auto& [path, was_directory] : pending) {
+            struct stat info{};
+            DirectoryChange change;
+            change.path = path;
+            if (::stat(path.c_str(), &info) == 0) {
+                change.kind = DirectoryChange::Kind::Upsert;
+                change.is_directory = S_ISDIR(info.st_mode);
+                const bool is_root =
+                    std::find(state->roots.begin(), state->roots.end(), path) != state->roots.end();
+                if (change.is_directory && state->recursive && !is_root) {
+                    state->add_watch(path);
+                }
+            } else {
+                change.kind = DirectoryChange::Kind::Removed;
+                change.is_directory = was_directory;
+            }
+            changes.push_back(std::move(change));
+        }
+        pending.clear();
+        if (!changes.empty() && state->callback) {
+            state->callback(std::move(changes));
+        }
+    };
+
+    while (true) {
+        int timeout = -1;
+        if (!pending.empty()) {
+            const auto now = Clock::now();
+            const auto due = std::min(last_event + kQuietPeriod, first_event + kMaxDelay);
+            timeout = static_cast<int>(
+                std::max<std::int64_t>(0, std::chrono::duration_cast<std::chrono::milliseconds>(due - now).count()));
+        }
+
+        pollfd fds[2] = {{state->inotify_fd, POLLIN, 0}, {state->stop_pipe[0], POLLIN, 0}};
+        const int ready = ::poll(fds, 2, timeout);
+        if (ready < 0 && errno != EINTR) {
+            return;
+        }
+        if (fds[1].revents & POLLIN) {
+            return;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            const bool window_open = !pending.empty();
+            while (true) {
+                const ssize_t length = ::read(state->inotify_fd, buffer, sizeof(buffer));
+                if (length <= 0) {
+                    break;
+                }
+                for (ssize_t offset = 0; offset < length;) {
+                    const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                    offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+                    if (event->mask & IN_Q_OVERFLOW) {
+                        for (const auto& root : state->roots) {
+                            pending[root] = true;
+                        }
+                        continue;
+                    }
+                    auto watch = state->watches.find(event->wd);
+                    if (watch == state->watches.end()) {
+                        continue;
+                    }
+                    if (event->mask & IN_IGNORED) {
+                        state->watches.erase(watch);
+                        continue;
+                    }
+                    if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+                        pending[watch->second] = true;
+                        continue;
+                    }
+                    if (event->len == 0) {
+                        continue;
+                    }
+                    auto& is_directory = pending[watch->second / event->name];
+                    is_directory = is_directory || (event->mask & IN_ISDIR) != 0;
+                }
+            }
+            if (!pending.empty()) {
+                last_event = Clock::now();
+                if (!window_open) {
+                    first_event = last_event;
+                }
+            }
+        }
+
+        if (!pending.empty()) {
+            const auto now = Clock::now();
+            if (now - last_event >= kQuietPeriod || now - first_event >= kMaxDelay) {
+                flush();
+            }
+        }
+    }
+}
+
+}
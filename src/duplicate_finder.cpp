@@ -0,0 +1,216 @@
+#include "duplicate_finder.hpp"
+#include "library_indexer.hpp"
+#include "work_stealing_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <numeric>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace tracker {
+
+namespace {
+
+struct Candidate {
+    std::size_t record;
+    std::uint64_t partial_hash = 0;
+    std::uint64_t full_hash = 0;
+    std::int64_t mtime_ns = 0;
+    bool hashed = false;
+};
+
+// Sorts candidates by key and keeps only runs of two or more.
+template <typename Key>
+void keep_collisions(std::vector<Candidate>& candidates, Key key) {
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [&key](const Candidate& a, const Candidate& b) { return key(a) < key(b); });
+    std::vector<Candidate> kept;
+    for (std::size_t begin = 0; begin < candidates.size();) {
+        std::size_t end = begin + 1;
+        while (end < candidates.size() && key(candidates[end]) == key(candidates[begin])) {
+            ++end;
+        }
+        if (end - begin > 1) {
+            kept.insert(kept.end(), candidates.begin() + static_cast<std::ptrdiff_t>(begin),
+                        candidates.begin() + static_cast<std::ptrdiff_t>(end));
+        }
+        begin = end;
+    }
+    candidates.swap(kept);
+}
+
+}
+
+bool DuplicateFinder::hash_file(const std::string& path, std::uint64_t size, bool partial, std::uint64_t& hash,
+                                std::int64_t& mtime_ns) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info{};
+    if (::fstat(fd, &info) != 0 || static_cast<std::uint64_t>(info.st_size) != size || size == 0) {
+        ::close(fd);
+        return false;
+    }
+    mtime_ns = static_cast<std::int64_t>(info.st_mtim.tv_sec) * 1'000'000'000 + info.st_mtim.tv_nsec;
+
+    void* mapping = ::mmap(nullptr, static_cast<std::size_t>(size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    const auto* data = static_cast<const std::uint8_t*>(mapping);
+    const auto length = static_cast<std::size_t>(size);
+    if (partial && length > 2 * kPartialBytes) {
+        const std::uint64_t head = LibraryIndexer::hash_content(data, kPartialBytes);
+        const std::uint64_t tail = LibraryIndexer::hash_content(data + length - kPartialBytes, kPartialBytes);
+        hash = head ^ (tail * 0x9E3779B97F4A7C15ull);
+    } else {
+        ::madvise(mapping, length, MADV_SEQUENTIAL);
+        hash = LibraryIndexer::hash_content(data, length);
+    }
+    ::munmap(mapping, length);
+    return true;
+}
+
+std::vector<DuplicateGroup> DuplicateFinder::find(std::vector<LibraryRecord>& records) {
+    const auto start = std::chrono::steady_clock::now();
+    stats_ = DuplicateStats{};
+
+    std::vector<Candidate> candidates;
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        records[i].duplicate_group = 0;
+        if (LibraryRecord::is_listed_module(records[i].flags) && records[i].size > 0) {
+            candidates.push_back(Candidate{i});
+        }
+    }
+    stats_.files = candidates.size();
+
+    keep_collisions(candidates, [&records](const Candidate& c) { return records[c.record].size; });
+    stats_.size_matches = candidates.size();
+
+    WorkStealingPool pool(threads_);
+    std::atomic<std::uint64_t> bytes_read{0};
+
+    // Files small enough that the partial hash covers them entirely get
+    // their full hash here too.
+    pool.run(candidates.size(), [&](std::size_t index, std::size_t) {
+        Candidate& candidate = candidates[index];
+        const LibraryRecord& record = records[candidate.record];
+        candidate.hashed = hash_file(record.path, record.size, true, candidate.partial_hash, candidate.mtime_ns);
+        if (candidate.hashed) {
+            bytes_read.fetch_add(std::min<std::uint64_t>(record.size, 2 * kPartialBytes), std::memory_order_relaxed);
+        }
+    });
+    stats_.partial_hashed = candidates.size();
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                                    [](const Candidate& candidate) { return !candidate.hashed; }),
+                     candidates.end());
+    keep_collisions(candidates, [&records](const Candidate& c) {
+        return std::make_pair(records[c.record].size, c.partial_hash);
+    });
+    stats_.partial_matches = candidates.size();
+
+    std::atomic<std::size_t> full_hashed{0};
+    std::atomic<std::size_t> reused{0};
+    pool.run(candidates.size(), [&](std::size_t index, std::size_t) {
+        Candidate& candidate = candidates[index];
+        const LibraryRecord& record = records[candidate.record];
+        if (record.size <= 2 * kPartialBytes) {
+            candidate.full_hash = candidate.partial_hash;
+            return;
+        }
+        if (record.content_hash != 0 && record.mtime_ns == candidate.mtime_ns) {
+            candidate.full_hash = record.content_hash;
+            reused.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        std::int64_t mtime_ns = 0;
+        candidate.hashed = hash_file(record.path, record.size, false, candidate.full_hash, mtime_ns);
+        if (candidate.hashed) {
+            full_hashed.fetch_add(1, std::memory_order_relaxed);
+            bytes_read.fetch_add(record.size, std::memory_order_relaxed);
+        }
+    });
+    stats_.full_hashed = full_hashed.load();
+    stats_.hashes_reused = reused.load();
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                                    [](const Candidate& candidate) { return !candidate.hashed; }),
+                     candidates.end());
+    keep_collisions(candidates, [&records](const Candidate& c) {
+        return std::make_pair(records[c.record].size, c.full_hash);
+    });
+
+    std::vector<DuplicateGroup> groups;
+    for (std::size_t begin = 0; begin < candidates.size();) {
+        std::size_t end = begin + 1;
+        while (end < candidates.size() && candidates[end].full_hash == candidates[begin].full_hash &&
+               records[candidates[end].record].size == records[candidates[begin].record].size) {
+            ++end;
+        }
+        DuplicateGroup& group = groups.emplace_back();
+        group.size = records[candidates[begin].record].size;
+        group.content_hash = candidates[begin].full_hash;
+        for (std::size_t i = begin; i < end; ++i) {
+            group.paths.push_back(records[candidates[i].record].path);
+        }
+        std::sort(group.paths.begin(), group.paths.end());
+        begin = end;
+    }
+    std::sort(groups.begin(), groups.end(), [](const DuplicateGroup& a, const DuplicateGroup& b) {
+        if (a.reclaimable_bytes() != b.reclaimable_bytes()) {
+            return a.reclaimable_bytes() > b.reclaimable_bytes();
+        }
+        return a.paths.front() < b.paths.front();
+    });
+
+    std::unordered_map<std::string_view, std::size_t> record_by_path;
+    for (const auto& candidate : candidates) {
+        record_by_path.emplace(records[candidate.record].path, candidate.record);
+    }
+    for (std::size_t i = 0; i < groups.size(); ++i) {
+        groups[i].id = static_cast<std::uint32_t>(i + 1);
+        for (const auto& path : groups[i].paths) {
+            records[record_by_path[path]].duplicate_group = groups[i].id;
+        }
+        stats_.duplicate_files += groups[i].paths.size();
+        stats_.reclaimable_bytes += groups[i].reclaimable_bytes();
+    }
+    stats_.groups = groups.size();
+    stats_.bytes_read = bytes_read.load();
+    stats_.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return groups;
+}
+
+std::vector<DuplicateGroup> DuplicateFinder::groups_from_index(const LibraryIndex& index) {
+    std::map<std::uint32_t, DuplicateGroup> by_id;
+    for (std::size_t i = 0; i < index.size(); ++i) {
+        const LibraryIndex::Entry entry = index.entry(i);
+        if (entry.duplicate_group == 0) {
+            continue;
+        }
+        DuplicateGroup& group = by_id[entry.duplicate_group];
+        group.id = entry.duplicate_group;
+        group.size = entry.size;
+        group.content_hash = entry.content_hash;
+        group.paths.emplace_back(entry.path);
+    }
+    // Ids were assigned in reporting order.
+    std::vector<DuplicateGroup> groups;
+    groups.reserve(by_id.size());
+    for (auto& [id, group] : by_id) {
+        if (group.paths.size() > 1) {
+            groups.push_back(std::move(group));
+        }
+    }
+    return groups;
+}
+
+}
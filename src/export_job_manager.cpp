@@ -0,0 +1,254 @@
+#include "export_job_manager.hpp"
+#include "offline_renderer.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace tracker {
+
+ExportJobManager::ExportJobManager(std::string module_path, std::size_t worker_count, std::size_t max_pending)
+    : ExportJobManager(
+          std::move(module_path),
+          [](const std::string& path, const ExportOptions& options, ExportStats& stats, std::string& error_message) {
+              OfflineRenderer renderer(path);
+              bool success = renderer.render_to_file(options, error_message);
+              stats = renderer.stats();
+              return success;
+          },
+          worker_count, max_pending) {}
+
+ExportJobManager::ExportJobManager(std::string module_path, ExportRenderFunction render, std::size_t worker_count,
+                                   std::size_t max_pending)
+    : module_path_(std::move(module_path)),
+      render_(std::move(render)),
+      max_pending_(std::max<std::size_t>(1, max_pending)) {
+    worker_count = std::max<std::size_t>(1, worker_count);
+    workers_.reserve(worker_count);
+    for (std::size_t i = 0; i < worker_count; ++i) {
+        workers_.emplace_back(&ExportJobManager::worker_loop, this);
+    }
+}
+
+ExportJobManager::~ExportJobManager() {
+    {
+        std::lock_guard lock(mutex_);
+        shutting_down_ = true;
+        for (auto& job : jobs_) {
+            job->cancel_requested = true;
+        }
+    }
+    queue_cv_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+int ExportJobManager::submit(ExportOptions options, std::string& error_message) {
+    std::lock_guard lock(mutex_);
+
+    if (shutting_down_) {
+        error_message = "Export queue is shutting down";
+        return -1;
+    }
+
+    if (queue_.size() >= max_pending_) {
+        error_message = "Export queue is full";
+        return -1;
+    }
+
+    for (const auto& job : jobs_) {
+        if (!is_finished(job->state) && job->options.output_path == options.output_path) {
+            error_message = "Already exporting to " + options.output_path;
+            return -1;
+        }
+    }
+
+    auto job = std::make_shared<Job>();
+    job->id = next_id_++;
+    job->module_path = module_path_;
+    job->options = std::move(options);
+    job->options.progress_callback = nullptr;
+
+    jobs_.push_back(job);
+    queue_.push_back(job);
+    prune_history_locked();
+
+    queue_cv_.notify_one();
+    return job->id;
+}
+
+void ExportJobManager::set_module_path(std::string module_path) {
+    std::lock_guard lock(mutex_);
+    module_path_ = std::move(module_path);
+}
+
+bool ExportJobManager::cancel(int job_id) {
+    std::lock_guard lock(mutex_);
+
+    auto it = std::find_if(jobs_.begin(), jobs_.end(), [job_id](const auto& job) { return job->id == job_id; });
+    if (it == jobs_.end() || is_finished((*it)->state)) {
+        return false;
+    }
+
+    auto& job = *it;
+    job->cancel_requested = true;
+
+    if (job->state == ExportJobState::Queued) {
+        queue_.erase(std::remove(queue_.begin(), queue_.end(), job), queue_.end());
+        job->state = ExportJobState::Cancelled;
+        job->started_at = job->finished_at = std::chrono::steady_clock::now();
+        finished_.push_back(describe_locked(*job));
+    }
+
+    return true;
+}
+
+void ExportJobManager::cancel_all() {
+    std::vector<int> ids;
+    {
+        std::lock_guard lock(mutex_);
+        for (const auto& job : jobs_) {
+            ids.push_back(job->id);
+        }
+    }
+    for (int id : ids) {
+        cancel(id);
+    }
+}
+
+std::vector<ExportJobInfo> ExportJobManager::jobs() const {
+    std::lock_guard lock(mutex_);
+
+    std::vector<ExportJobInfo> result;
+    result.reserve(jobs_.size());
+    for (const auto& job : jobs_) {
+        result.push_back(describe_locked(*job));
+    }
+    return result;
+}
+
+std::vector<ExportJobInfo> ExportJobManager::take_finished() {
+    std::lock_guard lock(mutex_);
+    return std::exchange(finished_, {});
+}
+
+std::size_t ExportJobManager::active_count() const {
+    std::lock_guard lock(mutex_);
+    return static_cast<std::size_t>(std::count_if(jobs_.begin(), jobs_.end(), [](const auto& job) {
+        return !is_finished(job->state);
+    }));
+}
+
+bool ExportJobManager::is_finished(ExportJobState state) {
+    return state == ExportJobState::Completed || state == ExportJobState::Failed ||
+           state == ExportJobState::Cancelled;
+}
+
+std::string ExportJobManager::state_name(ExportJobState state) {
+    switch (state) {
+        case ExportJobState::Queued:    return "Queued";
+        case ExportJobState::Running:   return "Running";
+        case ExportJobState::Completed: return "Done";
+        case ExportJobState::Failed:    return "Failed";
+        case ExportJobState::Cancelled: return "Cancelled";
+    }
+    return "Unknown";
+}
+
+void ExportJobManager::worker_loop() {
+    while (true) {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock lock(mutex_);
+            queue_cv_.wait(lock, [&] { return shutting_down_ || !queue_.empty(); });
+            if (shutting_down_) {
+                return;
+            }
+            job = queue_.front();
+            queue_.pop_front();
+            job->state = ExportJobState::Running;
+            job->started_at = std::chrono::steady_clock::now();
+        }
+
+        ExportOptions options = job->options;
+        options.progress_callback = [&job](std::size_t current, std::size_t total) {
+            job->current.store(current, std::memory_order_relaxed);
+            job->total.store(total, std::memory_order_relaxed);
+            return !job->cancel_requested.load(std::memory_order_relaxed);
+        };
+
+        std::string error_message;
+        ExportStats stats;
+        bool success = render_(job->module_path, options, stats, error_message);
+
+        std::lock_guard lock(mutex_);
+        job->finished_at = std::chrono::steady_clock::now();
+        if (success) {
+            job->state = ExportJobState::Completed;
+            job->stats = stats;
+        } else if (job->cancel_requested) {
+            job->state = ExportJobState::Cancelled;
+        } else {
+            job->state = ExportJobState::Failed;
+            job->error_message = error_message;
+        }
+        finished_.push_back(describe_locked(*job));
+        prune_history_locked();
+    }
+}
+
+ExportJobInfo ExportJobManager::describe_locked(const Job& job) const {
+    ExportJobInfo info;
+    info.id = job.id;
+    info.output_path = job.options.output_path;
+    info.format = job.options.format;
+    info.state = job.state;
+    info.error_message = job.error_message;
+    info.stats = job.stats;
+
+    const std::size_t current = job.current.load(std::memory_order_relaxed);
+    const std::size_t total = job.total.load(std::memory_order_relaxed);
+    if (info.state == ExportJobState::Completed) {
+        info.progress = 1.0;
+    } else if (total > 0) {
+        info.progress = std::clamp(static_cast<double>(current) / static_cast<double>(total), 0.0, 1.0);
+    }
+
+    if (info.state != ExportJobState::Queued) {
+        auto end = is_finished(info.state) ? job.finished_at : std::chrono::steady_clock::now();
+        info.elapsed_seconds = std::chrono::duration<double>(end - job.started_at).count();
+    }
+
+    if (info.state == ExportJobState::Completed) {
+        info.realtime_factor = info.stats.realtime_factor();
+        return info;
+    }
+
+    const double samples_per_second =
+        static_cast<double>(job.options.effective_render_rate()) * static_cast<double>(job.options.channels);
+    if (total > 0 && samples_per_second > 0.0 && info.elapsed_seconds > 0.0) {
+        double audio_seconds = static_cast<double>(total / OfflineRenderer::progress_passes(job.options)) / samples_per_second;
+        info.realtime_factor = info.progress * audio_seconds / info.elapsed_seconds;
+    }
+
+    return info;
+}
+
+void ExportJobManager::prune_history_locked() {
+    std::size_t finished_count = static_cast<std::size_t>(std::count_if(jobs_.begin(), jobs_.end(), [](const auto& job) {
+        return is_finished(job->state);
+    }));
+
+    for (auto it = jobs_.begin(); it != jobs_.end() && finished_count > kHistoryLimit;) {
+        if (is_finished((*it)->state)) {
+            it = jobs_.erase(it);
+            --finished_count;
+        } else {
+            ++it;
+        }
+    }
+}
+
+}
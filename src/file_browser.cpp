@@ -1,11 +1,163 @@
 #include "file_browser.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <numeric>
+#include <mutex>
+#include <optional>
 #include <system_error>
 
+#include <dirent.h>
+#include <sys/stat.h>
+
 namespace tracker {
 
+namespace {
+
+constexpr std::size_t kScanBatchSize = 512;
+constexpr auto kScanBatchInterval = std::chrono::milliseconds(50);
+constexpr std::size_t kProbeBatchSize = 256;
+// Directory timestamps are only as fine as the kernel's clock tick (or a
+// second on some filesystems), so a listing read just after a change could
+// miss a second change that leaves the mtime as it was.
+constexpr auto kListingSettleTime = std::chrono::seconds(2);
+
+std::int64_t mtime_of(const struct stat& info) {
+    return static_cast<std::int64_t>(info.st_mtim.tv_sec) * 1'000'000'000 + info.st_mtim.tv_nsec;
+}
+
+// 0 when the directory cannot be read or changed too recently for its mtime
+// to validate a cached listing.
+std::int64_t settled_directory_mtime(const std::filesystem::path& directory) {
+    struct stat info{};
+    if (::stat(directory.c_str(), &info) != 0) {
+        return 0;
+    }
+    const std::int64_t mtime_ns = mtime_of(info);
+    const auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch());
+    if (now.count() - mtime_ns < std::chrono::nanoseconds(kListingSettleTime).count()) {
+        return 0;
+    }
+    return mtime_ns;
+}
+
+bool is_within(const std::filesystem::path& path, const std::filesystem::path& directory) {
+    auto [mismatch, unused] = std::mismatch(directory.begin(), directory.end(), path.begin(), path.end());
+    return mismatch == directory.end();
+}
+
+void apply_metadata(const MetadataLookup& lookup, FileEntry& entry) {
+    EntryMetadata metadata;
+    if (lookup && lookup(entry.path, metadata)) {
+        entry.duration_ms = metadata.duration_ms;
+        entry.channels = metadata.channels;
+        entry.duplicate_count = metadata.duplicate_count;
+    }
+}
+
+}
+
+struct FileBrowser::ScanState {
+    std::filesystem::path directory;
+    std::shared_ptr<const ModuleDetector> detector;
+    MetadataLookup metadata_lookup;
+    SortMode sort_mode{SortMode::Name};
+    // Directory mtime before reading; 0 keeps the listing out of the cache.
+    std::int64_t directory_mtime_ns{0};
+    std::atomic<bool> cancelled{false};
+    std::atomic<bool> finished{false};
+    std::atomic<std::size_t> entries_seen{0};
+
+    std::mutex mutex;
+    std::vector<std::vector<FileEntry>> batches;
+    std::string error_message;
+
+    // Held while the callback runs so cancel_scan() can guarantee it is
+    // never invoked again once it returns.
+    std::mutex callback_mutex;
+    std::function<void()> on_update;
+
+    void notify() {
+        std::lock_guard lock(callback_mutex);
+        if (on_update) {
+            on_update();
+        }
+    }
+};
+
+// A change without an entry removes the path from the listing.
+struct WatchedChange {
+    std::filesystem::path path;
+    std::optional<FileEntry> entry;
+};
+
+struct FileBrowser::WatchState {
+    std::filesystem::path directory;
+    std::shared_ptr<const ModuleDetector> detector;
+    MetadataLookup metadata_lookup;
+
+    std::mutex mutex;
+    std::vector<WatchedChange> changes;
+    bool rescan{false};
+
+    std::mutex callback_mutex;
+    std::function<void()> on_update;
+
+    void notify() {
+        std::lock_guard lock(callback_mutex);
+        if (on_update) {
+            on_update();
+        }
+    }
+};
+
+std::string format_file_size(std::uint64_t bytes) {
+    char buffer[32];
+    if (bytes < 1024) {
+        std::snprintf(buffer, sizeof(buffer), "%llu B", static_cast<unsigned long long>(bytes));
+    } else if (bytes < 1024 * 1024) {
+        std::snprintf(buffer, sizeof(buffer), "%.1f KB", static_cast<double>(bytes) / 1024.0);
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%.1f MB", static_cast<double>(bytes) / (1024.0 * 1024.0));
+    }
+    return buffer;
+}
+
+std::string make_collation_key(std::string_view name) {
+    std::string key;
+    key.reserve(name.size() + 4);
+    for (std::size_t i = 0; i < name.size();) {
+        const auto c = static_cast<unsigned char>(name[i]);
+        if (!std::isdigit(c)) {
+            key.push_back(static_cast<char>(std::tolower(c)));
+            ++i;
+            continue;
+        }
+        std::size_t end = i;
+        while (end < name.size() && std::isdigit(static_cast<unsigned char>(name[end]))) {
+            ++end;
+        }
+        std::size_t first = i;
+        while (first + 1 < end && name[first] == '0') {
+            ++first;
+        }
+        // A '0' marker keeps numbers ordered against letters as before; the
+        // length byte makes longer numbers compare greater.
+        key.push_back('0');
+        key.push_back(static_cast<char>(std::min<std::size_t>(end - first, 255)));
+        key.append(name.substr(first, end - first));
+        i = end;
+    }
+    return key;
+}
+
 const std::vector<std::string> FileBrowser::module_extensions_ = {
     ".mod", ".xm", ".s3m", ".it", ".mptm", ".stm", ".nst", ".m15", ".stk",
     ".wow", ".ult", ".669", ".mtm", ".med", ".far", ".mdl", ".ams", ".dsm",
@@ -13,6 +165,10 @@ const std::vector<std::string> FileBrowser::module_extensions_ = {
     ".j2b", ".gdm", ".umx", ".plm", ".mo3", ".xpk", ".ppm", ".mmcmp"
 };
 
+const std::vector<std::string> FileBrowser::amiga_prefixes_ = {
+    "mod.", "med.", "okt.", "stk.", "dbm.", "digi."
+};
+
 FileBrowser::FileBrowser() : FileBrowser(std::filesystem::current_path()) {}
 
 FileBrowser::FileBrowser(const std::filesystem::path& start_path) 
@@ -20,6 +176,118 @@ FileBrowser::FileBrowser(const std::filesystem::path& start_path)
     refresh();
 }
 
+FileBrowser::~FileBrowser() {
+    watcher_.stop();
+    cancel_scan();
+    for (auto& [state, thread] : retired_scans_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+void FileBrowser::set_update_callback(std::function<void()> callback) {
+    update_callback_ = std::move(callback);
+    if (scan_) {
+        std::lock_guard lock(scan_->callback_mutex);
+        scan_->on_update = update_callback_;
+    }
+    if (watch_) {
+        std::lock_guard lock(watch_->callback_mutex);
+        watch_->on_update = update_callback_;
+    }
+}
+
+void FileBrowser::set_detector(std::shared_ptr<const ModuleDetector> detector) {
+    detector_ = std::move(detector);
+    listing_cache_.clear();
+    refresh();
+}
+
+void FileBrowser::set_metadata_lookup(MetadataLookup lookup) {
+    metadata_lookup_ = std::move(lookup);
+    listing_cache_.clear();
+    refresh();
+}
+
+void FileBrowser::set_watching(bool enabled) {
+    if (enabled == watching_) {
+        return;
+    }
+    watching_ = enabled;
+    if (enabled) {
+        refresh();
+    } else {
+        watcher_.stop();
+        watch_.reset();
+    }
+}
+
+void FileBrowser::set_listing_cache_capacity(std::size_t capacity) {
+    listing_cache_capacity_ = capacity;
+    while (listing_cache_.size() > listing_cache_capacity_) {
+        listing_cache_.pop_back();
+    }
+}
+
+void FileBrowser::set_sort_mode(SortMode mode) {
+    if (mode == sort_mode_) {
+        return;
+    }
+    sort_mode_ = mode;
+    if (scan_) {
+        std::lock_guard lock(scan_->mutex);
+        scan_->sort_mode = mode;
+    }
+    sort_entries();
+}
+
+const char* FileBrowser::sort_mode_name(SortMode mode) {
+    switch (mode) {
+        case SortMode::Name: return "name";
+        case SortMode::Size: return "size";
+        case SortMode::Modified: return "modified";
+        case SortMode::Duration: return "duration";
+        case SortMode::Channels: return "channels";
+    }
+    return "name";
+}
+
+void FileBrowser::sort_file_entries(std::vector<FileEntry>& entries, std::size_t first, SortMode mode) {
+    if (first >= entries.size()) {
+        return;
+    }
+    std::vector<std::uint32_t> order(entries.size() - first);
+    std::iota(order.begin(), order.end(), static_cast<std::uint32_t>(first));
+    std::sort(order.begin(), order.end(), [&entries, mode](std::uint32_t a, std::uint32_t b) {
+        return compare_entries(entries[a], entries[b], mode);
+    });
+
+    std::vector<FileEntry> sorted;
+    sorted.reserve(entries.size());
+    std::move(entries.begin(), entries.begin() + static_cast<std::ptrdiff_t>(first), std::back_inserter(sorted));
+    for (std::uint32_t index : order) {
+        sorted.push_back(std::move(entries[index]));
+    }
+    entries.swap(sorted);
+}
+
+void FileBrowser::sort_entries() {
+    const std::size_t first = !entries_.empty() && entries_.front().display_name == ".." ? 1 : 0;
+    std::filesystem::path selected;
+    if (selected_index_ < entries_.size()) {
+        selected = entries_[selected_index_].path;
+    }
+
+    sort_file_entries(entries_, first, sort_mode_);
+
+    auto it = std::find_if(entries_.begin(), entries_.end(),
+                           [&selected](const FileEntry& entry) { return entry.path == selected; });
+    if (it != entries_.end()) {
+        selected_index_ = static_cast<std::size_t>(it - entries_.begin());
+    }
+}
+
 void FileBrowser::navigate_to(const std::filesystem::path& path) {
     clear_error();
     
@@ -34,7 +302,9 @@ void FileBrowser::navigate_to(const std::filesystem::path& path) {
             return;
         }
         
-        current_path_ = std::filesystem::canonical(path);
+        std::filesystem::path target = std::filesystem::canonical(path);
+        remember_selection();
+        current_path_ = std::move(target);
         selected_index_ = 0;
         refresh();
     } catch (const std::filesystem::filesystem_error& e) {
@@ -60,55 +330,502 @@ void FileBrowser::navigate_into(std::size_t index) {
 }
 
 void FileBrowser::refresh() {
+    cancel_scan();
     entries_.clear();
+    entries_seen_ = 0;
     clear_error();
     
-    try {
-        if (current_path_.has_parent_path() && current_path_ != current_path_.root_path()) {
-            entries_.emplace_back(current_path_.parent_path(), "..", true, 0);
+    if (current_path_.has_parent_path() && current_path_ != current_path_.root_path()) {
+        entries_.emplace_back(current_path_.parent_path(), "..", true, 0);
+    }
+    
+    // The watch starts before the mtime is read and the scan begins so
+    // nothing created in between is missed; its changes are held until the
+    // scan has been merged.
+    if (watching_) {
+        start_watch();
+    }
+    const std::int64_t mtime_ns = settled_directory_mtime(current_path_);
+    if (restore_listing(mtime_ns)) {
+        return;
+    }
+
+    scan_ = std::make_shared<ScanState>();
+    scan_->directory = current_path_;
+    scan_->detector = detector_;
+    scan_->metadata_lookup = metadata_lookup_;
+    scan_->sort_mode = sort_mode_;
+    scan_->directory_mtime_ns = mtime_ns;
+    scan_->on_update = update_callback_;
+    scan_thread_ = std::thread(run_scan, scan_);
+}
+
+bool FileBrowser::restore_listing(std::int64_t mtime_ns) {
+    auto it = std::find_if(listing_cache_.begin(), listing_cache_.end(),
+                           [this](const CachedListing& listing) { return listing.directory == current_path_; });
+    if (it == listing_cache_.end()) {
+        return false;
+    }
+    if (mtime_ns == 0 || it->mtime_ns != mtime_ns) {
+        listing_cache_.erase(it);
+        return false;
+    }
+
+    listing_cache_.splice(listing_cache_.begin(), listing_cache_, it);
+    const CachedListing& listing = listing_cache_.front();
+    const std::size_t first = entries_.size();
+    entries_.insert(entries_.end(), listing.entries.begin(), listing.entries.end());
+    entries_seen_ = listing.entries_seen;
+    if (listing.sort_mode != sort_mode_) {
+        sort_file_entries(entries_, first, sort_mode_);
+    }
+    auto selected = std::find_if(entries_.begin(), entries_.end(), [&listing](const FileEntry& entry) {
+        return entry.path == listing.selected;
+    });
+    if (selected != entries_.end()) {
+        selected_index_ = static_cast<std::size_t>(selected - entries_.begin());
+    }
+    ++listing_cache_hits_;
+    return true;
+}
+
+void FileBrowser::cache_listing(const ScanState& scan) {
+    forget_listings(scan.directory, false);
+    if (listing_cache_capacity_ == 0 || scan.directory_mtime_ns == 0) {
+        return;
+    }
+
+    CachedListing listing;
+    listing.directory = scan.directory;
+    listing.mtime_ns = scan.directory_mtime_ns;
+    listing.sort_mode = sort_mode_;
+    const std::size_t first = !entries_.empty() && entries_.front().display_name == ".." ? 1 : 0;
+    listing.entries.assign(entries_.begin() + static_cast<std::ptrdiff_t>(first), entries_.end());
+    listing.entries_seen = entries_seen_;
+    if (selected_index_ < entries_.size()) {
+        listing.selected = entries_[selected_index_].path;
+    }
+    listing_cache_.push_front(std::move(listing));
+    while (listing_cache_.size() > listing_cache_capacity_) {
+        listing_cache_.pop_back();
+    }
+}
+
+void FileBrowser::remember_selection() {
+    if (listing_cache_.empty() || listing_cache_.front().directory != current_path_) {
+        return;
+    }
+    listing_cache_.front().selected = selected_index_ < entries_.size() ? entries_[selected_index_].path
+                                                                         : std::filesystem::path();
+}
+
+void FileBrowser::forget_listings(const std::filesystem::path& path, bool subdirectories) {
+    listing_cache_.remove_if([&path, subdirectories](const CachedListing& listing) {
+        return subdirectories ? is_within(listing.directory, path) : listing.directory == path;
+    });
+}
+
+void FileBrowser::start_watch() {
+    watcher_.stop();
+    watch_ = std::make_shared<WatchState>();
+    watch_->directory = current_path_;
+    watch_->detector = detector_;
+    watch_->metadata_lookup = metadata_lookup_;
+    watch_->on_update = update_callback_;
+
+    std::string error;
+    auto state = watch_;
+    if (!watcher_.start({current_path_}, false,
+                        [state](std::vector<DirectoryChange> changes) {
+                            handle_watch_changes(state, std::move(changes));
+                        },
+                        error)) {
+        // Without inotify the listing still works; it just won't update.
+        watch_.reset();
+    }
+}
+
+// Runs on the watcher thread so stats and probes stay off the UI thread.
+void FileBrowser::handle_watch_changes(const std::shared_ptr<WatchState>& state,
+                                       std::vector<DirectoryChange> changes) {
+    std::vector<WatchedChange> resolved;
+    bool rescan = false;
+    for (auto& change : changes) {
+        if (change.path == state->directory) {
+            rescan = true;
+            continue;
         }
-        
-        std::vector<FileEntry> directories;
-        std::vector<FileEntry> files;
-        
-        for (const auto& entry : std::filesystem::directory_iterator(current_path_)) {
-            try {
-                const auto& path = entry.path();
-                std::string name = path.filename().string();
-                bool is_dir = entry.is_directory();
-                std::size_t size = is_dir ? 0 : (entry.is_regular_file() ? entry.file_size() : 0);
-                
-                if (is_dir) {
-                    directories.emplace_back(path, name, true, 0);
-                } else if (is_module_file(path)) {
-                    files.emplace_back(path, name, false, size);
+        WatchedChange& item = resolved.emplace_back();
+        item.path = std::move(change.path);
+        if (change.kind == DirectoryChange::Kind::Removed) {
+            continue;
+        }
+        const std::string name = item.path.filename().string();
+        if (change.is_directory) {
+            item.entry.emplace(item.path, name, true, 0);
+            continue;
+        }
+
+        struct stat info{};
+        if (::stat(item.path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) {
+            continue;
+        }
+        bool is_module = false;
+        if (state->detector) {
+            std::vector<DetectionCandidate> candidates(1);
+            candidates[0].path = item.path;
+            candidates[0].size = static_cast<std::uint64_t>(info.st_size);
+            candidates[0].mtime_ns = mtime_of(info);
+            candidates[0].has_module_extension = is_module_file(item.path);
+            state->detector->classify(candidates);
+            is_module = candidates[0].is_module;
+        } else {
+            is_module = is_module_file(item.path);
+        }
+        if (!is_module) {
+            continue;
+        }
+        FileEntry& entry = item.entry.emplace(item.path, name, false, static_cast<std::size_t>(info.st_size));
+        entry.mtime_ns = mtime_of(info);
+        apply_metadata(state->metadata_lookup, entry);
+    }
+
+    {
+        std::lock_guard lock(state->mutex);
+        state->rescan = state->rescan || rescan;
+        state->changes.insert(state->changes.end(), std::make_move_iterator(resolved.begin()),
+                              std::make_move_iterator(resolved.end()));
+    }
+    state->notify();
+}
+
+void FileBrowser::run_scan(const std::shared_ptr<ScanState>& state) {
+    std::vector<FileEntry> batch;
+    std::vector<DetectionCandidate> candidates;
+    auto last_publish = std::chrono::steady_clock::now();
+
+    auto add_file = [&](std::filesystem::path path, const char* name, std::uint64_t size, std::int64_t mtime_ns) {
+        FileEntry& entry = batch.emplace_back(std::move(path), name, false, static_cast<std::size_t>(size));
+        entry.mtime_ns = mtime_ns;
+        apply_metadata(state->metadata_lookup, entry);
+    };
+
+    auto classify_candidates = [&]() {
+        state->detector->classify(candidates, &state->cancelled);
+        for (auto& candidate : candidates) {
+            if (candidate.is_module) {
+                std::string name = candidate.path.filename().string();
+                add_file(std::move(candidate.path), name.c_str(), candidate.size, candidate.mtime_ns);
+            }
+        }
+        candidates.clear();
+    };
+
+    auto publish = [&]() {
+        SortMode mode;
+        {
+            std::lock_guard lock(state->mutex);
+            mode = state->sort_mode;
+        }
+        std::sort(batch.begin(), batch.end(),
+                  [mode](const FileEntry& a, const FileEntry& b) { return compare_entries(a, b, mode); });
+        {
+            std::lock_guard lock(state->mutex);
+            state->batches.push_back(std::move(batch));
+        }
+        batch.clear();
+        last_publish = std::chrono::steady_clock::now();
+        state->notify();
+    };
+
+    auto fail = [&](const std::string& message) {
+        std::lock_guard lock(state->mutex);
+        state->error_message = "Error reading directory: " + message;
+    };
+
+    DIR* directory = opendir(state->directory.c_str());
+    if (!directory) {
+        fail(std::strerror(errno));
+    } else {
+        const int directory_fd = dirfd(directory);
+
+        while (!state->cancelled.load(std::memory_order_relaxed)) {
+            errno = 0;
+            dirent* item = readdir(directory);
+            if (!item) {
+                if (errno != 0) {
+                    fail(std::strerror(errno));
                 }
-            } catch (const std::filesystem::filesystem_error&) {
+                break;
+            }
+
+            const char* name = item->d_name;
+            if (std::strcmp(name, ".") == 0 || std::strcmp(name, "..") == 0) {
                 continue;
             }
+            state->entries_seen.fetch_add(1, std::memory_order_relaxed);
+
+            // d_type answers most entries without a stat; only symlinks,
+            // filesystems that report DT_UNKNOWN, and module files (for
+            // their size) need fstatat. Content detection stats every file
+            // so cached probe results can be validated.
+            bool is_dir = item->d_type == DT_DIR;
+            bool is_file = item->d_type == DT_REG;
+            bool have_size = false;
+            struct stat info{};
+            if (item->d_type == DT_LNK || item->d_type == DT_UNKNOWN) {
+                if (fstatat(directory_fd, name, &info, 0) != 0) {
+                    continue;
+                }
+                is_dir = S_ISDIR(info.st_mode);
+                is_file = S_ISREG(info.st_mode);
+                have_size = true;
+            }
+
+            if (is_dir) {
+                batch.emplace_back(state->directory / name, name, true, 0);
+            } else if (is_file && state->detector) {
+                if (!have_size && fstatat(directory_fd, name, &info, 0) != 0) {
+                    continue;
+                }
+                DetectionCandidate candidate;
+                candidate.path = state->directory / name;
+                candidate.size = static_cast<std::uint64_t>(info.st_size);
+                candidate.mtime_ns = mtime_of(info);
+                candidate.has_module_extension = is_module_file(candidate.path);
+                candidates.push_back(std::move(candidate));
+                if (candidates.size() >= kProbeBatchSize) {
+                    classify_candidates();
+                }
+            } else if (is_file) {
+                std::filesystem::path path = state->directory / name;
+                if (!is_module_file(path)) {
+                    continue;
+                }
+                if (!have_size && fstatat(directory_fd, name, &info, 0) != 0) {
+                    info = {};
+                }
+                add_file(std::move(path), name, static_cast<std::uint64_t>(info.st_size), mtime_of(info));
+            }
+
+            if (batch.size() >= kScanBatchSize ||
+                (!batch.empty() && std::chrono::steady_clock::now() - last_publish >= kScanBatchInterval)) {
+                publish();
+            }
         }
-        
-        auto sort_by_name = [](const FileEntry& a, const FileEntry& b) {
-            std::string a_lower = a.display_name;
-            std::string b_lower = b.display_name;
-            std::transform(a_lower.begin(), a_lower.end(), a_lower.begin(), ::tolower);
-            std::transform(b_lower.begin(), b_lower.end(), b_lower.begin(), ::tolower);
-            return a_lower < b_lower;
-        };
-        
-        std::sort(directories.begin(), directories.end(), sort_by_name);
-        std::sort(files.begin(), files.end(), sort_by_name);
-        
-        entries_.insert(entries_.end(), directories.begin(), directories.end());
-        entries_.insert(entries_.end(), files.begin(), files.end());
-        
-        if (selected_index_ >= entries_.size() && !entries_.empty()) {
-            selected_index_ = entries_.size() - 1;
+        closedir(directory);
+    }
+
+    if (!candidates.empty() && !state->cancelled.load()) {
+        classify_candidates();
+    }
+    if (!batch.empty() && !state->cancelled.load()) {
+        publish();
+    }
+    state->finished.store(true, std::memory_order_release);
+    state->notify();
+}
+
+bool FileBrowser::poll() {
+    reap_finished_scans();
+    bool changed = poll_scan();
+    if (!scan_ && watch_) {
+        changed = apply_watch_changes() || changed;
+    }
+    return changed;
+}
+
+bool FileBrowser::poll_scan() {
+    if (!scan_) {
+        return false;
+    }
+
+    // Read the flag first: once it is set every batch has been published.
+    const bool finished = scan_->finished.load(std::memory_order_acquire);
+    std::vector<std::vector<FileEntry>> batches;
+    std::string error;
+    {
+        std::lock_guard lock(scan_->mutex);
+        batches.swap(scan_->batches);
+        error = scan_->error_message;
+    }
+
+    bool changed = !batches.empty();
+    for (auto& batch : batches) {
+        merge_batch(std::move(batch));
+    }
+    if (!error.empty() && error_message_ != error) {
+        error_message_ = error;
+        changed = true;
+    }
+
+    entries_seen_ = scan_->entries_seen.load(std::memory_order_relaxed);
+    if (finished) {
+        if (error.empty()) {
+            cache_listing(*scan_);
         }
-        
-    } catch (const std::filesystem::filesystem_error& e) {
-        error_message_ = "Error reading directory: " + std::string(e.what());
+        scan_thread_.join();
+        scan_.reset();
+        changed = true;
+    }
+    return changed;
+}
+
+bool FileBrowser::apply_watch_changes() {
+    std::vector<WatchedChange> changes;
+    bool rescan = false;
+    {
+        std::lock_guard lock(watch_->mutex);
+        changes.swap(watch_->changes);
+        rescan = std::exchange(watch_->rescan, false);
+    }
+    if (rescan) {
+        forget_listings(current_path_, true);
+        refresh();
+        return true;
+    }
+    if (changes.empty()) {
+        return false;
+    }
+
+    // The cached copy of this listing is stale now, as is any listing of a
+    // subdirectory that was created, replaced or removed.
+    forget_listings(current_path_, false);
+    for (const auto& change : changes) {
+        forget_listings(change.path, true);
+    }
+
+    const std::size_t first = !entries_.empty() && entries_.front().display_name == ".." ? 1 : 0;
+    std::filesystem::path selected;
+    if (selected_index_ < entries_.size()) {
+        selected = entries_[selected_index_].path;
+    }
+
+    const SortMode mode = sort_mode_;
+    auto compare = [mode](const FileEntry& a, const FileEntry& b) { return compare_entries(a, b, mode); };
+    const auto begin = static_cast<std::ptrdiff_t>(first);
+    for (auto& change : changes) {
+        auto existing = std::find_if(entries_.begin() + begin, entries_.end(),
+                                     [&change](const FileEntry& entry) { return entry.path == change.path; });
+        if (existing != entries_.end()) {
+            entries_.erase(existing);
+        }
+        if (change.entry) {
+            auto position = std::upper_bound(entries_.begin() + begin, entries_.end(), *change.entry, compare);
+            entries_.insert(position, std::move(*change.entry));
+        }
+    }
+
+    // A removed selection leaves the cursor on whatever slid into its row.
+    auto it = std::find_if(entries_.begin(), entries_.end(),
+                           [&selected](const FileEntry& entry) { return entry.path == selected; });
+    if (it != entries_.end()) {
+        selected_index_ = static_cast<std::size_t>(it - entries_.begin());
+    } else if (selected_index_ >= entries_.size()) {
+        selected_index_ = entries_.empty() ? 0 : entries_.size() - 1;
+    }
+    return true;
+}
+
+void FileBrowser::merge_batch(std::vector<FileEntry> batch) {
+    const std::size_t first = !entries_.empty() && entries_.front().display_name == ".." ? 1 : 0;
+
+    // Keep the cursor on the same entry while new ones are merged around it.
+    std::filesystem::path selected;
+    if (selected_index_ > 0 && selected_index_ < entries_.size()) {
+        selected = entries_[selected_index_].path;
+    }
+
+    // A batch sorted before a sort-mode change is re-sorted here.
+    const SortMode mode = sort_mode_;
+    auto compare = [mode](const FileEntry& a, const FileEntry& b) { return compare_entries(a, b, mode); };
+    if (!std::is_sorted(batch.begin(), batch.end(), compare)) {
+        std::sort(batch.begin(), batch.end(), compare);
+    }
+
+    const auto middle = static_cast<std::ptrdiff_t>(entries_.size());
+    entries_.insert(entries_.end(), std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+    std::inplace_merge(entries_.begin() + static_cast<std::ptrdiff_t>(first), entries_.begin() + middle,
+                       entries_.end(), compare);
+
+    if (!selected.empty()) {
+        auto it = std::find_if(entries_.begin(), entries_.end(),
+                               [&selected](const FileEntry& entry) { return entry.path == selected; });
+        if (it != entries_.end()) {
+            selected_index_ = static_cast<std::size_t>(it - entries_.begin());
+        }
+    }
+}
+
+bool FileBrowser::scanning() const {
+    return scan_ != nullptr;
+}
+
+ScanProgress FileBrowser::scan_progress() const {
+    ScanProgress progress;
+    progress.scanning = scanning();
+    progress.entries_seen = scan_ ? scan_->entries_seen.load(std::memory_order_relaxed) : entries_seen_;
+    progress.entries_listed = entries_.size();
+    if (!entries_.empty() && entries_.front().display_name == "..") {
+        --progress.entries_listed;
     }
+    return progress;
+}
+
+void FileBrowser::cancel_scan() {
+    if (!scan_) {
+        return;
+    }
+
+    scan_->cancelled.store(true);
+    {
+        std::lock_guard lock(scan_->callback_mutex);
+        scan_->on_update = nullptr;
+    }
+    retired_scans_.emplace_back(std::move(scan_), std::move(scan_thread_));
+    scan_.reset();
+    reap_finished_scans();
+}
+
+// Cancelled scans may still be blocked in readdir on a slow mount; they are
+// joined once they notice the flag rather than stalling navigation.
+void FileBrowser::reap_finished_scans() {
+    for (auto it = retired_scans_.begin(); it != retired_scans_.end();) {
+        if (it->first->finished.load()) {
+            it->second.join();
+            it = retired_scans_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool FileBrowser::compare_entries(const FileEntry& a, const FileEntry& b, SortMode mode) {
+    if (a.is_directory != b.is_directory) {
+        return a.is_directory;
+    }
+    if (!a.is_directory) {
+        switch (mode) {
+            case SortMode::Name:
+                break;
+            case SortMode::Size:
+                if (a.size != b.size) return a.size > b.size;
+                break;
+            case SortMode::Modified:
+                if (a.mtime_ns != b.mtime_ns) return a.mtime_ns > b.mtime_ns;
+                break;
+            case SortMode::Duration:
+                if (a.duration_ms != b.duration_ms) return a.duration_ms > b.duration_ms;
+                break;
+            case SortMode::Channels:
+                if (a.channels != b.channels) return a.channels > b.channels;
+                break;
+        }
+    }
+    if (a.collation_key != b.collation_key) {
+        return a.collation_key < b.collation_key;
+    }
+    return a.display_name < b.display_name;
 }
 
 void FileBrowser::select_next() {
@@ -153,15 +870,22 @@ std::filesystem::path FileBrowser::get_selected_file() const {
 }
 
 bool FileBrowser::is_module_file(const std::filesystem::path& path) {
-    if (!path.has_extension()) {
-        return false;
-    }
+    std::string name = path.filename().string();
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
     
-    std::string ext = path.extension().string();
-    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    const std::size_t dot = name.rfind('.');
+    if (dot != std::string::npos && dot > 0 &&
+        std::find(module_extensions_.begin(), module_extensions_.end(), name.substr(dot)) 
+            != module_extensions_.end()) {
+        return true;
+    }
     
-    return std::find(module_extensions_.begin(), module_extensions_.end(), ext) 
-           != module_extensions_.end();
+    const std::size_t prefix_end = name.find('.');
+    if (prefix_end == std::string::npos || prefix_end + 1 == name.size()) {
+        return false;
+    }
+    return std::find(amiga_prefixes_.begin(), amiga_prefixes_.end(), name.substr(0, prefix_end + 1)) 
+           != amiga_prefixes_.end();
 }
 
 void FileBrowser::clear_error() {
@@ -1,10 +1,15 @@
 #include "file_browser_ui.hpp"
+#include "library_search.hpp"
+#include "list_viewport.hpp"
 #include <ftxui/component/component.hpp>
 #include <ftxui/component/event.hpp>
 #include <ftxui/component/screen_interactive.hpp>
 #include <ftxui/dom/elements.hpp>
+#include <ftxui/screen/terminal.hpp>
+#include <algorithm>
 #include <iomanip>
 #include <sstream>
+#include <unordered_map>
 
 namespace tracker {
 
@@ -20,74 +25,225 @@ ftxui::Color kTextDim = ftxui::Color::RGB(160, 164, 182);
 ftxui::Color kSuccess = ftxui::Color::RGB(124, 200, 146);
 ftxui::Color kWarning = ftxui::Color::RGB(230, 196, 84);
 
-std::string format_file_size(std::size_t bytes) {
-    std::ostringstream oss;
-    if (bytes < 1024) {
-        oss << bytes << " B";
-    } else if (bytes < 1024 * 1024) {
-        oss << std::fixed << std::setprecision(1) << (bytes / 1024.0) << " KB";
-    } else {
-        oss << std::fixed << std::setprecision(1) << (bytes / (1024.0 * 1024.0)) << " MB";
-    }
-    return oss.str();
+// Title, path line, help line, three separators and the border.
+constexpr int kChromeRows = 8;
+constexpr std::size_t kViewportMargin = 4;
+
+std::size_t visible_list_rows() {
+    return static_cast<std::size_t>(std::max(1, ftxui::Terminal::Size().dimy - kChromeRows));
+}
+
 }
 
+ftxui::Element render_file_entries(const std::vector<FileEntry>& entries, std::size_t selected,
+                                   std::size_t begin, std::size_t end) {
+    using namespace ftxui;
+
+    Elements file_list;
+    file_list.reserve(end > begin ? end - begin : 0);
+    for (std::size_t i = begin; i < end && i < entries.size(); ++i) {
+        const auto& entry = entries[i];
+        bool is_selected = (i == selected);
+        
+        auto line = hbox({
+            text((entry.is_directory ? "📁 " : "🎵 ") + entry.display_name) | flex,
+            entry.duplicate_count > 1 ? text(" ⧉" + std::to_string(entry.duplicate_count)) | color(kWarning)
+                                      : text(""),
+            text("  "),
+            text(entry.size_label) | align_right | size(WIDTH, EQUAL, 12)
+        });
+        
+        if (is_selected) {
+            line = line | bgcolor(kPanelAlt) | color(kAccent) | bold | focus;
+        } else if (entry.is_directory) {
+            line = line | color(kSuccess);
+        } else {
+            line = line | color(kText);
+        }
+        
+        file_list.push_back(line);
+    }
+    return vbox(std::move(file_list));
 }
 
-std::optional<std::filesystem::path> run_file_browser_ui(const std::filesystem::path& start_dir) {
+std::optional<std::filesystem::path> run_file_browser_ui(const std::filesystem::path& start_dir,
+                                                         std::shared_ptr<const ModuleDetector> detector,
+                                                         std::shared_ptr<const LibraryIndex> library,
+                                                         PreviewCallback preview,
+                                                         std::shared_ptr<Playlist> queue) {
     using namespace ftxui;
     
+    // The screen must outlive the browser: scan threads post wake-up events
+    // to it until the browser is destroyed.
+    auto screen = ScreenInteractive::Fullscreen();
+    
     FileBrowser browser(start_dir);
+    browser.set_update_callback([&screen] { screen.PostEvent(Event::Custom); });
+    if (library && library->is_open()) {
+        auto duplicate_counts = std::make_shared<std::unordered_map<std::uint32_t, std::uint32_t>>();
+        for (std::size_t i = 0; i < library->size(); ++i) {
+            if (const std::uint32_t group = library->entry(i).duplicate_group) {
+                ++(*duplicate_counts)[group];
+            }
+        }
+        browser.set_metadata_lookup([library, duplicate_counts](const std::filesystem::path& path,
+                                                                EntryMetadata& metadata) {
+            auto found = library->find(path.string());
+            if (!found) {
+                return false;
+            }
+            const LibraryIndex::Entry entry = library->entry(*found);
+            metadata.duration_ms = entry.duration_ms;
+            metadata.channels = entry.channels;
+            if (entry.duplicate_group != 0) {
+                metadata.duplicate_count = duplicate_counts->at(entry.duplicate_group);
+            }
+            return true;
+        });
+    }
+    if (detector) {
+        browser.set_detector(std::move(detector));
+    }
+    browser.set_watching(true);
+    LibrarySearcher searcher;
+    searcher.set_update_callback([&screen] { screen.PostEvent(Event::Custom); });
+    bool search_mode = false;
+    std::string search_query;
+    std::size_t search_selected = 0;
+    ListViewport file_viewport;
+    ListViewport search_viewport;
     std::optional<std::filesystem::path> selected_file;
     bool quit = false;
+    bool preview_enabled = static_cast<bool>(preview);
+    std::filesystem::path previewed;
+
+    // The preview loader debounces, so this can run on every frame.
+    auto update_preview = [&](const std::filesystem::path& target) {
+        if (preview_enabled && target != previewed) {
+            previewed = target;
+            preview(target);
+        }
+    };
     
-    auto screen = ScreenInteractive::Fullscreen();
-    
-    auto component = Renderer([&] {
-        Elements file_list;
-        
-        const auto& entries = browser.entries();
-        const std::size_t selected = browser.selected_index();
-        
-        for (std::size_t i = 0; i < entries.size(); ++i) {
-            const auto& entry = entries[i];
-            bool is_selected = (i == selected);
-            
-            std::string prefix = entry.is_directory ? "📁 " : "🎵 ";
-            std::string name = entry.display_name;
-            std::string size_str = entry.is_directory ? "<DIR>" : format_file_size(entry.size);
-            
-            auto name_element = text(prefix + name);
-            auto size_element = text(size_str) | align_right;
-            
+    auto render_search = [&] {
+        if (searcher.poll()) {
+            search_selected = 0;
+        }
+        const auto& results = searcher.results();
+        search_selected = std::min(search_selected, results.empty() ? 0 : results.size() - 1);
+        update_preview(search_selected < results.size() ? std::filesystem::path(results[search_selected].path)
+                                                         : std::filesystem::path());
+
+        search_viewport.update(results.size(), search_selected, visible_list_rows());
+        Elements result_list;
+        for (std::size_t i = search_viewport.begin(kViewportMargin);
+             i < search_viewport.end(results.size(), kViewportMargin); ++i) {
+            const auto& result = results[i];
+            std::string file_name = std::filesystem::path(result.path).filename().string();
+            std::string label = result.title.empty() ? file_name : result.title;
+            std::string detail = result.artist.empty() ? file_name : result.artist + " · " + file_name;
+
             auto line = hbox({
-                name_element | flex,
+                text("🎵 " + label) | flex,
                 text("  "),
-                size_element | size(WIDTH, EQUAL, 12)
+                text(detail) | color(kTextDim)
             });
-            
-            if (is_selected) {
+            if (i == search_selected) {
                 line = line | bgcolor(kPanelAlt) | color(kAccent) | bold | focus;
-            } else if (entry.is_directory) {
-                line = line | color(kSuccess);
             } else {
                 line = line | color(kText);
             }
-            
-            file_list.push_back(line);
+            result_list.push_back(line);
+        }
+
+        std::string status;
+        const std::string error = searcher.error_message();
+        if (!error.empty()) {
+            status = error;
+        } else if (!searcher.query_error().empty()) {
+            status = searcher.query_error();
+        } else if (!searcher.ready()) {
+            status = "Loading library index...";
+        } else if (search_query.empty()) {
+            status = std::to_string(searcher.indexed_count()) + " modules indexed";
+        } else {
+            std::ostringstream oss;
+            oss << results.size() << (results.size() >= LibrarySearcher::kMaxResults ? "+" : "") << " matches ("
+                << std::fixed << std::setprecision(1) << searcher.last_query_milliseconds() << " ms)";
+            status = oss.str();
+        }
+        if (result_list.empty()) {
+            result_list.push_back(text(search_query.empty()
+                                           ? "Type to search the library, or filter: ch=4 format=mod duration<3:00"
+                                           : "No matches") |
+                                  color(kTextDim) | dim | center);
         }
+
+        auto search_line = hbox({
+            text("🔎 /") | color(kAccent) | bold,
+            text(search_query) | color(kText),
+            text("▏") | color(kAccent) | blink | flex,
+            text(status + " ") | color(kTextDim)
+        });
+
+        auto help_text = hbox({
+            text("↑↓: Navigate  ") | color(kTextDim),
+            text("Enter: Play  ") | color(kTextDim),
+            queue ? text("Tab: Queue  ") | color(kTextDim) : text(""),
+            text("Esc: Back to files") | color(kWarning)
+        }) | center;
+
+        return vbox({
+            text("═══ cli-modplayer v1.3.0 ═══") | bold | color(kAccent) | center,
+            separator(),
+            search_line,
+            separator(),
+            vbox(result_list) | yflex | bgcolor(kPanel) | yframe,
+            separator(),
+            help_text
+        }) | border | color(kBorder) | bgcolor(kBackground);
+    };
+
+    auto component = Renderer([&] {
+        browser.poll();
+        if (search_mode) {
+            return render_search();
+        }
+        const auto& entries = browser.entries();
+        const std::size_t selected = browser.selected_index();
+        update_preview(browser.get_selected_file());
+        
+        file_viewport.update(entries.size(), selected, visible_list_rows());
+        Element file_list = render_file_entries(entries, selected, file_viewport.begin(kViewportMargin),
+                                                file_viewport.end(entries.size(), kViewportMargin));
         
-        if (file_list.empty()) {
-            file_list.push_back(text("No module files found") | color(kTextDim) | dim | center);
+        const ScanProgress progress = browser.scan_progress();
+        if (entries.empty() || (entries.size() == 1 && entries.front().display_name == "..")) {
+            file_list = vbox({file_list, text(progress.scanning ? "Scanning..." : "No module files found") |
+                                             color(kTextDim) | dim | center});
         }
         
-        auto current_path_display = text("📂 " + browser.current_path().string()) | 
-                                   color(kAccent) | bold;
+        auto current_path_display = hbox({
+            text("📂 " + browser.current_path().string()) | color(kAccent) | bold | flex,
+            progress.scanning
+                ? text("⟳ " + std::to_string(progress.entries_listed) + " listed / " +
+                       std::to_string(progress.entries_seen) + " scanned ") | color(kWarning)
+                : text(std::to_string(entries.empty() ? 0 : selected + 1) + "/" +
+                       std::to_string(progress.entries_listed) + " entries ") | color(kTextDim),
+            text("│ sort: " + std::string(FileBrowser::sort_mode_name(browser.sort_mode())) + " ") | color(kTextDim),
+            preview_enabled ? text("│ ♪ preview ") | color(kSuccess) : text(""),
+            queue && !queue->empty() ? text("│ queue: " + std::to_string(queue->size()) + " ") | color(kSuccess)
+                                     : text("")
+        });
         
         auto help_text = hbox({
             text("↑↓: Navigate  ") | color(kTextDim),
             text("Enter: Select/Open  ") | color(kTextDim),
             text("Backspace: Parent  ") | color(kTextDim),
+            text("/: Search library  ") | color(kTextDim),
+            text("S: Sort  ") | color(kTextDim),
+            preview ? text("P: Preview  ") | color(kTextDim) : text(""),
+            queue ? text("A: Queue  ") | color(kTextDim) : text(""),
             text("Q: Quit") | color(kWarning)
         }) | center;
         
@@ -96,7 +252,7 @@ std::optional<std::filesystem::path> run_file_browser_ui(const std::filesystem::
             separator(),
             current_path_display,
             separator(),
-            vbox(file_list) | yflex | bgcolor(kPanel) | vscroll_indicator | yframe | focus,
+            file_list | yflex | bgcolor(kPanel) | yframe,
             separator(),
             help_text
         }) | border | color(kBorder) | bgcolor(kBackground);
@@ -114,6 +270,85 @@ std::optional<std::filesystem::path> run_file_browser_ui(const std::filesystem::
     });
     
     component = CatchEvent(component, [&](Event event) {
+        if (search_mode) {
+            const auto& results = searcher.results();
+            if (event == Event::Escape) {
+                search_mode = false;
+                return true;
+            }
+            if (event == Event::ArrowDown) {
+                if (search_selected + 1 < results.size()) ++search_selected;
+                return true;
+            }
+            if (event == Event::ArrowUp) {
+                if (search_selected > 0) --search_selected;
+                return true;
+            }
+            if (event == Event::Return) {
+                if (search_selected < results.size()) {
+                    selected_file = results[search_selected].path;
+                    screen.Exit();
+                }
+                return true;
+            }
+            if (queue && event == Event::Tab) {
+                if (search_selected < results.size()) {
+                    queue->add(results[search_selected].path, results[search_selected].title);
+                }
+                return true;
+            }
+            if (event == Event::Backspace) {
+                if (!search_query.empty()) {
+                    while (search_query.size() > 1 && (static_cast<unsigned char>(search_query.back()) & 0xC0) == 0x80) {
+                        search_query.pop_back();
+                    }
+                    search_query.pop_back();
+                    searcher.submit(search_query);
+                }
+                return true;
+            }
+            if (event.is_character()) {
+                search_query += event.character();
+                searcher.submit(search_query);
+                return true;
+            }
+            return false;
+        }
+
+        if (event == Event::Character('s') || event == Event::Character('S')) {
+            const SortMode next = static_cast<SortMode>((static_cast<int>(browser.sort_mode()) + 1) %
+                                                        (static_cast<int>(SortMode::Channels) + 1));
+            browser.set_sort_mode(next);
+            return true;
+        }
+
+        if (preview && (event == Event::Character('p') || event == Event::Character('P'))) {
+            if (preview_enabled) {
+                update_preview({});
+            }
+            preview_enabled = !preview_enabled;
+            return true;
+        }
+
+        if (queue && (event == Event::Character('a') || event == Event::Character('A'))) {
+            const auto& entries = browser.entries();
+            const std::size_t selected = browser.selected_index();
+            if (selected < entries.size() && entries[selected].display_name != "..") {
+                if (entries[selected].is_directory) {
+                    queue->add_directory(entries[selected].path);
+                } else {
+                    queue->add(entries[selected].path);
+                }
+            }
+            return true;
+        }
+
+        if (event == Event::Character('/')) {
+            search_mode = true;
+            searcher.load(LibraryIndex::default_path());
+            return true;
+        }
+
         if (event == Event::Character('q') || event == Event::Character('Q') || 
             event == Event::Escape) {
             quit = true;
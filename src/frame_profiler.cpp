@@ -0,0 +1,109 @@
+#include "frame_profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace tracker {
+
+std::size_t RollingHistogram::bucket_for(std::uint64_t value) {
+    if (value == 0) {
+        return 0;
+    }
+    const double quarter_octaves = std::floor(4.0 * std::log2(static_cast<double>(value)));
+    return std::min(kBuckets - 1, static_cast<std::size_t>(quarter_octaves) + 1);
+}
+
+std::uint64_t RollingHistogram::bucket_limit(std::size_t bucket) {
+    if (bucket == 0) {
+        return 0;
+    }
+    return static_cast<std::uint64_t>(std::ceil(std::exp2(static_cast<double>(bucket) / 4.0)));
+}
+
+void RollingHistogram::add(std::uint64_t value) {
+    if (size_ == kWindow) {
+        --counts_[ring_[next_]];
+    } else {
+        ++size_;
+    }
+    const std::size_t bucket = bucket_for(value);
+    ring_[next_] = static_cast<std::uint8_t>(bucket);
+    ++counts_[bucket];
+    next_ = (next_ + 1) % kWindow;
+}
+
+std::uint64_t RollingHistogram::percentile(double fraction) const {
+    if (size_ == 0) {
+        return 0;
+    }
+    const auto rank = static_cast<std::size_t>(
+        std::ceil(std::clamp(fraction, 0.0, 1.0) * static_cast<double>(size_)));
+    std::size_t seen = 0;
+    for (std::size_t bucket = 0; bucket < kBuckets; ++bucket) {
+        seen += counts_[bucket];
+        if (seen >= std::max<std::size_t>(rank, 1)) {
+            return bucket_limit(bucket);
+        }
+    }
+    return bucket_limit(kBuckets - 1);
+}
+
+std::size_t FrameProfiler::add_phase(std::string name) {
+    names_.push_back(std::move(name));
+    phases_.emplace_back();
+    return phases_.size() - 1;
+}
+
+void FrameProfiler::record(std::size_t phase, Clock::duration elapsed) {
+    if (phase >= phases_.size()) {
+        return;
+    }
+    const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    phases_[phase].add(static_cast<std::uint64_t>(std::max<std::int64_t>(0, micros)));
+}
+
+void FrameProfiler::record_bytes(std::uint64_t bytes) {
+    bytes_.add(bytes);
+}
+
+std::vector<FrameProfiler::PhaseSummary> FrameProfiler::summary() const {
+    std::vector<PhaseSummary> result;
+    result.reserve(phases_.size());
+    for (std::size_t i = 0; i < phases_.size(); ++i) {
+        result.push_back({names_[i], phases_[i].percentile(0.5), phases_[i].percentile(0.99)});
+    }
+    return result;
+}
+
+std::uint64_t CountingStreambuf::take_bytes() {
+    return std::exchange(bytes_, 0);
+}
+
+FrameProfiler::Clock::duration CountingStreambuf::take_flush_time() {
+    return std::exchange(flush_time_, FrameProfiler::Clock::duration{});
+}
+
+CountingStreambuf::int_type CountingStreambuf::overflow(int_type ch) {
+    if (traits_type::eq_int_type(ch, traits_type::eof())) {
+        return traits_type::not_eof(ch);
+    }
+    ++bytes_;
+    return target_->sputc(traits_type::to_char_type(ch));
+}
+
+std::streamsize CountingStreambuf::xsputn(const char *data, std::streamsize count) {
+    const std::streamsize written = target_->sputn(data, count);
+    bytes_ += static_cast<std::uint64_t>(std::max<std::streamsize>(0, written));
+    return written;
+}
+
+int CountingStreambuf::sync() {
+    const auto start = FrameProfiler::Clock::now();
+    const int result = target_->pubsync();
+    last_flush_ = FrameProfiler::Clock::now();
+    flush_time_ += last_flush_ - start;
+    return result;
+}
+
+}
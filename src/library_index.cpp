@@ -0,0 +1,305 @@
+#include "library_index.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace tracker {
+
+namespace {
+
+constexpr char kMagic[8] = {'C', 'L', 'T', 'R', 'K', 'I', 'D', 'X'};
+constexpr std::uint32_t kVersion = 2;
+
+struct DiskString {
+    std::uint32_t offset;
+    std::uint32_t length;
+};
+
+struct DiskHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t record_count;
+    std::uint64_t records_offset;
+    std::uint64_t strings_offset;
+    std::uint64_t strings_size;
+    std::uint64_t reserved;
+};
+
+struct DiskRecord {
+    DiskString path;
+    DiskString format;
+    DiskString title;
+    DiskString artist;
+    DiskString tracker;
+    std::uint64_t size;
+    std::int64_t mtime_ns;
+    std::uint64_t content_hash;
+    std::uint32_t duration_ms;
+    std::uint32_t flags;
+    std::uint16_t channels;
+    std::uint16_t patterns;
+    std::uint32_t duplicate_group;
+    DiskString envelope;
+};
+
+static_assert(sizeof(DiskHeader) == 48);
+static_assert(sizeof(DiskRecord) == 88);
+
+bool string_in_bounds(const DiskString& value, std::uint64_t strings_size) {
+    return static_cast<std::uint64_t>(value.offset) + value.length <= strings_size;
+}
+
+// Interns strings so repeated values such as format and tracker names are
+// stored once.
+class StringTableBuilder {
+public:
+    DiskString add(const std::string& value) {
+        auto it = offsets_.find(value);
+        if (it != offsets_.end()) {
+            return it->second;
+        }
+        DiskString stored{static_cast<std::uint32_t>(data_.size()), static_cast<std::uint32_t>(value.size())};
+        data_.insert(data_.end(), value.begin(), value.end());
+        offsets_.emplace(value, stored);
+        return stored;
+    }
+
+    const std::string& data() const noexcept { return data_; }
+
+private:
+    std::string data_;
+    std::unordered_map<std::string, DiskString> offsets_;
+};
+
+}
+
+LibraryRecord LibraryIndex::Entry::to_record() const {
+    LibraryRecord record;
+    record.path = std::string(path);
+    record.size = size;
+    record.mtime_ns = mtime_ns;
+    record.content_hash = content_hash;
+    record.format = std::string(format);
+    record.title = std::string(title);
+    record.artist = std::string(artist);
+    record.tracker = std::string(tracker);
+    record.channels = channels;
+    record.patterns = patterns;
+    record.duration_ms = duration_ms;
+    record.flags = flags;
+    record.duplicate_group = duplicate_group;
+    record.envelope = std::string(envelope);
+    return record;
+}
+
+LibraryIndex::~LibraryIndex() {
+    close();
+}
+
+LibraryIndex::LibraryIndex(LibraryIndex&& other) noexcept {
+    *this = std::move(other);
+}
+
+LibraryIndex& LibraryIndex::operator=(LibraryIndex&& other) noexcept {
+    if (this != &other) {
+        close();
+        data_ = std::exchange(other.data_, nullptr);
+        mapped_size_ = std::exchange(other.mapped_size_, 0);
+        record_count_ = std::exchange(other.record_count_, 0);
+        records_ = std::exchange(other.records_, nullptr);
+        strings_ = std::exchange(other.strings_, nullptr);
+    }
+    return *this;
+}
+
+void LibraryIndex::close() {
+    if (data_) {
+        munmap(const_cast<std::uint8_t*>(data_), mapped_size_);
+    }
+    data_ = nullptr;
+    mapped_size_ = 0;
+    record_count_ = 0;
+    records_ = nullptr;
+    strings_ = nullptr;
+}
+
+bool LibraryIndex::open(const std::filesystem::path& file, std::string& error_message) {
+    close();
+
+    int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error_message = "Failed to open library index: " + std::string(std::strerror(errno));
+        return false;
+    }
+
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(DiskHeader)) {
+        ::close(fd);
+        error_message = "Library index is truncated";
+        return false;
+    }
+
+    const auto size = static_cast<std::size_t>(info.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        error_message = "Failed to map library index: " + std::string(std::strerror(errno));
+        return false;
+    }
+
+    const auto* bytes = static_cast<const std::uint8_t*>(mapping);
+    DiskHeader header;
+    std::memcpy(&header, bytes, sizeof(header));
+
+    const std::uint64_t records_end =
+        header.records_offset + static_cast<std::uint64_t>(header.record_count) * sizeof(DiskRecord);
+    bool valid = std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.version == kVersion &&
+                 header.records_offset % alignof(DiskRecord) == 0 && records_end <= size &&
+                 header.strings_offset + header.strings_size <= size;
+
+    const auto* records = reinterpret_cast<const DiskRecord*>(bytes + header.records_offset);
+    for (std::uint32_t i = 0; valid && i < header.record_count; ++i) {
+        const DiskRecord& record = records[i];
+        valid = string_in_bounds(record.path, header.strings_size) &&
+                string_in_bounds(record.format, header.strings_size) &&
+                string_in_bounds(record.title, header.strings_size) &&
+                string_in_bounds(record.artist, header.strings_size) &&
+                string_in_bounds(record.tracker, header.strings_size) &&
+                string_in_bounds(record.envelope, header.strings_size);
+    }
+
+    if (!valid) {
+        munmap(mapping, size);
+        error_message = "Library index is corrupt or from an incompatible version";
+        return false;
+    }
+
+    data_ = bytes;
+    mapped_size_ = size;
+    record_count_ = header.record_count;
+    records_ = bytes + header.records_offset;
+    strings_ = reinterpret_cast<const char*>(bytes + header.strings_offset);
+    return true;
+}
+
+LibraryIndex::Entry LibraryIndex::entry(std::size_t index) const {
+    const auto& record = reinterpret_cast<const DiskRecord*>(records_)[index];
+    auto view = [this](const DiskString& value) { return std::string_view(strings_ + value.offset, value.length); };
+    return Entry{view(record.path),  view(record.format),  view(record.title),   view(record.artist),
+                 view(record.tracker), record.size,         record.mtime_ns,      record.content_hash,
+                 record.channels,     record.patterns,      record.duration_ms,   record.flags,
+                 record.duplicate_group, view(record.envelope)};
+}
+
+std::optional<std::size_t> LibraryIndex::find(std::string_view path) const {
+    std::size_t low = 0;
+    std::size_t high = record_count_;
+    while (low < high) {
+        const std::size_t middle = low + (high - low) / 2;
+        const std::string_view candidate = entry(middle).path;
+        if (candidate < path) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low < record_count_ && entry(low).path == path) {
+        return low;
+    }
+    return std::nullopt;
+}
+
+bool LibraryIndex::write(const std::filesystem::path& file, std::vector<LibraryRecord> records,
+                         std::string& error_message) {
+    std::sort(records.begin(), records.end(),
+              [](const LibraryRecord& a, const LibraryRecord& b) { return a.path < b.path; });
+
+    StringTableBuilder strings;
+    std::vector<DiskRecord> disk_records;
+    disk_records.reserve(records.size());
+    for (const auto& record : records) {
+        DiskRecord disk{};
+        disk.path = strings.add(record.path);
+        disk.format = strings.add(record.format);
+        disk.title = strings.add(record.title);
+        disk.artist = strings.add(record.artist);
+        disk.tracker = strings.add(record.tracker);
+        disk.size = record.size;
+        disk.mtime_ns = record.mtime_ns;
+        disk.content_hash = record.content_hash;
+        disk.duration_ms = record.duration_ms;
+        disk.flags = record.flags;
+        disk.channels = record.channels;
+        disk.patterns = record.patterns;
+        disk.duplicate_group = record.duplicate_group;
+        disk.envelope = strings.add(record.envelope);
+        disk_records.push_back(disk);
+    }
+
+    DiskHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.record_count = static_cast<std::uint32_t>(disk_records.size());
+    header.records_offset = sizeof(DiskHeader);
+    header.strings_offset = header.records_offset + disk_records.size() * sizeof(DiskRecord);
+    header.strings_size = strings.data().size();
+
+    std::error_code ec;
+    std::filesystem::create_directories(file.parent_path(), ec);
+
+    std::filesystem::path temp = file;
+    temp += ".tmp" + std::to_string(::getpid());
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            error_message = "Failed to create library index: " + temp.string();
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(disk_records.data()),
+                  static_cast<std::streamsize>(disk_records.size() * sizeof(DiskRecord)));
+        out.write(strings.data().data(), static_cast<std::streamsize>(strings.data().size()));
+        out.close();
+        if (!out) {
+            std::filesystem::remove(temp, ec);
+            error_message = "Failed to write library index: " + temp.string();
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temp, file, ec);
+    if (ec) {
+        std::filesystem::remove(temp, ec);
+        error_message = "Failed to replace library index: " + ec.message();
+        return false;
+    }
+    return true;
+}
+
+std::filesystem::path LibraryIndex::default_path() {
+    std::filesystem::path cache_dir;
+    const char* xdg_cache = std::getenv("XDG_CACHE_HOME");
+    if (xdg_cache && std::strlen(xdg_cache) > 0) {
+        cache_dir = xdg_cache;
+    } else {
+        const char* home = std::getenv("HOME");
+        if (!home || std::strlen(home) == 0) {
+            return "library.idx";
+        }
+        cache_dir = std::filesystem::path(home) / ".cache";
+    }
+    return cache_dir / "cli-tracker" / "library.idx";
+}
+
+}
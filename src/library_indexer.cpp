@@ -0,0 +1,295 @@
+#include "library_indexer.hpp"
+#include "file_browser.hpp"
+
+#include <chrono>
+#include <system_error>
+#include <iterator>
+#include <string_view>
+#include <unordered_set>
+
+#include <sys/stat.h>
+
+namespace tracker {
+
+namespace {
+
+constexpr std::size_t kProgressInterval = 256;
+
+}
+
+double IndexStats::files_per_second() const {
+    return elapsed_seconds > 0.0 ? static_cast<double>(files_seen) / elapsed_seconds : 0.0;
+}
+
+double IndexStats::parsed_files_per_second() const {
+    return parse_seconds > 0.0 ? static_cast<double>(parsed + failed) / parse_seconds : 0.0;
+}
+
+LibraryIndexer::LibraryIndexer(MetadataReader reader, ExtractorOptions options)
+    : extractor_(std::move(reader), options), threads_(options.threads) {}
+
+std::uint64_t LibraryIndexer::hash_content(const std::uint8_t* data, std::size_t size) {
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+bool LibraryIndexer::update(const std::vector<std::filesystem::path>& roots, const LibraryIndex& previous,
+                            std::vector<LibraryRecord>& records, std::string& error_message) {
+    const auto start = std::chrono::steady_clock::now();
+    stats_ = IndexStats{};
+    records.clear();
+    error_message.clear();
+
+    std::unordered_set<std::string> seen;
+    std::vector<DetectionCandidate> pending;
+    bool any_root = false;
+    for (const auto& root : roots) {
+        std::string root_error;
+        if (walk(root, previous, records, pending, seen, root_error)) {
+            any_root = true;
+            continue;
+        }
+        keep_previous(root, previous, records, seen);
+        ++stats_.failed_roots;
+        error_message += (error_message.empty() ? "" : "; ") + root_error;
+    }
+
+    process_pending(pending, records);
+    find_duplicates(records);
+
+    for (std::size_t i = 0; i < previous.size(); ++i) {
+        if (seen.find(std::string(previous.entry(i).path)) == seen.end()) {
+            ++stats_.removed;
+        }
+    }
+
+    stats_.elapsed_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report_progress();
+    return any_root || roots.empty();
+}
+
+bool LibraryIndexer::apply_changes(const LibraryIndex& previous, const std::vector<DirectoryChange>& changes,
+                                   std::vector<LibraryRecord>& records, std::string& error_message) {
+    const auto start = std::chrono::steady_clock::now();
+    stats_ = IndexStats{};
+    records.clear();
+
+    std::unordered_set<std::string> changed;
+    for (const auto& change : changes) {
+        changed.insert(change.path.lexically_normal().string());
+    }
+
+    // A record is replaced when its own path or any ancestor directory
+    // changed; everything else is carried over untouched.
+    auto is_changed = [&changed](std::string_view path) {
+        while (!path.empty()) {
+            if (changed.find(std::string(path)) != changed.end()) {
+                return true;
+            }
+            const std::size_t slash = path.rfind('/');
+            if (slash == std::string_view::npos || slash == 0) {
+                break;
+            }
+            path = path.substr(0, slash);
+        }
+        return false;
+    };
+
+    std::vector<std::size_t> replaced;
+    for (std::size_t i = 0; i < previous.size(); ++i) {
+        LibraryIndex::Entry entry = previous.entry(i);
+        if (is_changed(entry.path)) {
+            replaced.push_back(i);
+        } else {
+            records.push_back(entry.to_record());
+        }
+    }
+
+    error_message.clear();
+    std::unordered_set<std::string> seen;
+    std::vector<DetectionCandidate> pending;
+    for (const auto& change : changes) {
+        if (change.kind == DirectoryChange::Kind::Removed) {
+            continue;
+        }
+        const std::filesystem::path path = change.path.lexically_normal();
+        if (change.is_directory) {
+            std::string walk_error;
+            if (!walk(path, previous, records, pending, seen, walk_error)) {
+                keep_previous(path, previous, records, seen);
+                ++stats_.failed_roots;
+                error_message += (error_message.empty() ? "" : "; ") + walk_error;
+            }
+        } else if (detector_ || FileBrowser::is_module_file(path)) {
+            if (seen.insert(path.string()).second) {
+                visit_file(path, previous, records, pending);
+            }
+        }
+    }
+
+    process_pending(pending, records);
+    find_duplicates(records);
+
+    for (std::size_t index : replaced) {
+        if (seen.find(std::string(previous.entry(index).path)) == seen.end()) {
+            ++stats_.removed;
+        }
+    }
+
+    stats_.elapsed_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+bool LibraryIndexer::walk(const std::filesystem::path& root, const LibraryIndex& previous,
+                          std::vector<LibraryRecord>& records, std::vector<DetectionCandidate>& pending,
+                          std::unordered_set<std::string>& seen, std::string& error_message) {
+    std::error_code ec;
+    std::filesystem::recursive_directory_iterator it(
+        root, std::filesystem::directory_options::skip_permission_denied, ec);
+    if (ec) {
+        error_message = "Cannot read library root " + root.string() + ": " + ec.message();
+        return false;
+    }
+
+    for (std::filesystem::recursive_directory_iterator end; it != end; it.increment(ec)) {
+        if (ec) {
+            error_message = "Stopped reading library root " + root.string() + ": " + ec.message();
+            return false;
+        }
+        const auto& entry = *it;
+        std::error_code type_ec;
+        if (!entry.is_regular_file(type_ec) || (!detector_ && !FileBrowser::is_module_file(entry.path()))) {
+            continue;
+        }
+        const std::filesystem::path path = entry.path().lexically_normal();
+        if (!seen.insert(path.string()).second) {
+            continue;
+        }
+        if (visit_file(path, previous, records, pending) && stats_.files_seen % kProgressInterval == 0) {
+            report_progress();
+        }
+    }
+    return true;
+}
+
+// Records under root the failed walk did not reach are carried over as
+// they were, so an unmounted or unreadable root is not reported as removed.
+void LibraryIndexer::keep_previous(const std::filesystem::path& root, const LibraryIndex& previous,
+                                   std::vector<LibraryRecord>& records, std::unordered_set<std::string>& seen) {
+    std::string prefix = root.lexically_normal().string();
+    while (prefix.size() > 1 && prefix.back() == '/') {
+        prefix.pop_back();
+    }
+    if (prefix.back() != '/') {
+        prefix += '/';
+    }
+
+    for (std::size_t i = 0; i < previous.size(); ++i) {
+        LibraryIndex::Entry entry = previous.entry(i);
+        if (entry.path.substr(0, prefix.size()) != prefix) {
+            continue;
+        }
+        if (seen.insert(std::string(entry.path)).second) {
+            records.push_back(entry.to_record());
+        }
+    }
+}
+
+void LibraryIndexer::process_pending(std::vector<DetectionCandidate>& pending, std::vector<LibraryRecord>& records) {
+    if (detector_) {
+        detector_->classify(pending);
+    } else {
+        for (auto& candidate : pending) {
+            candidate.is_module = true;
+        }
+    }
+
+    std::vector<DetectionCandidate> modules;
+    for (auto& candidate : pending) {
+        if (candidate.is_module) {
+            modules.push_back(std::move(candidate));
+            continue;
+        }
+        LibraryRecord record;
+        record.path = candidate.path.string();
+        record.size = candidate.size;
+        record.mtime_ns = candidate.mtime_ns;
+        record.flags = LibraryRecord::kProbed;
+        records.push_back(std::move(record));
+        ++stats_.not_modules;
+    }
+
+    // Progress comes from the pool's workers; only the count changes there.
+    extractor_.set_progress_callback([this](std::size_t done) {
+        if (done % kProgressInterval == 0 && progress_callback_) {
+            IndexStats snapshot = stats_;
+            snapshot.parsed = done;
+            progress_callback_(snapshot);
+        }
+    });
+    std::vector<LibraryRecord> parsed;
+    extractor_.extract(modules,
+                       detector_ ? LibraryRecord::kProbed | LibraryRecord::kDetectedModule : 0, parsed);
+    records.insert(records.end(), std::make_move_iterator(parsed.begin()), std::make_move_iterator(parsed.end()));
+
+    const ExtractorStats& extracted = extractor_.stats();
+    stats_.parsed = extracted.parsed;
+    stats_.failed = extracted.failed;
+    stats_.bytes_read = extracted.bytes_read;
+    stats_.peak_bytes_in_flight = extracted.peak_bytes_in_flight;
+    stats_.threads = extracted.threads;
+    stats_.parse_seconds = extracted.elapsed_seconds;
+}
+
+void LibraryIndexer::find_duplicates(std::vector<LibraryRecord>& records) {
+    DuplicateFinder finder(threads_);
+    duplicates_ = finder.find(records);
+    stats_.duplicate_groups = finder.stats().groups;
+    stats_.duplicate_files = finder.stats().duplicate_files;
+    stats_.reclaimable_bytes = finder.stats().reclaimable_bytes;
+}
+
+void LibraryIndexer::report_progress() {
+    if (progress_callback_) {
+        progress_callback_(stats_);
+    }
+}
+
+bool LibraryIndexer::visit_file(const std::filesystem::path& path, const LibraryIndex& previous,
+                                std::vector<LibraryRecord>& records, std::vector<DetectionCandidate>& pending) {
+    struct stat info{};
+    if (::stat(path.c_str(), &info) != 0) {
+        return false;
+    }
+    ++stats_.files_seen;
+
+    DetectionCandidate candidate;
+    candidate.path = path;
+    candidate.size = static_cast<std::uint64_t>(info.st_size);
+    candidate.mtime_ns = static_cast<std::int64_t>(info.st_mtim.tv_sec) * 1'000'000'000 + info.st_mtim.tv_nsec;
+    candidate.has_module_extension = FileBrowser::is_module_file(path);
+
+    // Records indexed by extension alone are probed once detection is on.
+    if (auto existing = previous.find(path.string())) {
+        LibraryIndex::Entry entry = previous.entry(*existing);
+        if (entry.size == candidate.size && entry.mtime_ns == candidate.mtime_ns &&
+            (!detector_ || (entry.flags & LibraryRecord::kProbed)) &&
+            (!envelopes_ || (entry.flags & LibraryRecord::kEnvelopeChecked) ||
+             !LibraryRecord::is_listed_module(entry.flags))) {
+            records.push_back(entry.to_record());
+            ++stats_.reused;
+            return true;
+        }
+    }
+
+    pending.push_back(std::move(candidate));
+    return true;
+}
+
+}
@@ -0,0 +1,499 @@
+#include "library_query.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <numeric>
+#include <unordered_map>
+
+namespace tracker {
+
+namespace {
+
+struct FieldName {
+    const char* name;
+    QueryField field;
+};
+
+constexpr FieldName kFieldNames[] = {
+    {"path", QueryField::Path},         {"file", QueryField::Path},         {"title", QueryField::Title},
+    {"name", QueryField::Title},        {"artist", QueryField::Artist},     {"author", QueryField::Artist},
+    {"tracker", QueryField::Tracker},   {"format", QueryField::Format},     {"type", QueryField::Format},
+    {"channels", QueryField::Channels}, {"ch", QueryField::Channels},       {"patterns", QueryField::Patterns},
+    {"duration", QueryField::Duration}, {"length", QueryField::Duration},   {"time", QueryField::Duration},
+    {"size", QueryField::Size},
+};
+
+std::string lowercase(std::string_view text) {
+    std::string out;
+    out.reserve(text.size());
+    for (unsigned char c : text) {
+        out.push_back(static_cast<char>(std::tolower(c)));
+    }
+    return out;
+}
+
+bool lookup_field(std::string_view name, QueryField& field) {
+    const std::string lowered = lowercase(name);
+    for (const auto& entry : kFieldNames) {
+        if (lowered == entry.name) {
+            field = entry.field;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool is_numeric(QueryField field) {
+    return field == QueryField::Channels || field == QueryField::Patterns || field == QueryField::Duration ||
+           field == QueryField::Size;
+}
+
+struct Term {
+    std::string name;
+    std::string op;
+    std::string value;
+    bool has_op = false;
+};
+
+// Splits on whitespace outside double quotes. A term is either
+// name<op>value or a bare word; quotes are stripped from values.
+std::vector<Term> tokenize(std::string_view text) {
+    std::vector<Term> terms;
+    std::size_t i = 0;
+    while (i < text.size()) {
+        while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i]))) {
+            ++i;
+        }
+        if (i >= text.size()) {
+            break;
+        }
+
+        Term term;
+        std::size_t name_end = i;
+        while (name_end < text.size() &&
+               (std::isalpha(static_cast<unsigned char>(text[name_end])) || text[name_end] == '_')) {
+            ++name_end;
+        }
+        std::size_t op_end = name_end;
+        if (name_end > i && name_end < text.size()) {
+            const std::string_view rest = text.substr(name_end);
+            if (rest.rfind("!=", 0) == 0 || rest.rfind("<=", 0) == 0 || rest.rfind(">=", 0) == 0) {
+                op_end = name_end + 2;
+            } else if (rest[0] == '=' || rest[0] == '<' || rest[0] == '>' || rest[0] == '~' || rest[0] == ':') {
+                op_end = name_end + 1;
+            }
+        }
+        std::size_t value_start = i;
+        if (op_end > name_end) {
+            term.has_op = true;
+            term.name = std::string(text.substr(i, name_end - i));
+            term.op = std::string(text.substr(name_end, op_end - name_end));
+            value_start = op_end;
+        }
+
+        bool quoted = false;
+        i = value_start;
+        while (i < text.size() && (quoted || !std::isspace(static_cast<unsigned char>(text[i])))) {
+            if (text[i] == '"') {
+                quoted = !quoted;
+            } else {
+                term.value.push_back(text[i]);
+            }
+            ++i;
+        }
+        terms.push_back(std::move(term));
+    }
+    return terms;
+}
+
+bool parse_number(const std::string& text, double& value) {
+    if (text.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    value = std::strtod(text.c_str(), &end);
+    return end == text.c_str() + text.size() && std::isfinite(value) && value >= 0.0;
+}
+
+// "185", "185s", "3m", "3:05" or "1:02:03" into milliseconds.
+bool parse_duration(std::string text, std::uint64_t& milliseconds) {
+    double seconds = 0.0;
+    if (text.find(':') != std::string::npos) {
+        std::size_t start = 0;
+        while (true) {
+            const std::size_t colon = text.find(':', start);
+            double part = 0.0;
+            if (!parse_number(text.substr(start, colon - start), part)) {
+                return false;
+            }
+            seconds = seconds * 60.0 + part;
+            if (colon == std::string::npos) {
+                break;
+            }
+            start = colon + 1;
+        }
+    } else {
+        double scale = 1.0;
+        if (!text.empty() && (text.back() == 's' || text.back() == 'S')) {
+            text.pop_back();
+        } else if (!text.empty() && (text.back() == 'm' || text.back() == 'M')) {
+            text.pop_back();
+            scale = 60.0;
+        }
+        if (!parse_number(text, seconds)) {
+            return false;
+        }
+        seconds *= scale;
+    }
+    milliseconds = static_cast<std::uint64_t>(std::llround(seconds * 1000.0));
+    return true;
+}
+
+// "2048", "512k", "1.5mb" into bytes.
+bool parse_size(std::string text, std::uint64_t& bytes) {
+    text = lowercase(text);
+    if (!text.empty() && text.back() == 'b') {
+        text.pop_back();
+    }
+    double scale = 1.0;
+    if (!text.empty()) {
+        switch (text.back()) {
+            case 'k': scale = 1024.0; break;
+            case 'm': scale = 1024.0 * 1024.0; break;
+            case 'g': scale = 1024.0 * 1024.0 * 1024.0; break;
+            default: break;
+        }
+        if (scale != 1.0) {
+            text.pop_back();
+        }
+    }
+    double value = 0.0;
+    if (!parse_number(text, value)) {
+        return false;
+    }
+    bytes = static_cast<std::uint64_t>(std::llround(value * scale));
+    return true;
+}
+
+template <typename T, typename Compare>
+void filter_column(const std::vector<T>& column, std::vector<std::uint8_t>& mask, Compare compare) {
+    const T* values = column.data();
+    std::uint8_t* out = mask.data();
+    const std::size_t count = mask.size();
+    for (std::size_t i = 0; i < count; ++i) {
+        out[i] &= static_cast<std::uint8_t>(compare(values[i]));
+    }
+}
+
+template <typename T>
+void filter_numeric(const std::vector<T>& column, QueryOp op, std::uint64_t bound, std::vector<std::uint8_t>& mask) {
+    switch (op) {
+        case QueryOp::Equal:
+            filter_column(column, mask, [bound](T value) { return static_cast<std::uint64_t>(value) == bound; });
+            break;
+        case QueryOp::NotEqual:
+            filter_column(column, mask, [bound](T value) { return static_cast<std::uint64_t>(value) != bound; });
+            break;
+        case QueryOp::Less:
+            filter_column(column, mask, [bound](T value) { return static_cast<std::uint64_t>(value) < bound; });
+            break;
+        case QueryOp::LessEqual:
+            filter_column(column, mask, [bound](T value) { return static_cast<std::uint64_t>(value) <= bound; });
+            break;
+        case QueryOp::Greater:
+            filter_column(column, mask, [bound](T value) { return static_cast<std::uint64_t>(value) > bound; });
+            break;
+        case QueryOp::GreaterEqual:
+            filter_column(column, mask, [bound](T value) { return static_cast<std::uint64_t>(value) >= bound; });
+            break;
+        case QueryOp::Contains:
+            break;
+    }
+}
+
+bool string_matches(std::string_view value, const QueryPredicate& predicate) {
+    switch (predicate.op) {
+        case QueryOp::Equal: return value == predicate.text;
+        case QueryOp::NotEqual: return value != predicate.text;
+        case QueryOp::Contains: return value.find(predicate.text) != std::string_view::npos;
+        default: return false;
+    }
+}
+
+}
+
+const char* LibraryQuery::field_name(QueryField field) {
+    switch (field) {
+        case QueryField::Path: return "path";
+        case QueryField::Title: return "title";
+        case QueryField::Artist: return "artist";
+        case QueryField::Tracker: return "tracker";
+        case QueryField::Format: return "format";
+        case QueryField::Channels: return "channels";
+        case QueryField::Patterns: return "patterns";
+        case QueryField::Duration: return "duration";
+        case QueryField::Size: return "size";
+    }
+    return "path";
+}
+
+bool LibraryQuery::is_structured(std::string_view text) {
+    for (const Term& term : tokenize(text)) {
+        QueryField field = QueryField::Path;
+        const std::string name = lowercase(term.name);
+        if (term.has_op && (lookup_field(name, field) || (term.op == ":" && (name == "sort" || name == "limit")))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool LibraryQuery::parse(std::string_view text, LibraryQuery& query, std::string& error_message) {
+    query = LibraryQuery{};
+    for (Term& term : tokenize(text)) {
+        if (!term.has_op) {
+            if (!term.value.empty()) {
+                query.words.push_back(lowercase(term.value));
+            }
+            continue;
+        }
+
+        const std::string name = lowercase(term.name);
+        if (name == "sort" && term.op == ":") {
+            std::string_view key = term.value;
+            query.descending = !key.empty() && key.front() == '-';
+            if (query.descending) {
+                key.remove_prefix(1);
+            }
+            if (!lookup_field(key, query.sort_field)) {
+                error_message = "Unknown sort field '" + std::string(key) + "'";
+                return false;
+            }
+            continue;
+        }
+        if (name == "limit" && term.op == ":") {
+            double limit = 0.0;
+            if (!parse_number(term.value, limit) || limit < 1.0) {
+                error_message = "limit needs a positive number";
+                return false;
+            }
+            query.limit = static_cast<std::size_t>(limit);
+            continue;
+        }
+
+        QueryPredicate predicate;
+        if (!lookup_field(name, predicate.field)) {
+            error_message = "Unknown field '" + term.name + "'";
+            return false;
+        }
+        const bool numeric = is_numeric(predicate.field);
+        if (term.op == "=") predicate.op = QueryOp::Equal;
+        else if (term.op == "!=") predicate.op = QueryOp::NotEqual;
+        else if (term.op == "<") predicate.op = QueryOp::Less;
+        else if (term.op == "<=") predicate.op = QueryOp::LessEqual;
+        else if (term.op == ">") predicate.op = QueryOp::Greater;
+        else if (term.op == ">=") predicate.op = QueryOp::GreaterEqual;
+        else if (term.op == "~") predicate.op = QueryOp::Contains;
+        else predicate.op = numeric ? QueryOp::Equal : QueryOp::Contains;
+
+        if (numeric) {
+            if (predicate.op == QueryOp::Contains) {
+                error_message = std::string(field_name(predicate.field)) + " is numeric; use = < <= > >=";
+                return false;
+            }
+            bool valid = false;
+            if (predicate.field == QueryField::Duration) {
+                valid = parse_duration(term.value, predicate.number);
+            } else if (predicate.field == QueryField::Size) {
+                valid = parse_size(term.value, predicate.number);
+            } else {
+                double value = 0.0;
+                valid = parse_number(term.value, value) && value == std::floor(value);
+                predicate.number = static_cast<std::uint64_t>(value);
+            }
+            if (!valid) {
+                error_message = "Bad " + std::string(field_name(predicate.field)) + " value '" + term.value + "'";
+                return false;
+            }
+        } else {
+            if (predicate.op != QueryOp::Equal && predicate.op != QueryOp::NotEqual &&
+                predicate.op != QueryOp::Contains) {
+                error_message = std::string(field_name(predicate.field)) + " is text; use = != or ~";
+                return false;
+            }
+            predicate.text = lowercase(term.value);
+        }
+        query.predicates.push_back(std::move(predicate));
+    }
+    return true;
+}
+
+LibraryColumns::LibraryColumns(const LibraryIndex& index) {
+    const std::size_t count = index.size();
+    listed_.resize(count);
+    channels_.resize(count);
+    patterns_.resize(count);
+    duration_ms_.resize(count);
+    size_.resize(count);
+    paths_.resize(count);
+    titles_.resize(count);
+
+    std::unordered_map<std::string, std::uint32_t> tracker_codes;
+    std::unordered_map<std::string, std::uint32_t> format_codes;
+    std::unordered_map<std::string, std::uint32_t> artist_codes;
+    auto encode = [](Dictionary& dictionary, std::unordered_map<std::string, std::uint32_t>& codes,
+                     std::string_view value) {
+        std::string key = lowercase(value);
+        auto [it, inserted] = codes.try_emplace(key, static_cast<std::uint32_t>(dictionary.values.size()));
+        if (inserted) {
+            dictionary.values.push_back(std::move(key));
+        }
+        dictionary.codes.push_back(it->second);
+    };
+    auto append_text = [this](std::string_view value) {
+        TextSpan span{static_cast<std::uint32_t>(text_pool_.size()), static_cast<std::uint32_t>(value.size())};
+        for (unsigned char c : value) {
+            text_pool_.push_back(static_cast<char>(std::tolower(c)));
+        }
+        return span;
+    };
+
+    for (std::size_t i = 0; i < count; ++i) {
+        const LibraryIndex::Entry entry = index.entry(i);
+        listed_[i] = LibraryRecord::is_listed_module(entry.flags) ? 1 : 0;
+        channels_[i] = entry.channels;
+        patterns_[i] = entry.patterns;
+        duration_ms_[i] = entry.duration_ms;
+        size_[i] = entry.size;
+        encode(tracker_, tracker_codes, entry.tracker);
+        encode(format_, format_codes, entry.format);
+        encode(artist_, artist_codes, entry.artist);
+        paths_[i] = append_text(entry.path);
+        titles_[i] = append_text(entry.title);
+    }
+
+    for (Dictionary* dictionary : {&tracker_, &format_, &artist_}) {
+        std::vector<std::uint32_t> order(dictionary->values.size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::sort(order.begin(), order.end(), [dictionary](std::uint32_t a, std::uint32_t b) {
+            return dictionary->values[a] < dictionary->values[b];
+        });
+        dictionary->ranks.resize(order.size());
+        for (std::uint32_t rank = 0; rank < order.size(); ++rank) {
+            dictionary->ranks[order[rank]] = rank;
+        }
+    }
+}
+
+const LibraryColumns::Dictionary* LibraryColumns::dictionary(QueryField field) const {
+    switch (field) {
+        case QueryField::Tracker: return &tracker_;
+        case QueryField::Format: return &format_;
+        case QueryField::Artist: return &artist_;
+        default: return nullptr;
+    }
+}
+
+std::string_view LibraryColumns::text(const std::vector<TextSpan>& spans, std::uint32_t row) const {
+    const TextSpan span = spans[row];
+    return std::string_view(text_pool_).substr(span.offset, span.length);
+}
+
+void LibraryColumns::apply(const QueryPredicate& predicate, std::vector<std::uint8_t>& mask) const {
+    switch (predicate.field) {
+        case QueryField::Channels: filter_numeric(channels_, predicate.op, predicate.number, mask); return;
+        case QueryField::Patterns: filter_numeric(patterns_, predicate.op, predicate.number, mask); return;
+        case QueryField::Duration:
+            // 0 means the duration was never computed, which no comparison should match.
+            filter_numeric(duration_ms_, predicate.op, predicate.number, mask);
+            filter_column(duration_ms_, mask, [](std::uint32_t value) { return value != 0; });
+            return;
+        case QueryField::Size: filter_numeric(size_, predicate.op, predicate.number, mask); return;
+        default: break;
+    }
+
+    if (const Dictionary* values = dictionary(predicate.field)) {
+        std::vector<std::uint8_t> matching(values->values.size());
+        for (std::size_t code = 0; code < matching.size(); ++code) {
+            matching[code] = string_matches(values->values[code], predicate) ? 1 : 0;
+        }
+        const std::uint8_t* lookup = matching.data();
+        filter_column(values->codes, mask, [lookup](std::uint32_t code) { return lookup[code]; });
+        return;
+    }
+
+    const std::vector<TextSpan>& spans = predicate.field == QueryField::Title ? titles_ : paths_;
+    for (std::uint32_t row = 0; row < mask.size(); ++row) {
+        if (mask[row] && !string_matches(text(spans, row), predicate)) {
+            mask[row] = 0;
+        }
+    }
+}
+
+void LibraryColumns::apply_word(const std::string& word, std::vector<std::uint8_t>& mask) const {
+    std::vector<std::uint8_t> artist_matches(artist_.values.size());
+    for (std::size_t code = 0; code < artist_matches.size(); ++code) {
+        artist_matches[code] = artist_.values[code].find(word) != std::string::npos ? 1 : 0;
+    }
+    for (std::uint32_t row = 0; row < mask.size(); ++row) {
+        if (mask[row] && !artist_matches[artist_.codes[row]] &&
+            text(paths_, row).find(word) == std::string_view::npos &&
+            text(titles_, row).find(word) == std::string_view::npos) {
+            mask[row] = 0;
+        }
+    }
+}
+
+void LibraryColumns::sort(std::vector<std::uint32_t>& rows, QueryField field, bool descending) const {
+    // Rows arrive in path order, so a stable sort breaks ties by path.
+    auto by = [&](auto key) {
+        if (descending) {
+            std::stable_sort(rows.begin(), rows.end(), [&](std::uint32_t a, std::uint32_t b) { return key(b) < key(a); });
+        } else {
+            std::stable_sort(rows.begin(), rows.end(), [&](std::uint32_t a, std::uint32_t b) { return key(a) < key(b); });
+        }
+    };
+    switch (field) {
+        case QueryField::Channels: by([this](std::uint32_t row) { return channels_[row]; }); return;
+        case QueryField::Patterns: by([this](std::uint32_t row) { return patterns_[row]; }); return;
+        case QueryField::Duration: by([this](std::uint32_t row) { return duration_ms_[row]; }); return;
+        case QueryField::Size: by([this](std::uint32_t row) { return size_[row]; }); return;
+        case QueryField::Title: by([this](std::uint32_t row) { return text(titles_, row); }); return;
+        case QueryField::Path:
+            if (descending) {
+                std::reverse(rows.begin(), rows.end());
+            }
+            return;
+        default: {
+            const Dictionary* values = dictionary(field);
+            by([values](std::uint32_t row) { return values->ranks[values->codes[row]]; });
+            return;
+        }
+    }
+}
+
+std::vector<std::uint32_t> LibraryColumns::execute(const LibraryQuery& query) const {
+    std::vector<std::uint8_t> mask = listed_;
+    for (const QueryPredicate& predicate : query.predicates) {
+        apply(predicate, mask);
+    }
+    for (const std::string& word : query.words) {
+        apply_word(word, mask);
+    }
+
+    std::vector<std::uint32_t> rows;
+    for (std::uint32_t row = 0; row < mask.size(); ++row) {
+        if (mask[row]) {
+            rows.push_back(row);
+        }
+    }
+    sort(rows, query.sort_field, query.descending);
+    if (query.limit > 0 && rows.size() > query.limit) {
+        rows.resize(query.limit);
+    }
+    return rows;
+}
+
+}
@@ -0,0 +1,410 @@
+#include "library_search.hpp"
+#include "library_query.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+
+namespace tracker {
+
+namespace {
+
+constexpr char kFieldSeparator = '\x1f';
+
+void append_lowercase(std::string& out, std::string_view value) {
+    for (unsigned char c : value) {
+        out.push_back(static_cast<char>(std::tolower(c)));
+    }
+}
+
+bool is_trigram_byte(char c) {
+    return c != kFieldSeparator && c != ' ' && c != '\t';
+}
+
+template <typename Callback>
+void for_each_trigram(std::string_view text, Callback&& callback) {
+    for (std::size_t i = 0; i + 3 <= text.size(); ++i) {
+        if (is_trigram_byte(text[i]) && is_trigram_byte(text[i + 1]) && is_trigram_byte(text[i + 2])) {
+            callback(static_cast<std::uint32_t>(static_cast<unsigned char>(text[i])) << 16 |
+                     static_cast<std::uint32_t>(static_cast<unsigned char>(text[i + 1])) << 8 |
+                     static_cast<std::uint32_t>(static_cast<unsigned char>(text[i + 2])));
+        }
+    }
+}
+
+std::vector<std::uint32_t> unique_trigrams(std::string_view text) {
+    std::vector<std::uint32_t> trigrams;
+    for_each_trigram(text, [&trigrams](std::uint32_t key) { trigrams.push_back(key); });
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
+
+bool is_word_boundary(char c) {
+    return c == kFieldSeparator || c == ' ' || c == '_' || c == '-' || c == '.' || c == '/';
+}
+
+// Greedy in-order match of the query characters. Consecutive runs, word
+// starts and hits inside the file name score higher; gaps cost a little.
+int subsequence_score(std::string_view text, std::string_view query, bool& complete) {
+    const std::size_t name_end = text.find(kFieldSeparator);
+    std::size_t position = 0;
+    std::size_t previous = std::string_view::npos;
+    int score = 0;
+    complete = true;
+    for (char c : query) {
+        if (c == ' ') {
+            continue;
+        }
+        const std::size_t found = text.find(c, position);
+        if (found == std::string_view::npos) {
+            complete = false;
+            return 0;
+        }
+        score += 1;
+        if (previous != std::string_view::npos && found == previous + 1) {
+            score += 5;
+        }
+        if (found == 0 || is_word_boundary(text[found - 1])) {
+            score += 8;
+        }
+        if (found < name_end) {
+            score += 2;
+        }
+        score -= static_cast<int>(std::min<std::size_t>(found - position, 3));
+        previous = found;
+        position = found + 1;
+    }
+    return score;
+}
+
+}
+
+LibrarySearchIndex::LibrarySearchIndex(std::shared_ptr<const LibraryIndex> library)
+    : library_(std::move(library)) {
+    const std::size_t count = library_ ? library_->size() : 0;
+
+    text_offsets_.reserve(count + 1);
+    text_offsets_.push_back(0);
+    for (std::size_t i = 0; i < count; ++i) {
+        const LibraryIndex::Entry entry = library_->entry(i);
+        if (!LibraryRecord::is_listed_module(entry.flags)) {
+            text_offsets_.push_back(static_cast<std::uint32_t>(text_pool_.size()));
+            continue;
+        }
+        const std::size_t slash = entry.path.find_last_of('/');
+        append_lowercase(text_pool_, slash == std::string_view::npos ? entry.path : entry.path.substr(slash + 1));
+        text_pool_.push_back(kFieldSeparator);
+        append_lowercase(text_pool_, entry.title);
+        text_pool_.push_back(kFieldSeparator);
+        append_lowercase(text_pool_, entry.artist);
+        text_offsets_.push_back(static_cast<std::uint32_t>(text_pool_.size()));
+    }
+
+    // Two passes: count list lengths, then fill. Records are visited in
+    // order, so every posting list comes out sorted.
+    std::vector<std::uint32_t> counts;
+    for (std::uint32_t record = 0; record < count; ++record) {
+        for (std::uint32_t key : unique_trigrams(text(record))) {
+            auto [it, inserted] = trigram_slots_.try_emplace(key, static_cast<std::uint32_t>(counts.size()));
+            if (inserted) {
+                counts.push_back(0);
+            }
+            ++counts[it->second];
+        }
+    }
+
+    posting_offsets_.assign(counts.size() + 1, 0);
+    for (std::size_t slot = 0; slot < counts.size(); ++slot) {
+        posting_offsets_[slot + 1] = posting_offsets_[slot] + counts[slot];
+    }
+    postings_.resize(posting_offsets_.back());
+
+    std::vector<std::uint32_t> cursor(posting_offsets_.begin(), posting_offsets_.end() - 1);
+    for (std::uint32_t record = 0; record < count; ++record) {
+        for (std::uint32_t key : unique_trigrams(text(record))) {
+            postings_[cursor[trigram_slots_.find(key)->second]++] = record;
+        }
+    }
+}
+
+std::string_view LibrarySearchIndex::text(std::uint32_t record) const {
+    return std::string_view(text_pool_).substr(text_offsets_[record], text_offsets_[record + 1] - text_offsets_[record]);
+}
+
+std::vector<std::pair<std::uint32_t, int>> LibrarySearchIndex::candidates(
+    const std::vector<std::uint32_t>& trigrams) const {
+    struct List {
+        const std::uint32_t* begin;
+        const std::uint32_t* end;
+    };
+    std::vector<List> lists;
+    lists.reserve(trigrams.size());
+    for (std::uint32_t key : trigrams) {
+        auto it = trigram_slots_.find(key);
+        if (it == trigram_slots_.end()) {
+            lists.push_back({nullptr, nullptr});
+        } else {
+            lists.push_back({postings_.data() + posting_offsets_[it->second],
+                             postings_.data() + posting_offsets_[it->second + 1]});
+        }
+    }
+    std::sort(lists.begin(), lists.end(),
+              [](const List& a, const List& b) { return (a.end - a.begin) < (b.end - b.begin); });
+
+    // One typo breaks up to three trigrams, so a third of them may miss. A
+    // record sharing `required` of n trigrams must appear in at least one of
+    // the n - required + 1 shortest lists, so only those seed candidates.
+    const int total = static_cast<int>(lists.size());
+    const int required = std::max(1, total - (total + 1) / 3);
+    const int merged = total - required + 1;
+
+    std::vector<std::uint16_t> counts(size(), 0);
+    std::vector<std::uint32_t> touched;
+    for (int i = 0; i < merged; ++i) {
+        for (const std::uint32_t* id = lists[i].begin; id != lists[i].end; ++id) {
+            if (counts[*id]++ == 0) {
+                touched.push_back(*id);
+            }
+        }
+    }
+
+    // The remaining lists only confirm candidates: scan the ones that are
+    // cheaper to walk than to binary-search once per candidate.
+    std::vector<const List*> probed;
+    for (int j = merged; j < total; ++j) {
+        const auto length = static_cast<std::size_t>(lists[j].end - lists[j].begin);
+        std::size_t steps = 1;
+        while ((std::size_t{1} << steps) < length) {
+            ++steps;
+        }
+        if (touched.size() * steps < length) {
+            probed.push_back(&lists[j]);
+            continue;
+        }
+        for (const std::uint32_t* id = lists[j].begin; id != lists[j].end; ++id) {
+            if (counts[*id] > 0) {
+                ++counts[*id];
+            }
+        }
+    }
+
+    std::vector<std::pair<std::uint32_t, int>> result;
+    for (std::uint32_t record : touched) {
+        int hits = counts[record];
+        for (std::size_t j = 0; j < probed.size() && hits + static_cast<int>(probed.size() - j) >= required; ++j) {
+            if (std::binary_search(probed[j]->begin, probed[j]->end, record)) {
+                ++hits;
+            }
+        }
+        if (hits >= required) {
+            result.emplace_back(record, hits);
+        }
+    }
+    return result;
+}
+
+int LibrarySearchIndex::score(std::uint32_t record, std::string_view query, int trigram_hits) const {
+    const std::string_view haystack = text(record);
+    bool complete = false;
+    int value = trigram_hits * 4 + subsequence_score(haystack, query, complete);
+    if (complete) {
+        value += 20;
+    }
+    const std::size_t exact = haystack.find(query);
+    if (exact != std::string_view::npos) {
+        value += exact < haystack.find(kFieldSeparator) ? 120 : 100;
+    }
+    return value - static_cast<int>(haystack.size() / 16);
+}
+
+std::vector<SearchResult> LibrarySearchIndex::search(std::string_view query, std::size_t limit) const {
+    std::string needle;
+    append_lowercase(needle, query);
+    needle.erase(0, needle.find_first_not_of(' '));
+    needle.erase(needle.find_last_not_of(' ') + 1);
+    if (needle.empty() || limit == 0) {
+        return {};
+    }
+
+    std::vector<std::pair<int, std::uint32_t>> scored;
+    const std::vector<std::uint32_t> trigrams = unique_trigrams(needle);
+    if (trigrams.empty()) {
+        // Queries too short for trigrams fall back to a subsequence scan.
+        for (std::uint32_t record = 0; record < size(); ++record) {
+            if (text(record).empty()) {
+                continue;
+            }
+            bool complete = false;
+            const int value = subsequence_score(text(record), needle, complete);
+            if (complete) {
+                scored.emplace_back(value - static_cast<int>(text(record).size() / 16), record);
+            }
+        }
+    } else {
+        for (const auto& [record, hits] : candidates(trigrams)) {
+            scored.emplace_back(score(record, needle, hits), record);
+        }
+    }
+
+    const std::size_t kept = std::min(limit, scored.size());
+    std::partial_sort(scored.begin(), scored.begin() + static_cast<std::ptrdiff_t>(kept), scored.end(),
+                      [](const auto& a, const auto& b) {
+                          return a.first != b.first ? a.first > b.first : a.second < b.second;
+                      });
+
+    std::vector<SearchResult> results;
+    results.reserve(kept);
+    for (std::size_t i = 0; i < kept; ++i) {
+        const LibraryIndex::Entry entry = library_->entry(scored[i].second);
+        results.push_back({scored[i].second, scored[i].first, std::string(entry.path), std::string(entry.title),
+                           std::string(entry.artist)});
+    }
+    return results;
+}
+
+LibrarySearcher::LibrarySearcher() = default;
+
+LibrarySearcher::~LibrarySearcher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+void LibrarySearcher::load(const std::filesystem::path& index_path) {
+    if (worker_.joinable()) {
+        return;
+    }
+    worker_ = std::thread(&LibrarySearcher::run, this, index_path);
+}
+
+void LibrarySearcher::set_update_callback(std::function<void()> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    update_callback_ = std::move(callback);
+}
+
+void LibrarySearcher::submit(std::string query) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_query_ = std::move(query);
+        ++submitted_;
+    }
+    wake_.notify_one();
+}
+
+bool LibrarySearcher::poll() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (completed_ == taken_) {
+        return false;
+    }
+    taken_ = completed_;
+    results_ = std::move(completed_results_);
+    completed_results_.clear();
+    query_error_ = std::move(completed_error_);
+    completed_error_.clear();
+    last_query_ms_ = completed_ms_;
+    return true;
+}
+
+bool LibrarySearcher::loaded() const {
+    return worker_.joinable();
+}
+
+bool LibrarySearcher::ready() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ready_;
+}
+
+std::size_t LibrarySearcher::indexed_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return indexed_count_;
+}
+
+std::string LibrarySearcher::error_message() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return error_message_;
+}
+
+void LibrarySearcher::run(std::filesystem::path index_path) {
+    auto notify = [this] {
+        std::function<void()> callback;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            callback = update_callback_;
+        }
+        if (callback) {
+            callback();
+        }
+    };
+
+    auto library = std::make_shared<LibraryIndex>();
+    std::string error;
+    if (!library->open(index_path, error)) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            error_message_ = error + " (run --index first)";
+        }
+        notify();
+        return;
+    }
+
+    LibrarySearchIndex index(library);
+    LibraryColumns columns(*library);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ready_ = true;
+        indexed_count_ = index.size();
+    }
+    notify();
+
+    while (true) {
+        std::string query;
+        std::uint64_t generation = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return stop_ || submitted_ != completed_; });
+            if (stop_) {
+                return;
+            }
+            query = pending_query_;
+            generation = submitted_;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<SearchResult> results;
+        std::string query_error;
+        if (LibraryQuery::is_structured(query)) {
+            LibraryQuery filter;
+            if (LibraryQuery::parse(query, filter, query_error)) {
+                if (filter.limit == 0 || filter.limit > kMaxResults) {
+                    filter.limit = kMaxResults;
+                }
+                for (std::uint32_t row : columns.execute(filter)) {
+                    const LibraryIndex::Entry entry = library->entry(row);
+                    results.push_back({row, 0, std::string(entry.path), std::string(entry.title),
+                                       std::string(entry.artist)});
+                }
+            }
+        } else {
+            results = index.search(query, kMaxResults);
+        }
+        const double elapsed =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            completed_ = generation;
+            completed_results_ = std::move(results);
+            completed_error_ = std::move(query_error);
+            completed_ms_ = elapsed;
+        }
+        notify();
+    }
+}
+
+}
@@ -0,0 +1,190 @@
+#include "loudness.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace tracker {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kAbsoluteGateLufs = -70.0;
+constexpr double kRelativeGateLu = -10.0;
+
+double energy_to_lufs(double energy) {
+    return -0.691 + 10.0 * std::log10(energy);
+}
+
+}
+
+double decibels_to_gain(double decibels) {
+    return std::pow(10.0, decibels / 20.0);
+}
+
+double gain_to_decibels(double gain) {
+    return gain > 0.0 ? 20.0 * std::log10(gain) : -std::numeric_limits<double>::infinity();
+}
+
+LoudnessMeter::LoudnessMeter(int sample_rate)
+    : sub_block_frames_(std::max<std::size_t>(1, static_cast<std::size_t>(sample_rate) / 10)) {
+    const double rate = static_cast<double>(sample_rate);
+
+    // K-weighting pre-filter coefficients, derived for any rate from the
+    // analog prototypes behind the 48 kHz tables in BS.1770.
+    {
+        const double f0 = 1681.974450955533;
+        const double gain_db = 3.999843853973347;
+        const double q = 0.7071752369554196;
+        const double k = std::tan(kPi * f0 / rate);
+        const double vh = std::pow(10.0, gain_db / 20.0);
+        const double vb = std::pow(vh, 0.4996667741545416);
+        const double a0 = 1.0 + k / q + k * k;
+        Biquad shelf{(vh + vb * k / q + k * k) / a0, 2.0 * (k * k - vh) / a0, (vh - vb * k / q + k * k) / a0,
+                     2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0};
+        shelf_.fill(shelf);
+    }
+    {
+        const double f0 = 38.13547087602444;
+        const double q = 0.5003270373238773;
+        const double k = std::tan(kPi * f0 / rate);
+        const double a0 = 1.0 + k / q + k * k;
+        Biquad highpass{1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0};
+        highpass_.fill(highpass);
+    }
+
+    // Windowed-sinc interpolator for 4x oversampled true-peak detection.
+    const double center = static_cast<double>(interpolation_taps_.size() - 1) / 2.0;
+    for (std::size_t i = 0; i < interpolation_taps_.size(); ++i) {
+        const double x = (static_cast<double>(i) - center) / static_cast<double>(kOversample);
+        const double sinc = x == 0.0 ? 1.0 : std::sin(kPi * x) / (kPi * x);
+        const double window = 0.42 - 0.5 * std::cos(2.0 * kPi * (static_cast<double>(i) + 0.5) / interpolation_taps_.size()) +
+                              0.08 * std::cos(4.0 * kPi * (static_cast<double>(i) + 0.5) / interpolation_taps_.size());
+        interpolation_taps_[i] = static_cast<float>(sinc * window);
+    }
+    for (std::size_t phase = 0; phase < kOversample; ++phase) {
+        float sum = 0.0f;
+        for (std::size_t tap = 0; tap < kTapsPerPhase; ++tap) {
+            sum += interpolation_taps_[phase + tap * kOversample];
+        }
+        for (std::size_t tap = 0; tap < kTapsPerPhase; ++tap) {
+            interpolation_taps_[phase + tap * kOversample] /= sum;
+        }
+    }
+}
+
+double LoudnessMeter::oversampled_peak(std::size_t channel, float sample) {
+    auto& history = history_[channel];
+    history[history_position_] = sample;
+
+    float peak = std::fabs(sample);
+    for (std::size_t phase = 0; phase < kOversample; ++phase) {
+        float value = 0.0f;
+        std::size_t position = history_position_;
+        for (std::size_t tap = 0; tap < kTapsPerPhase; ++tap) {
+            value += interpolation_taps_[phase + tap * kOversample] * history[position];
+            position = position == 0 ? kTapsPerPhase - 1 : position - 1;
+        }
+        peak = std::max(peak, std::fabs(value));
+    }
+    return peak;
+}
+
+void LoudnessMeter::process(const float* interleaved_stereo, std::size_t frame_count) {
+    for (std::size_t frame = 0; frame < frame_count; ++frame) {
+        for (std::size_t channel = 0; channel < 2; ++channel) {
+            const float sample = interleaved_stereo[frame * 2 + channel];
+            const double weighted = highpass_[channel].process(shelf_[channel].process(sample));
+            sub_block_energy_ += weighted * weighted;
+            true_peak_ = std::max(true_peak_, oversampled_peak(channel, sample));
+        }
+        history_position_ = (history_position_ + 1) % kTapsPerPhase;
+
+        if (++sub_block_position_ == sub_block_frames_) {
+            sub_block_energies_.push_back(sub_block_energy_);
+            sub_block_energy_ = 0.0;
+            sub_block_position_ = 0;
+        }
+    }
+}
+
+double LoudnessMeter::integrated_lufs() const {
+    constexpr std::size_t kSubBlocksPerBlock = 4;
+    if (sub_block_energies_.size() < kSubBlocksPerBlock) {
+        return -std::numeric_limits<double>::infinity();
+    }
+
+    const double block_frames = static_cast<double>(sub_block_frames_ * kSubBlocksPerBlock);
+    std::vector<double> blocks;
+    blocks.reserve(sub_block_energies_.size());
+    for (std::size_t i = kSubBlocksPerBlock - 1; i < sub_block_energies_.size(); ++i) {
+        double energy = 0.0;
+        for (std::size_t j = 0; j < kSubBlocksPerBlock; ++j) {
+            energy += sub_block_energies_[i - j];
+        }
+        energy /= block_frames;
+        if (energy > 0.0 && energy_to_lufs(energy) > kAbsoluteGateLufs) {
+            blocks.push_back(energy);
+        }
+    }
+    if (blocks.empty()) {
+        return -std::numeric_limits<double>::infinity();
+    }
+
+    const double ungated = std::accumulate(blocks.begin(), blocks.end(), 0.0) / static_cast<double>(blocks.size());
+    const double relative_gate = energy_to_lufs(ungated) + kRelativeGateLu;
+
+    double gated_sum = 0.0;
+    std::size_t gated_count = 0;
+    for (double energy : blocks) {
+        if (energy_to_lufs(energy) > relative_gate) {
+            gated_sum += energy;
+            ++gated_count;
+        }
+    }
+    if (gated_count == 0) {
+        return -std::numeric_limits<double>::infinity();
+    }
+    return energy_to_lufs(gated_sum / static_cast<double>(gated_count));
+}
+
+double LoudnessMeter::true_peak_db() const {
+    return gain_to_decibels(true_peak_);
+}
+
+PeakLimiter::PeakLimiter(int sample_rate, float ceiling)
+    : lookahead_frames_(std::max<std::size_t>(1, static_cast<std::size_t>(sample_rate) / 200)),
+      ceiling_(ceiling),
+      attack_coeff_(1.0f - std::exp(-5.0f / static_cast<float>(lookahead_frames_))),
+      release_coeff_(1.0f - std::exp(-1.0f / (0.1f * static_cast<float>(sample_rate)))) {}
+
+void PeakLimiter::process(const float* interleaved_stereo, std::size_t total_frames, std::size_t start_frame,
+                          std::size_t frame_count, float gain, float* output) {
+    for (std::size_t i = 0; i < frame_count; ++i) {
+        const std::size_t frame = start_frame + i;
+        const std::size_t horizon = std::min(frame + lookahead_frames_, total_frames - 1);
+
+        for (; next_frame_ <= horizon; ++next_frame_) {
+            const float peak = std::max(std::fabs(interleaved_stereo[next_frame_ * 2]),
+                                        std::fabs(interleaved_stereo[next_frame_ * 2 + 1]));
+            while (!window_.empty() && window_.back().second <= peak) {
+                window_.pop_back();
+            }
+            window_.emplace_back(next_frame_, peak);
+        }
+        while (!window_.empty() && window_.front().first < frame) {
+            window_.pop_front();
+        }
+
+        const float upcoming = window_.empty() ? 0.0f : window_.front().second * gain;
+        const float target = upcoming > ceiling_ ? ceiling_ / upcoming : 1.0f;
+        envelope_ += (target - envelope_) * (target < envelope_ ? attack_coeff_ : release_coeff_);
+
+        const float scale = gain * envelope_;
+        output[i * 2] = std::clamp(interleaved_stereo[frame * 2] * scale, -ceiling_, ceiling_);
+        output[i * 2 + 1] = std::clamp(interleaved_stereo[frame * 2 + 1] * scale, -ceiling_, ceiling_);
+    }
+}
+
+}
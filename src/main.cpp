@@ -3,27 +3,241 @@
 #include "config.hpp"
 #include "file_browser_ui.hpp"
 #include "simple_ui.hpp"
+#include "cli_commands.hpp"
+#include "module_metadata.hpp"
 
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
 #include <exception>
 #include <filesystem>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace {
+
+// Numeric option values must parse completely and fall inside [min, max];
+// otherwise a usage error is printed and the caller exits.
+bool parse_option(const std::string &option, const char *text, int min, int max, int &value) {
+    const char *end = text + std::char_traits<char>::length(text);
+    auto [ptr, ec] = std::from_chars(text, end, value);
+    if (ec != std::errc() || ptr != end || ptr == text || value < min || value > max) {
+        std::cerr << "Invalid value for " << option << ": '" << text << "' (expected " << min << " to " << max << ")"
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool parse_option(const std::string &option, const char *text, double min, double max, double &value) {
+    char *end = nullptr;
+    value = std::strtod(text, &end);
+    if (end == text || *end != '\0' || !std::isfinite(value) || value < min || value > max) {
+        std::cerr << "Invalid value for " << option << ": '" << text << "' (expected " << min << " to " << max << ")"
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}
 
 int main(int argc, char **argv) {
     std::filesystem::path module_path;
+    std::vector<std::filesystem::path> inputs;
+    bool shuffle = false;
+    tracker::RepeatMode repeat_mode = tracker::RepeatMode::Off;
+    std::filesystem::path save_playlist_path;
     bool simple_mode = false;
+    tracker::UiOptions ui_options;
+    bool json_output = false;
+    tracker::ExportOptions export_options;
+    std::vector<std::string> export_specs;
+    bool index_mode = false;
+    bool duplicates_mode = false;
+    std::string query_expression;
+    bool query_mode = false;
+    bool detect_content = false;
+    tracker::IndexCommandOptions index_options;
+    std::vector<std::string> library_roots;
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
         if (arg == "--simple") simple_mode = true;
-        else if (arg[0] != '-') module_path = arg;
+        else if (arg == "--low-bandwidth") ui_options.low_bandwidth = true;
+        else if (arg == "--colors" && i + 1 < argc) ui_options.colors = std::atoi(argv[++i]);
+        else if (arg == "--json") json_output = true;
+        else if (arg == "--index") index_mode = true;
+        else if (arg == "--duplicates") duplicates_mode = true;
+        else if (arg == "--query" && i + 1 < argc) {
+            query_mode = true;
+            query_expression = argv[++i];
+        }
+        else if (arg == "--detect-content") detect_content = true;
+        else if (arg == "--no-duration") index_options.durations = false;
+        else if (arg == "--envelopes") index_options.envelopes = true;
+        else if (arg == "--watch") index_options.watch = true;
+        else if (arg == "--jobs" && i + 1 < argc) index_options.jobs = static_cast<std::size_t>(std::max(0, std::atoi(argv[++i])));
+        else if (arg == "--index-memory" && i + 1 < argc) {
+            index_options.memory_cap_megabytes = static_cast<std::uint64_t>(std::max(1, std::atoi(argv[++i])));
+        }
+        else if (arg == "--library-root" && i + 1 < argc) library_roots.push_back(argv[++i]);
+        else if (arg == "--export" && i + 1 < argc) export_specs.push_back(argv[++i]);
+        else if (arg == "--rate" && i + 1 < argc) {
+            if (!parse_option(arg, argv[++i], 8000, 384000, export_options.sample_rate)) {
+                return 1;
+            }
+        }
+        else if (arg == "--render-rate" && i + 1 < argc) {
+            if (!parse_option(arg, argv[++i], 8000, 384000, export_options.render_sample_rate)) {
+                return 1;
+            }
+        }
+        else if (arg == "--resampler" && i + 1 < argc) {
+            if (!tracker::Resampler::parse_quality(argv[++i], export_options.resampler_quality)) {
+                std::cerr << "Unknown resampler quality (use fast, balanced or best)" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--normalize-lufs" && i + 1 < argc) {
+            export_options.normalization = tracker::NormalizationMode::Loudness;
+            if (!parse_option(arg, argv[++i], -70.0, 0.0, export_options.target_lufs)) {
+                return 1;
+            }
+        }
+        else if (arg == "--normalize-peak" && i + 1 < argc) {
+            export_options.normalization = tracker::NormalizationMode::Peak;
+            if (!parse_option(arg, argv[++i], -60.0, 0.0, export_options.peak_ceiling_db)) {
+                return 1;
+            }
+        }
+        else if (arg == "--ceiling" && i + 1 < argc) {
+            if (!parse_option(arg, argv[++i], -60.0, 0.0, export_options.peak_ceiling_db)) {
+                return 1;
+            }
+        }
+        else if (arg == "--limit") export_options.limiter = true;
+        else if (arg == "--shuffle") shuffle = true;
+        else if (arg == "--repeat" && i + 1 < argc) {
+            if (!tracker::Playlist::parse_repeat_mode(argv[++i], repeat_mode)) {
+                std::cerr << "Unknown repeat mode (use off, all or one)" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--save-playlist" && i + 1 < argc) save_playlist_path = argv[++i];
+        else if (arg[0] != '-') inputs.push_back(arg);
+    }
+    if (!inputs.empty()) {
+        module_path = inputs.front();
+    }
+    if (duplicates_mode) {
+        return tracker::run_duplicates_command(json_output);
+    }
+    if (query_mode) {
+        return tracker::run_query_command(query_expression, json_output);
     }
-    if (module_path.empty()) {
-        auto selected = tracker::run_file_browser_ui(std::filesystem::current_path());
+    if (index_mode || !library_roots.empty()) {
+        tracker::Config config;
+        for (const auto& root : library_roots) {
+            std::error_code ec;
+            auto absolute = std::filesystem::absolute(root, ec);
+            config.add_library_root((ec ? std::filesystem::path(root) : absolute).lexically_normal().string());
+        }
+        if (!library_roots.empty()) {
+            config.save();
+        }
+        std::vector<std::filesystem::path> roots(config.get_library_roots().begin(),
+                                                 config.get_library_roots().end());
+        index_options.content_detection = detect_content || config.get_content_detection();
+        return tracker::run_index_command(roots, index_options, json_output);
+    }
+    if (!export_specs.empty()) {
+        if (module_path.empty() || !std::filesystem::exists(module_path)) {
+            std::cerr << "Usage: cli-modplayer <module> --export <output.wav|.mp3|.flac>[@Hz] [--export ...] [--rate Hz]\n"
+                      << "       [--render-rate Hz] [--resampler fast|balanced|best] [--json]\n"
+                      << "       [--normalize-lufs LUFS [--ceiling dBTP] [--limit] | --normalize-peak dBTP]" << std::endl;
+            return 1;
+        }
+        return tracker::run_export_command(module_path, export_options, export_specs, json_output);
+    }
+    auto playlist = std::make_shared<tracker::Playlist>();
+    std::optional<std::size_t> start_index;
+    for (const auto& input : inputs) {
+        std::error_code ec;
+        if (tracker::Playlist::is_playlist_file(input)) {
+            std::string error_message;
+            if (!playlist->load(input, error_message)) {
+                std::cerr << error_message << std::endl;
+                return 1;
+            }
+        } else if (std::filesystem::is_directory(input, ec)) {
+            playlist->add_directory(input);
+        } else if (std::filesystem::exists(input, ec)) {
+            playlist->add(input);
+        } else {
+            std::cerr << "File not found: " << input << std::endl;
+            return 1;
+        }
+    }
+    if (inputs.empty()) {
+        auto library = std::make_shared<tracker::LibraryIndex>();
+        std::string library_error;
+        library->open(tracker::LibraryIndex::default_path(), library_error);
+        std::shared_ptr<tracker::ModuleDetector> detector;
+        if (detect_content || tracker::Config().get_content_detection()) {
+            detector = tracker::make_module_detector(library);
+        }
+        // Auditioning is optional; without an output device the browser
+        // works as before.
+        std::unique_ptr<tracker::PreviewPlayer> preview_player;
+        try {
+            preview_player = std::make_unique<tracker::PreviewPlayer>();
+            preview_player->set_volume(tracker::Config().get_volume());
+        } catch (const std::exception &) {
+            preview_player.reset();
+        }
+        tracker::PreviewCallback preview;
+        if (preview_player) {
+            preview = [&preview_player](const std::filesystem::path &path) { preview_player->preview(path); };
+        }
+        auto selected = tracker::run_file_browser_ui(std::filesystem::current_path(), std::move(detector), library,
+                                                     std::move(preview), playlist);
+        preview_player.reset();
         if (!selected) {
             std::cout << "No file selected. Exiting." << std::endl;
             return 0;
         }
-        module_path = *selected;
+        // The picked file plays first and the queue carries on from it.
+        start_index = playlist->find(*selected);
+        if (!start_index) {
+            playlist->add(*selected);
+            start_index = playlist->size() - 1;
+        }
+    }
+    if (playlist->empty()) {
+        std::cerr << "No module files found." << std::endl;
+        return 1;
+    }
+    if (!save_playlist_path.empty()) {
+        std::string error_message;
+        if (!playlist->save(save_playlist_path, error_message)) {
+            std::cerr << error_message << std::endl;
+            return 1;
+        }
+    }
+    playlist->set_repeat(repeat_mode);
+    if (start_index) {
+        playlist->select(*start_index);
+        playlist->set_shuffle(shuffle);
+    } else {
+        playlist->set_shuffle(shuffle);
+        playlist->advance();
     }
+    module_path = playlist->entries()[*playlist->current()].path;
     if (!std::filesystem::exists(module_path)) {
         std::cerr << "File not found: " << module_path << std::endl;
         return 1;
@@ -31,6 +245,17 @@ int main(int argc, char **argv) {
     try {
         tracker::Config config;
         tracker::Player player(module_path.string());
+        // Envelopes stored by --index --envelopes save rendering them here.
+        auto envelope_index = std::make_shared<tracker::LibraryIndex>();
+        std::string envelope_index_error;
+        if (envelope_index->open(tracker::LibraryIndex::default_path(), envelope_index_error)) {
+            player.set_envelope_lookup([envelope_index](const std::string &path, std::vector<std::uint8_t> &levels) {
+                return tracker::find_song_envelope(*envelope_index, path, levels);
+            });
+        }
+        if (playlist->size() > 1 || repeat_mode != tracker::RepeatMode::Off) {
+            player.set_playlist(playlist);
+        }
         player.set_volume(config.get_volume());
         player.start();
         if (simple_mode) {
@@ -38,7 +263,10 @@ int main(int argc, char **argv) {
             simple_ui.run();
         } else {
             std::string module_name = module_path.stem().string();
-            tracker::Ui ui(player, config, module_name);
+            if (ui_options.low_bandwidth && ui_options.colors == 0) {
+                ui_options.colors = 256;
+            }
+            tracker::Ui ui(player, config, module_name, ui_options);
             ui.run();
         }
         player.stop();
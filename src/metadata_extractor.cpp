@@ -0,0 +1,118 @@
+#include "metadata_extractor.hpp"
+#include "library_indexer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+
+namespace tracker {
+
+namespace {
+
+class MemoryBudget {
+public:
+    explicit MemoryBudget(std::uint64_t capacity) : capacity_(std::max<std::uint64_t>(capacity, 1)) {}
+
+    std::uint64_t acquire(std::uint64_t bytes) {
+        const std::uint64_t charged = std::min(bytes, capacity_);
+        std::unique_lock<std::mutex> lock(mutex_);
+        released_.wait(lock, [&] { return in_flight_ + charged <= capacity_; });
+        in_flight_ += charged;
+        peak_ = std::max(peak_, in_flight_);
+        return charged;
+    }
+
+    void release(std::uint64_t charged) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            in_flight_ -= charged;
+        }
+        released_.notify_all();
+    }
+
+    std::uint64_t peak() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return peak_;
+    }
+
+private:
+    std::uint64_t capacity_;
+    std::uint64_t in_flight_{0};
+    std::uint64_t peak_{0};
+    mutable std::mutex mutex_;
+    std::condition_variable released_;
+};
+
+}
+
+double ExtractorStats::files_per_second() const {
+    return elapsed_seconds > 0.0 ? static_cast<double>(parsed + failed) / elapsed_seconds : 0.0;
+}
+
+MetadataExtractor::MetadataExtractor(MetadataReader reader, ExtractorOptions options)
+    : reader_(std::move(reader)), options_(options) {}
+
+void MetadataExtractor::extract(const std::vector<DetectionCandidate>& candidates, std::uint32_t detected_flags,
+                                std::vector<LibraryRecord>& records) {
+    const auto start = std::chrono::steady_clock::now();
+    stats_ = ExtractorStats{};
+    records.assign(candidates.size(), LibraryRecord{});
+
+    WorkStealingPool pool(options_.threads);
+    MemoryBudget budget(options_.memory_cap_bytes);
+    std::vector<std::vector<std::uint8_t>> buffers(pool.thread_count());
+    std::atomic<std::size_t> parsed{0};
+    std::atomic<std::size_t> failed{0};
+    std::atomic<std::uint64_t> bytes_read{0};
+    std::mutex progress_mutex;
+    std::size_t done = 0;
+
+    pool.run(candidates.size(), [&](std::size_t index, std::size_t worker) {
+        const DetectionCandidate& candidate = candidates[index];
+        LibraryRecord& record = records[index];
+        record.path = candidate.path.string();
+        record.size = candidate.size;
+        record.mtime_ns = candidate.mtime_ns;
+        record.flags = detected_flags;
+
+        const std::uint64_t charged = budget.acquire(candidate.size);
+        std::vector<std::uint8_t>& buffer = buffers[worker];
+        buffer.resize(static_cast<std::size_t>(candidate.size));
+        std::ifstream file(candidate.path, std::ios::binary);
+        if (file && file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()))) {
+            bytes_read.fetch_add(candidate.size, std::memory_order_relaxed);
+            record.content_hash = LibraryIndexer::hash_content(buffer.data(), buffer.size());
+            std::string parse_error;
+            if (reader_ && reader_(buffer.data(), buffer.size(), record, parse_error)) {
+                record.flags |= LibraryRecord::kMetadataValid;
+                parsed.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                failed.fetch_add(1, std::memory_order_relaxed);
+            }
+        } else {
+            failed.fetch_add(1, std::memory_order_relaxed);
+        }
+        // Large files should not pin their buffer for the rest of the run.
+        if (buffer.capacity() > options_.memory_cap_bytes / pool.thread_count()) {
+            std::vector<std::uint8_t>().swap(buffer);
+        }
+        budget.release(charged);
+
+        if (progress_callback_) {
+            std::lock_guard<std::mutex> lock(progress_mutex);
+            progress_callback_(++done);
+        }
+    });
+
+    stats_.parsed = parsed.load();
+    stats_.failed = failed.load();
+    stats_.bytes_read = bytes_read.load();
+    stats_.peak_bytes_in_flight = budget.peak();
+    stats_.threads = pool.thread_count();
+    stats_.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
@@ -0,0 +1,88 @@
+#include "module_detection.hpp"
+
+#include <algorithm>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace tracker {
+
+namespace {
+
+// Below this many uncached files a batch is probed on the calling thread.
+constexpr std::size_t kParallelThreshold = 16;
+
+}
+
+ModuleDetector::ModuleDetector(HeaderProbe probe, std::size_t thread_count)
+    : probe_(std::move(probe)),
+      thread_count_(thread_count > 0 ? thread_count
+                                     : std::clamp<std::size_t>(std::thread::hardware_concurrency(), 1, 8)) {}
+
+bool ModuleDetector::probe_file(const DetectionCandidate& candidate) const {
+    if (!probe_) {
+        return candidate.has_module_extension;
+    }
+
+    const int fd = ::open(candidate.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    std::uint8_t header[kProbeBytes];
+    const ssize_t read_bytes = ::pread(fd, header, sizeof(header), 0);
+    ::close(fd);
+    if (read_bytes <= 0) {
+        return false;
+    }
+    probes_run_.fetch_add(1, std::memory_order_relaxed);
+
+    switch (probe_(header, static_cast<std::size_t>(read_bytes), candidate.size)) {
+        case ProbeResult::Module:
+            return true;
+        case ProbeResult::NotModule:
+            return false;
+        case ProbeResult::NeedMoreData:
+            break;
+    }
+    // Formats whose signature lies beyond the probed prefix keep the
+    // extension-based answer.
+    return candidate.has_module_extension;
+}
+
+void ModuleDetector::classify(std::vector<DetectionCandidate>& candidates, const std::atomic<bool>* cancelled) const {
+    std::vector<DetectionCandidate*> uncached;
+    for (auto& candidate : candidates) {
+        std::optional<bool> cached = cache_ ? cache_(candidate) : std::nullopt;
+        if (cached) {
+            candidate.is_module = *cached;
+            candidate.from_cache = true;
+        } else {
+            uncached.push_back(&candidate);
+        }
+    }
+
+    std::atomic<std::size_t> next{0};
+    auto worker = [&] {
+        for (std::size_t i = next.fetch_add(1); i < uncached.size(); i = next.fetch_add(1)) {
+            if (cancelled && cancelled->load(std::memory_order_relaxed)) {
+                return;
+            }
+            uncached[i]->is_module = probe_file(*uncached[i]);
+        }
+    };
+
+    const std::size_t threads = uncached.size() < kParallelThreshold
+                                    ? 1
+                                    : std::min(thread_count_, uncached.size() / (kParallelThreshold / 2));
+    std::vector<std::thread> pool;
+    for (std::size_t i = 1; i < threads; ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+}
+
+}
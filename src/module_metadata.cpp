@@ -0,0 +1,205 @@
+#include "module_metadata.hpp"
+#include "song_envelope.hpp"
+
+#include <libopenmpt/libopenmpt.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <map>
+#include <sstream>
+#include <system_error>
+#include <utility>
+
+#include <sys/stat.h>
+
+namespace tracker {
+
+namespace {
+
+// Sample data is never needed for the index, so it is never decoded.
+// Patterns are only loaded when the duration has to be computed, since
+// that means simulating playback.
+bool read_metadata(const std::uint8_t* data, std::size_t size, bool with_duration, LibraryRecord& record,
+                   std::string& error_message) {
+    std::map<std::string, std::string> ctls = {{"load.skip_samples", "1"}, {"load.skip_plugins", "1"}};
+    if (!with_duration) {
+        ctls.emplace("load.skip_patterns", "1");
+        ctls.emplace("load.skip_subsongs_init", "1");
+    }
+
+    try {
+        std::ostringstream load_log;
+        openmpt::module module(data, size, load_log, ctls);
+
+        record.title = module.get_metadata("title");
+        record.artist = module.get_metadata("artist");
+        record.tracker = module.get_metadata("tracker");
+        record.format = module.get_metadata("type");
+        record.channels = static_cast<std::uint16_t>(std::clamp(module.get_num_channels(), 0, 0xFFFF));
+        if (!with_duration) {
+            return true;
+        }
+
+        record.patterns = static_cast<std::uint16_t>(std::clamp(module.get_num_patterns(), 0, 0xFFFF));
+        const double duration = module.get_duration_seconds();
+        record.duration_ms = std::isfinite(duration) && duration > 0.0
+                                 ? static_cast<std::uint32_t>(std::min(duration * 1000.0, 4294967295.0))
+                                 : 0;
+        return true;
+    } catch (const std::exception& ex) {
+        error_message = ex.what();
+    } catch (...) {
+        error_message = "Unknown error while reading module";
+    }
+    return false;
+}
+
+}
+
+bool read_module_metadata(const std::uint8_t* data, std::size_t size, LibraryRecord& record,
+                          std::string& error_message) {
+    return read_metadata(data, size, true, record, error_message);
+}
+
+bool read_module_tags(const std::uint8_t* data, std::size_t size, LibraryRecord& record,
+                      std::string& error_message) {
+    return read_metadata(data, size, false, record, error_message);
+}
+
+bool read_module_metadata_with_envelope(const std::uint8_t* data, std::size_t size, LibraryRecord& record,
+                                        std::string& error_message) {
+    record.flags |= LibraryRecord::kEnvelopeChecked;
+    if (!read_metadata(data, size, true, record, error_message)) {
+        return false;
+    }
+    // A module that loads but fails to render still keeps its metadata.
+    std::vector<std::uint8_t> levels;
+    std::string render_error;
+    if (render_song_envelope(data, size, levels, render_error)) {
+        record.envelope.assign(levels.begin(), levels.end());
+    }
+    return true;
+}
+
+bool render_song_envelope(const std::uint8_t* data, std::size_t size, std::vector<std::uint8_t>& levels,
+                          std::string& error_message, const std::atomic<bool>* cancelled) {
+    try {
+        std::ostringstream load_log;
+        openmpt::module module(data, size, load_log, {{"load.skip_plugins", "1"}});
+        module.set_repeat_count(0);
+        module.set_render_param(openmpt::module::RENDER_INTERPOLATIONFILTER_LENGTH, 1);
+        module.set_render_param(openmpt::module::RENDER_VOLUMERAMPING_STRENGTH, 0);
+
+        SongEnvelope envelope;
+        std::vector<float> buffer(4096);
+        while (true) {
+            if (cancelled && cancelled->load(std::memory_order_relaxed)) {
+                error_message = "Cancelled";
+                return false;
+            }
+            const std::size_t frames = module.read(SongEnvelope::kSampleRate, buffer.size(), buffer.data());
+            if (frames == 0) {
+                break;
+            }
+            envelope.add(buffer.data(), frames);
+        }
+        levels = envelope.finish();
+        return true;
+    } catch (const std::exception& ex) {
+        error_message = ex.what();
+    } catch (...) {
+        error_message = "Unknown error while rendering module";
+    }
+    return false;
+}
+
+bool load_pattern_cache(const std::uint8_t* data, std::size_t size, PatternCache& cache, std::string& error_message,
+                        const std::atomic<bool>* cancelled) {
+    try {
+        std::ostringstream load_log;
+        openmpt::module module(data, size, load_log, {{"load.skip_samples", "1"}, {"load.skip_plugins", "1"}});
+        const int channels = module.get_num_channels();
+        PatternCache result(channels);
+        for (int pattern = 0; pattern < module.get_num_patterns(); ++pattern) {
+            if (cancelled && cancelled->load(std::memory_order_relaxed)) {
+                error_message = "Cancelled";
+                return false;
+            }
+            const int rows = module.get_pattern_num_rows(pattern);
+            result.begin_pattern(rows);
+            for (int row = 0; row < rows; ++row) {
+                for (int channel = 0; channel < channels; ++channel) {
+                    result.add_cell(module.format_pattern_row_channel(pattern, row, channel));
+                }
+            }
+        }
+        std::vector<int> orders(static_cast<std::size_t>(std::max(0, module.get_num_orders())));
+        for (std::size_t order = 0; order < orders.size(); ++order) {
+            orders[order] = module.get_order_pattern(static_cast<int>(order));
+        }
+        result.set_orders(std::move(orders));
+        cache = std::move(result);
+        return true;
+    } catch (const std::exception& ex) {
+        error_message = ex.what();
+    } catch (...) {
+        error_message = "Unknown error while loading module";
+    }
+    return false;
+}
+
+bool find_song_envelope(const LibraryIndex& index, const std::filesystem::path& path,
+                        std::vector<std::uint8_t>& levels) {
+    std::error_code ec;
+    const std::filesystem::path absolute = std::filesystem::absolute(path, ec).lexically_normal();
+    auto found = index.is_open() && !ec ? index.find(absolute.string()) : std::nullopt;
+    if (!found) {
+        return false;
+    }
+    const LibraryIndex::Entry entry = index.entry(*found);
+    struct stat info{};
+    if (entry.envelope.empty() || ::stat(absolute.c_str(), &info) != 0 ||
+        entry.size != static_cast<std::uint64_t>(info.st_size) ||
+        entry.mtime_ns != static_cast<std::int64_t>(info.st_mtim.tv_sec) * 1'000'000'000 + info.st_mtim.tv_nsec) {
+        return false;
+    }
+    levels.assign(entry.envelope.begin(), entry.envelope.end());
+    return true;
+}
+
+ProbeResult probe_module_header(const std::uint8_t* header, std::size_t size, std::uint64_t file_size) {
+    try {
+        switch (openmpt::probe_file_header(openmpt::probe_file_header_flags_default, header, size, file_size)) {
+            case openmpt::probe_file_header_result_success:
+                return ProbeResult::Module;
+            case openmpt::probe_file_header_result_wantmoredata:
+                return ProbeResult::NeedMoreData;
+            default:
+                return ProbeResult::NotModule;
+        }
+    } catch (...) {
+        return ProbeResult::NotModule;
+    }
+}
+
+std::shared_ptr<ModuleDetector> make_module_detector(std::shared_ptr<const LibraryIndex> cache) {
+    auto detector = std::make_shared<ModuleDetector>(probe_module_header);
+    if (cache && cache->is_open()) {
+        detector->set_cache([cache](const DetectionCandidate& candidate) -> std::optional<bool> {
+            auto found = cache->find(candidate.path.string());
+            if (!found) {
+                return std::nullopt;
+            }
+            const LibraryIndex::Entry entry = cache->entry(*found);
+            if (entry.size != candidate.size || entry.mtime_ns != candidate.mtime_ns ||
+                !(entry.flags & LibraryRecord::kProbed)) {
+                return std::nullopt;
+            }
+            return (entry.flags & LibraryRecord::kDetectedModule) != 0;
+        });
+    }
+    return detector;
+}
+
+}
@@ -0,0 +1,509 @@
+#include "offline_renderer.hpp"
+#include "loudness.hpp"
+#include "scoped_timer.hpp"
+#include "spill_buffer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+#include <libopenmpt/libopenmpt.hpp>
+
+namespace tracker {
+
+namespace {
+
+constexpr std::size_t kChunkFrames = 4096;
+constexpr std::size_t kLaneQueueDepth = 8;
+
+using SampleSink = std::function<bool(const float* samples, std::size_t sample_count)>;
+
+// Passes chunks straight through, or through a resampler when the output
+// rate differs from the render rate.
+class RateAdapter {
+public:
+    RateAdapter(const ExportOptions& options, int render_rate) {
+        if (render_rate != options.sample_rate) {
+            resampler_.emplace(render_rate, options.sample_rate, options.channels, options.resampler_quality);
+        }
+    }
+
+    bool push(const float* samples, std::size_t sample_count, double& resample_seconds, const SampleSink& sink) {
+        if (!resampler_) {
+            return sink(samples, sample_count);
+        }
+        buffer_.clear();
+        {
+            ScopedTimer resample(resample_seconds);
+            resampler_->process(samples, sample_count / 2, buffer_);
+        }
+        return buffer_.empty() || sink(buffer_.data(), buffer_.size());
+    }
+
+    bool finish(double& resample_seconds, const SampleSink& sink) {
+        if (!resampler_) {
+            return true;
+        }
+        buffer_.clear();
+        {
+            ScopedTimer resample(resample_seconds);
+            resampler_->flush(buffer_);
+        }
+        return buffer_.empty() || sink(buffer_.data(), buffer_.size());
+    }
+
+private:
+    std::optional<Resampler> resampler_;
+    std::vector<float> buffer_;
+};
+
+struct EncoderLane {
+    ExportOptions options;
+    AudioExporter exporter;
+    std::deque<std::shared_ptr<const std::vector<float>>> queue;
+    bool closed = false;
+    bool done = false;
+    bool failed = false;
+    std::string error_message;
+    double resample_seconds = 0.0;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::thread thread;
+};
+
+void run_lane(EncoderLane& lane, int render_rate, const std::atomic<bool>& abort) {
+    RateAdapter adapter(lane.options, render_rate);
+    auto sink = [&lane](const float* samples, std::size_t sample_count) {
+        return lane.exporter.write(samples, sample_count, lane.error_message);
+    };
+
+    bool success = true;
+    while (true) {
+        std::shared_ptr<const std::vector<float>> chunk;
+        {
+            std::unique_lock lock(lane.mutex);
+            lane.cv.wait(lock, [&] { return !lane.queue.empty() || lane.closed || abort.load(); });
+            if (abort.load()) {
+                success = false;
+                break;
+            }
+            if (lane.queue.empty()) {
+                break;
+            }
+            chunk = std::move(lane.queue.front());
+            lane.queue.pop_front();
+        }
+        lane.cv.notify_all();
+
+        if (!adapter.push(chunk->data(), chunk->size(), lane.resample_seconds, sink)) {
+            success = false;
+            break;
+        }
+    }
+
+    if (success) {
+        success = adapter.finish(lane.resample_seconds, sink) && lane.exporter.finish(lane.error_message);
+    }
+    if (!success) {
+        lane.exporter.abort();
+    }
+
+    {
+        std::lock_guard lock(lane.mutex);
+        lane.failed = !success;
+        lane.done = true;
+    }
+    lane.cv.notify_all();
+}
+
+}
+
+OfflineRenderer::OfflineRenderer(std::string module_path)
+    : module_path_(std::move(module_path)) {}
+
+std::size_t OfflineRenderer::progress_passes(const ExportOptions& options) {
+    return options.normalization == NormalizationMode::None ? 1 : 2;
+}
+
+bool OfflineRenderer::render_stream(const ExportOptions& options, std::size_t pass, const StartHandler& on_start,
+                                    const ChunkHandler& on_chunk, std::string& error_message) {
+    if (options.channels != 2) {
+        error_message = "Only stereo export is supported";
+        return false;
+    }
+    if (options.sample_rate <= 0 || options.render_sample_rate < 0) {
+        error_message = "Invalid sample rate";
+        return false;
+    }
+    const int render_rate = options.effective_render_rate();
+
+    try {
+        std::ifstream file(module_path_, std::ios::binary);
+        if (!file) {
+            error_message = "Unable to open module file: " + module_path_;
+            return false;
+        }
+
+        std::ostringstream load_log;
+        std::unique_ptr<openmpt::module> module;
+        {
+            ScopedTimer render_time(stats_.render_seconds);
+            module = std::make_unique<openmpt::module>(file, load_log);
+        }
+        if (options.interpolation_filter_length > 0) {
+            module->set_render_param(openmpt::module::RENDER_INTERPOLATIONFILTER_LENGTH,
+                                     options.interpolation_filter_length);
+        }
+
+        const double duration = module->get_duration_seconds();
+        const std::size_t total_samples =
+            static_cast<std::size_t>(duration * render_rate) * static_cast<std::size_t>(options.channels);
+        const std::size_t passes = progress_passes(options);
+
+        if (!on_start(total_samples)) {
+            return false;
+        }
+
+        AudioEffects effects(render_rate);
+        const float volume = static_cast<float>(options.volume);
+
+        std::vector<float> chunk_buffer(kChunkFrames * static_cast<std::size_t>(options.channels));
+        std::size_t samples_rendered = 0;
+
+        while (samples_rendered < total_samples) {
+            std::size_t frames_to_read =
+                std::min(kChunkFrames, (total_samples - samples_rendered) / static_cast<std::size_t>(options.channels));
+            if (frames_to_read == 0) {
+                break;
+            }
+
+            std::size_t frames_read;
+            {
+                ScopedTimer render_time(stats_.render_seconds);
+                frames_read = module->read_interleaved_stereo(render_rate, frames_to_read,
+                                                              chunk_buffer.data());
+            }
+            if (frames_read == 0) {
+                break;
+            }
+
+            const std::size_t samples_read = frames_read * static_cast<std::size_t>(options.channels);
+            {
+                ScopedTimer effect_time(stats_.effect_seconds);
+                if (volume != 1.0f) {
+                    for (std::size_t i = 0; i < samples_read; ++i) {
+                        chunk_buffer[i] *= volume;
+                    }
+                }
+
+                if (options.effect != AudioEffect::None) {
+                    effects.apply_effects(chunk_buffer.data(), frames_read, options.effect);
+                }
+            }
+
+            if (!on_chunk(chunk_buffer.data(), samples_read)) {
+                return false;
+            }
+
+            samples_rendered += samples_read;
+            stats_.audio_seconds = static_cast<double>(samples_rendered / static_cast<std::size_t>(options.channels)) /
+                                   static_cast<double>(render_rate);
+
+            if (options.progress_callback &&
+                !options.progress_callback(pass * total_samples + samples_rendered, total_samples * passes)) {
+                error_message = "Export cancelled by user";
+                return false;
+            }
+        }
+
+        return true;
+
+    } catch (const std::exception& e) {
+        error_message = std::string("Render failed: ") + e.what();
+        return false;
+    }
+}
+
+bool OfflineRenderer::render(const ExportOptions& options, std::vector<float>& audio_data,
+                             std::string& error_message) {
+    ExportOptions render_options = options;
+    render_options.normalization = NormalizationMode::None;
+
+    stats_ = ExportStats{};
+    ScopedTimer wall(stats_.wall_seconds);
+
+    audio_data.clear();
+    RateAdapter adapter(options, options.effective_render_rate());
+    SampleSink append = [&audio_data](const float* samples, std::size_t sample_count) {
+        audio_data.insert(audio_data.end(), samples, samples + sample_count);
+        return true;
+    };
+
+    return render_stream(
+               render_options, 0,
+               [&audio_data](std::size_t total_samples) {
+                   audio_data.reserve(total_samples);
+                   return true;
+               },
+               [&](const float* samples, std::size_t sample_count) {
+                   return adapter.push(samples, sample_count, stats_.resample_seconds, append);
+               },
+               error_message) &&
+           adapter.finish(stats_.resample_seconds, append);
+}
+
+bool OfflineRenderer::render_to_file(const ExportOptions& options, std::string& error_message) {
+    if (options.normalization != NormalizationMode::None) {
+        return render_normalized(options, error_message);
+    }
+
+    stats_ = ExportStats{};
+    const auto started = std::chrono::steady_clock::now();
+
+    AudioExporter exporter;
+    RateAdapter adapter(options, options.effective_render_rate());
+    SampleSink encode = [&](const float* samples, std::size_t sample_count) {
+        return exporter.write(samples, sample_count, error_message);
+    };
+
+    bool success = render_stream(
+        options, 0,
+        [&](std::size_t) { return exporter.begin(options, error_message); },
+        [&](const float* samples, std::size_t sample_count) {
+            return adapter.push(samples, sample_count, stats_.resample_seconds, encode);
+        },
+        error_message);
+
+    if (success) {
+        success = adapter.finish(stats_.resample_seconds, encode) && exporter.finish(error_message);
+    } else {
+        exporter.abort();
+    }
+
+    merge_encoder_stats(exporter.stats());
+    stats_.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    stats_.process_peak_rss_bytes = ExportStats::read_process_peak_rss_bytes();
+    return success;
+}
+
+bool OfflineRenderer::render_normalized(const ExportOptions& options, std::string& error_message) {
+    stats_ = ExportStats{};
+    const auto started = std::chrono::steady_clock::now();
+    auto finish_stats = [this, &started]() {
+        stats_.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        stats_.process_peak_rss_bytes = ExportStats::read_process_peak_rss_bytes();
+    };
+
+    SpillBuffer spill;
+    LoudnessMeter meter(options.effective_render_rate());
+    std::size_t expected_samples = 0;
+
+    bool success = render_stream(
+        options, 0,
+        [&](std::size_t total_samples) {
+            expected_samples = total_samples;
+            ScopedTimer io(stats_.io_seconds);
+            return spill.open(total_samples, error_message);
+        },
+        [&](const float* samples, std::size_t sample_count) {
+            {
+                ScopedTimer analysis(stats_.analysis_seconds);
+                meter.process(samples, sample_count / 2);
+            }
+            ScopedTimer io(stats_.io_seconds);
+            return spill.append(samples, sample_count, error_message);
+        },
+        error_message);
+
+    if (!success) {
+        finish_stats();
+        return false;
+    }
+
+    const double lufs = meter.integrated_lufs();
+    const double peak_db = meter.true_peak_db();
+    double gain_db = 0.0;
+    if (std::isfinite(peak_db)) {
+        if (options.normalization == NormalizationMode::Peak) {
+            gain_db = options.peak_ceiling_db - peak_db;
+        } else if (std::isfinite(lufs)) {
+            gain_db = options.target_lufs - lufs;
+            if (!options.limiter) {
+                gain_db = std::min(gain_db, options.peak_ceiling_db - peak_db);
+            }
+        }
+    }
+
+    stats_.normalized = true;
+    stats_.measured_lufs = lufs;
+    stats_.measured_true_peak_db = peak_db;
+    stats_.applied_gain_db = gain_db;
+
+    const float gain = static_cast<float>(decibels_to_gain(gain_db));
+    PeakLimiter limiter(options.effective_render_rate(), static_cast<float>(decibels_to_gain(options.peak_ceiling_db)));
+    const bool use_limiter = options.limiter && options.normalization == NormalizationMode::Loudness;
+
+    spill.prepare_for_read();
+    const float* source = spill.data();
+    const std::size_t total_frames = spill.size() / 2;
+    const std::size_t progress_total = std::max(expected_samples, spill.size());
+    std::vector<float> chunk_buffer(kChunkFrames * 2);
+
+    AudioExporter exporter;
+    RateAdapter adapter(options, options.effective_render_rate());
+    SampleSink encode = [&](const float* samples, std::size_t sample_count) {
+        return exporter.write(samples, sample_count, error_message);
+    };
+    success = exporter.begin(options, error_message);
+
+    for (std::size_t frame = 0; success && frame < total_frames; frame += kChunkFrames) {
+        const std::size_t frame_count = std::min(kChunkFrames, total_frames - frame);
+        {
+            ScopedTimer analysis(stats_.analysis_seconds);
+            if (use_limiter) {
+                limiter.process(source, total_frames, frame, frame_count, gain, chunk_buffer.data());
+            } else {
+                const float* chunk = source + frame * 2;
+                for (std::size_t i = 0; i < frame_count * 2; ++i) {
+                    chunk_buffer[i] = chunk[i] * gain;
+                }
+            }
+        }
+
+        success = adapter.push(chunk_buffer.data(), frame_count * 2, stats_.resample_seconds, encode);
+
+        if (success && options.progress_callback &&
+            !options.progress_callback(progress_total + (frame + frame_count) * 2, progress_total * 2)) {
+            error_message = "Export cancelled by user";
+            success = false;
+        }
+    }
+
+    if (success) {
+        success = adapter.finish(stats_.resample_seconds, encode) && exporter.finish(error_message);
+    } else {
+        exporter.abort();
+    }
+
+    merge_encoder_stats(exporter.stats());
+    finish_stats();
+    return success;
+}
+
+bool OfflineRenderer::render_to_files(const ExportOptions& options, const std::vector<ExportOptions>& outputs,
+                                      std::string& error_message) {
+    if (outputs.empty()) {
+        error_message = "No outputs specified";
+        return false;
+    }
+    if (options.normalization != NormalizationMode::None) {
+        error_message = "Normalization is not supported for multi-output export";
+        return false;
+    }
+
+    std::set<std::string> paths;
+    for (const auto& output : outputs) {
+        if (output.channels != options.channels) {
+            error_message = "All outputs must use the render channel count";
+            return false;
+        }
+        if (!paths.insert(output.output_path).second) {
+            error_message = "Duplicate output path: " + output.output_path;
+            return false;
+        }
+    }
+
+    stats_ = ExportStats{};
+    const auto started = std::chrono::steady_clock::now();
+    const int render_rate = options.effective_render_rate();
+
+    std::vector<std::unique_ptr<EncoderLane>> lanes;
+    for (const auto& output : outputs) {
+        auto lane = std::make_unique<EncoderLane>();
+        lane->options = output;
+        lane->options.resampler_quality = options.resampler_quality;
+        if (!lane->exporter.begin(lane->options, error_message)) {
+            error_message = output.output_path + ": " + error_message;
+            for (auto& started_lane : lanes) {
+                started_lane->exporter.abort();
+            }
+            return false;
+        }
+        lanes.push_back(std::move(lane));
+    }
+
+    std::atomic<bool> abort{false};
+    for (auto& lane : lanes) {
+        lane->thread = std::thread(run_lane, std::ref(*lane), render_rate, std::cref(abort));
+    }
+
+    auto fan_out = [&](const float* samples, std::size_t sample_count) {
+        auto chunk = std::make_shared<const std::vector<float>>(samples, samples + sample_count);
+        for (auto& lane : lanes) {
+            std::unique_lock lock(lane->mutex);
+            lane->cv.wait(lock, [&] { return lane->queue.size() < kLaneQueueDepth || lane->done; });
+            if (lane->done) {
+                error_message = lane->options.output_path + ": " + lane->error_message;
+                return false;
+            }
+            lane->queue.push_back(chunk);
+            lock.unlock();
+            lane->cv.notify_all();
+        }
+        return true;
+    };
+
+    bool success = render_stream(options, 0, [](std::size_t) { return true; }, fan_out, error_message);
+
+    if (!success) {
+        abort.store(true);
+    }
+    for (auto& lane : lanes) {
+        {
+            std::lock_guard lock(lane->mutex);
+            lane->closed = true;
+        }
+        lane->cv.notify_all();
+    }
+    for (auto& lane : lanes) {
+        lane->thread.join();
+        merge_encoder_stats(lane->exporter.stats());
+        stats_.resample_seconds += lane->resample_seconds;
+        if (success && lane->failed) {
+            success = false;
+            error_message = lane->options.output_path + ": " + lane->error_message;
+        }
+    }
+
+    // A lane that failed after the render finished leaves its siblings
+    // complete; remove them too so the output set stays all-or-nothing.
+    if (!success) {
+        for (auto& lane : lanes) {
+            std::remove(lane->options.output_path.c_str());
+        }
+    }
+
+    stats_.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    stats_.process_peak_rss_bytes = ExportStats::read_process_peak_rss_bytes();
+    return success;
+}
+
+void OfflineRenderer::merge_encoder_stats(const ExportStats& encoder_stats) {
+    stats_.encode_seconds += encoder_stats.encode_seconds;
+    stats_.io_seconds += encoder_stats.io_seconds;
+    stats_.bytes_written += encoder_stats.bytes_written;
+}
+
+}
@@ -0,0 +1,50 @@
+#include "pattern_cache.hpp"
+
+namespace tracker {
+
+void PatternCache::begin_pattern(int rows) {
+    pattern_rows_.push_back(rows > 0 ? rows : 0);
+    pattern_first_cell_.push_back(static_cast<std::uint32_t>(cell_offsets_.size() - 1));
+}
+
+void PatternCache::add_cell(std::string_view text) {
+    text_.append(text);
+    cell_offsets_.push_back(static_cast<std::uint32_t>(text_.size()));
+}
+
+int PatternCache::num_rows(int pattern) const noexcept {
+    if (pattern < 0 || pattern >= num_patterns()) {
+        return 0;
+    }
+    return pattern_rows_[static_cast<std::size_t>(pattern)];
+}
+
+int PatternCache::order_pattern(int order) const noexcept {
+    if (order < 0 || order >= num_orders()) {
+        return -1;
+    }
+    const int pattern = orders_[static_cast<std::size_t>(order)];
+    return pattern < num_patterns() ? pattern : -1;
+}
+
+std::string_view PatternCache::cell(int pattern, int row, int channel) const noexcept {
+    if (row < 0 || row >= num_rows(pattern) || channel < 0 || channel >= channels_) {
+        return {};
+    }
+    const std::size_t index = pattern_first_cell_[static_cast<std::size_t>(pattern)] +
+                              static_cast<std::size_t>(row) * static_cast<std::size_t>(channels_) +
+                              static_cast<std::size_t>(channel);
+    if (index + 1 >= cell_offsets_.size()) {
+        return {};
+    }
+    const std::uint32_t begin = cell_offsets_[index];
+    return std::string_view(text_).substr(begin, cell_offsets_[index + 1] - begin);
+}
+
+std::size_t PatternCache::memory_bytes() const noexcept {
+    return text_.capacity() + cell_offsets_.capacity() * sizeof(std::uint32_t) +
+           pattern_first_cell_.capacity() * sizeof(std::uint32_t) + pattern_rows_.capacity() * sizeof(int) +
+           orders_.capacity() * sizeof(int);
+}
+
+}
@@ -1,10 +1,13 @@
 #include "player.hpp"
+#include "module_metadata.hpp"
+#include "offline_renderer.hpp"
 
 #include <algorithm>
 #include <cmath>
 #include <complex>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <numbers>
 #include <sstream>
 #include <stdexcept>
@@ -56,6 +59,22 @@ void fft(std::vector<std::complex<float>>& data) {
     }
 }
 
+// Devices that cannot run at the render rate get their native rate and
+// the rendered audio is resampled on the way out.
+int choose_device_rate(int sample_rate) {
+    PaDeviceIndex device = Pa_GetDefaultOutputDevice();
+    if (device == paNoDevice) {
+        return sample_rate;
+    }
+    const PaDeviceInfo *info = Pa_GetDeviceInfo(device);
+    PaStreamParameters output{device, 2, paFloat32, info ? info->defaultHighOutputLatency : 0.0, nullptr};
+    if (info && info->defaultSampleRate > 0.0 &&
+        Pa_IsFormatSupported(nullptr, &output, sample_rate) != paFormatIsSupported) {
+        return static_cast<int>(info->defaultSampleRate);
+    }
+    return sample_rate;
+}
+
 constexpr int CHANNEL_DISPLAY_WIDTH = 24;
 
 std::vector<std::string> read_instrument_names(openmpt::module &module) {
@@ -102,48 +121,106 @@ std::vector<std::string> split_lines(const std::string &text, std::size_t max_li
 
 }
 
-Player::Player(const std::string &path, int sample_rate, int buffer_size)
-    : sample_rate_(sample_rate), 
-      buffer_size_(buffer_size),
-      audio_effects_(std::make_unique<AudioEffects>(sample_rate)),
-      fft_buffer_(kFFTSize),
-      fft_write_pos_(0),
-      spectrum_bands_(kSpectrumBands, 0.0),
-      waveform_buffer_left_(kWaveformSize, 0.0f),
-      waveform_buffer_right_(kWaveformSize, 0.0f),
-      waveform_write_pos_(0) {
+struct Player::Track {
+    std::string path;
+    std::unique_ptr<openmpt::module> module;
+    std::vector<std::string> instrument_names;
+    std::vector<std::string> sample_names;
+    std::vector<std::string> message_lines;
+    std::string title;
+    std::string tracker_name;
+    std::string artist;
+    std::string module_type;
+    std::string date;
+    int num_channels{0};
+    int num_instruments{0};
+    int num_samples{0};
+    int num_patterns{0};
+    int num_orders{0};
+    double duration_seconds{0.0};
+};
+
+std::unique_ptr<Player::Track> Player::load_track(const std::string &path, const std::string &fallback_title) {
     std::ifstream file(path, std::ios::binary);
     if (!file) {
         throw std::runtime_error("Unable to open module file: " + path);
     }
 
-    module_ = std::make_unique<openmpt::module>(file);
+    auto track = std::make_unique<Track>();
+    track->path = path;
+    std::ostringstream log;
+    track->module = std::make_unique<openmpt::module>(file, log);
+    openmpt::module &module = *track->module;
 
-    instrument_names_ = read_instrument_names(*module_);
-    for (auto &name : instrument_names_) {
+    track->instrument_names = read_instrument_names(module);
+    for (auto &name : track->instrument_names) {
         name = sanitize_name(name);
     }
 
-    sample_names_ = module_->get_sample_names();
-    for (auto &name : sample_names_) {
+    track->sample_names = module.get_sample_names();
+    for (auto &name : track->sample_names) {
         name = sanitize_name(name);
     }
 
-    tracker_name_ = module_->get_metadata("tracker");
-    if (tracker_name_.empty()) {
-        tracker_name_ = "Unknown";
+    track->tracker_name = module.get_metadata("tracker");
+    if (track->tracker_name.empty()) {
+        track->tracker_name = "Unknown";
     }
 
-    std::string message = module_->get_metadata("message");
+    std::string message = module.get_metadata("message");
     if (message.empty()) {
-        message = module_->get_metadata("comment");
+        message = module.get_metadata("comment");
     }
     if (message.empty()) {
-        message = module_->get_metadata("message_text");
+        message = module.get_metadata("message_text");
     }
     if (!message.empty()) {
-        module_message_lines_ = split_lines(message, 256);
+        track->message_lines = split_lines(message, 256);
+    }
+
+    track->title = module.get_metadata("title");
+    if (track->title.empty()) {
+        track->title = fallback_title.empty() ? path : fallback_title;
+    }
+    
+    track->artist = module.get_metadata("artist");
+    if (track->artist.empty()) {
+        track->artist = "Unknown";
+    }
+    
+    track->module_type = module.get_metadata("type");
+    if (track->module_type.empty()) {
+        track->module_type = module.get_metadata("type_long");
     }
+    if (track->module_type.empty()) {
+        track->module_type = "Unknown";
+    }
+    
+    track->date = module.get_metadata("date");
+    
+    track->num_channels = module.get_num_channels();
+    track->num_instruments = module.get_num_instruments();
+    track->num_samples = module.get_num_samples();
+    track->num_patterns = module.get_num_patterns();
+    track->num_orders = module.get_num_orders();
+    track->duration_seconds = module.get_duration_seconds();
+    return track;
+}
+
+Player::Player(const std::string &path, int sample_rate, int buffer_size)
+    : sample_rate_(sample_rate), 
+      buffer_size_(buffer_size),
+      audio_effects_(std::make_unique<AudioEffects>(sample_rate)),
+      fft_buffer_(kFFTSize),
+      fft_write_pos_(0),
+      spectrum_bands_(kSpectrumBands, 0.0),
+      waveform_buffer_left_(kWaveformSize, 0.0f),
+      waveform_buffer_right_(kWaveformSize, 0.0f),
+      waveform_write_pos_(0) {
+    auto track = load_track(path, {});
+    module_ = std::move(track->module);
+    active_instrument_names_ = track->instrument_names;
+    adopt_metadata(*track);
 
     PaError err;
     {
@@ -155,47 +232,28 @@ Player::Player(const std::string &path, int sample_rate, int buffer_size)
     }
     pa_initialized_ = true;
 
-    err = Pa_OpenDefaultStream(&stream_, 0, 2, paFloat32, sample_rate_, buffer_size_, nullptr, nullptr);
+    device_sample_rate_ = choose_device_rate(sample_rate_);
+    if (device_sample_rate_ != sample_rate_) {
+        resampler_ = std::make_unique<Resampler>(sample_rate_, device_sample_rate_, 2, ResamplerQuality::Balanced);
+    }
+
+    err = Pa_OpenDefaultStream(&stream_, 0, 2, paFloat32, device_sample_rate_, buffer_size_, nullptr, nullptr);
     if (err != paNoError) {
         Pa_Terminate();
         pa_initialized_ = false;
         throw std::runtime_error(std::string("Failed to open PortAudio stream: ") + Pa_GetErrorText(err));
     }
 
-    title_ = module_->get_metadata("title");
-    if (title_.empty()) {
-        title_ = path;
-    }
-    
-    artist_ = module_->get_metadata("artist");
-    if (artist_.empty()) {
-        artist_ = "Unknown";
-    }
-    
-    module_type_ = module_->get_metadata("type");
-    if (module_type_.empty()) {
-        module_type_ = module_->get_metadata("type_long");
-    }
-    if (module_type_.empty()) {
-        module_type_ = "Unknown";
-    }
-    
-    date_ = module_->get_metadata("date");
-    
-    num_channels_ = module_->get_num_channels();
-    num_instruments_ = module_->get_num_instruments();
-    num_samples_ = module_->get_num_samples();
-    num_patterns_ = module_->get_num_patterns();
-    num_orders_ = module_->get_num_orders();
-    duration_seconds_ = module_->get_duration_seconds();
-
     state_.channels.resize(static_cast<std::size_t>(num_channels_));
     state_.spectrum_bands.resize(kSpectrumBands, 0.0);
     update_state_locked();
 }
 
 Player::~Player() {
+    cancel_envelope();
+    cancel_pattern_cache();
     stop();
+    stop_prefetch();
     if (stream_) {
         Pa_CloseStream(stream_);
         stream_ = nullptr;
@@ -218,6 +276,8 @@ void Player::start() {
     stream_running_ = true;
     stop_requested_ = false;
     playback_thread_ = std::thread(&Player::playback_loop, this);
+    request_envelope();
+    request_pattern_cache();
 }
 
 void Player::stop() {
@@ -243,6 +303,7 @@ void Player::toggle_pause() {
         std::lock_guard lock(state_mutex_);
         paused_ = !paused_;
         state_.paused = paused_;
+        touch_state_locked();
     }
     pause_cv_.notify_all();
 }
@@ -284,6 +345,22 @@ void Player::jump_to_order(int delta) {
     update_state_locked();
 }
 
+void Player::jump_to_position(int order, int row) {
+    {
+        std::lock_guard module_lock(module_mutex_);
+        if (!module_) {
+            return;
+        }
+        int target = std::clamp(order, 0, module_->get_num_orders() - 1);
+        module_->set_position_order_row(target, std::max(0, row));
+    }
+
+    std::lock_guard state_lock(state_mutex_);
+    finished_ = false;
+    state_.finished = false;
+    update_state_locked();
+}
+
 void Player::jump_rows(int delta_rows) {
     if (delta_rows == 0) {
         return;
@@ -427,6 +504,7 @@ void Player::playback_loop() {
                         channel.vu_left = 0.0;
                         channel.vu_right = 0.0;
                     }
+                    touch_state_locked();
                 }
             }
 
@@ -463,9 +541,13 @@ void Player::playback_loop() {
         }
 
         if (frames_rendered <= 0) {
+            if (advance_track()) {
+                continue;
+            }
             std::lock_guard lock(state_mutex_);
             finished_ = true;
             state_.finished = true;
+            touch_state_locked();
             break;
         }
 
@@ -489,7 +571,16 @@ void Player::playback_loop() {
         update_spectrum(buffer.data(), static_cast<std::size_t>(frames_rendered * 2));
         update_waveform(buffer.data(), static_cast<std::size_t>(frames_rendered * 2));
 
-        PaError err = Pa_WriteStream(stream_, buffer.data(), frames_rendered);
+        const float *output = buffer.data();
+        unsigned long output_frames = static_cast<unsigned long>(frames_rendered);
+        if (resampler_) {
+            resampled_buffer_.clear();
+            output_frames = static_cast<unsigned long>(
+                resampler_->process(buffer.data(), static_cast<std::size_t>(frames_rendered), resampled_buffer_));
+            output = resampled_buffer_.data();
+        }
+
+        PaError err = output_frames > 0 ? Pa_WriteStream(stream_, output, output_frames) : paNoError;
         if (err != paNoError) {
             std::cerr << "PortAudio error: " << Pa_GetErrorText(err) << std::endl;
             break;
@@ -506,6 +597,7 @@ void Player::update_state_locked() {
     if (!module_) {
         return;
     }
+    touch_state_locked();
 
     std::lock_guard module_lock(module_mutex_);
 
@@ -554,7 +646,7 @@ void Player::update_state_locked() {
                             }
                         }
                         
-                        if (detected_ins > 0 && detected_ins <= static_cast<int>(instrument_names_.size())) {
+                        if (detected_ins > 0 && detected_ins <= static_cast<int>(active_instrument_names_.size())) {
                             channel_instruments_[static_cast<std::size_t>(ch)] = detected_ins - 1;
                         }
                     } catch (...) {
@@ -565,9 +657,9 @@ void Player::update_state_locked() {
             double vu_level = std::max(std::abs(status.vu_left), std::abs(status.vu_right));
             if (vu_level > 0.01 && channel_instruments_[static_cast<std::size_t>(ch)] >= 0) {
                 int ins_idx = channel_instruments_[static_cast<std::size_t>(ch)];
-                if (ins_idx < static_cast<int>(instrument_names_.size())) {
+                if (ins_idx < static_cast<int>(active_instrument_names_.size())) {
                     status.instrument_index = ins_idx;
-                    status.instrument_name = instrument_names_[static_cast<std::size_t>(ins_idx)];
+                    status.instrument_name = active_instrument_names_[static_cast<std::size_t>(ins_idx)];
                 } else {
                     status.instrument_index = -1;
                     status.instrument_name.clear();
@@ -646,6 +738,10 @@ void Player::update_state_locked() {
     }
 }
 
+void Player::touch_state_locked() {
+    state_.version = state_version_.fetch_add(1, std::memory_order_acq_rel) + 1;
+}
+
 void Player::update_spectrum(const float* audio_data, std::size_t sample_count) {
     std::lock_guard lock(spectrum_mutex_);
 
@@ -747,105 +843,388 @@ void Player::update_waveform(const float* audio_data, std::size_t sample_count)
 }
 
 bool Player::export_to_file(const ExportOptions& options, std::string& error_message) {
-    try {
-        bool was_playing = false;
-        {
-            std::lock_guard lock(state_mutex_);
-            was_playing = running_ && !paused_;
-            if (was_playing) {
-                paused_ = true;
+    ExportOptions render_options = options;
+    {
+        std::lock_guard lock(state_mutex_);
+        render_options.volume = volume_;
+        render_options.effect = current_effect_;
+    }
+
+    OfflineRenderer renderer(module_path_);
+    return renderer.render_to_file(render_options, error_message);
+}
+
+void Player::adopt_metadata(Track &track) {
+    module_path_ = std::move(track.path);
+    instrument_names_ = std::move(track.instrument_names);
+    sample_names_ = std::move(track.sample_names);
+    module_message_lines_ = std::move(track.message_lines);
+    title_ = std::move(track.title);
+    tracker_name_ = std::move(track.tracker_name);
+    artist_ = std::move(track.artist);
+    module_type_ = std::move(track.module_type);
+    date_ = std::move(track.date);
+    num_channels_ = track.num_channels;
+    num_instruments_ = track.num_instruments;
+    num_samples_ = track.num_samples;
+    num_patterns_ = track.num_patterns;
+    num_orders_ = track.num_orders;
+    duration_seconds_ = track.duration_seconds;
+}
+
+void Player::install_track(std::unique_ptr<Track> track) {
+    std::lock_guard state_lock(state_mutex_);
+    {
+        std::lock_guard module_lock(module_mutex_);
+        module_ = std::move(track->module);
+        active_instrument_names_ = track->instrument_names;
+        channel_instruments_.assign(static_cast<std::size_t>(module_->get_num_channels()), -1);
+    }
+    finished_ = false;
+    state_.finished = false;
+    pending_track_ = std::move(track);
+    update_state_locked();
+}
+
+bool Player::poll_track_change() {
+    std::unique_ptr<Track> track;
+    {
+        std::lock_guard lock(state_mutex_);
+        track = std::move(pending_track_);
+    }
+    if (!track) {
+        return false;
+    }
+    adopt_metadata(*track);
+    request_envelope();
+    request_pattern_cache();
+    return true;
+}
+
+std::vector<std::uint8_t> Player::song_envelope() const {
+    std::lock_guard lock(envelope_mutex_);
+    return envelope_;
+}
+
+// The render uses its own module instance, read from disk again, so the
+// playback thread's module is never touched.
+void Player::request_envelope() {
+    cancel_envelope();
+    {
+        std::lock_guard lock(envelope_mutex_);
+        envelope_.clear();
+    }
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    envelope_cancelled_ = cancelled;
+    envelope_thread_ = std::thread([this, path = module_path_, lookup = envelope_lookup_, cancelled] {
+        std::vector<std::uint8_t> levels;
+        if (!lookup || !lookup(path, levels)) {
+            std::ifstream file(path, std::ios::binary);
+            std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            std::string error_message;
+            if (data.empty() || !render_song_envelope(data.data(), data.size(), levels, error_message, cancelled.get())) {
+                return;
             }
         }
-        
-        double saved_position;
-        double duration;
-        std::size_t total_samples;
-        
-        {
-            std::lock_guard module_lock(module_mutex_);
-            saved_position = module_->get_position_seconds();
-            duration = module_->get_duration_seconds();
-            total_samples = static_cast<std::size_t>(duration * options.sample_rate * options.channels);
-            module_->set_position_seconds(0.0);
+        std::lock_guard lock(envelope_mutex_);
+        if (!cancelled->load()) {
+            envelope_ = std::move(levels);
         }
-        
-        std::vector<float> audio_buffer;
-        audio_buffer.reserve(total_samples);
-        
-        const std::size_t chunk_size = 4096 * options.channels;
-        std::vector<float> chunk_buffer(chunk_size);
-        std::size_t samples_rendered = 0;
-        
-        while (samples_rendered < total_samples) {
-            std::size_t to_read = std::min(chunk_size, total_samples - samples_rendered);
-            std::size_t frames_to_read = to_read / options.channels;
-            
-            std::size_t frames_read;
-            {
-                std::lock_guard module_lock(module_mutex_);
-                frames_read = module_->read_interleaved_stereo(
-                    options.sample_rate, 
-                    frames_to_read, 
-                    chunk_buffer.data()
-                );
-            }
-            
-            if (frames_read == 0) {
-                break;
-            }
-            
-            for (std::size_t i = 0; i < frames_read * options.channels; ++i) {
-                chunk_buffer[i] *= static_cast<float>(volume_);
-            }
-            
-            if (current_effect_ != AudioEffect::None && audio_effects_) {
-                audio_effects_->apply_effects(chunk_buffer.data(), frames_read, current_effect_);
+    });
+}
+
+void Player::cancel_envelope() {
+    if (envelope_cancelled_) {
+        envelope_cancelled_->store(true);
+    }
+    if (envelope_thread_.joinable()) {
+        envelope_thread_.join();
+    }
+}
+
+std::shared_ptr<const PatternCache> Player::pattern_cache() const {
+    std::lock_guard lock(pattern_cache_mutex_);
+    return pattern_cache_;
+}
+
+std::shared_ptr<const SongMinimap> Player::song_minimap() const {
+    std::lock_guard lock(pattern_cache_mutex_);
+    return minimap_;
+}
+
+std::uint64_t Player::pattern_cache_generation() const {
+    std::lock_guard lock(pattern_cache_mutex_);
+    return pattern_cache_generation_;
+}
+
+void Player::request_pattern_cache() {
+    cancel_pattern_cache();
+    {
+        std::lock_guard lock(pattern_cache_mutex_);
+        pattern_cache_.reset();
+        minimap_.reset();
+        ++pattern_cache_generation_;
+    }
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    pattern_cache_cancelled_ = cancelled;
+    pattern_cache_thread_ = std::thread([this, path = module_path_, cancelled] {
+        std::ifstream file(path, std::ios::binary);
+        std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        auto cache = std::make_shared<PatternCache>();
+        std::string error_message;
+        if (data.empty() || !load_pattern_cache(data.data(), data.size(), *cache, error_message, cancelled.get())) {
+            return;
+        }
+        auto minimap = std::make_shared<const SongMinimap>(*cache);
+        std::lock_guard lock(pattern_cache_mutex_);
+        if (!cancelled->load()) {
+            pattern_cache_ = std::move(cache);
+            minimap_ = std::move(minimap);
+            ++pattern_cache_generation_;
+        }
+    });
+}
+
+void Player::cancel_pattern_cache() {
+    if (pattern_cache_cancelled_) {
+        pattern_cache_cancelled_->store(true);
+    }
+    if (pattern_cache_thread_.joinable()) {
+        pattern_cache_thread_.join();
+    }
+}
+
+void Player::set_playlist(std::shared_ptr<Playlist> playlist) {
+    std::lock_guard lock(playlist_mutex_);
+    playlist_ = std::move(playlist);
+    if (!prefetch_thread_.joinable()) {
+        prefetch_thread_ = std::thread(&Player::prefetch_loop, this);
+    }
+    schedule_prefetch_locked();
+}
+
+bool Player::has_playlist() const {
+    std::lock_guard lock(playlist_mutex_);
+    return playlist_ != nullptr;
+}
+
+PlaylistStatus Player::playlist_status() const {
+    std::lock_guard lock(playlist_mutex_);
+    PlaylistStatus status;
+    if (playlist_) {
+        status.position = playlist_->position();
+        status.count = playlist_->size();
+        status.shuffle = playlist_->shuffle();
+        status.repeat = playlist_->repeat();
+    }
+    return status;
+}
+
+void Player::toggle_shuffle() {
+    std::lock_guard lock(playlist_mutex_);
+    if (playlist_) {
+        playlist_->set_shuffle(!playlist_->shuffle());
+        schedule_prefetch_locked();
+    }
+}
+
+void Player::cycle_repeat() {
+    std::lock_guard lock(playlist_mutex_);
+    if (!playlist_) {
+        return;
+    }
+    switch (playlist_->repeat()) {
+        case RepeatMode::Off: playlist_->set_repeat(RepeatMode::All); break;
+        case RepeatMode::All: playlist_->set_repeat(RepeatMode::One); break;
+        case RepeatMode::One: playlist_->set_repeat(RepeatMode::Off); break;
+    }
+    schedule_prefetch_locked();
+}
+
+bool Player::skip_track(int direction) {
+    std::unique_ptr<Track> track;
+    {
+        std::unique_lock lock(playlist_mutex_);
+        if (!playlist_) {
+            return false;
+        }
+        // Entries that fail to load are stepped over.
+        for (std::size_t attempts = playlist_->size(); attempts > 0 && !track; --attempts) {
+            auto index = direction < 0 ? playlist_->previous() : playlist_->next();
+            if (!index) {
+                return false;
             }
-            
-            audio_buffer.insert(audio_buffer.end(), 
-                              chunk_buffer.begin(), 
-                              chunk_buffer.begin() + frames_read * options.channels);
-            
-            samples_rendered += frames_read * options.channels;
-            
-            if (options.progress_callback) {
-                if (!options.progress_callback(samples_rendered, total_samples)) {
-                    error_message = "Export cancelled by user";
-                    
-                    {
-                        std::lock_guard module_lock(module_mutex_);
-                        module_->set_position_seconds(saved_position);
-                    }
-                    if (was_playing) {
-                        std::lock_guard lock(state_mutex_);
-                        paused_ = false;
-                        pause_cv_.notify_all();
-                    }
-                    return false;
-                }
+            track = load_entry_locked(*index, lock);
+        }
+        if (!track) {
+            return false;
+        }
+        schedule_prefetch_locked();
+    }
+    install_track(std::move(track));
+    return true;
+}
+
+// Runs on the playback thread when the current module has ended.
+bool Player::advance_track() {
+    std::unique_ptr<Track> track;
+    {
+        std::unique_lock lock(playlist_mutex_);
+        if (!playlist_) {
+            return false;
+        }
+        for (std::size_t attempts = playlist_->size(); attempts > 0 && !track; --attempts) {
+            auto index = playlist_->advance();
+            if (!index) {
+                return false;
             }
+            track = load_entry_locked(*index, lock);
         }
-        
-        AudioExporter exporter;
-        bool success = exporter.export_audio(audio_buffer, options, error_message);
-        
-        {
-            std::lock_guard module_lock(module_mutex_);
-            module_->set_position_seconds(saved_position);
+        if (!track) {
+            return false;
         }
-        if (was_playing) {
-            std::lock_guard lock(state_mutex_);
-            paused_ = false;
-            pause_cv_.notify_all();
+        schedule_prefetch_locked();
+    }
+    install_track(std::move(track));
+    return true;
+}
+
+// Takes the prefetched module when it is the one wanted, waiting for the
+// worker if it is still parsing; anything else is loaded here.
+std::unique_ptr<Player::Track> Player::load_entry_locked(std::size_t index, std::unique_lock<std::mutex> &lock) {
+    if (prefetch_index_ == index) {
+        prefetch_cv_.wait(lock, [&] { return prefetch_ready_ || prefetch_index_ != index || prefetch_stop_; });
+        if (prefetch_ready_ && prefetch_index_ == index) {
+            prefetch_index_.reset();
+            prefetch_ready_ = false;
+            return std::move(prefetched_);
         }
-        
-        return success;
-        
-    } catch (const std::exception& e) {
-        error_message = std::string("Export failed: ") + e.what();
-        return false;
+    }
+
+    PlaylistEntry entry = playlist_->entries()[index];
+    lock.unlock();
+    std::unique_ptr<Track> track;
+    try {
+        track = load_track(entry.path.string(), entry.title);
+    } catch (const std::exception &) {
+    }
+    lock.lock();
+    return track;
+}
+
+void Player::schedule_prefetch_locked() {
+    auto next = playlist_ ? playlist_->peek_next() : std::nullopt;
+    if (next && next == prefetch_index_ && (prefetch_requested_ || prefetch_ready_)) {
+        return;
+    }
+    prefetched_.reset();
+    prefetch_ready_ = false;
+    prefetch_index_ = next;
+    prefetch_requested_ = next.has_value();
+    if (next) {
+        prefetch_entry_ = playlist_->entries()[*next];
+    }
+    prefetch_cv_.notify_all();
+}
+
+void Player::prefetch_loop() {
+    std::unique_lock lock(playlist_mutex_);
+    while (true) {
+        prefetch_cv_.wait(lock, [&] { return prefetch_requested_ || prefetch_stop_; });
+        if (prefetch_stop_) {
+            return;
+        }
+        prefetch_requested_ = false;
+        std::size_t index = *prefetch_index_;
+        PlaylistEntry entry = prefetch_entry_;
+
+        lock.unlock();
+        std::unique_ptr<Track> track;
+        try {
+            track = load_track(entry.path.string(), entry.title);
+        } catch (const std::exception &) {
+        }
+        lock.lock();
+
+        // A failed load still counts as ready; the consumer skips the entry.
+        if (prefetch_index_ == index && !prefetch_requested_) {
+            prefetched_ = std::move(track);
+            prefetch_ready_ = true;
+            prefetch_cv_.notify_all();
+        }
+    }
+}
+
+void Player::stop_prefetch() {
+    {
+        std::lock_guard lock(playlist_mutex_);
+        prefetch_stop_ = true;
+    }
+    prefetch_cv_.notify_all();
+    if (prefetch_thread_.joinable()) {
+        prefetch_thread_.join();
     }
 }
 
-} 
+PreviewPlayer::PreviewPlayer(int sample_rate, int buffer_size)
+    : source_(sample_rate), buffer_size_(buffer_size) {
+    PaError err;
+    {
+        SuppressStderr suppress;
+        err = Pa_Initialize();
+    }
+    if (err != paNoError) {
+        throw std::runtime_error(std::string("Failed to initialize PortAudio: ") + Pa_GetErrorText(err));
+    }
 
+    const int device_sample_rate = choose_device_rate(sample_rate);
+    if (device_sample_rate != sample_rate) {
+        resampler_ = std::make_unique<Resampler>(sample_rate, device_sample_rate, 2, ResamplerQuality::Fast);
+    }
+
+    err = Pa_OpenDefaultStream(&stream_, 0, 2, paFloat32, device_sample_rate, buffer_size_, nullptr, nullptr);
+    if (err == paNoError) {
+        err = Pa_StartStream(stream_);
+    }
+    if (err != paNoError) {
+        if (stream_) {
+            Pa_CloseStream(stream_);
+        }
+        Pa_Terminate();
+        throw std::runtime_error(std::string("Failed to open PortAudio stream: ") + Pa_GetErrorText(err));
+    }
+    output_thread_ = std::thread(&PreviewPlayer::output_loop, this);
+}
+
+PreviewPlayer::~PreviewPlayer() {
+    stop_requested_ = true;
+    output_thread_.join();
+    Pa_StopStream(stream_);
+    Pa_CloseStream(stream_);
+    Pa_Terminate();
+}
+
+// Silence is written while nothing is loaded so the stream never has to be
+// restarted when the next file is ready.
+void PreviewPlayer::output_loop() {
+    std::vector<float> buffer(static_cast<std::size_t>(buffer_size_) * 2);
+    while (!stop_requested_) {
+        source_.render(buffer.data(), static_cast<std::size_t>(buffer_size_));
+
+        const float *output = buffer.data();
+        unsigned long output_frames = static_cast<unsigned long>(buffer_size_);
+        if (resampler_) {
+            resampled_buffer_.clear();
+            output_frames = static_cast<unsigned long>(
+                resampler_->process(buffer.data(), static_cast<std::size_t>(buffer_size_), resampled_buffer_));
+            output = resampled_buffer_.data();
+        }
+
+        PaError err = output_frames > 0 ? Pa_WriteStream(stream_, output, output_frames) : paNoError;
+        if (err != paNoError && err != paOutputUnderflowed) {
+            break;
+        }
+    }
+}
+
+}
@@ -0,0 +1,480 @@
+#include "playlist.hpp"
+
+#include "file_browser.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include <system_error>
+
+namespace tracker {
+
+namespace {
+
+std::string lowercase(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+std::string trim(const std::string& text) {
+    std::size_t begin = 0;
+    std::size_t end = text.size();
+    while (begin < end && std::isspace(static_cast<unsigned char>(text[begin]))) {
+        ++begin;
+    }
+    while (end > begin && std::isspace(static_cast<unsigned char>(text[end - 1]))) {
+        --end;
+    }
+    return text.substr(begin, end - begin);
+}
+
+// Upper bound for FileN/TitleN numbers; anything larger is not a real entry.
+constexpr int kMaxPlsIndex = 1'000'000;
+
+// Parses the N of a FileN/TitleN key, rejecting signs, junk and overflow.
+bool parse_pls_index(const std::string& digits, int& index) {
+    const char* end = digits.data() + digits.size();
+    auto [ptr, ec] = std::from_chars(digits.data(), end, index);
+    return !digits.empty() && std::isdigit(static_cast<unsigned char>(digits[0])) && ec == std::errc() &&
+           ptr == end && index <= kMaxPlsIndex;
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+std::string percent_decode(const std::string& text) {
+    std::string decoded;
+    decoded.reserve(text.size());
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '%' && i + 2 < text.size()) {
+            int high = hex_value(text[i + 1]);
+            int low = hex_value(text[i + 2]);
+            if (high >= 0 && low >= 0) {
+                decoded.push_back(static_cast<char>(high * 16 + low));
+                i += 2;
+                continue;
+            }
+        }
+        decoded.push_back(text[i]);
+    }
+    return decoded;
+}
+
+// Turns a playlist line into a local path. Remote URLs are not playable
+// and come back empty.
+std::filesystem::path resolve_location(const std::string& location, const std::filesystem::path& base) {
+    std::string local = location;
+    if (lowercase(local.substr(0, 7)) == "file://") {
+        local = percent_decode(local.substr(7));
+    } else if (local.find("://") != std::string::npos) {
+        return {};
+    }
+    std::filesystem::path path(local);
+    if (path.is_relative()) {
+        path = base / path;
+    }
+    return path.lexically_normal();
+}
+
+std::string location_for(const std::filesystem::path& entry, const std::filesystem::path& base) {
+    std::filesystem::path path = std::filesystem::absolute(entry).lexically_normal();
+    if (!base.empty()) {
+        std::filesystem::path relative = path.lexically_relative(base);
+        if (!relative.empty() && *relative.begin() != "..") {
+            return relative.string();
+        }
+    }
+    return path.string();
+}
+
+bool is_pls(const std::filesystem::path& file) {
+    return lowercase(file.extension().string()) == ".pls";
+}
+
+}
+
+Playlist::Playlist()
+    : rng_(std::random_device{}()) {}
+
+Playlist::Playlist(std::uint64_t seed)
+    : rng_(seed) {}
+
+bool Playlist::is_playlist_file(const std::filesystem::path& path) {
+    std::string extension = lowercase(path.extension().string());
+    return extension == ".m3u" || extension == ".m3u8" || extension == ".pls";
+}
+
+bool Playlist::load(const std::filesystem::path& file, std::string& error_message) {
+    std::ifstream input(file);
+    if (!input) {
+        error_message = "Failed to open playlist: " + file.string();
+        return false;
+    }
+
+    std::filesystem::path base = file.parent_path();
+    if (base.empty()) {
+        base = ".";
+    }
+    std::vector<PlaylistEntry> loaded;
+    std::string line;
+    bool first_line = true;
+
+    if (is_pls(file)) {
+        std::map<int, PlaylistEntry> numbered;
+        while (std::getline(input, line)) {
+            if (first_line && line.rfind("\xEF\xBB\xBF", 0) == 0) {
+                line.erase(0, 3);
+            }
+            first_line = false;
+            line = trim(line);
+            std::size_t equals = line.find('=');
+            if (equals == std::string::npos) {
+                continue;
+            }
+            std::string key = lowercase(trim(line.substr(0, equals)));
+            std::string value = trim(line.substr(equals + 1));
+            bool is_file = key.rfind("file", 0) == 0;
+            bool is_title = key.rfind("title", 0) == 0;
+            if (!is_file && !is_title) {
+                continue;
+            }
+            int index = 0;
+            if (!parse_pls_index(key.substr(is_file ? 4 : 5), index)) {
+                continue;
+            }
+            PlaylistEntry& entry = numbered[index];
+            if (is_file) {
+                entry.path = resolve_location(value, base);
+            } else {
+                entry.title = value;
+            }
+        }
+        for (auto& [number, entry] : numbered) {
+            if (!entry.path.empty()) {
+                loaded.push_back(std::move(entry));
+            }
+        }
+    } else {
+        std::string pending_title;
+        while (std::getline(input, line)) {
+            if (first_line && line.rfind("\xEF\xBB\xBF", 0) == 0) {
+                line.erase(0, 3);
+            }
+            first_line = false;
+            line = trim(line);
+            if (line.empty()) {
+                continue;
+            }
+            if (line[0] == '#') {
+                if (line.rfind("#EXTINF:", 0) == 0) {
+                    std::size_t comma = line.find(',');
+                    pending_title = comma == std::string::npos ? std::string() : trim(line.substr(comma + 1));
+                }
+                continue;
+            }
+            std::filesystem::path path = resolve_location(line, base);
+            if (!path.empty()) {
+                loaded.push_back({std::move(path), std::move(pending_title)});
+            }
+            pending_title.clear();
+        }
+    }
+
+    if (input.bad()) {
+        error_message = "Failed to read playlist: " + file.string();
+        return false;
+    }
+    for (auto& entry : loaded) {
+        add(entry.path, std::move(entry.title));
+    }
+    return true;
+}
+
+bool Playlist::save(const std::filesystem::path& file, std::string& error_message) const {
+    std::filesystem::path base = std::filesystem::absolute(file).lexically_normal().parent_path();
+    std::ofstream output(file, std::ios::trunc);
+    if (!output) {
+        error_message = "Failed to create playlist: " + file.string();
+        return false;
+    }
+
+    if (is_pls(file)) {
+        output << "[playlist]\n";
+        for (std::size_t i = 0; i < entries_.size(); ++i) {
+            const PlaylistEntry& entry = entries_[i];
+            output << "File" << (i + 1) << '=' << location_for(entry.path, base) << '\n';
+            if (!entry.title.empty()) {
+                output << "Title" << (i + 1) << '=' << entry.title << '\n';
+            }
+            output << "Length" << (i + 1) << "=-1\n";
+        }
+        output << "NumberOfEntries=" << entries_.size() << "\nVersion=2\n";
+    } else {
+        output << "#EXTM3U\n";
+        for (const PlaylistEntry& entry : entries_) {
+            if (!entry.title.empty()) {
+                output << "#EXTINF:-1," << entry.title << '\n';
+            }
+            output << location_for(entry.path, base) << '\n';
+        }
+    }
+
+    output.flush();
+    if (!output) {
+        error_message = "Failed to write playlist: " + file.string();
+        return false;
+    }
+    return true;
+}
+
+void Playlist::add(const std::filesystem::path& path, std::string title) {
+    std::size_t index = entries_.size();
+    entries_.push_back({path, std::move(title)});
+
+    if (shuffle_) {
+        // Land somewhere in the unplayed part of the current pass.
+        std::size_t first = current_ ? cursor_ + 1 : cursor_;
+        first = std::min(first, order_.size());
+        std::uniform_int_distribution<std::size_t> slot(first, order_.size());
+        order_.insert(order_.begin() + static_cast<std::ptrdiff_t>(slot(rng_)), index);
+    } else {
+        order_.push_back(index);
+    }
+    prepare_next_pass();
+}
+
+std::size_t Playlist::add_directory(const std::filesystem::path& directory, bool recursive) {
+    std::vector<std::pair<std::string, std::filesystem::path>> found;
+    std::error_code ec;
+    auto collect = [&](const std::filesystem::directory_entry& item) {
+        std::error_code status_error;
+        if (!item.is_regular_file(status_error) || !FileBrowser::is_module_file(item.path())) {
+            return;
+        }
+        found.emplace_back(make_collation_key(item.path().lexically_relative(directory).generic_string()),
+                           item.path());
+    };
+
+    auto options = std::filesystem::directory_options::skip_permission_denied;
+    if (recursive) {
+        for (std::filesystem::recursive_directory_iterator it(directory, options, ec), end; !ec && it != end;
+             it.increment(ec)) {
+            collect(*it);
+        }
+    } else {
+        for (std::filesystem::directory_iterator it(directory, options, ec), end; !ec && it != end;
+             it.increment(ec)) {
+            collect(*it);
+        }
+    }
+
+    std::sort(found.begin(), found.end());
+    for (auto& [key, path] : found) {
+        add(path);
+    }
+    return found.size();
+}
+
+bool Playlist::remove(std::size_t index) {
+    if (index >= entries_.size()) {
+        return false;
+    }
+    entries_.erase(entries_.begin() + static_cast<std::ptrdiff_t>(index));
+
+    auto position = std::find(order_.begin(), order_.end(), index);
+    std::size_t slot = static_cast<std::size_t>(position - order_.begin());
+    if (position != order_.end()) {
+        order_.erase(position);
+    }
+    for (std::size_t& value : order_) {
+        if (value > index) {
+            --value;
+        }
+    }
+
+    if (current_ && *current_ == index) {
+        // The entry that followed now sits in the vacated slot, which is
+        // where the next advance() picks up.
+        current_.reset();
+        cursor_ = slot;
+    } else {
+        if (current_ && *current_ > index) {
+            --*current_;
+        }
+        if (slot < cursor_) {
+            --cursor_;
+        }
+    }
+    prepare_next_pass();
+    return true;
+}
+
+void Playlist::clear() {
+    entries_.clear();
+    order_.clear();
+    next_order_.clear();
+    cursor_ = 0;
+    current_.reset();
+}
+
+std::optional<std::size_t> Playlist::find(const std::filesystem::path& path) const {
+    for (std::size_t i = 0; i < entries_.size(); ++i) {
+        if (entries_[i].path == path) {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+bool Playlist::select(std::size_t index) {
+    if (index >= entries_.size()) {
+        return false;
+    }
+    current_ = index;
+    rebuild_order();
+    return true;
+}
+
+std::optional<std::size_t> Playlist::peek_next() const {
+    if (order_.empty()) {
+        return std::nullopt;
+    }
+    if (current_ && repeat_ == RepeatMode::One) {
+        return current_;
+    }
+    std::size_t position = current_ ? cursor_ + 1 : cursor_;
+    if (position < order_.size()) {
+        return order_[position];
+    }
+    if (repeat_ != RepeatMode::All) {
+        return std::nullopt;
+    }
+    return shuffle_ && !next_order_.empty() ? next_order_.front() : order_.front();
+}
+
+std::optional<std::size_t> Playlist::advance() {
+    return step(true);
+}
+
+std::optional<std::size_t> Playlist::next() {
+    return step(false);
+}
+
+std::optional<std::size_t> Playlist::step(bool honour_repeat_one) {
+    if (order_.empty()) {
+        return std::nullopt;
+    }
+    if (honour_repeat_one && current_ && repeat_ == RepeatMode::One) {
+        return current_;
+    }
+    std::size_t position = current_ ? cursor_ + 1 : cursor_;
+    if (position >= order_.size()) {
+        if (repeat_ == RepeatMode::Off) {
+            return std::nullopt;
+        }
+        if (shuffle_ && !next_order_.empty()) {
+            order_ = std::move(next_order_);
+            next_order_.clear();
+        }
+        position = 0;
+    }
+    cursor_ = position;
+    current_ = order_[cursor_];
+    prepare_next_pass();
+    return current_;
+}
+
+std::optional<std::size_t> Playlist::previous() {
+    if (order_.empty()) {
+        return std::nullopt;
+    }
+    if (cursor_ > 0) {
+        --cursor_;
+    } else if (repeat_ == RepeatMode::All) {
+        cursor_ = order_.size() - 1;
+    } else if (current_) {
+        return current_;
+    }
+    current_ = order_[cursor_];
+    return current_;
+}
+
+void Playlist::set_shuffle(bool enabled) {
+    if (shuffle_ == enabled) {
+        return;
+    }
+    shuffle_ = enabled;
+    rebuild_order();
+}
+
+void Playlist::set_repeat(RepeatMode mode) {
+    repeat_ = mode;
+    prepare_next_pass();
+}
+
+const char* Playlist::repeat_mode_name(RepeatMode mode) {
+    switch (mode) {
+        case RepeatMode::Off: return "off";
+        case RepeatMode::All: return "all";
+        case RepeatMode::One: return "one";
+    }
+    return "off";
+}
+
+bool Playlist::parse_repeat_mode(const std::string& name, RepeatMode& mode) {
+    std::string lowered = lowercase(name);
+    if (lowered == "off" || lowered == "none") {
+        mode = RepeatMode::Off;
+    } else if (lowered == "all") {
+        mode = RepeatMode::All;
+    } else if (lowered == "one" || lowered == "track") {
+        mode = RepeatMode::One;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void Playlist::rebuild_order() {
+    order_.resize(entries_.size());
+    std::iota(order_.begin(), order_.end(), std::size_t{0});
+    cursor_ = 0;
+    if (shuffle_) {
+        std::shuffle(order_.begin(), order_.end(), rng_);
+        if (current_) {
+            // The playing entry opens the pass so everything else is still
+            // ahead of it.
+            auto position = std::find(order_.begin(), order_.end(), *current_);
+            std::rotate(order_.begin(), position, position + 1);
+        }
+    } else if (current_) {
+        cursor_ = *current_;
+    }
+    prepare_next_pass();
+}
+
+void Playlist::prepare_next_pass() {
+    if (!shuffle_ || repeat_ != RepeatMode::All || order_.empty()) {
+        next_order_.clear();
+        return;
+    }
+    if (next_order_.size() == order_.size() && next_order_.front() != order_.back()) {
+        return;
+    }
+    next_order_ = order_;
+    std::shuffle(next_order_.begin(), next_order_.end(), rng_);
+    if (next_order_.size() > 1 && next_order_.front() == order_.back()) {
+        std::uniform_int_distribution<std::size_t> other(1, next_order_.size() - 1);
+        std::swap(next_order_.front(), next_order_[other(rng_)]);
+    }
+}
+
+}
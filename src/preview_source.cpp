@@ -0,0 +1,207 @@
+#include "preview_source.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+#include <libopenmpt/libopenmpt.hpp>
+
+namespace tracker {
+
+namespace {
+
+constexpr std::size_t kReadChunkBytes = 256 * 1024;
+
+}
+
+PreviewSource::PreviewSource(int sample_rate, std::chrono::milliseconds debounce)
+    : sample_rate_(sample_rate),
+      debounce_(debounce),
+      loader_thread_(&PreviewSource::loader_loop, this) {}
+
+PreviewSource::~PreviewSource() {
+    {
+        std::lock_guard lock(request_mutex_);
+        shutdown_ = true;
+        on_update_ = nullptr;
+    }
+    request_cv_.notify_all();
+    loader_thread_.join();
+}
+
+void PreviewSource::set_update_callback(std::function<void()> callback) {
+    std::lock_guard lock(request_mutex_);
+    on_update_ = std::move(callback);
+}
+
+void PreviewSource::request(const std::filesystem::path& path) {
+    {
+        std::lock_guard lock(request_mutex_);
+        if (path == requested_path_) {
+            return;
+        }
+        requested_path_ = path;
+        requested_at_ = Clock::now();
+        settled_ = false;
+        ++generation_;
+        error_message_.clear();
+    }
+    request_cv_.notify_all();
+}
+
+void PreviewSource::settle() {
+    {
+        std::lock_guard lock(request_mutex_);
+        settled_ = true;
+    }
+    request_cv_.notify_all();
+}
+
+std::filesystem::path PreviewSource::playing_path() const {
+    std::lock_guard lock(module_mutex_);
+    return playing_path_;
+}
+
+std::string PreviewSource::error_message() const {
+    std::lock_guard lock(request_mutex_);
+    return error_message_;
+}
+
+bool PreviewSource::loading() const {
+    std::lock_guard lock(request_mutex_);
+    return !requested_path_.empty() && loaded_generation_ != generation_;
+}
+
+bool PreviewSource::is_current(std::uint64_t generation) const {
+    std::lock_guard lock(request_mutex_);
+    return !shutdown_ && generation == generation_;
+}
+
+std::size_t PreviewSource::render(float* interleaved, std::size_t frames) {
+    std::lock_guard lock(module_mutex_);
+    std::size_t rendered = 0;
+    if (module_) {
+        rendered = module_->read_interleaved_stereo(sample_rate_, frames, interleaved);
+        if (rendered > 0 && latency_pending_) {
+            latency_pending_ = false;
+            last_start_latency_ms_.store(
+                std::chrono::duration<double, std::milli>(Clock::now() - started_request_at_).count());
+        }
+    }
+    std::fill(interleaved + rendered * 2, interleaved + frames * 2, 0.0f);
+
+    const auto volume = static_cast<float>(volume_.load(std::memory_order_relaxed));
+    for (std::size_t frame = 0; frame < rendered; ++frame) {
+        float gain = volume;
+        if (fade_position_ < fade_frames_) {
+            gain *= static_cast<float>(fade_position_) / static_cast<float>(fade_frames_);
+            ++fade_position_;
+        }
+        interleaved[frame * 2] *= gain;
+        interleaved[frame * 2 + 1] *= gain;
+    }
+    return rendered;
+}
+
+bool PreviewSource::read_file(const std::filesystem::path& path, std::uint64_t generation, std::string& data) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    // Chunked so a large file being scrolled past stops reading promptly.
+    std::vector<char> chunk(kReadChunkBytes);
+    while (file.read(chunk.data(), static_cast<std::streamsize>(chunk.size())) || file.gcount() > 0) {
+        data.append(chunk.data(), static_cast<std::size_t>(file.gcount()));
+        if (!is_current(generation)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void PreviewSource::loader_loop() {
+    std::unique_lock lock(request_mutex_);
+    while (true) {
+        request_cv_.wait(lock, [this] { return shutdown_ || loaded_generation_ != generation_; });
+        if (shutdown_) {
+            return;
+        }
+
+        // Wait until the selection has stayed put for the debounce period.
+        const auto settle_at = requested_at_ + debounce_;
+        if (!settled_ && Clock::now() < settle_at) {
+            request_cv_.wait_until(lock, settle_at);
+            continue;
+        }
+
+        const std::uint64_t generation = generation_;
+        const std::filesystem::path path = requested_path_;
+        const Clock::time_point requested_at = requested_at_;
+        lock.unlock();
+
+        std::unique_ptr<openmpt::module> module;
+        std::string error;
+        if (!path.empty()) {
+            std::string data;
+            if (!read_file(path, generation, data)) {
+                error = is_current(generation) ? "Unable to read " + path.filename().string() : std::string();
+            } else {
+                try {
+                    // The browser owns the terminal, so load warnings are dropped.
+                    std::ostringstream load_log;
+                    const std::map<std::string, std::string> ctls = {{"load.skip_plugins", "1"}};
+                    module = std::make_unique<openmpt::module>(data.data(), data.size(), load_log, ctls);
+                    module->set_repeat_count(-1);
+                    const double duration = module->get_duration_seconds();
+                    if (duration >= kMinSecondsForSeek) {
+                        // Start at the top of the pattern playing at that point.
+                        module->set_position_seconds(duration * kStartFraction);
+                        module->set_position_order_row(module->get_current_order(), 0);
+                    }
+                } catch (const std::exception& ex) {
+                    module.reset();
+                    error = ex.what();
+                }
+            }
+        }
+
+        lock.lock();
+        if (generation != generation_ || shutdown_) {
+            ++loads_discarded_;
+            lock.unlock();
+            module.reset();
+            lock.lock();
+            continue;
+        }
+        loaded_generation_ = generation;
+        error_message_ = error;
+        auto on_update = on_update_;
+        lock.unlock();
+
+        {
+            std::lock_guard module_lock(module_mutex_);
+            module_.swap(module);
+            playing_path_ = module_ ? path : std::filesystem::path();
+            fade_frames_ = static_cast<std::size_t>(kFadeInSeconds * sample_rate_);
+            fade_position_ = 0;
+            started_request_at_ = requested_at;
+            latency_pending_ = module_ != nullptr;
+        }
+        // The previous module is released here, off the audio thread.
+        module.reset();
+        if (!path.empty() && error.empty()) {
+            ++loads_completed_;
+        }
+        if (on_update) {
+            on_update();
+        }
+
+        lock.lock();
+    }
+}
+
+}
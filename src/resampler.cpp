@@ -0,0 +1,209 @@
+#include "resampler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+namespace tracker {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr std::size_t kLanes = 8;
+
+struct QualitySettings {
+    std::size_t taps;
+    std::size_t max_phases;
+    double rolloff;
+    double kaiser_beta;
+};
+
+QualitySettings settings_for(ResamplerQuality quality) {
+    switch (quality) {
+        case ResamplerQuality::Fast:     return {16, 128, 0.90, 6.0};
+        case ResamplerQuality::Balanced: return {32, 256, 0.94, 8.5};
+        case ResamplerQuality::Best:     return {64, 512, 0.96, 10.0};
+    }
+    return {32, 256, 0.94, 8.5};
+}
+
+double bessel_i0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+// Fixed-width partial sums instead of a single accumulator: float addition
+// is not associative, so this is what lets the compiler emit SIMD code
+// without -ffast-math. taps is always a multiple of kLanes.
+float dot_product(const float* coefficients, const float* samples, std::size_t taps) {
+    float partial[kLanes] = {};
+    for (std::size_t i = 0; i < taps; i += kLanes) {
+        for (std::size_t lane = 0; lane < kLanes; ++lane) {
+            partial[lane] += coefficients[i + lane] * samples[i + lane];
+        }
+    }
+    float sum = 0.0f;
+    for (float value : partial) {
+        sum += value;
+    }
+    return sum;
+}
+
+}
+
+Resampler::Resampler(int input_rate, int output_rate, int channels, ResamplerQuality quality)
+    : input_rate_(input_rate),
+      output_rate_(output_rate),
+      channels_(static_cast<std::size_t>(channels)) {
+    if (input_rate <= 0 || output_rate <= 0 || channels <= 0) {
+        throw std::invalid_argument("Resampler rates and channel count must be positive");
+    }
+
+    const auto divisor = std::gcd(input_rate, output_rate);
+    upsample_ = static_cast<std::uint64_t>(output_rate / divisor);
+    downsample_ = static_cast<std::uint64_t>(input_rate / divisor);
+
+    const QualitySettings settings = settings_for(quality);
+    const double cutoff = std::min(1.0, static_cast<double>(output_rate) / input_rate) * settings.rolloff;
+
+    // Downsampling stretches the kernel so the filter keeps the same number
+    // of zero crossings at the lower cutoff.
+    taps_ = static_cast<std::size_t>(std::ceil(static_cast<double>(settings.taps) / cutoff));
+    taps_ = (taps_ + kLanes - 1) / kLanes * kLanes;
+    phases_ = static_cast<std::size_t>(std::min<std::uint64_t>(upsample_, settings.max_phases));
+
+    coefficients_.resize(phases_ * taps_);
+    const double half = static_cast<double>(taps_) / 2.0;
+    const double beta_norm = bessel_i0(settings.kaiser_beta);
+    for (std::size_t phase = 0; phase < phases_; ++phase) {
+        const double fraction = static_cast<double>(phase) / static_cast<double>(phases_);
+        float* row = coefficients_.data() + phase * taps_;
+        double sum = 0.0;
+        for (std::size_t k = 0; k < taps_; ++k) {
+            const double x = fraction + half - 1.0 - static_cast<double>(k);
+            const double scaled = cutoff * x;
+            const double sinc = scaled == 0.0 ? 1.0 : std::sin(kPi * scaled) / (kPi * scaled);
+            const double ratio = x / half;
+            const double window =
+                std::fabs(ratio) >= 1.0 ? 0.0 : bessel_i0(settings.kaiser_beta * std::sqrt(1.0 - ratio * ratio)) / beta_norm;
+            const double value = cutoff * sinc * window;
+            row[k] = static_cast<float>(value);
+            sum += value;
+        }
+        for (std::size_t k = 0; k < taps_; ++k) {
+            row[k] = static_cast<float>(row[k] / sum);
+        }
+    }
+
+    reset();
+}
+
+void Resampler::reset() {
+    history_.assign(channels_, std::vector<float>(taps_ / 2, 0.0f));
+    history_offset_ = 0;
+    input_frames_ = 0;
+    output_frames_ = 0;
+    integer_position_ = 0;
+    fractional_position_ = 0;
+}
+
+std::size_t Resampler::process(const float* input, std::size_t frame_count, std::vector<float>& output) {
+    for (std::size_t channel = 0; channel < channels_; ++channel) {
+        auto& history = history_[channel];
+        const std::size_t start = history.size();
+        history.resize(start + frame_count);
+        for (std::size_t frame = 0; frame < frame_count; ++frame) {
+            history[start + frame] = input[frame * channels_ + channel];
+        }
+    }
+    input_frames_ += frame_count;
+
+    std::size_t produced = produce(output, UINT64_MAX);
+    compact();
+    return produced;
+}
+
+std::size_t Resampler::flush(std::vector<float>& output) {
+    const std::uint64_t expected = (input_frames_ * upsample_ + downsample_ - 1) / downsample_;
+    for (auto& history : history_) {
+        history.resize(history.size() + taps_, 0.0f);
+    }
+
+    std::size_t produced = produce(output, expected);
+    reset();
+    return produced;
+}
+
+std::size_t Resampler::produce(std::vector<float>& output, std::uint64_t limit) {
+    const std::uint64_t available = history_offset_ + history_.front().size();
+    std::size_t produced = 0;
+
+    // Output frame n reads stored indices [ip + 1, ip + taps] where
+    // ip = floor(n * in / out).
+    while (output_frames_ < limit && integer_position_ + taps_ + 1 <= available) {
+        const std::size_t phase =
+            static_cast<std::size_t>(fractional_position_ * phases_ / upsample_);
+        const float* row = coefficients_.data() + phase * taps_;
+        const std::size_t start = static_cast<std::size_t>(integer_position_ + 1 - history_offset_);
+
+        for (std::size_t channel = 0; channel < channels_; ++channel) {
+            output.push_back(dot_product(row, history_[channel].data() + start, taps_));
+        }
+
+        ++output_frames_;
+        ++produced;
+        fractional_position_ += downsample_;
+        integer_position_ += fractional_position_ / upsample_;
+        fractional_position_ %= upsample_;
+    }
+    return produced;
+}
+
+void Resampler::compact() {
+    const std::uint64_t first_needed = integer_position_ + 1;
+    if (first_needed <= history_offset_) {
+        return;
+    }
+    const std::size_t drop = static_cast<std::size_t>(
+        std::min<std::uint64_t>(first_needed - history_offset_, history_.front().size()));
+    if (drop < 4096) {
+        return;
+    }
+    for (auto& history : history_) {
+        history.erase(history.begin(), history.begin() + static_cast<std::ptrdiff_t>(drop));
+    }
+    history_offset_ += drop;
+}
+
+bool Resampler::parse_quality(const std::string& name, ResamplerQuality& quality) {
+    if (name == "fast") {
+        quality = ResamplerQuality::Fast;
+    } else if (name == "balanced") {
+        quality = ResamplerQuality::Balanced;
+    } else if (name == "best") {
+        quality = ResamplerQuality::Best;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* Resampler::quality_name(ResamplerQuality quality) {
+    switch (quality) {
+        case ResamplerQuality::Fast:     return "fast";
+        case ResamplerQuality::Balanced: return "balanced";
+        case ResamplerQuality::Best:     return "best";
+    }
+    return "balanced";
+}
+
+}
@@ -1,4 +1,6 @@
 #include "simple_ui.hpp"
+#include "song_envelope.hpp"
+#include <algorithm>
 #include <iostream>
 #include <thread>
 #include <chrono>
@@ -42,9 +44,16 @@ bool kbhit() {
 }
 }
 
-void SimpleUi::run() {
+void SimpleUi::print_header() {
     std::cout << "cli-modplayer v1.3.0 | github.com/Master290/cli-modplayer\n";
     std::cout << "─────────────────────────────────────────────────────────────\n";
+    if (player_.has_playlist()) {
+        PlaylistStatus playlist = player_.playlist_status();
+        std::cout << "Track:   " << playlist.position << "/" << playlist.count;
+        if (playlist.shuffle) std::cout << " | shuffle";
+        if (playlist.repeat != RepeatMode::Off) std::cout << " | repeat " << Playlist::repeat_mode_name(playlist.repeat);
+        std::cout << "\n";
+    }
     std::cout << "Title:   " << player_.title() << "\n";
     if (!player_.artist().empty() && player_.artist() != "Unknown") {
         std::cout << "Artist:  " << player_.artist() << "\n";
@@ -57,9 +66,21 @@ void SimpleUi::run() {
     std::cout << "Patterns: " << player_.num_patterns() << " | Orders: " << player_.num_orders() << "\n";
     std::cout << "Instruments: " << player_.num_instruments() << " | Samples: " << player_.num_samples() << "\n";
     std::cout << "─────────────────────────────────────────────────────────────\n";
-    std::cout << "[Space] pause  [←/→] skip order  [Q] quit\n\n";
+    if (player_.has_playlist()) {
+        std::cout << "[Space] pause  [←/→] skip order  [N/P] next/prev track  [S] shuffle  [R] repeat  [Q] quit\n\n";
+    } else {
+        std::cout << "[Space] pause  [←/→] skip order  [Q] quit\n\n";
+    }
+}
+
+void SimpleUi::run() {
+    print_header();
     
     while (running_) {
+        if (player_.poll_track_change()) {
+            std::cout << "\n\n";
+            print_header();
+        }
         auto state = player_.snapshot();
         double pos = state.position_seconds;
         double dur = player_.duration_seconds();
@@ -81,7 +102,17 @@ void SimpleUi::run() {
         std::cout << "  Pattern: " << std::setw(2) << state.pattern 
                   << "  Row: " << std::setw(2) << state.row;
         if (state.paused) std::cout << "  [PAUSED]";
-        std::cout << "    " << std::flush;
+        std::cout << "    ";
+        // The song overview goes on the line below; the cursor then returns
+        // to the bar for the next update.
+        const auto envelope = SongEnvelope::resample(player_.song_envelope(), static_cast<std::size_t>(barw));
+        std::cout << "\n\r ";
+        for (int i = 0; i < barw; ++i) {
+            if (envelope.empty()) std::cout << ' ';
+            else if (i == std::min(filled, barw - 1)) std::cout << "│";
+            else std::cout << SongEnvelope::glyph(envelope[static_cast<std::size_t>(i)]);
+        }
+        std::cout << " \033[1A" << std::flush;
         
         if (kbhit()) {
             int c = getch();
@@ -101,11 +132,19 @@ void SimpleUi::run() {
                 player_.jump_to_order(1);
             else if (c == 'h')
                 player_.jump_to_order(-1);
+            else if (c == 'n' || c == 'N')
+                player_.skip_track(1);
+            else if (c == 'p' || c == 'P')
+                player_.skip_track(-1);
+            else if (c == 's' || c == 'S')
+                player_.toggle_shuffle();
+            else if (c == 'r' || c == 'R')
+                player_.cycle_repeat();
         }
         if (state.finished) break;
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
-    std::cout << "\n\nPlayback finished.\n";
+    std::cout << "\n\n\nPlayback finished.\n";
 }
 
 }
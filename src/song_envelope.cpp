@@ -0,0 +1,72 @@
+#include "song_envelope.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace tracker {
+
+void SongEnvelope::add(const float* mono, std::size_t frames) {
+    for (std::size_t i = 0; i < frames; ++i) {
+        energy_ += static_cast<double>(mono[i]) * mono[i];
+        if (++frames_ == kBlockFrames) {
+            block_energies_.push_back(energy_ / static_cast<double>(kBlockFrames));
+            energy_ = 0.0;
+            frames_ = 0;
+        }
+    }
+}
+
+std::vector<std::uint8_t> SongEnvelope::finish() const {
+    std::vector<double> blocks = block_energies_;
+    if (frames_ > 0) {
+        blocks.push_back(energy_ / static_cast<double>(frames_));
+    }
+    if (blocks.empty()) {
+        return {};
+    }
+
+    // Songs shorter than kBuckets blocks repeat blocks across buckets.
+    std::vector<std::uint8_t> levels(kBuckets);
+    const std::size_t count = blocks.size();
+    for (std::size_t bucket = 0; bucket < kBuckets; ++bucket) {
+        const std::size_t begin = bucket * count / kBuckets;
+        const std::size_t end = std::max(begin + 1, (bucket + 1) * count / kBuckets);
+        double energy = 0.0;
+        for (std::size_t block = begin; block < end; ++block) {
+            energy += blocks[block];
+        }
+        energy /= static_cast<double>(end - begin);
+        if (energy <= 0.0) {
+            continue;
+        }
+        const double decibels = 10.0 * std::log10(energy);
+        const double scaled = (decibels - kFloorDb) / -kFloorDb * 255.0;
+        levels[bucket] = static_cast<std::uint8_t>(std::clamp(std::lround(scaled), 0L, 255L));
+    }
+    return levels;
+}
+
+std::vector<std::uint8_t> SongEnvelope::resample(const std::vector<std::uint8_t>& levels, std::size_t width) {
+    if (levels.empty() || width == 0) {
+        return {};
+    }
+    std::vector<std::uint8_t> columns(width);
+    const std::size_t count = levels.size();
+    for (std::size_t column = 0; column < width; ++column) {
+        const std::size_t begin = column * count / width;
+        const std::size_t end = std::max(begin + 1, (column + 1) * count / width);
+        columns[column] = *std::max_element(levels.begin() + static_cast<std::ptrdiff_t>(begin),
+                                            levels.begin() + static_cast<std::ptrdiff_t>(end));
+    }
+    return columns;
+}
+
+const char* SongEnvelope::glyph(std::uint8_t level) {
+    static const char* const kBlocks[] = {"▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+    if (level == 0) {
+        return " ";
+    }
+    return kBlocks[(level - 1) * 8 / 255];
+}
+
+}
@@ -0,0 +1,78 @@
+#include "song_minimap.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace tracker {
+
+namespace {
+
+bool has_note(std::string_view cell) {
+    return !cell.empty() && cell.front() >= 'A' && cell.front() <= 'G';
+}
+
+}
+
+SongMinimap::SongMinimap(const PatternCache &cache) {
+    const int channels = cache.channels();
+    std::vector<double> pattern_density(static_cast<std::size_t>(cache.num_patterns()) * kBlocks, 0.0);
+    double busiest = 0.0;
+    for (int pattern = 0; pattern < cache.num_patterns(); ++pattern) {
+        const int rows = cache.num_rows(pattern);
+        for (int block = 0; block < kBlocks && rows > 0; ++block) {
+            const int begin = block * rows / kBlocks;
+            const int end = std::min(rows, std::max(begin + 1, (block + 1) * rows / kBlocks));
+            int notes = 0;
+            for (int row = begin; row < end; ++row) {
+                for (int channel = 0; channel < channels; ++channel) {
+                    notes += has_note(cache.cell(pattern, row, channel)) ? 1 : 0;
+                }
+            }
+            const double density = static_cast<double>(notes) / static_cast<double>(end - begin);
+            pattern_density[static_cast<std::size_t>(pattern) * kBlocks + static_cast<std::size_t>(block)] = density;
+            busiest = std::max(busiest, density);
+        }
+    }
+
+    levels_.assign(static_cast<std::size_t>(cache.num_orders()) * kBlocks, 0);
+    separators_.assign(static_cast<std::size_t>(cache.num_orders()), 0);
+    for (int order = 0; order < cache.num_orders(); ++order) {
+        const int pattern = cache.order_pattern(order);
+        if (pattern < 0) {
+            separators_[static_cast<std::size_t>(order)] = 1;
+            continue;
+        }
+        for (int block = 0; block < kBlocks; ++block) {
+            const double density =
+                pattern_density[static_cast<std::size_t>(pattern) * kBlocks + static_cast<std::size_t>(block)];
+            if (density <= 0.0) {
+                continue;
+            }
+            // Any note at all stays visible next to the busiest block.
+            const long level = std::max(1L, std::lround(density / busiest * 255.0));
+            levels_[static_cast<std::size_t>(order) * kBlocks + static_cast<std::size_t>(block)] =
+                static_cast<std::uint8_t>(std::min(255L, level));
+        }
+    }
+}
+
+std::uint8_t SongMinimap::level(int order, int block) const noexcept {
+    if (order < 0 || order >= num_orders() || block < 0 || block >= kBlocks) {
+        return 0;
+    }
+    return levels_[static_cast<std::size_t>(order) * kBlocks + static_cast<std::size_t>(block)];
+}
+
+bool SongMinimap::is_separator(int order) const noexcept {
+    return order >= 0 && order < num_orders() && separators_[static_cast<std::size_t>(order)] != 0;
+}
+
+const char *SongMinimap::glyph(std::uint8_t level) {
+    static const char *const kShades[] = {"░", "▒", "▓", "█"};
+    if (level == 0) {
+        return " ";
+    }
+    return kShades[(level - 1) * 4 / 255];
+}
+
+}
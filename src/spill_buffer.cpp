@@ -0,0 +1,103 @@
+#include "spill_buffer.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace tracker {
+
+SpillBuffer::~SpillBuffer() {
+    release();
+}
+
+void SpillBuffer::release() {
+    if (data_) {
+        munmap(data_, capacity_ * sizeof(float));
+        data_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+    capacity_ = 0;
+    size_ = 0;
+}
+
+bool SpillBuffer::open(std::size_t capacity, std::string& error_message) {
+    release();
+
+    std::error_code ec;
+    std::filesystem::path directory = std::filesystem::temp_directory_path(ec);
+    if (ec) {
+        directory = "/tmp";
+    }
+    std::string pattern = (directory / "cli-modplayer-spill-XXXXXX").string();
+    std::vector<char> path(pattern.begin(), pattern.end());
+    path.push_back('\0');
+
+    fd_ = mkstemp(path.data());
+    if (fd_ < 0) {
+        error_message = std::string("Failed to create spill file: ") + std::strerror(errno);
+        return false;
+    }
+    unlink(path.data());
+
+    return reserve(std::max<std::size_t>(capacity, 1), error_message);
+}
+
+bool SpillBuffer::reserve(std::size_t capacity, std::string& error_message) {
+    if (capacity <= capacity_) {
+        return true;
+    }
+
+    if (ftruncate(fd_, static_cast<off_t>(capacity * sizeof(float))) != 0) {
+        error_message = std::string("Failed to grow spill file: ") + std::strerror(errno);
+        return false;
+    }
+
+    if (data_) {
+        munmap(data_, capacity_ * sizeof(float));
+        data_ = nullptr;
+    }
+
+    void* mapping = mmap(nullptr, capacity * sizeof(float), PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mapping == MAP_FAILED) {
+        capacity_ = 0;
+        error_message = std::string("Failed to map spill file: ") + std::strerror(errno);
+        return false;
+    }
+
+    data_ = static_cast<float*>(mapping);
+    capacity_ = capacity;
+    return true;
+}
+
+bool SpillBuffer::append(const float* samples, std::size_t sample_count, std::string& error_message) {
+    if (fd_ < 0) {
+        error_message = "Spill file not open";
+        return false;
+    }
+    if (size_ + sample_count > capacity_ &&
+        !reserve(std::max(size_ + sample_count, capacity_ + capacity_ / 2), error_message)) {
+        return false;
+    }
+
+    std::memcpy(data_ + size_, samples, sample_count * sizeof(float));
+    size_ += sample_count;
+    return true;
+}
+
+void SpillBuffer::prepare_for_read() {
+    if (data_ && size_ > 0) {
+        madvise(data_, size_ * sizeof(float), MADV_SEQUENTIAL);
+    }
+}
+
+}
@@ -1,6 +1,7 @@
 #include "ui.hpp"
 #include "audio_effects.hpp"
 #include "audio_exporter.hpp"
+#include "song_envelope.hpp"
 
 #include <algorithm>
 #include <array>
@@ -8,11 +9,17 @@
 #include <chrono>
 #include <cmath>
 #include <cctype>
+#include <condition_variable>
+#include <ctime>
+#include <filesystem>
 #include <iomanip>
+#include <iostream>
 #include <limits>
 #include <map>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <utility>
 
@@ -37,18 +44,128 @@ struct Theme {
     ftxui::Color success;
     ftxui::Color warning;
     ftxui::Color danger;
+    // Note colours by pitch class.
+    std::array<ftxui::Color, 12> notes;
 };
 
-const Theme kTheme{ftxui::Color::RGB(16, 18, 26),    ftxui::Color::RGB(26, 28, 38),
-                   ftxui::Color::RGB(32, 34, 46),    ftxui::Color::RGB(129, 200, 190),
-                   ftxui::Color::RGB(54, 57, 70),    ftxui::Color::RGB(118, 92, 199),
-                   ftxui::Color::RGB(230, 230, 230), ftxui::Color::RGB(160, 164, 182),
-                   ftxui::Color::RGB(124, 200, 146), ftxui::Color::RGB(230, 196, 84),
-                   ftxui::Color::RGB(232, 125, 104)};
+Theme make_theme() {
+    return Theme{ftxui::Color::RGB(16, 18, 26),    ftxui::Color::RGB(26, 28, 38),
+                 ftxui::Color::RGB(32, 34, 46),    ftxui::Color::RGB(129, 200, 190),
+                 ftxui::Color::RGB(54, 57, 70),    ftxui::Color::RGB(118, 92, 199),
+                 ftxui::Color::RGB(230, 230, 230), ftxui::Color::RGB(160, 164, 182),
+                 ftxui::Color::RGB(124, 200, 146), ftxui::Color::RGB(230, 196, 84),
+                 ftxui::Color::RGB(232, 125, 104),
+                 {ftxui::Color::RGB(239, 71, 111), ftxui::Color::RGB(255, 182, 99), ftxui::Color::RGB(255, 213, 153),
+                  ftxui::Color::RGB(6, 214, 160), ftxui::Color::RGB(17, 138, 178), ftxui::Color::RGB(239, 71, 111),
+                  ftxui::Color::RGB(255, 182, 99), ftxui::Color::RGB(255, 213, 153), ftxui::Color::RGB(6, 214, 160),
+                  ftxui::Color::RGB(17, 138, 178), ftxui::Color::RGB(76, 201, 240), ftxui::Color::RGB(150, 199, 255)}};
+}
+
+// Not const: ftxui maps an RGB colour onto the terminal's palette when the
+// colour is constructed, so the theme is made again after the colour
+// support is lowered.
+Theme kTheme = make_theme();
 
 constexpr int kMasterVisualizerBars = 20;
 constexpr int kMasterVisualizerHeight = 12;
 
+// Frames are drawn at the active rate while audio plays or meters are still
+// settling, and at the idle rate otherwise, which only has to keep status
+// messages and export progress current.
+constexpr auto kActiveFrameInterval = std::chrono::milliseconds(16);
+constexpr auto kLowBandwidthFrameInterval = std::chrono::milliseconds(100);
+constexpr auto kIdleFrameInterval = std::chrono::milliseconds(500);
+
+// FNV-1a over the inputs a cached panel was built from.
+class PanelKey {
+public:
+    PanelKey &add(std::int64_t value) {
+        for (int i = 0; i < 8; ++i) {
+            mix(static_cast<unsigned char>(static_cast<std::uint64_t>(value) >> (i * 8)));
+        }
+        return *this;
+    }
+    PanelKey &add(const std::string &value) {
+        for (char c : value) {
+            mix(static_cast<unsigned char>(c));
+        }
+        return add(static_cast<std::int64_t>(value.size()));
+    }
+    // Levels only count as changed once they move by a step.
+    PanelKey &add_levels(const std::vector<double> &levels, int steps) {
+        for (double level : levels) {
+            add(std::lround(level * steps));
+        }
+        return *this;
+    }
+    std::uint64_t value() const { return hash_; }
+
+private:
+    void mix(unsigned char byte) { hash_ = (hash_ ^ byte) * 1099511628211ull; }
+
+    std::uint64_t hash_{14695981039346656037ull};
+};
+
+// Phases of a frame, registered with the profiler in this order.
+enum ProfilePhase : std::size_t {
+    kPhaseSnapshot,
+    kPhaseHistory,
+    kPhasePlayback,
+    kPhaseInstruments,
+    kPhaseVisualizer,
+    kPhaseOscilloscope,
+    kPhaseMinimap,
+    kPhasePattern,
+    kPhaseStatus,
+    kPhaseFooter,
+    kPhaseOverlay,
+    kPhaseDraw,
+    kPhaseFlush,
+};
+
+constexpr const char *kProfilePhaseNames[] = {"snapshot", "history",  "playback", "instruments",
+                                              "visualizer", "oscilloscope", "minimap", "pattern", "status bar",
+                                              "footer",   "overlays", "layout+diff", "flush"};
+
+// Points std::cout at another buffer for as long as it lives.
+class StreamRedirect {
+public:
+    StreamRedirect(std::ostream &stream, std::streambuf *buffer) : stream_(stream), previous_(stream.rdbuf(buffer)) {}
+    ~StreamRedirect() { stream_.rdbuf(previous_); }
+    StreamRedirect(const StreamRedirect &) = delete;
+    StreamRedirect &operator=(const StreamRedirect &) = delete;
+
+private:
+    std::ostream &stream_;
+    std::streambuf *previous_;
+};
+
+std::string format_micros(std::uint64_t micros) {
+    std::ostringstream oss;
+    if (micros >= 1000) {
+        oss << std::fixed << std::setprecision(micros >= 10000 ? 0 : 1) << micros / 1000.0 << " ms";
+    } else {
+        oss << micros << " µs";
+    }
+    return oss.str();
+}
+
+std::string format_bytes(std::uint64_t bytes) {
+    std::ostringstream oss;
+    if (bytes >= 1024) {
+        oss << std::fixed << std::setprecision(1) << bytes / 1024.0 << " KB";
+    } else {
+        oss << bytes << " B";
+    }
+    return oss.str();
+}
+
+std::int64_t thread_cpu_ns() {
+    timespec now{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return static_cast<std::int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
 std::string channel_placeholder() {
     return "--- .. .. ...";
 }
@@ -94,11 +211,44 @@ std::string format_time(double seconds) {
     return oss.str();
 }
 
-ftxui::Element apply_decorators(ftxui::Element element, const std::vector<ftxui::Decorator> &decorators) {
-    for (const auto &decorator : decorators) {
-        element = element | decorator;
+// 0 for cells without a note, otherwise 1 + the note's pitch class.
+std::uint8_t note_color_index(std::string_view cell) {
+    if (cell.size() < 3) {
+        return 0;
+    }
+
+    char n0 = static_cast<char>(std::toupper(static_cast<unsigned char>(cell[0])));
+    char n1 = cell[1];
+    if ((n0 == '-' && n1 == '-') || n0 == ' ') {
+        return 0;
     }
-    return element;
+
+    int note_index = -1;
+    switch (n0) {
+    case 'C': note_index = 0; break;
+    case 'D': note_index = 2; break;
+    case 'E': note_index = 4; break;
+    case 'F': note_index = 5; break;
+    case 'G': note_index = 7; break;
+    case 'A': note_index = 9; break;
+    case 'B': note_index = 11; break;
+    default: break;
+    }
+
+    if (note_index == -1) {
+        return 0;
+    }
+    if (n1 == '#') {
+        note_index = (note_index + 1) % 12;
+    }
+    return static_cast<std::uint8_t>(note_index + 1);
+}
+
+ftxui::Color note_color(std::uint8_t index) {
+    if (index == 0 || index > kTheme.notes.size()) {
+        return kTheme.text_dim;
+    }
+    return kTheme.notes[index - 1u];
 }
 
 ftxui::Color amplitude_to_color(double amplitude) {
@@ -120,10 +270,40 @@ std::string format_status_position(const TransportState &state, double total_dur
     return oss.str();
 }
 
+// The song's loudness envelope across the available width, played part in
+// the accent colour and the playhead highlighted.
+ftxui::Element render_song_overview(std::vector<std::uint8_t> levels, double progress_ratio) {
+    using namespace ftxui;
+    return canvas([levels = std::move(levels), progress_ratio](Canvas &overview) {
+               const auto width = static_cast<std::size_t>(overview.width() / 2);
+               const std::vector<std::uint8_t> columns = SongEnvelope::resample(levels, width);
+               if (columns.empty()) {
+                   return;
+               }
+               const std::size_t playhead =
+                   std::min(width - 1, static_cast<std::size_t>(progress_ratio * static_cast<double>(width)));
+               for (std::size_t column = 0; column < width; ++column) {
+                   const char *glyph = SongEnvelope::glyph(columns[column]);
+                   Color shade = column < playhead ? kTheme.accent : kTheme.text_dim;
+                   if (column == playhead) {
+                       glyph = columns[column] == 0 ? "▏" : glyph;
+                       shade = kTheme.warning;
+                   }
+                   overview.DrawText(static_cast<int>(column * 2), 0, glyph, shade);
+               }
+           }) |
+           size(HEIGHT, EQUAL, 1) | flex;
+}
+
 } 
 
-Ui::Ui(Player &player, Config &config, const std::string& module_filename)
-    : player_(player), config_(config), export_filename_(module_filename) {}
+Ui::Ui(Player &player, Config &config, const std::string& module_filename, UiOptions options)
+    : player_(player), config_(config), options_(options), export_filename_(module_filename),
+      export_jobs_(std::make_unique<ExportJobManager>(player.module_path())) {
+    for (const char *name : kProfilePhaseNames) {
+        profiler_.add_phase(name);
+    }
+}
 
 Ui::~Ui() = default;
 
@@ -145,14 +325,50 @@ void Ui::reset_ui_state() {
     channel_offset_ = 0;
     page_columns_ = 4;
     last_state_ = TransportState{};
+    last_meters_key_ = 0;
+    playback_panel_ = {};
+    instruments_panel_ = {};
+    visualizer_panel_ = {};
+    oscilloscope_panel_ = {};
+    pattern_panel_ = {};
+    minimap_panel_ = {};
+    status_panel_ = {};
+    footer_panel_ = {};
+}
+
+void Ui::on_track_changed() {
+    reset_ui_state();
+    ++track_generation_;
+    export_filename_ = std::filesystem::path(player_.module_path()).stem().string();
+    export_jobs_->set_module_path(player_.module_path());
+    set_status_message("Now playing: " + player_.title());
 }
 
 void Ui::run() {
     using namespace std::chrono_literals;
 
     reset_ui_state();
+    if (options_.colors == 256 || options_.colors == 16) {
+        ftxui::Terminal::SetColorSupport(options_.colors == 16 ? ftxui::Terminal::Color::Palette16
+                                                               : ftxui::Terminal::Color::Palette256);
+        kTheme = make_theme();
+    }
+    const auto active_interval = std::chrono::steady_clock::duration(
+        options_.low_bandwidth ? kLowBandwidthFrameInterval : kActiveFrameInterval);
+    const auto idle_interval = std::chrono::steady_clock::duration(kIdleFrameInterval);
     auto screen = ftxui::ScreenInteractive::Fullscreen();
     std::atomic<bool> loop_running{true};
+    // The ticker only wakes the screen when there is something new to draw;
+    // the renderer picks its interval and tells it whether meters are still
+    // moving without new player state.
+    std::mutex frame_mutex;
+    std::condition_variable frame_cv;
+    auto frame_interval = active_interval;
+    std::atomic<bool> meters_moving{false};
+    // Everything ftxui writes goes through here, so the time from one
+    // frame's Element to its flush, and its size, can be attributed.
+    CountingStreambuf terminal_output(std::cout.rdbuf());
+    StreamRedirect redirect(std::cout, &terminal_output);
 
     auto renderer = ftxui::Renderer([&] {
         auto now = std::chrono::steady_clock::now();
@@ -161,8 +377,27 @@ void Ui::run() {
         }
         last_frame_time_ = now;
 
-        last_state_ = player_.snapshot();
-        update_history(last_state_);
+        if (terminal_output.last_flush() > last_render_end_) {
+            const auto flush_time = terminal_output.take_flush_time();
+            profiler_.record(kPhaseDraw, terminal_output.last_flush() - last_render_end_ - flush_time);
+            profiler_.record(kPhaseFlush, flush_time);
+            const std::uint64_t bytes = terminal_output.take_bytes();
+            stats_bytes_ += bytes;
+            profiler_.record_bytes(bytes);
+        }
+
+        if (player_.poll_track_change()) {
+            on_track_changed();
+        }
+        {
+            FrameProfiler::Scope scope(profiler_, kPhaseSnapshot);
+            last_state_ = player_.snapshot();
+        }
+        poll_export_jobs();
+        {
+            FrameProfiler::Scope scope(profiler_, kPhaseHistory);
+            update_history(last_state_);
+        }
         update_visualizer_peaks(last_state_, static_cast<int>(last_state_.channels.size()));
 
         if (last_state_.finished && running_) {
@@ -171,7 +406,24 @@ void Ui::run() {
             screen.Exit();
         }
 
-        return render(last_state_);
+        const std::uint64_t meters = meters_key();
+        const bool moving = meters != last_meters_key_;
+        last_meters_key_ = meters;
+        meters_moving = moving;
+        const bool active = (!last_state_.paused && !last_state_.finished) || moving;
+        update_frame_stats(now, active);
+        {
+            std::lock_guard<std::mutex> lock(frame_mutex);
+            const auto interval = active ? active_interval : idle_interval;
+            if (interval != frame_interval) {
+                frame_interval = interval;
+                frame_cv.notify_all();
+            }
+        }
+
+        auto document = render(last_state_);
+        last_render_end_ = FrameProfiler::Clock::now();
+        return document;
     });
 
     auto component = ftxui::CatchEvent(renderer, [&](ftxui::Event event) {
@@ -179,6 +431,92 @@ void Ui::run() {
             screen.PostEvent(ftxui::Event::Custom);
         };
 
+        if (pattern_browser_) {
+            if (event == ftxui::Event::Escape || event == ftxui::Event::Character('b') ||
+                event == ftxui::Event::Character('B')) {
+                pattern_browser_ = false;
+                set_status_message("Pattern browser closed");
+                refresh();
+                return true;
+            }
+            auto cache = player_.pattern_cache();
+            if (cache) {
+                int delta_rows = 0;
+                if (event == ftxui::Event::ArrowUp || event == ftxui::Event::Character('k')) {
+                    delta_rows = -1;
+                } else if (event == ftxui::Event::ArrowDown || event == ftxui::Event::Character('j')) {
+                    delta_rows = 1;
+                } else if (event == ftxui::Event::PageUp) {
+                    delta_rows = -16;
+                } else if (event == ftxui::Event::PageDown) {
+                    delta_rows = 16;
+                }
+                if (delta_rows != 0) {
+                    move_browse_cursor(*cache, delta_rows);
+                    refresh();
+                    return true;
+                }
+                if (event == ftxui::Event::ArrowLeft || event == ftxui::Event::Character('h') ||
+                    event == ftxui::Event::ArrowRight || event == ftxui::Event::Character('l')) {
+                    const int step = event == ftxui::Event::ArrowLeft || event == ftxui::Event::Character('h') ? -1 : 1;
+                    browse_order_ = std::clamp(browse_order_ + step, 0, std::max(0, cache->num_orders() - 1));
+                    browse_row_ = 0;
+                    refresh();
+                    return true;
+                }
+                if (event == ftxui::Event::Home || event == ftxui::Event::End) {
+                    browse_row_ = event == ftxui::Event::Home
+                                      ? 0
+                                      : std::max(0, cache->num_rows(cache->order_pattern(browse_order_)) - 1);
+                    refresh();
+                    return true;
+                }
+                if (event == ftxui::Event::Tab || event == ftxui::Event::TabReverse) {
+                    channel_offset_ = std::max(0, channel_offset_ + (event == ftxui::Event::Tab ? 1 : -1));
+                    refresh();
+                    return true;
+                }
+                if (event == ftxui::Event::Return) {
+                    player_.jump_to_position(browse_order_, browse_row_);
+                    set_status_message("Playing from " + format_order_row_label(browse_order_, browse_row_));
+                    refresh();
+                    return true;
+                }
+            }
+        }
+
+        if (minimap_) {
+            if (event == ftxui::Event::Escape || event == ftxui::Event::Character('o') ||
+                event == ftxui::Event::Character('O')) {
+                minimap_ = false;
+                set_status_message("Song map closed");
+                refresh();
+                return true;
+            }
+            auto minimap = player_.song_minimap();
+            if (minimap && minimap->num_orders() > 0) {
+                const int last_order = minimap->num_orders() - 1;
+                if (event == ftxui::Event::ArrowLeft || event == ftxui::Event::Character('h') ||
+                    event == ftxui::Event::ArrowRight || event == ftxui::Event::Character('l')) {
+                    const int step = event == ftxui::Event::ArrowLeft || event == ftxui::Event::Character('h') ? -1 : 1;
+                    minimap_cursor_ = std::clamp(minimap_cursor_ + step, 0, last_order);
+                    refresh();
+                    return true;
+                }
+                if (event == ftxui::Event::Home || event == ftxui::Event::End) {
+                    minimap_cursor_ = event == ftxui::Event::Home ? 0 : last_order;
+                    refresh();
+                    return true;
+                }
+                if (event == ftxui::Event::Return) {
+                    player_.jump_to_position(minimap_cursor_, 0);
+                    set_status_message("Order → " + format_two_digit(minimap_cursor_));
+                    refresh();
+                    return true;
+                }
+            }
+        }
+
         if (event == ftxui::Event::Character('q') || event == ftxui::Event::Character('Q') ||
             event == ftxui::Event::Escape) {
             running_ = false;
@@ -252,17 +590,68 @@ void Ui::run() {
             return true;
         }
 
+        if (player_.has_playlist() &&
+            (event == ftxui::Event::Character('>') || event == ftxui::Event::Character('.') ||
+             event == ftxui::Event::Character('<') || event == ftxui::Event::Character(','))) {
+            bool forward = event == ftxui::Event::Character('>') || event == ftxui::Event::Character('.');
+            if (!player_.skip_track(forward ? 1 : -1)) {
+                set_status_message(forward ? "End of playlist" : "Start of playlist");
+            }
+            refresh();
+            return true;
+        }
+
+        if (player_.has_playlist() && (event == ftxui::Event::Character('s') || event == ftxui::Event::Character('S'))) {
+            player_.toggle_shuffle();
+            set_status_message(player_.playlist_status().shuffle ? "Shuffle on" : "Shuffle off");
+            refresh();
+            return true;
+        }
+
+        if (player_.has_playlist() && (event == ftxui::Event::Character('r') || event == ftxui::Event::Character('R'))) {
+            player_.cycle_repeat();
+            set_status_message(std::string("Repeat: ") + Playlist::repeat_mode_name(player_.playlist_status().repeat));
+            refresh();
+            return true;
+        }
+
         if (event == ftxui::Event::Character('n') || event == ftxui::Event::Character('N')) {
             info_overlay_ = !info_overlay_;
             about_overlay_ = false;
+            jobs_panel_ = false;
             set_status_message(info_overlay_ ? "Overlay opened" : "Overlay closed");
             refresh();
             return true;
         }
 
+        if (event == ftxui::Event::Character('b') || event == ftxui::Event::Character('B')) {
+            pattern_browser_ = true;
+            browse_order_ = minimap_ ? minimap_cursor_ : std::max(0, last_state_.order);
+            browse_row_ = minimap_ ? 0 : std::max(0, last_state_.row);
+            set_status_message(player_.pattern_cache() ? "Pattern browser opened" : "Pattern browser: formatting patterns…");
+            refresh();
+            return true;
+        }
+
+        if (event == ftxui::Event::Character('o') || event == ftxui::Event::Character('O')) {
+            minimap_ = true;
+            minimap_cursor_ = std::max(0, last_state_.order);
+            set_status_message(player_.song_minimap() ? "Song map opened" : "Song map: reading patterns…");
+            refresh();
+            return true;
+        }
+
+        if (event == ftxui::Event::Character('p') || event == ftxui::Event::Character('P')) {
+            profiler_overlay_ = !profiler_overlay_;
+            set_status_message(profiler_overlay_ ? "Frame profiler shown" : "Frame profiler hidden");
+            refresh();
+            return true;
+        }
+
         if (event == ftxui::Event::Character('a') || event == ftxui::Event::Character('A')) {
             about_overlay_ = !about_overlay_;
             info_overlay_ = false;
+            jobs_panel_ = false;
             info_scroll_position_ = 0;
             set_status_message(about_overlay_ ? "About opened" : "About closed");
             refresh();
@@ -293,7 +682,7 @@ void Ui::run() {
             return true;
         }
 
-        if (!info_overlay_ && !about_overlay_ && 
+        if (!info_overlay_ && !about_overlay_ && !jobs_panel_ && !export_dialog_ &&
             (event == ftxui::Event::Character('+') || event == ftxui::Event::Character('=') ||
              event == ftxui::Event::ArrowUp)) {
             double volume = player_.get_volume();
@@ -307,7 +696,7 @@ void Ui::run() {
             return true;
         }
 
-        if (!info_overlay_ && !about_overlay_ &&
+        if (!info_overlay_ && !about_overlay_ && !jobs_panel_ && !export_dialog_ &&
             (event == ftxui::Event::Character('-') || event == ftxui::Event::Character('_') ||
              event == ftxui::Event::ArrowDown)) {
             double volume = player_.get_volume();
@@ -384,15 +773,15 @@ void Ui::run() {
         }
 
         if (event == ftxui::Event::Character('x') || event == ftxui::Event::Character('X')) {
-            if (!export_in_progress_) {
-                export_dialog_ = !export_dialog_;
-                set_status_message(export_dialog_ ? "Export dialog opened" : "Export dialog closed");
-                refresh();
-            }
+            export_dialog_ = !export_dialog_;
+            jobs_panel_ = false;
+            export_error_.clear();
+            set_status_message(export_dialog_ ? "Export dialog opened" : "Export dialog closed");
+            refresh();
             return true;
         }
 
-        if (export_dialog_ && !export_in_progress_) {
+        if (export_dialog_) {
             if (event == ftxui::Event::Tab || event == ftxui::Event::ArrowDown) {
                 export_format_selection_ = (export_format_selection_ + 1) % 3;
                 refresh();
@@ -404,50 +793,44 @@ void Ui::run() {
                 return true;
             }
             if (event == ftxui::Event::Return) {
-                export_in_progress_ = true;
-                export_current_ = 0;
-                export_total_ = 0;
-                export_error_.clear();
-                
-                std::thread([this, &refresh]() {
-                    ExportOptions options;
-                    options.sample_rate = 48000;
-                    options.channels = 2;
-                    
-                    switch (export_format_selection_) {
-                        case 0:
-                            options.format = ExportFormat::WAV;
-                            break;
-                        case 1:
-                            options.format = ExportFormat::MP3;
-                            options.mp3_bitrate = 320;
-                            break;
-                        case 2:
-                            options.format = ExportFormat::FLAC;
-                            options.flac_compression_level = 5;
-                            break;
-                    }
-                    
-                    options.output_path = export_filename_ + AudioExporter::get_extension(options.format);
-                    
-                    options.progress_callback = [this](std::size_t current, std::size_t total) {
-                        export_current_ = current;
-                        export_total_ = total;
-                        return true;
-                    };
-                    
-                    std::string error_message;
-                    bool success = player_.export_to_file(options, error_message);
-                    
-                    export_in_progress_ = false;
-                    if (success) {
-                        set_status_message("Export complete: " + options.output_path);
-                        export_dialog_ = false;
-                    } else {
-                        export_error_ = error_message;
+                start_export();
+                refresh();
+                return true;
+            }
+        }
+
+        if (event == ftxui::Event::Character('j') || event == ftxui::Event::Character('J')) {
+            jobs_panel_ = !jobs_panel_;
+            export_dialog_ = false;
+            info_overlay_ = false;
+            about_overlay_ = false;
+            jobs_selection_ = 0;
+            set_status_message(jobs_panel_ ? "Export jobs opened" : "Export jobs closed");
+            refresh();
+            return true;
+        }
+
+        if (jobs_panel_) {
+            if (event == ftxui::Event::ArrowUp || event == ftxui::Event::Character('k')) {
+                jobs_selection_ = std::max(0, jobs_selection_ - 1);
+                refresh();
+                return true;
+            }
+            if (event == ftxui::Event::ArrowDown) {
+                int last = static_cast<int>(export_jobs_->jobs().size()) - 1;
+                jobs_selection_ = std::max(0, std::min(jobs_selection_ + 1, last));
+                refresh();
+                return true;
+            }
+            if (event == ftxui::Event::Character('c') || event == ftxui::Event::Character('C')) {
+                auto jobs = export_jobs_->jobs();
+                if (!jobs.empty()) {
+                    const auto &job = jobs[static_cast<std::size_t>(std::clamp(jobs_selection_, 0, static_cast<int>(jobs.size()) - 1))];
+                    if (export_jobs_->cancel(job.id)) {
+                        set_status_message("Cancelling export #" + std::to_string(job.id));
                     }
-                }).detach();
-                
+                }
+                refresh();
                 return true;
             }
         }
@@ -456,16 +839,28 @@ void Ui::run() {
     });
 
     std::thread ticker([&] {
-        using namespace std::chrono_literals;
+        std::uint64_t posted_version = 0;
+        std::unique_lock<std::mutex> lock(frame_mutex);
         while (loop_running.load()) {
-            std::this_thread::sleep_for(50ms);
-            screen.PostEvent(ftxui::Event::Custom);
+            const auto interval = frame_interval;
+            if (frame_cv.wait_for(lock, interval, [&] { return !loop_running.load() || frame_interval != interval; })) {
+                continue;
+            }
+            const std::uint64_t version = player_.state_version();
+            if (version != posted_version || meters_moving.load() || interval == idle_interval) {
+                posted_version = version;
+                screen.PostEvent(ftxui::Event::Custom);
+            }
         }
     });
 
     screen.Loop(component);
 
-    loop_running = false;
+    {
+        std::lock_guard<std::mutex> lock(frame_mutex);
+        loop_running = false;
+    }
+    frame_cv.notify_all();
     if (ticker.joinable()) {
         ticker.join();
     }
@@ -493,8 +888,10 @@ void Ui::update_history(const TransportState &state) {
     row.pattern = state.pattern;
     row.row = state.row;
     row.channels.reserve(state.channels.size());
+    row.colors.reserve(state.channels.size());
     for (const auto &ch : state.channels) {
         row.channels.push_back(ch.line);
+        row.colors.push_back(note_color_index(ch.line));
     }
 
     history_.push_back(std::move(row));
@@ -506,33 +903,183 @@ void Ui::update_history(const TransportState &state) {
     last_row_ = state.row;
 }
 
+template <typename Build>
+ftxui::Element Ui::cached_panel(PanelCache &cache, std::size_t phase, std::uint64_t key, Build build) {
+    FrameProfiler::Scope scope(profiler_, phase);
+    if (cache.element && cache.key == key) {
+        ++stats_panels_reused_;
+        return cache.element;
+    }
+    ++stats_panels_built_;
+    cache.key = key;
+    cache.element = build();
+    return cache.element;
+}
+
+std::uint64_t Ui::meters_key() const {
+    return PanelKey()
+        .add_levels(master_levels_, meter_steps())
+        .add_levels(master_peaks_, meter_steps())
+        .add_levels(channel_peaks_, meter_steps())
+        .add(std::lround(master_overall_level_ * meter_steps()))
+        .value();
+}
+
+// Meter changes smaller than a step redraw nothing; a low-bandwidth
+// terminal only sees the spectrum move in eighths.
+int Ui::meter_steps() const {
+    return options_.low_bandwidth ? 8 : 64;
+}
+
+void Ui::update_frame_stats(std::chrono::steady_clock::time_point now, bool active) {
+    const std::int64_t cpu_ns = thread_cpu_ns();
+    active_frame_rate_ = active;
+    if (stats_started_.time_since_epoch().count() == 0) {
+        stats_started_ = now;
+        stats_cpu_ns_ = cpu_ns;
+        return;
+    }
+    ++stats_frames_;
+    const double elapsed = std::chrono::duration<double>(now - stats_started_).count();
+    if (elapsed < 1.0) {
+        return;
+    }
+    frames_per_second_ = stats_frames_ / elapsed;
+    ui_cpu_percent_ = static_cast<double>(cpu_ns - stats_cpu_ns_) / 1e9 / elapsed * 100.0;
+    const int panels = stats_panels_built_ + stats_panels_reused_;
+    panels_reused_percent_ = panels > 0 ? 100.0 * stats_panels_reused_ / panels : 0.0;
+    output_bytes_per_second_ = static_cast<double>(stats_bytes_) / elapsed;
+    stats_bytes_ = 0;
+    stats_started_ = now;
+    stats_cpu_ns_ = cpu_ns;
+    stats_frames_ = 0;
+    stats_panels_built_ = 0;
+    stats_panels_reused_ = 0;
+}
+
 ftxui::Element Ui::render(const TransportState &state) {
     using namespace ftxui;
 
-    auto playback = render_playback_info(state);
-    auto instruments = render_active_instruments(state);
-    auto visualizer = render_header_visualizer(state);
-    auto oscilloscope = render_oscilloscope(state);
-    auto header = hbox({playback | xflex, instruments, visualizer, oscilloscope});
-    
-    auto pattern = render_pattern_grid(state) | flex;
-    auto status = render_status_bar();
-    auto footer = render_footer();
+    if (!status_message_.empty() && std::chrono::steady_clock::now() >= status_message_until_) {
+        status_message_.clear();
+    }
 
-    auto layout = vbox({header, pattern, separator(), status, footer}) |
+    // Each panel is rebuilt only when something it shows has changed. Levels
+    // go into the keys quantized to what a meter can draw; only the scope
+    // follows every rendered buffer.
+    PanelKey playback_key;
+    playback_key.add(static_cast<std::int64_t>(track_generation_)).add(state.order).add(state.pattern).add(state.row).add(state.speed);
+    if (player_.has_playlist()) {
+        PlaylistStatus playlist = player_.playlist_status();
+        playback_key.add(static_cast<std::int64_t>(playlist.position)).add(static_cast<std::int64_t>(playlist.count))
+            .add(playlist.shuffle).add(static_cast<std::int64_t>(playlist.repeat));
+    }
+    auto playback = cached_panel(playback_panel_, kPhasePlayback, playback_key.value(), [&] { return render_playback_info(state); });
+    std::vector<double> channel_levels;
+    channel_levels.reserve(state.channels.size());
+    PanelKey instruments_key;
+    instruments_key.add(static_cast<std::int64_t>(track_generation_));
+    for (const auto &ch : state.channels) {
+        const double level = std::max(std::abs(ch.vu_left), std::abs(ch.vu_right));
+        channel_levels.push_back(std::clamp(level, 0.0, 1.0));
+        if (ch.instrument_index >= 0 && !ch.instrument_name.empty()) {
+            instruments_key.add(ch.instrument_index).add(std::lround(level * meter_steps()));
+        }
+    }
+    auto instruments = cached_panel(instruments_panel_, kPhaseInstruments, instruments_key.value(),
+                                    [&] { return render_active_instruments(state); });
+    const std::uint64_t visualizer_key = PanelKey()
+                                             .add_levels(master_levels_, meter_steps())
+                                             .add_levels(master_peaks_, meter_steps())
+                                             .add(std::lround(master_overall_level_ * meter_steps()))
+                                             .value();
+    auto visualizer = cached_panel(visualizer_panel_, kPhaseVisualizer, visualizer_key, [&] { return render_header_visualizer(state); });
+    auto header = hbox({playback | xflex, instruments, visualizer});
+    // The scope changes completely every buffer; over a slow link it costs
+    // more than the rest of the screen together.
+    if (!options_.low_bandwidth) {
+        auto oscilloscope = cached_panel(oscilloscope_panel_, kPhaseOscilloscope, state.version,
+                                         [&] { return render_oscilloscope(state); });
+        header = hbox({playback | xflex, instruments, visualizer, oscilloscope});
+    }
+
+    const auto terminal = Terminal::Size();
+    const std::uint64_t pattern_key = PanelKey()
+                                          .add(static_cast<std::int64_t>(track_generation_))
+                                          .add(state.order)
+                                          .add(state.pattern)
+                                          .add(state.row)
+                                          .add(static_cast<std::int64_t>(history_.size()))
+                                          .add(history_.empty() ? -1 : history_.back().order)
+                                          .add(history_.empty() ? -1 : history_.back().row)
+                                          .add(static_cast<std::int64_t>(state.channels.size()))
+                                          .add(channel_offset_)
+                                          .add(terminal.dimx)
+                                          .add(terminal.dimy)
+                                          .add_levels(channel_levels, meter_steps())
+                                          .add_levels(channel_peaks_, meter_steps())
+                                          .value();
+    Element pattern;
+    if (pattern_browser_) {
+        const std::uint64_t browser_key = PanelKey()
+                                              .add(static_cast<std::int64_t>(player_.pattern_cache_generation()))
+                                              .add(browse_order_)
+                                              .add(browse_row_)
+                                              .add(channel_offset_)
+                                              .add(state.order)
+                                              .add(state.row)
+                                              .add(terminal.dimx)
+                                              .add(terminal.dimy)
+                                              .value();
+        pattern = cached_panel(pattern_panel_, kPhasePattern, browser_key, [&] { return render_pattern_browser(state); });
+    } else {
+        pattern = cached_panel(pattern_panel_, kPhasePattern, pattern_key, [&] { return render_pattern_grid(state); });
+    }
+    pattern = pattern | flex;
+
+    Elements body = {header};
+    if (minimap_) {
+        const std::uint64_t minimap_key = PanelKey()
+                                              .add(static_cast<std::int64_t>(player_.pattern_cache_generation()))
+                                              .add(minimap_cursor_)
+                                              .add(state.order)
+                                              .add(terminal.dimx)
+                                              .value();
+        body.push_back(cached_panel(minimap_panel_, kPhaseMinimap, minimap_key, [&] { return render_minimap(state); }));
+    }
+
+    const std::uint64_t status_key = PanelKey()
+                                         .add(status_message_)
+                                         .add(std::lround(state.position_seconds * 10.0))
+                                         .add(std::lround(player_.get_volume() * 100.0))
+                                         .add(state.paused)
+                                         .add(running_)
+                                         .add(static_cast<std::int64_t>(player_.song_envelope().size()))
+                                         .value();
+    auto status = cached_panel(status_panel_, kPhaseStatus, status_key, [&] { return render_status_bar(); });
+    auto footer = cached_panel(footer_panel_, kPhaseFooter, player_.has_playlist(), [&] { return render_footer(); });
+
+    body.insert(body.end(), {pattern, separator(), status, footer});
+    auto layout = vbox(std::move(body)) |
                   bgcolor(kTheme.background) | color(kTheme.text) | flex;
 
+    FrameProfiler::Scope scope(profiler_, kPhaseOverlay);
+    Element overlay;
     if (export_dialog_) {
+        overlay = render_export_dialog();
+    } else if (jobs_panel_) {
+        overlay = render_jobs_panel();
+    } else if (info_overlay_) {
+        overlay = render_info_overlay(state);
+    } else if (about_overlay_) {
+        overlay = render_about_overlay();
+    }
+    if (overlay) {
         auto dimmed_bg = filler() | bgcolor(Color::RGB(0, 0, 0)) | dim;
-        return dbox({layout, dimmed_bg, render_export_dialog()});
-    }
-    if (info_overlay_) {
-        auto dimmed_bg = filler() | bgcolor(Color::RGB(0, 0, 0)) | dim;
-        return dbox({layout, dimmed_bg, render_info_overlay(state)});
+        layout = dbox({layout, dimmed_bg, overlay});
     }
-    if (about_overlay_) {
-        auto dimmed_bg = filler() | bgcolor(Color::RGB(0, 0, 0)) | dim;
-        return dbox({layout, dimmed_bg, render_about_overlay()});
+    if (profiler_overlay_) {
+        layout = dbox({layout, render_profiler_overlay()});
     }
     return layout;
 }
@@ -572,6 +1119,18 @@ ftxui::Element Ui::render_playback_info(const TransportState &state) const {
     grid_rows.push_back({text("Row") | color(kTheme.text_dim), text(format_two_digit(state.row))});
     
     grid_rows.push_back({text("Speed") | color(kTheme.text_dim), text(format_two_digit(state.speed))});
+
+    if (player_.has_playlist()) {
+        PlaylistStatus playlist = player_.playlist_status();
+        std::string playlist_info = std::to_string(playlist.position) + "/" + std::to_string(playlist.count);
+        if (playlist.shuffle) {
+            playlist_info += " • shuffle";
+        }
+        if (playlist.repeat != RepeatMode::Off) {
+            playlist_info += std::string(" • repeat ") + Playlist::repeat_mode_name(playlist.repeat);
+        }
+        grid_rows.push_back({text("Track") | color(kTheme.text_dim), text(playlist_info)});
+    }
     
     auto info_grid = gridbox(grid_rows);
 
@@ -887,70 +1446,82 @@ ftxui::Element Ui::render_pattern_grid(const TransportState &state) {
     int history_placeholders = history_total - history_real;
     int future_placeholders = future_total - future_real;
 
-    int total_span = history_total + future_total + 1;
     int history_start = std::max(0, history_available - history_real);
 
-    auto make_row = [&](const std::string &label, const std::vector<std::string> &channels, bool highlight,
-                        const std::vector<ftxui::Decorator> &decorators) {
+    // Rows are striped by row number so a history row keeps its background
+    // as it scrolls and its cached cells stay valid.
+    const auto stripe = [](int row) { return row % 2 == 0 ? kTheme.panel : kTheme.panel_alt; };
+
+    auto make_cells = [&](const std::string &label, const std::vector<std::string> &channels,
+                          const std::vector<std::uint8_t> &colors, bool highlight, bool emphasized,
+                          Color background) {
         std::vector<Element> cells;
-        auto background = highlight ? kTheme.accent_soft : (grid_rows.size() % 2 == 0 ? kTheme.panel : kTheme.panel_alt);
+        cells.reserve(static_cast<std::size_t>(visible_columns) + 1);
 
         Element label_cell = text(label) | center | size(WIDTH, EQUAL, label_width) | bgcolor(background) |
                               color(highlight ? kTheme.text : kTheme.text_dim);
-        label_cell = apply_decorators(std::move(label_cell), decorators);
+        if (emphasized) {
+            label_cell = label_cell | bold;
+        }
         cells.push_back(std::move(label_cell));
 
         for (int col = 0; col < visible_columns; ++col) {
-            int channel_index = channel_offset_ + col;
-            std::string content = placeholder;
-            if (channel_index < static_cast<int>(channels.size())) {
-                content = channels[static_cast<std::size_t>(channel_index)];
-            }
+            const auto channel_index = static_cast<std::size_t>(channel_offset_ + col);
+            const std::string &content = channel_index < channels.size() ? channels[channel_index] : placeholder;
+            const std::uint8_t color_index =
+                channel_index < colors.size() ? colors[channel_index] : note_color_index(content);
 
             Element cell = text(content) | size(WIDTH, EQUAL, column_width) | center | bgcolor(background);
-            cell = cell | color(highlight ? kTheme.text : color_for_note(content));
-            if (highlight) {
+            cell = cell | color(highlight ? kTheme.text : note_color(color_index));
+            if (highlight || emphasized) {
                 cell = cell | bold;
             }
-            cell = apply_decorators(std::move(cell), decorators);
             cells.push_back(std::move(cell));
         }
-
-        grid_rows.push_back(std::move(cells));
+        return cells;
     };
 
     const std::vector<std::string> empty_channels;
+    const std::vector<std::uint8_t> no_colors;
 
     for (int i = 0; i < history_placeholders; ++i) {
         int offset_from_center = -(history_total - i);
-        auto decorators = decorators_for_row_index(offset_from_center, total_span);
-        make_row("", empty_channels, false, decorators);
+        grid_rows.push_back(make_cells("", empty_channels, no_colors, false, emphasized_row(offset_from_center),
+                                       stripe(i)));
     }
 
     for (int i = 0; i < history_real; ++i) {
         int slot_index = history_placeholders + i;
         int offset_from_center = -(history_total - slot_index);
-        const RowRender &row = history_[static_cast<std::size_t>(history_start + i)];
-        auto decorators = decorators_for_row_index(offset_from_center, total_span);
-        make_row(format_order_row_label(row.order, row.row), row.channels, false, decorators);
+        RowRender &row = history_[static_cast<std::size_t>(history_start + i)];
+        if (row.cells.empty() || row.cells_offset != channel_offset_ || row.cells_columns != visible_columns ||
+            row.cells_width != column_width) {
+            row.cells = make_cells(format_order_row_label(row.order, row.row), row.channels, row.colors, false,
+                                   emphasized_row(offset_from_center), stripe(row.row));
+            row.cells_offset = channel_offset_;
+            row.cells_columns = visible_columns;
+            row.cells_width = column_width;
+        }
+        grid_rows.push_back(row.cells);
     }
 
     if (current_row) {
-        make_row(format_order_row_label(current_row->order, current_row->row), current_row->channels, true, {});
+        grid_rows.push_back(make_cells(format_order_row_label(current_row->order, current_row->row),
+                                       current_row->channels, current_row->colors, true, false, kTheme.accent_soft));
     }
 
     for (int i = 0; i < future_real; ++i) {
         int offset_from_center = i + 1;
         const PatternRowPreview &preview = state.preview_rows[static_cast<std::size_t>(i)];
-        auto decorators = decorators_for_row_index(offset_from_center, total_span);
-        make_row(format_order_row_label(preview.order, preview.row), preview.channels, false, decorators);
+        grid_rows.push_back(make_cells(format_order_row_label(preview.order, preview.row), preview.channels,
+                                       no_colors, false, emphasized_row(offset_from_center), stripe(preview.row)));
     }
 
     for (int i = 0; i < future_placeholders; ++i) {
         int slot_index = future_real + i;
         int offset_from_center = slot_index + 1;
-        auto decorators = decorators_for_row_index(offset_from_center, total_span);
-        make_row("", empty_channels, false, decorators);
+        grid_rows.push_back(make_cells("", empty_channels, no_colors, false, emphasized_row(offset_from_center),
+                                       stripe(slot_index)));
     }
 
     auto grid = gridbox(grid_rows) | frame;
@@ -971,14 +1542,163 @@ ftxui::Element Ui::render_pattern_grid(const TransportState &state) {
     return window(text(" Pattern ") | color(kTheme.accent), content) | color(kTheme.border);
 }
 
-ftxui::Element Ui::render_status_bar() {
+void Ui::move_browse_cursor(const PatternCache &cache, int delta_rows) {
+    const int last_order = cache.num_orders() - 1;
+    browse_order_ = std::clamp(browse_order_, 0, std::max(0, last_order));
+    int row = browse_row_ + delta_rows;
+    while (row < 0 && browse_order_ > 0) {
+        --browse_order_;
+        row += cache.num_rows(cache.order_pattern(browse_order_));
+    }
+    while (browse_order_ < last_order && row >= cache.num_rows(cache.order_pattern(browse_order_))) {
+        row -= cache.num_rows(cache.order_pattern(browse_order_));
+        ++browse_order_;
+    }
+    browse_row_ = std::clamp(row, 0, std::max(0, cache.num_rows(cache.order_pattern(browse_order_)) - 1));
+}
+
+// Drawn only from the pattern cache: each frame formats nothing and reads
+// just the visible cells, whatever the size of the pattern.
+ftxui::Element Ui::render_pattern_browser(const TransportState &state) {
     using namespace ftxui;
 
-    auto now = std::chrono::steady_clock::now();
-    if (!status_message_.empty() && now >= status_message_until_) {
-        status_message_.clear();
+    auto title = text(" Pattern Browser ") | color(kTheme.accent);
+    const auto cache = player_.pattern_cache();
+    if (!cache) {
+        return window(title, paragraph("Formatting patterns…") | color(kTheme.text_dim) | center) | color(kTheme.border);
+    }
+    if (cache->channels() == 0 || cache->num_orders() == 0) {
+        return window(title, paragraph("No patterns") | color(kTheme.text_dim) | center) | color(kTheme.border);
     }
 
+    browse_order_ = std::clamp(browse_order_, 0, cache->num_orders() - 1);
+    const int pattern = cache->order_pattern(browse_order_);
+    const int rows = cache->num_rows(pattern);
+    browse_row_ = std::clamp(browse_row_, 0, std::max(0, rows - 1));
+
+    const int total_channels = cache->channels();
+    auto terminal = ftxui::Terminal::Size();
+    int terminal_width = terminal.dimx > 0 ? terminal.dimx : 80;
+    int terminal_height = terminal.dimy > 0 ? terminal.dimy : 24;
+    constexpr int kLabelWidth = 8;
+    constexpr int kMinColumnWidth = 18;
+    constexpr int kOuterPadding = 6;
+    constexpr int kBrowserOverhead = 24;
+
+    int available_width = std::max(40, terminal_width - kOuterPadding);
+    page_columns_ = std::clamp((available_width - kLabelWidth) / kMinColumnWidth, 1, total_channels);
+    channel_offset_ = std::clamp(channel_offset_, 0, std::max(0, total_channels - page_columns_));
+    int visible_columns = std::max(1, std::min(page_columns_, total_channels - channel_offset_));
+    int column_width = std::max(kMinColumnWidth, (available_width - kLabelWidth) / visible_columns);
+
+    int visible_rows = std::max(4, terminal_height - kBrowserOverhead);
+    int first_row = std::clamp(browse_row_ - visible_rows / 2, 0, std::max(0, rows - visible_rows));
+    int end_row = std::min(rows, first_row + visible_rows);
+
+    std::vector<Elements> grid_rows;
+    Elements header_cells;
+    header_cells.push_back(text("ROW") | bold | center | color(kTheme.accent) | size(WIDTH, EQUAL, kLabelWidth) |
+                           bgcolor(kTheme.panel_alt));
+    for (int col = 0; col < visible_columns; ++col) {
+        header_cells.push_back(text(format_channel_label(channel_offset_ + col + 1)) | bold | center |
+                               size(WIDTH, EQUAL, column_width) | bgcolor(kTheme.panel_alt) | color(kTheme.accent));
+    }
+    grid_rows.push_back(std::move(header_cells));
+
+    for (int row = first_row; row < end_row; ++row) {
+        const bool cursor = row == browse_row_;
+        const bool playing = state.order == browse_order_ && state.row == row;
+        const Color background = cursor ? kTheme.accent_soft : (row % 2 == 0 ? kTheme.panel : kTheme.panel_alt);
+
+        Elements cells;
+        cells.reserve(static_cast<std::size_t>(visible_columns) + 1);
+        auto label = text((playing ? "▶" : " ") + format_two_digit(row)) | center | size(WIDTH, EQUAL, kLabelWidth) |
+                     bgcolor(background) | color(playing ? kTheme.success : (cursor ? kTheme.text : kTheme.text_dim));
+        cells.push_back(cursor ? label | bold | focus : label);
+        for (int col = 0; col < visible_columns; ++col) {
+            const std::string_view content = cache->cell(pattern, row, channel_offset_ + col);
+            auto cell = text(std::string(content)) | size(WIDTH, EQUAL, column_width) | center | bgcolor(background) |
+                        color(cursor ? kTheme.text : note_color(note_color_index(content)));
+            cells.push_back(cursor ? cell | bold : cell);
+        }
+        grid_rows.push_back(std::move(cells));
+    }
+
+    std::string position = "Order " + format_two_digit(browse_order_) + "/" +
+                           format_two_digit(cache->num_orders() - 1);
+    position += pattern >= 0 ? "  •  Pattern " + format_two_digit(pattern) + "  •  Row " +
+                                   format_two_digit(browse_row_) + "/" + format_two_digit(std::max(0, rows - 1))
+                             : "  •  no pattern";
+    std::string playing = "▶ " + format_order_row_label(std::max(0, state.order), std::max(0, state.row));
+    auto info = hbox({text(position) | bold, filler(), text(playing) | color(kTheme.success)}) | bgcolor(kTheme.panel);
+    auto keys = text("↑↓ Rows  PgUp/PgDn Page  ←/→ Orders  Home/End  Tab Channels  Enter Play from here  B Close") |
+                color(kTheme.text_dim) | dim;
+
+    Element body = rows > 0 ? gridbox(grid_rows) | frame
+                            : paragraph("This order is a separator") | color(kTheme.text_dim) | center;
+    auto content = vbox({info, separatorLight(), body | flex, separatorLight(), keys}) | bgcolor(kTheme.panel) |
+                   color(kTheme.text);
+    return window(title, content) | color(kTheme.border);
+}
+
+// One column per order, read from the precomputed density grid; songs
+// wider than the terminal scroll to keep the selection in view.
+ftxui::Element Ui::render_minimap(const TransportState &state) {
+    using namespace ftxui;
+
+    auto title = text(" Song Map ") | color(kTheme.accent);
+    const auto minimap = player_.song_minimap();
+    if (!minimap) {
+        return window(title, text("Reading patterns…") | color(kTheme.text_dim)) | color(kTheme.border);
+    }
+    const int orders = minimap->num_orders();
+    if (orders == 0) {
+        return window(title, text("No orders") | color(kTheme.text_dim)) | color(kTheme.border);
+    }
+
+    minimap_cursor_ = std::clamp(minimap_cursor_, 0, orders - 1);
+    auto terminal = ftxui::Terminal::Size();
+    const int width = std::max(8, (terminal.dimx > 0 ? terminal.dimx : 80) - 4);
+    const int visible = std::min(orders, width);
+    const int first = std::clamp(minimap_cursor_ - visible / 2, 0, orders - visible);
+
+    Elements lines;
+    for (int block = 0; block < SongMinimap::kBlocks; ++block) {
+        Elements cells;
+        cells.reserve(static_cast<std::size_t>(visible));
+        for (int order = first; order < first + visible; ++order) {
+            Element cell = minimap->is_separator(order)
+                               ? text("┊") | color(kTheme.text_dim) | dim
+                               : text(SongMinimap::glyph(minimap->level(order, block))) |
+                                     color(order == state.order ? kTheme.success : kTheme.accent);
+            if (order == minimap_cursor_) {
+                cell = cell | bgcolor(kTheme.accent_soft);
+            }
+            cells.push_back(std::move(cell));
+        }
+        lines.push_back(hbox(std::move(cells)));
+    }
+    if (state.order >= first && state.order < first + visible) {
+        lines.push_back(hbox({text(std::string(static_cast<std::size_t>(state.order - first), ' ')),
+                              text("▲") | color(kTheme.success)}));
+    } else {
+        lines.push_back(text(""));
+    }
+
+    std::string selection = "Order " + format_two_digit(minimap_cursor_) + "/" + format_two_digit(orders - 1);
+    if (const auto cache = player_.pattern_cache(); cache && cache->order_pattern(minimap_cursor_) >= 0) {
+        selection += "  •  Pattern " + format_two_digit(cache->order_pattern(minimap_cursor_));
+    }
+    lines.push_back(hbox({text(selection) | bold, filler(),
+                          text("←/→ Select  Enter Play  B Browse  O Close") | color(kTheme.text_dim) | dim}));
+
+    auto content = vbox(std::move(lines)) | bgcolor(kTheme.panel) | color(kTheme.text);
+    return window(title, content) | color(kTheme.border);
+}
+
+ftxui::Element Ui::render_status_bar() {
+    using namespace ftxui;
+
     std::string message = status_message_.empty() ? "Ready" : status_message_;
     std::string playback_state = last_state_.paused ? "Paused" : (running_ ? "Playing" : "Stopped");
     auto playback_color = last_state_.paused ? kTheme.warning : kTheme.success;
@@ -995,6 +1715,10 @@ ftxui::Element Ui::render_status_bar() {
 
     auto left = text(message) | color(kTheme.text_dim);
     auto progress_bar = gaugeRight(progress_ratio) | color(kTheme.accent) | bgcolor(kTheme.panel_alt) | flex;
+    std::vector<std::uint8_t> envelope = player_.song_envelope();
+    if (!envelope.empty()) {
+        progress_bar = vbox({progress_bar, render_song_overview(std::move(envelope), progress_ratio)}) | flex;
+    }
     auto center = hbox({progress_bar, text("  "), text(time_label) | color(kTheme.text_dim)}) | flex;
     auto right = hbox({
         text(volume_label) | color(kTheme.text_dim),
@@ -1007,7 +1731,9 @@ ftxui::Element Ui::render_status_bar() {
 
 ftxui::Element Ui::render_footer() const {
     using namespace ftxui;
-    auto shortcuts = text("Space: Play/Pause  [ / ] ±8 rows  ←/→ Orders  PgUp/PgDn Channels  +/- Volume  M Mute  E Effects  X Export  N Info  A About  Q Quit") |
+    std::string playlist_keys = player_.has_playlist() ? "< / > Track  S Shuffle  R Repeat  " : "";
+    auto shortcuts = text("Space: Play/Pause  [ / ] ±8 rows  ←/→ Orders  PgUp/PgDn Channels  +/- Volume  M Mute  E Effects  " +
+                          playlist_keys + "X Export  J Jobs  B Browse  O Map  N Info  P Profiler  A About  Q Quit") |
                      color(kTheme.text_dim) | dim;
     return hbox({shortcuts}) | bgcolor(kTheme.background) | color(kTheme.text);
 }
@@ -1056,28 +1782,14 @@ ftxui::Element Ui::render_export_dialog() {
     
     dialog_content.push_back(separatorLight());
     
-    if (export_in_progress_) {
-        dialog_content.push_back(text("Exporting...") | color(kTheme.warning) | bold);
-        
-        if (export_total_ > 0) {
-            float progress = static_cast<float>(export_current_) / static_cast<float>(export_total_);
-            int percent = static_cast<int>(progress * 100.0f);
-            
-            dialog_content.push_back(hbox({
-                text(std::to_string(percent) + "%") | color(kTheme.text),
-                text(" ") | flex,
-                text(std::to_string(export_current_ / 48000) + "s / " + 
-                     std::to_string(export_total_ / 48000) + "s") | color(kTheme.text_dim)
-            }));
-            
-            int bar_width = 40;
-            int filled = static_cast<int>(progress * bar_width);
-            std::string bar_str;
-            for (int i = 0; i < filled; ++i) bar_str += "█";
-            for (int i = filled; i < bar_width; ++i) bar_str += "░";
-            dialog_content.push_back(text(bar_str) | color(kTheme.accent));
-        }
-    } else if (!export_error_.empty()) {
+    std::size_t active_jobs = export_jobs_->active_count();
+    if (active_jobs > 0) {
+        dialog_content.push_back(text(std::to_string(active_jobs) + " export job(s) active, press J to view") |
+                                 color(kTheme.warning) | bold);
+        dialog_content.push_back(separatorLight());
+    }
+
+    if (!export_error_.empty()) {
         dialog_content.push_back(text("Export failed!") | color(kTheme.danger) | bold);
         dialog_content.push_back(text(export_error_) | color(kTheme.text_dim));
         dialog_content.push_back(separatorLight());
@@ -1085,7 +1797,7 @@ ftxui::Element Ui::render_export_dialog() {
     } else {
         dialog_content.push_back(text("Controls:") | color(kTheme.text_dim) | dim);
         dialog_content.push_back(text("  Tab/↑↓: Select format") | color(kTheme.text_dim) | dim);
-        dialog_content.push_back(text("  Enter: Start export") | color(kTheme.text_dim) | dim);
+        dialog_content.push_back(text("  Enter: Queue export") | color(kTheme.text_dim) | dim);
         dialog_content.push_back(text("  X: Close dialog") | color(kTheme.text_dim) | dim);
     }
     
@@ -1095,14 +1807,147 @@ ftxui::Element Ui::render_export_dialog() {
     return dialog | center | bgcolor(kTheme.background);
 }
 
+ftxui::Element Ui::render_jobs_panel() {
+    using namespace ftxui;
+
+    auto jobs = export_jobs_->jobs();
+    jobs_selection_ = std::clamp(jobs_selection_, 0, std::max(0, static_cast<int>(jobs.size()) - 1));
+
+    Elements lines;
+    if (jobs.empty()) {
+        lines.push_back(text("No export jobs yet. Press X to queue one.") | color(kTheme.text_dim) | dim);
+    }
+
+    for (std::size_t i = 0; i < jobs.size(); ++i) {
+        const auto &job = jobs[i];
+        bool selected = static_cast<int>(i) == jobs_selection_;
+
+        auto state_color = kTheme.text_dim;
+        switch (job.state) {
+            case ExportJobState::Running:   state_color = kTheme.warning; break;
+            case ExportJobState::Completed: state_color = kTheme.success; break;
+            case ExportJobState::Failed:    state_color = kTheme.danger; break;
+            default: break;
+        }
+
+        std::ostringstream stats;
+        stats << std::setw(3) << static_cast<int>(std::round(job.progress * 100.0)) << "%  "
+              << format_time(job.elapsed_seconds);
+        if (job.realtime_factor > 0.0) {
+            stats << "  " << std::fixed << std::setprecision(1) << job.realtime_factor << "x";
+        }
+
+        auto line = hbox({
+            text(selected ? "▶ " : "  ") | color(kTheme.accent),
+            text("#" + std::to_string(job.id)) | color(kTheme.accent) | size(WIDTH, EQUAL, 5),
+            text(job.output_path) | color(kTheme.text) | size(WIDTH, EQUAL, 28),
+            text(ExportJobManager::state_name(job.state)) | color(state_color) | bold | size(WIDTH, EQUAL, 10),
+            gaugeRight(static_cast<float>(job.progress)) | color(state_color) | bgcolor(kTheme.panel_alt) |
+                size(WIDTH, EQUAL, 16),
+            text(" " + stats.str()) | color(kTheme.text_dim)
+        });
+        if (selected) {
+            line = line | bgcolor(kTheme.accent_soft);
+        }
+        lines.push_back(line);
+
+        if (selected && job.state == ExportJobState::Failed && !job.error_message.empty()) {
+            lines.push_back(text("    " + job.error_message) | color(kTheme.danger));
+        }
+        if (selected && job.state == ExportJobState::Completed) {
+            lines.push_back(text("    " + job.stats.summary()) | color(kTheme.text_dim));
+        }
+    }
+
+    lines.push_back(separatorLight());
+    lines.push_back(text("↑↓ Select  C Cancel  J Close") | color(kTheme.text_dim) | dim);
+
+    auto content = vbox(std::move(lines)) | bgcolor(kTheme.panel) | color(kTheme.text) |
+                   size(WIDTH, GREATER_THAN, 72);
+    auto overlay = window(text(" Export Jobs ") | color(kTheme.accent), content) | color(kTheme.border);
+
+    return overlay | clear_under | center | vcenter;
+}
+
+void Ui::start_export() {
+    ExportOptions options;
+    options.sample_rate = 48000;
+    options.channels = 2;
+    options.volume = player_.get_volume();
+    options.effect = player_.get_effect();
+
+    switch (export_format_selection_) {
+        case 0:
+            options.format = ExportFormat::WAV;
+            break;
+        case 1:
+            options.format = ExportFormat::MP3;
+            options.mp3_bitrate = 320;
+            break;
+        case 2:
+            options.format = ExportFormat::FLAC;
+            options.flac_compression_level = 5;
+            break;
+    }
+
+    options.output_path = export_filename_ + AudioExporter::get_extension(options.format);
+
+    if (!AudioExporter::is_format_supported(options.format)) {
+        export_error_ = "Format not supported (missing library)";
+        return;
+    }
+
+    std::string error_message;
+    int job_id = export_jobs_->submit(std::move(options), error_message);
+    if (job_id < 0) {
+        export_error_ = error_message;
+        return;
+    }
+
+    export_error_.clear();
+    export_dialog_ = false;
+    set_status_message("Export #" + std::to_string(job_id) + " queued");
+}
+
+void Ui::poll_export_jobs() {
+    for (const auto &job : export_jobs_->take_finished()) {
+        switch (job.state) {
+            case ExportJobState::Completed: {
+                std::ostringstream oss;
+                oss << "Export complete: " << job.output_path << std::fixed << std::setprecision(1) << " • "
+                    << job.stats.realtime_factor() << "x realtime • " << job.stats.write_megabytes_per_second()
+                    << " MB/s";
+                set_status_message(oss.str(), std::chrono::milliseconds(6000));
+                break;
+            }
+            case ExportJobState::Failed:
+                set_status_message("Export failed: " + job.error_message, std::chrono::milliseconds(4000));
+                break;
+            case ExportJobState::Cancelled:
+                set_status_message("Export cancelled: " + job.output_path);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
 ftxui::Element Ui::render_info_overlay(const TransportState &state) {
     using namespace ftxui;
 
+    std::ostringstream display_line;
+    display_line << "Display: " << std::fixed << std::setprecision(0) << frames_per_second_ << " fps ("
+                 << (active_frame_rate_ ? "active" : "idle") << ") • UI thread " << std::setprecision(1)
+                 << ui_cpu_percent_ << "% CPU • " << std::setprecision(0) << panels_reused_percent_
+                 << "% panels reused • " << std::setprecision(1) << output_bytes_per_second_ / 1024.0
+                 << " KB/s output";
+
     Elements info_lines = {
         text("Title: " + player_.title()) | color(kTheme.text),
         text("Tracker: " + player_.tracker_name()) | color(kTheme.text_dim),
         text("Duration: " + format_time(player_.duration_seconds())) | color(kTheme.text_dim),
         text("Channels: " + std::to_string(state.channels.size())) | color(kTheme.text_dim),
+        text(display_line.str()) | color(kTheme.text_dim),
     };
 
     const auto &message_lines = player_.module_message_lines();
@@ -1149,6 +1994,30 @@ ftxui::Element Ui::render_info_overlay(const TransportState &state) {
     return overlay | clear_under | center | vcenter;
 }
 
+ftxui::Element Ui::render_profiler_overlay() const {
+    using namespace ftxui;
+
+    std::vector<Elements> rows;
+    rows.push_back({text("Phase") | color(kTheme.text_dim), text("  p50") | color(kTheme.text_dim),
+                    text("  p99") | color(kTheme.text_dim)});
+    for (const auto &phase : profiler_.summary()) {
+        auto p99_color = phase.p99_us >= 16000 ? kTheme.danger : (phase.p99_us >= 4000 ? kTheme.warning : kTheme.text);
+        rows.push_back({text(phase.name), text("  " + format_micros(phase.p50_us)) | align_right,
+                        text("  " + format_micros(phase.p99_us)) | align_right | color(p99_color)});
+    }
+    rows.push_back({text("output/frame"), text("  " + format_bytes(profiler_.bytes_percentile(0.5))) | align_right,
+                    text("  " + format_bytes(profiler_.bytes_percentile(0.99))) | align_right});
+
+    auto content = vbox({gridbox(rows),
+                         separatorLight(),
+                         text("Output " + format_bytes(static_cast<std::uint64_t>(output_bytes_per_second_)) + "/s"),
+                         text("Last " + std::to_string(profiler_.frames()) + " frames • P to close") |
+                             color(kTheme.text_dim) | dim}) |
+                   bgcolor(kTheme.panel) | color(kTheme.text);
+    auto panel = window(text(" Frame Profiler ") | color(kTheme.accent), content) | color(kTheme.border) | clear_under;
+    return vbox({hbox({filler(), panel}), filler()});
+}
+
 ftxui::Element Ui::render_about_overlay() {
     using namespace ftxui;
 
@@ -1234,34 +2103,33 @@ ftxui::Elements Ui::render_history_rows(const TransportState &state, int columns
     int history_placeholders = history_total - history_real;
     int future_placeholders = future_total - future_real;
 
-    int total_span = history_total + future_total + 1;
     int history_start = std::max(0, history_available - history_real);
 
     const std::string placeholder = channel_placeholder();
     constexpr int kLabelWidth = 8;
 
-    auto make_cells = [&](const std::string &label, const std::vector<std::string> &channels, bool highlight,
-                          const std::vector<ftxui::Decorator> &decorators) {
+    auto make_cells = [&](const std::string &label, const std::vector<std::string> &channels,
+                          const std::vector<std::uint8_t> &colors, bool highlight, bool emphasized) {
         Elements cells;
         auto background = highlight ? kTheme.accent_soft : (rows.size() % 2 == 0 ? kTheme.panel : kTheme.panel_alt);
 
         auto label_cell = text(label) | size(WIDTH, EQUAL, kLabelWidth) | center | bgcolor(background) |
                           color(highlight ? kTheme.text : kTheme.text_dim);
-        label_cell = apply_decorators(std::move(label_cell), decorators);
+        if (emphasized) {
+            label_cell = label_cell | bold;
+        }
         cells.push_back(label_cell);
 
         for (int col = 0; col < columns; ++col) {
-            int channel_index = channel_offset_ + col;
-            std::string content = placeholder;
-            if (channel_index < static_cast<int>(channels.size())) {
-                content = channels[static_cast<std::size_t>(channel_index)];
-            }
+            const auto channel_index = static_cast<std::size_t>(channel_offset_ + col);
+            const std::string &content = channel_index < channels.size() ? channels[channel_index] : placeholder;
+            const std::uint8_t color_index =
+                channel_index < colors.size() ? colors[channel_index] : note_color_index(content);
             auto cell = text(content) | size(WIDTH, EQUAL, column_width) | center | bgcolor(background) |
-                        color(highlight ? kTheme.text : color_for_note(content));
-            if (highlight) {
+                        color(highlight ? kTheme.text : note_color(color_index));
+            if (highlight || emphasized) {
                 cell = cell | bold;
             }
-            cell = apply_decorators(std::move(cell), decorators);
             cells.push_back(cell);
         }
 
@@ -1269,37 +2137,37 @@ ftxui::Elements Ui::render_history_rows(const TransportState &state, int columns
     };
 
     const std::vector<std::string> empty_channels;
+    const std::vector<std::uint8_t> no_colors;
 
     for (int i = 0; i < history_placeholders; ++i) {
         int offset_from_center = -(history_total - i);
-        make_cells("", empty_channels, false,
-                   decorators_for_row_index(offset_from_center, total_span));
+        make_cells("", empty_channels, no_colors, false, emphasized_row(offset_from_center));
     }
 
     for (int i = 0; i < history_real; ++i) {
         int slot_index = history_placeholders + i;
         int offset_from_center = -(history_total - slot_index);
         const RowRender &row = history_[static_cast<std::size_t>(history_start + i)];
-        make_cells(format_order_row_label(row.order, row.row), row.channels, false,
-                   decorators_for_row_index(offset_from_center, total_span));
+        make_cells(format_order_row_label(row.order, row.row), row.channels, row.colors, false,
+                   emphasized_row(offset_from_center));
     }
 
     if (current_row) {
-        make_cells(format_order_row_label(current_row->order, current_row->row), current_row->channels, true, {});
+        make_cells(format_order_row_label(current_row->order, current_row->row), current_row->channels,
+                   current_row->colors, true, false);
     }
 
     for (int i = 0; i < future_real; ++i) {
         int offset_from_center = i + 1;
         const PatternRowPreview &preview = state.preview_rows[static_cast<std::size_t>(i)];
-        make_cells(format_order_row_label(preview.order, preview.row), preview.channels, false,
-                   decorators_for_row_index(offset_from_center, total_span));
+        make_cells(format_order_row_label(preview.order, preview.row), preview.channels, no_colors, false,
+                   emphasized_row(offset_from_center));
     }
 
     for (int i = 0; i < future_placeholders; ++i) {
         int slot_index = future_real + i;
         int offset_from_center = slot_index + 1;
-        make_cells("", empty_channels, false,
-                   decorators_for_row_index(offset_from_center, total_span));
+        make_cells("", empty_channels, no_colors, false, emphasized_row(offset_from_center));
     }
 
     return rows;
@@ -1333,6 +2201,10 @@ ftxui::Element Ui::render_visualizers(const TransportState &state, int columns,
         std::ostringstream oss;
         oss << std::setw(3) << std::setfill(' ') << static_cast<int>(std::round(amplitude * 100.0)) << "%  pk "
             << std::setw(3) << static_cast<int>(std::round(peak * 100.0)) << '%';
+        if (options_.low_bandwidth) {
+            bars.push_back(gauge);
+            continue;
+        }
         auto caption = text(oss.str()) | color(kTheme.text_dim) | center;
 
         bars.push_back(vbox({gauge, caption}) | bgcolor(kTheme.panel_alt));
@@ -1341,58 +2213,8 @@ ftxui::Element Ui::render_visualizers(const TransportState &state, int columns,
     return hbox(std::move(bars));
 }
 
-ftxui::Color Ui::color_for_note(const std::string &cell) const {
-    if (cell.size() < 3) {
-        return kTheme.text_dim;
-    }
-
-    char n0 = static_cast<char>(std::toupper(static_cast<unsigned char>(cell[0])));
-    char n1 = cell.size() > 1 ? cell[1] : '-';
-    if ((n0 == '-' && n1 == '-') || n0 == ' ') {
-        return kTheme.text_dim;
-    }
-
-    int note_index = -1;
-    switch (n0) {
-    case 'C': note_index = 0; break;
-    case 'D': note_index = 2; break;
-    case 'E': note_index = 4; break;
-    case 'F': note_index = 5; break;
-    case 'G': note_index = 7; break;
-    case 'A': note_index = 9; break;
-    case 'B': note_index = 11; break;
-    default: break;
-    }
-
-    if (note_index == -1) {
-        return kTheme.text_dim;
-    }
-    if (n1 == '#') {
-        note_index = (note_index + 1) % 12;
-    }
-
-    static const std::array<ftxui::Color, 12> palette = {
-        ftxui::Color::RGB(239, 71, 111),  ftxui::Color::RGB(255, 182, 99),  ftxui::Color::RGB(255, 213, 153),
-        ftxui::Color::RGB(6, 214, 160),  ftxui::Color::RGB(17, 138, 178),  ftxui::Color::RGB(239, 71, 111),
-        ftxui::Color::RGB(255, 182, 99), ftxui::Color::RGB(255, 213, 153), ftxui::Color::RGB(6, 214, 160),
-        ftxui::Color::RGB(17, 138, 178), ftxui::Color::RGB(76, 201, 240),  ftxui::Color::RGB(150, 199, 255)};
-
-    return palette[static_cast<std::size_t>(note_index)];
-}
-
-std::vector<ftxui::Decorator> Ui::decorators_for_row_index(int offset_from_center, int) const {
-    std::vector<ftxui::Decorator> decorators;
-    int distance = std::abs(offset_from_center);
-    
-    if (distance == 0) {
-        return decorators;
-    }
-
-    if (offset_from_center > 0 && distance <= 2) {
-        decorators.push_back(ftxui::bold);
-    }
-    
-    return decorators;
+bool Ui::emphasized_row(int offset_from_center) const {
+    return offset_from_center > 0 && offset_from_center <= 2;
 }
 
 void Ui::update_visualizer_peaks(const TransportState &state, int total_channels) {
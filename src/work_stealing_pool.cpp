@@ -0,0 +1,86 @@
+#include "work_stealing_pool.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tracker {
+
+namespace {
+
+struct WorkQueue {
+    std::mutex mutex;
+    std::deque<std::size_t> items;
+
+    bool pop_back(std::size_t& index) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (items.empty()) {
+            return false;
+        }
+        index = items.back();
+        items.pop_back();
+        return true;
+    }
+
+    bool steal_front(std::size_t& index) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (items.empty()) {
+            return false;
+        }
+        index = items.front();
+        items.pop_front();
+        return true;
+    }
+};
+
+}
+
+WorkStealingPool::WorkStealingPool(std::size_t thread_count)
+    : thread_count_(thread_count > 0 ? thread_count : std::max(1u, std::thread::hardware_concurrency())) {}
+
+void WorkStealingPool::run(std::size_t count,
+                           const std::function<void(std::size_t index, std::size_t worker)>& task) const {
+    const std::size_t workers = std::max<std::size_t>(1, std::min(thread_count_, count));
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    for (std::size_t w = 0; w < workers; ++w) {
+        queues.push_back(std::make_unique<WorkQueue>());
+        const std::size_t begin = count * w / workers;
+        const std::size_t end = count * (w + 1) / workers;
+        // Reversed so pop_back hands out the slice in ascending order.
+        for (std::size_t i = end; i > begin; --i) {
+            queues[w]->items.push_back(i - 1);
+        }
+    }
+
+    auto work = [&](std::size_t worker) {
+        std::size_t index = 0;
+        while (true) {
+            if (queues[worker]->pop_back(index)) {
+                task(index, worker);
+                continue;
+            }
+            bool stolen = false;
+            for (std::size_t offset = 1; offset < workers && !stolen; ++offset) {
+                stolen = queues[(worker + offset) % workers]->steal_front(index);
+            }
+            if (!stolen) {
+                return;
+            }
+            task(index, worker);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t w = 1; w < workers; ++w) {
+        threads.emplace_back(work, w);
+    }
+    work(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+}
@@ -0,0 +1,63 @@
+#include "file_browser_ui.hpp"
+#include "list_viewport.hpp"
+
+#include <ftxui/dom/elements.hpp>
+#include <ftxui/screen/screen.hpp>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using tracker::FileEntry;
+using tracker::ListViewport;
+
+namespace {
+
+std::vector<FileEntry> make_entries(std::size_t count) {
+    std::vector<FileEntry> entries;
+    entries.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        entries.emplace_back("/mods/track" + std::to_string(i) + ".xm", "track" + std::to_string(i) + ".xm", false,
+                             i * 37);
+    }
+    return entries;
+}
+
+// Average time to build and draw one frame of the list into a 120x40 screen
+// while the selection walks down the list.
+double frame_milliseconds(const std::vector<FileEntry>& entries, bool virtualized) {
+    const int frames = 30;
+    const std::size_t rows = 32;
+    ListViewport viewport;
+    auto screen = ftxui::Screen(120, 40);
+    const auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; ++frame) {
+        const std::size_t selected = (entries.size() / frames) * static_cast<std::size_t>(frame);
+        viewport.update(entries.size(), selected, rows);
+        const std::size_t begin = virtualized ? viewport.begin(4) : 0;
+        const std::size_t end = virtualized ? viewport.end(entries.size(), 4) : entries.size();
+        auto element = tracker::render_file_entries(entries, selected, begin, end) | ftxui::yframe;
+        ftxui::Render(screen, element);
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+}
+
+}
+
+// Prints how long one frame of the file list takes with and without
+// virtualization, for a range of directory sizes.
+int main() {
+    std::cout << std::setw(10) << "entries" << std::setw(16) << "full (ms)" << std::setw(18) << "virtual (ms)"
+              << std::endl;
+    for (std::size_t count : {100u, 1000u, 10000u, 100000u}) {
+        const auto entries = make_entries(count);
+        const double full = count <= 10000 ? frame_milliseconds(entries, false) : -1.0;
+        const double virtualized = frame_milliseconds(entries, true);
+        std::cout << std::setw(10) << count << std::setw(16) << std::fixed << std::setprecision(3)
+                  << (full < 0 ? std::string("skipped") : std::to_string(full)) << std::setw(18) << virtualized
+                  << std::endl;
+    }
+    return 0;
+}
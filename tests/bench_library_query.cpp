@@ -0,0 +1,86 @@
+#include "library_query.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using tracker::LibraryColumns;
+using tracker::LibraryIndex;
+using tracker::LibraryQuery;
+using tracker::LibraryRecord;
+
+namespace {
+
+std::vector<LibraryRecord> make_records(std::size_t count) {
+    const char* artists[] = {"Purple Motion", "Skaven", "Jester", "Lizardking", "Necros", "Captain", "Jogeir Liljedahl"};
+    const char* formats[] = {"mod", "s3m", "xm", "it"};
+    const char* trackers[] = {"ProTracker", "Scream Tracker 3", "FastTracker 2", "Impulse Tracker"};
+    std::vector<LibraryRecord> records;
+    records.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::size_t kind = i % 4;
+        LibraryRecord record;
+        record.path = "/mods/filler/f" + std::to_string(i) + "." + formats[kind];
+        record.title = "Filler " + std::to_string(i);
+        record.artist = artists[i % 7];
+        record.format = formats[kind];
+        record.tracker = trackers[kind];
+        record.channels = static_cast<std::uint16_t>(4 + 4 * (i % 8));
+        record.patterns = static_cast<std::uint16_t>(record.channels * 4);
+        record.duration_ms = static_cast<std::uint32_t>(200000 + i % 400000);
+        record.size = record.duration_ms / 10;
+        record.flags = LibraryRecord::kMetadataValid;
+        records.push_back(std::move(record));
+    }
+    return records;
+}
+
+}
+
+// Prints how long building the query columns and one filtered scan take
+// for a range of library sizes.
+int main() {
+    namespace fs = std::filesystem;
+    const fs::path root = fs::temp_directory_path() / ("library_query_bench_" + std::to_string(::getpid()));
+    fs::remove_all(root);
+    const fs::path index_path = root / "library.idx";
+
+    LibraryQuery query;
+    std::string error;
+    if (!LibraryQuery::parse("ch=4 format=mod duration<=4:00 artist~purple", query, error)) {
+        std::cerr << "Query failed to parse: " << error << std::endl;
+        return 1;
+    }
+
+    std::cout << std::setw(10) << "records" << std::setw(14) << "build (ms)" << std::setw(14) << "scan (ms)"
+              << std::setw(10) << "matches" << std::endl;
+    for (std::size_t count : {10000u, 50000u, 200000u}) {
+        LibraryIndex index;
+        if (!LibraryIndex::write(index_path, make_records(count), error) || !index.open(index_path, error)) {
+            std::cerr << "Index failed: " << error << std::endl;
+            fs::remove_all(root);
+            return 1;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        LibraryColumns columns(index);
+        const double build_ms =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        const std::size_t matches = columns.execute(query).size();
+        const double scan_ms =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << std::setw(10) << count << std::setw(14) << std::fixed << std::setprecision(3) << build_ms
+                  << std::setw(14) << scan_ms << std::setw(10) << matches << std::endl;
+    }
+
+    fs::remove_all(root);
+    return 0;
+}
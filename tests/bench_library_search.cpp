@@ -0,0 +1,74 @@
+#include "library_search.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using tracker::LibraryIndex;
+using tracker::LibraryRecord;
+using tracker::LibrarySearchIndex;
+
+namespace {
+
+std::vector<LibraryRecord> make_records(std::size_t count) {
+    const char* words[] = {"space", "debris", "cyber", "night", "acid", "dream", "chip", "tune", "mega", "blast",
+                           "funk", "lazer", "ocean", "drift", "metal", "storm"};
+    std::vector<LibraryRecord> records;
+    records.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        LibraryRecord record;
+        record.path = "/mods/filler/f" + std::to_string(i) + ".xm";
+        record.title = std::string(words[i % 16]) + " " + words[(i / 16) % 16] + " " + std::to_string(i);
+        record.artist = std::string("Artist ") + words[(i / 256) % 16];
+        records.push_back(std::move(record));
+    }
+    return records;
+}
+
+}
+
+// Prints how long building the search index and an average two-word
+// query take for a range of library sizes.
+int main() {
+    namespace fs = std::filesystem;
+    const fs::path root = fs::temp_directory_path() / ("library_search_bench_" + std::to_string(::getpid()));
+    fs::remove_all(root);
+    const fs::path index_path = root / "library.idx";
+
+    std::cout << std::setw(10) << "records" << std::setw(14) << "build (ms)" << std::setw(14) << "query (ms)"
+              << std::endl;
+    for (std::size_t count : {5000u, 50000u}) {
+        std::string error;
+        auto library = std::make_shared<LibraryIndex>();
+        if (!LibraryIndex::write(index_path, make_records(count), error) || !library->open(index_path, error)) {
+            std::cerr << "Index failed: " << error << std::endl;
+            fs::remove_all(root);
+            return 1;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        LibrarySearchIndex index(library);
+        const double build_ms =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        const int query_runs = 100;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < query_runs; ++i) {
+            index.search("lazer ocean", tracker::LibrarySearcher::kMaxResults);
+        }
+        const double query_ms =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / query_runs;
+
+        std::cout << std::setw(10) << count << std::setw(14) << std::fixed << std::setprecision(3) << build_ms
+                  << std::setw(14) << query_ms << std::endl;
+    }
+
+    fs::remove_all(root);
+    return 0;
+}
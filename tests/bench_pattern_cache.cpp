@@ -0,0 +1,33 @@
+#include "pattern_cache.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+using tracker::PatternCache;
+
+// Fills 64 patterns of 256 rows x 64 channels and prints how long reading
+// one screen of the last pattern takes: scrolling reads only what is
+// visible, whatever the pattern size.
+int main() {
+    const std::string text = "C-5 01 v64 A0F";
+    PatternCache cache(64);
+    for (int pattern = 0; pattern < 64; ++pattern) {
+        cache.begin_pattern(256);
+        for (int cell = 0; cell < 256 * 64; ++cell) {
+            cache.add_cell(text);
+        }
+    }
+    const auto start = std::chrono::steady_clock::now();
+    std::size_t bytes = 0;
+    for (int row = 0; row < 256; ++row) {
+        for (int channel = 0; channel < 8; ++channel) {
+            bytes += cache.cell(63, row, channel).size();
+        }
+    }
+    const double elapsed_us =
+        std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "256 rows x 8 visible channels (" << bytes << " bytes) read in " << elapsed_us << " us, cache "
+              << cache.memory_bytes() / (1024 * 1024) << " MB" << std::endl;
+    return 0;
+}
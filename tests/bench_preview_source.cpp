@@ -0,0 +1,46 @@
+#include "preview_source.hpp"
+#include "test_modules.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using tracker::PreviewSource;
+
+// Prints the time from request() to the first audible block with the
+// default debounce, for a few module lengths.
+int main() {
+    namespace fs = std::filesystem;
+    const fs::path root = fs::temp_directory_path() / ("preview_source_bench_" + std::to_string(::getpid()));
+    fs::remove_all(root);
+    fs::create_directories(root);
+
+    PreviewSource source(48000);
+    std::vector<float> buffer(480 * 2);
+    std::cout << std::setw(10) << "orders" << std::setw(16) << "latency (ms)" << std::endl;
+    for (int orders : {1, 10, 40, 120}) {
+        const fs::path path = root / ("song" + std::to_string(orders) + ".mod");
+        const auto module = tracker::test::make_square_module(orders);
+        std::ofstream(path, std::ios::binary)
+            .write(reinterpret_cast<const char*>(module.data()), static_cast<std::streamsize>(module.size()));
+
+        source.request(path);
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (source.render(buffer.data(), buffer.size() / 2) == 0 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::cout << std::setw(10) << orders << std::setw(16) << std::fixed << std::setprecision(1)
+                  << source.last_start_latency_milliseconds() << std::endl;
+    }
+
+    fs::remove_all(root);
+    return 0;
+}
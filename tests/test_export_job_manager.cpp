@@ -0,0 +1,199 @@
+#include "export_job_manager.hpp"
+#include "test_support.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using tracker::ExportJobInfo;
+using tracker::ExportJobManager;
+using tracker::ExportJobState;
+using tracker::ExportOptions;
+using tracker::ExportStats;
+using tracker::test::expect;
+
+namespace {
+
+// Stands in for the offline renderer: jobs spin on the progress callback
+// until the gate opens or they are cancelled, so tests control when they end.
+class Gate {
+public:
+    void open() {
+        {
+            std::lock_guard lock(mutex_);
+            open_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    bool render(const ExportOptions& options, ExportStats& stats, std::string& error_message) {
+        while (true) {
+            if (!options.progress_callback(1, 2)) {
+                error_message = "Export cancelled";
+                return false;
+            }
+            std::unique_lock lock(mutex_);
+            if (cv_.wait_for(lock, std::chrono::milliseconds(1), [this] { return open_; })) {
+                break;
+            }
+        }
+        if (options.output_path.rfind("fail", 0) == 0) {
+            error_message = "Disk full";
+            return false;
+        }
+        stats.audio_seconds = 1.0;
+        return true;
+    }
+
+    tracker::ExportRenderFunction function() {
+        return [this](const std::string&, const ExportOptions& options, ExportStats& stats, std::string& error_message) {
+            return render(options, stats, error_message);
+        };
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool open_{false};
+};
+
+ExportOptions options_for(const std::string& output_path) {
+    ExportOptions options;
+    options.output_path = output_path;
+    return options;
+}
+
+bool wait_for(const std::function<bool()>& condition) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return true;
+}
+
+ExportJobState state_of(const ExportJobManager& manager, int id) {
+    for (const auto& job : manager.jobs()) {
+        if (job.id == id) {
+            return job.state;
+        }
+    }
+    return ExportJobState::Queued;
+}
+
+const ExportJobInfo* find_job(const std::vector<ExportJobInfo>& jobs, int id) {
+    auto it = std::find_if(jobs.begin(), jobs.end(), [id](const auto& job) { return job.id == id; });
+    return it == jobs.end() ? nullptr : &*it;
+}
+
+}
+
+int main() {
+    // One worker and two queue slots: the third pending job is refused.
+    {
+        Gate gate;
+        ExportJobManager manager("song.mod", gate.function(), 1, 2);
+        std::string error;
+
+        int running = manager.submit(options_for("a.wav"), error);
+        expect(running > 0, "first job refused: " + error);
+        expect(wait_for([&] { return state_of(manager, running) == ExportJobState::Running; }),
+               "first job never started");
+
+        int queued = manager.submit(options_for("b.wav"), error);
+        int last = manager.submit(options_for("c.wav"), error);
+        expect(queued > 0 && last > 0, "queue refused a job below its limit");
+        expect(state_of(manager, queued) == ExportJobState::Queued, "second job is not queued");
+
+        error.clear();
+        expect(manager.submit(options_for("d.wav"), error) == -1, "full queue accepted a job");
+        expect(error == "Export queue is full", "unexpected full-queue error: " + error);
+
+        // A queued job is cancelled at once and frees its slot.
+        expect(manager.cancel(last), "cancelling a queued job failed");
+        expect(state_of(manager, last) == ExportJobState::Cancelled, "queued job not cancelled immediately");
+        auto finished = manager.take_finished();
+        expect(finished.size() == 1 && finished[0].id == last, "cancelled job not reported as finished");
+
+        error.clear();
+        expect(manager.submit(options_for("a.wav"), error) == -1, "duplicate output path accepted");
+        expect(error == "Already exporting to a.wav", "unexpected duplicate error: " + error);
+
+        // The running job stops at its next progress check.
+        expect(manager.cancel(running), "cancelling the running job failed");
+        expect(wait_for([&] { return state_of(manager, running) == ExportJobState::Cancelled; }),
+               "running job never cancelled");
+        expect(wait_for([&] { return state_of(manager, queued) == ExportJobState::Running; }),
+               "next job did not start after a cancel");
+
+        gate.open();
+        expect(wait_for([&] { return manager.active_count() == 0; }), "jobs never finished");
+        auto jobs = manager.jobs();
+        const auto* done = find_job(jobs, queued);
+        expect(done && done->state == ExportJobState::Completed, "released job did not complete");
+        expect(done && done->progress == 1.0 && done->stats.audio_seconds == 1.0, "completed job lost its stats");
+        expect(!manager.cancel(queued), "cancel succeeded on a finished job");
+        expect(manager.take_finished().size() == 2, "finished list missed a job");
+    }
+
+    // A failing render keeps its error message.
+    {
+        Gate gate;
+        gate.open();
+        ExportJobManager manager("song.mod", gate.function(), 1, 2);
+        std::string error;
+        int id = manager.submit(options_for("fail.wav"), error);
+        expect(wait_for([&] { return manager.active_count() == 0; }), "failing job never finished");
+        auto jobs = manager.jobs();
+        const auto* job = find_job(jobs, id);
+        expect(job && job->state == ExportJobState::Failed, "failing job not marked failed");
+        expect(job && job->error_message == "Disk full", "failed job lost its error");
+    }
+
+    // Finished jobs beyond the history limit are dropped, oldest first.
+    {
+        Gate gate;
+        gate.open();
+        ExportJobManager manager("song.mod", gate.function(), 2, 2);
+        const int total = static_cast<int>(ExportJobManager::kHistoryLimit) + 6;
+        int first = -1;
+        int latest = -1;
+        for (int i = 0; i < total; i += 2) {
+            std::string error;
+            latest = manager.submit(options_for("out" + std::to_string(i) + ".wav"), error);
+            if (first < 0) {
+                first = latest;
+            }
+            latest = manager.submit(options_for("out" + std::to_string(i + 1) + ".wav"), error);
+            expect(latest > 0, "batch submit refused: " + error);
+            expect(wait_for([&] { return manager.active_count() == 0; }), "batch never finished");
+        }
+
+        auto jobs = manager.jobs();
+        expect(jobs.size() == ExportJobManager::kHistoryLimit, "history not pruned to its limit");
+        expect(find_job(jobs, latest) != nullptr, "newest job was pruned");
+        expect(find_job(jobs, first) == nullptr, "oldest job survived pruning");
+        expect(manager.take_finished().size() == static_cast<std::size_t>(total),
+               "pruning dropped unreported finished jobs");
+    }
+
+    // Destroying the manager cancels a job that would otherwise never end.
+    {
+        Gate gate;
+        auto manager = std::make_unique<ExportJobManager>("song.mod", gate.function(), 1, 2);
+        std::string error;
+        int id = manager->submit(options_for("stuck.wav"), error);
+        expect(wait_for([&] { return state_of(*manager, id) == ExportJobState::Running; }), "job never started");
+        manager.reset();
+    }
+
+    return tracker::test::finish("export job manager");
+}
@@ -0,0 +1,311 @@
+#include "file_browser.hpp"
+#include "test_support.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+using tracker::FileBrowser;
+using tracker::FileEntry;
+using tracker::test::expect;
+
+namespace {
+
+void write_file(const std::filesystem::path& path, std::size_t size) {
+    std::ofstream file(path, std::ios::binary);
+    file << std::string(size, 'x');
+}
+
+template <typename Predicate>
+bool poll_until(FileBrowser& browser, Predicate done) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!done()) {
+        browser.poll();
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+bool wait_for_scan(FileBrowser& browser) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (browser.scanning()) {
+        browser.poll();
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+}
+
+int main() {
+    namespace fs = std::filesystem;
+    const fs::path root = fs::temp_directory_path() / ("file_browser_test_" + std::to_string(::getpid()));
+    fs::remove_all(root);
+    fs::create_directories(root / "songs");
+    fs::create_directories(root / "Beta");
+    fs::create_directories(root / "alpha");
+    fs::create_directories(root / "other");
+
+    const std::size_t module_count = 2000;
+    for (std::size_t i = 0; i < module_count; ++i) {
+        write_file(root / "songs" / ("track" + std::to_string(i) + (i % 2 ? ".MOD" : ".xm")), i % 97);
+    }
+    write_file(root / "songs" / "readme.txt", 10);
+    write_file(root / "other" / "only.it", 5);
+    fs::create_directory_symlink(root / "alpha", root / "songs" / "linked_dir");
+    fs::create_symlink(root / "other" / "only.it", root / "songs" / "linked.it");
+
+    {
+        FileBrowser browser(root / "songs");
+        expect(wait_for_scan(browser), "scan did not finish");
+        const auto& entries = browser.entries();
+
+        expect(!entries.empty() && entries.front().display_name == "..", "missing parent entry");
+        expect(entries.size() == module_count + 3, "unexpected entry count " + std::to_string(entries.size()));
+        expect(entries.size() > 1 && entries[1].display_name == "linked_dir" && entries[1].is_directory,
+               "symlinked directory not listed first");
+        expect(std::is_sorted(entries.begin() + 1, entries.end(),
+                              [](const auto& a, const auto& b) {
+                                  if (a.is_directory != b.is_directory) {
+                                      return a.is_directory;
+                                  }
+                                  return a.collation_key < b.collation_key;
+                              }),
+               "entries not sorted");
+        auto position = [&entries](const std::string& name) {
+            return std::find_if(entries.begin(), entries.end(),
+                                [&name](const auto& entry) { return entry.display_name == name; }) -
+                   entries.begin();
+        };
+        expect(position("track2.xm") < position("track10.xm") && position("track10.xm") < position("track100.xm"),
+               "numbers not in natural order");
+        expect(std::none_of(entries.begin(), entries.end(),
+                            [](const auto& entry) { return entry.display_name == "readme.txt"; }),
+               "non-module file listed");
+
+        auto linked = std::find_if(entries.begin(), entries.end(),
+                                   [](const auto& entry) { return entry.display_name == "linked.it"; });
+        expect(linked != entries.end() && linked->size == 5, "symlinked module missing or wrong size");
+        auto track = std::find_if(entries.begin(), entries.end(),
+                                  [](const auto& entry) { return entry.display_name == "track200.xm"; });
+        expect(track != entries.end() && track->size == 200 % 97, "module size not read");
+
+        auto progress = browser.scan_progress();
+        expect(!progress.scanning && progress.entries_seen == module_count + 3 &&
+                   progress.entries_listed == module_count + 2,
+               "unexpected scan progress");
+    }
+
+    // Sort modes re-sort in place and keep the cursor on the same file.
+    {
+        FileBrowser browser(root / "songs");
+        browser.set_metadata_lookup([](const fs::path& path, tracker::EntryMetadata& metadata) {
+            metadata.channels = static_cast<std::uint16_t>(path.filename().string().size());
+            return true;
+        });
+        expect(wait_for_scan(browser), "metadata scan did not finish");
+        browser.set_selected_index(10);
+        const fs::path selected = browser.get_selected_file();
+
+        browser.set_sort_mode(tracker::SortMode::Size);
+        const auto& entries = browser.entries();
+        expect(browser.get_selected_file() == selected, "selection lost on sort change");
+        auto first_file = std::find_if(entries.begin(), entries.end(), [](const auto& e) { return !e.is_directory; });
+        expect(first_file != entries.end() && first_file->size == 96, "size sort should put largest first");
+
+        browser.set_sort_mode(tracker::SortMode::Channels);
+        first_file = std::find_if(entries.begin(), entries.end(), [](const auto& e) { return !e.is_directory; });
+        expect(first_file != entries.end() && first_file->channels == std::string("track1000.MOD").size(),
+               "channel sort should use looked-up metadata");
+    }
+
+    // Collation keys sort without allocating per comparison.
+    {
+        expect(tracker::make_collation_key("Track2") < tracker::make_collation_key("track10"),
+               "natural order for numbers");
+        expect(tracker::make_collation_key("a007") == tracker::make_collation_key("A7"),
+               "leading zeros and case should fold");
+        expect(tracker::make_collation_key("b1") > tracker::make_collation_key("a99"), "prefix decides first");
+
+        std::vector<FileEntry> entries;
+        for (const char* name : {"Track10.xm", "track2.xm", "song 3.xm", "Song 0.xm", "..", "track1.xm"}) {
+            entries.emplace_back("/x", name, std::string(name) == "..", 0);
+        }
+        FileBrowser::sort_file_entries(entries, 1, tracker::SortMode::Name);
+        std::string order;
+        for (const auto& entry : entries) {
+            order += entry.display_name + "|";
+        }
+        expect(order == "Track10.xm|..|Song 0.xm|song 3.xm|track1.xm|track2.xm|",
+               "entries before the first sorted index moved, or names out of order: " + order);
+    }
+
+    // Navigating away mid-scan drops the old listing entirely.
+    {
+        FileBrowser browser(root / "songs");
+        browser.navigate_to(root / "other");
+        expect(wait_for_scan(browser), "second scan did not finish");
+        const auto& entries = browser.entries();
+        expect(entries.size() == 2 && entries[1].display_name == "only.it",
+               "stale entries after navigation: " + std::to_string(entries.size()));
+    }
+
+    {
+        FileBrowser browser(root / "songs");
+        browser.set_update_callback([] {});
+        browser.navigate_to(root / "missing");
+        expect(browser.has_error(), "missing directory not reported");
+    }
+
+    // Content detection lists files by their header, not their name.
+    {
+        fs::create_directories(root / "probe");
+        for (int i = 0; i < 40; ++i) {
+            std::ofstream(root / "probe" / ("renamed" + std::to_string(i)), std::ios::binary) << "MODULE data";
+        }
+        std::ofstream(root / "probe" / "mod.amiga", std::ios::binary) << "MODULE amiga";
+        std::ofstream(root / "probe" / "fake.xm", std::ios::binary) << "not a module";
+        std::ofstream(root / "probe" / "cached.s3m", std::ios::binary) << "not probed";
+
+        auto detector = std::make_shared<tracker::ModuleDetector>(
+            [](const std::uint8_t* header, std::size_t size, std::uint64_t) {
+                const std::string prefix(reinterpret_cast<const char*>(header), std::min<std::size_t>(size, 6));
+                return prefix == "MODULE" ? tracker::ProbeResult::Module : tracker::ProbeResult::NotModule;
+            },
+            4);
+        detector->set_cache([](const tracker::DetectionCandidate& candidate) -> std::optional<bool> {
+            if (candidate.path.filename() == "cached.s3m") {
+                return true;
+            }
+            return std::nullopt;
+        });
+
+        FileBrowser browser(root / "probe");
+        browser.set_detector(detector);
+        expect(wait_for_scan(browser), "content scan did not finish");
+        const auto& entries = browser.entries();
+        auto listed = [&entries](const std::string& name) {
+            return std::any_of(entries.begin(), entries.end(),
+                               [&name](const auto& entry) { return entry.display_name == name; });
+        };
+        expect(entries.size() == 1 + 40 + 2, "unexpected content-detected count " + std::to_string(entries.size()));
+        expect(listed("renamed7") && listed("mod.amiga"), "extensionless module not detected");
+        expect(!listed("fake.xm"), "non-module with module extension listed");
+        expect(listed("cached.s3m"), "cached detection result ignored");
+        expect(detector->probes_run() == 42, "unexpected probe count " + std::to_string(detector->probes_run()));
+        expect(FileBrowser::is_module_file("mod.amiga") && !FileBrowser::is_module_file("notes.txt"),
+               "Amiga-style prefix not recognised");
+    }
+
+    // Watched directories pick up new and deleted files without a rescan.
+    {
+        fs::create_directories(root / "watched");
+        write_file(root / "watched" / "b.mod", 10);
+        write_file(root / "watched" / "d.mod", 10);
+
+        FileBrowser browser(root / "watched");
+        browser.set_watching(true);
+        expect(wait_for_scan(browser), "watched scan did not finish");
+        browser.set_selected_index(2);
+        expect(browser.get_selected_file().filename() == "d.mod", "unexpected initial selection");
+
+        auto names = [&browser] {
+            std::string joined;
+            for (const auto& entry : browser.entries()) {
+                joined += entry.display_name + " ";
+            }
+            return joined;
+        };
+
+        // A burst of writes to one file is coalesced into a single insert.
+        {
+            std::ofstream file(root / "watched" / "a.mod", std::ios::binary);
+            for (int i = 0; i < 50; ++i) {
+                file << std::string(100, 'x') << std::flush;
+            }
+        }
+        write_file(root / "watched" / "c.mod", 10);
+        write_file(root / "watched" / "readme.txt", 10);
+        fs::create_directories(root / "watched" / "sub");
+        expect(poll_until(browser, [&] { return browser.entries().size() == 6; }), "inserts not applied: " + names());
+        expect(names() == ".. sub a.mod b.mod c.mod d.mod ", "unexpected watched order: " + names());
+        expect(browser.get_selected_file().filename() == "d.mod", "selection moved by inserts");
+        expect(!browser.scanning(), "watch changes triggered a rescan");
+        expect(browser.entries()[2].size == 5000, "coalesced insert has stale size");
+
+        fs::remove(root / "watched" / "d.mod");
+        fs::remove(root / "watched" / "a.mod");
+        expect(poll_until(browser, [&] { return browser.entries().size() == 4; }), "removals not applied: " + names());
+        expect(browser.selected_index() == 3 && browser.get_selected_file().filename() == "c.mod",
+               "selection not clamped after removal");
+
+        browser.set_watching(false);
+        write_file(root / "watched" / "e.mod", 10);
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        browser.poll();
+        expect(browser.entries().size() == 4, "unwatched directory still updated");
+    }
+
+    // Returning to a directory whose mtime is unchanged reuses its listing.
+    {
+        const auto settled = fs::file_time_type::clock::now() - std::chrono::hours(1);
+        fs::create_directories(root / "cache" / "a");
+        fs::create_directories(root / "cache" / "b");
+        write_file(root / "cache" / "a" / "a.mod", 10);
+        write_file(root / "cache" / "a" / "b.mod", 10);
+        write_file(root / "cache" / "b" / "c.mod", 10);
+        for (const auto& directory : {root / "cache", root / "cache" / "a", root / "cache" / "b"}) {
+            fs::last_write_time(directory, settled);
+        }
+
+        FileBrowser browser(root / "cache" / "a");
+        expect(wait_for_scan(browser), "cached directory scan did not finish");
+        browser.set_selected_index(2);
+        browser.navigate_to(root / "cache" / "b");
+        expect(wait_for_scan(browser), "second cached directory scan did not finish");
+        expect(browser.listing_cache_size() == 2, "unexpected cache size " + std::to_string(browser.listing_cache_size()));
+
+        browser.navigate_to(root / "cache" / "a");
+        expect(!browser.scanning() && browser.listing_cache_hits() == 1, "unchanged directory was rescanned");
+        expect(browser.entries().size() == 3 && browser.get_selected_file().filename() == "b.mod",
+               "cached listing or selection not restored");
+
+        write_file(root / "cache" / "b" / "d.mod", 10);
+        fs::last_write_time(root / "cache" / "b", settled + std::chrono::seconds(1));
+        browser.navigate_to(root / "cache" / "b");
+        expect(browser.scanning() && browser.listing_cache_hits() == 1, "changed directory served from cache");
+        expect(wait_for_scan(browser), "changed directory scan did not finish");
+        expect(browser.entries().size() == 3, "new file missing after rescan");
+
+        browser.set_listing_cache_capacity(1);
+        expect(browser.listing_cache_size() == 1, "cache not trimmed to its capacity");
+        browser.navigate_to(root / "cache" / "a");
+        expect(browser.scanning(), "evicted listing served from cache");
+        expect(wait_for_scan(browser), "evicted directory scan did not finish");
+
+        // Changes seen by the watcher drop the cached copy.
+        browser.set_watching(true);
+        expect(!browser.scanning() && browser.listing_cache_size() == 1, "watching discarded a valid listing");
+        write_file(root / "cache" / "a" / "e.mod", 10);
+        expect(poll_until(browser, [&] { return browser.entries().size() == 4; }), "watched insert not applied");
+        expect(browser.listing_cache_size() == 0, "watched change left a stale listing cached");
+    }
+
+    fs::remove_all(root);
+
+    return tracker::test::finish("file browser");
+}
@@ -0,0 +1,94 @@
+#include "frame_profiler.hpp"
+#include "test_support.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using tracker::CountingStreambuf;
+using tracker::FrameProfiler;
+using tracker::RollingHistogram;
+using tracker::test::expect;
+
+namespace {
+
+// Percentiles are bucket upper edges, a quarter octave wide.
+bool near(std::uint64_t reported, std::uint64_t actual) {
+    return reported >= actual && reported <= actual * 6 / 5 + 1;
+}
+
+}
+
+int main() {
+    {
+        RollingHistogram histogram;
+        expect(histogram.percentile(0.5) == 0 && histogram.size() == 0, "empty histogram reported a value");
+        for (std::uint64_t i = 1; i <= 100; ++i) {
+            histogram.add(i * 10);
+        }
+        expect(histogram.size() == 100, "unexpected sample count");
+        expect(near(histogram.percentile(0.5), 500), "p50 of 10..1000 was " + std::to_string(histogram.percentile(0.5)));
+        expect(near(histogram.percentile(0.99), 990), "p99 of 10..1000 was " + std::to_string(histogram.percentile(0.99)));
+        expect(histogram.percentile(0.0) >= 10 && histogram.percentile(0.0) <= 12, "p0 not at the minimum");
+    }
+
+    // Only the last kWindow samples count.
+    {
+        RollingHistogram histogram;
+        for (std::size_t i = 0; i < RollingHistogram::kWindow; ++i) {
+            histogram.add(100000);
+        }
+        for (std::size_t i = 0; i < RollingHistogram::kWindow; ++i) {
+            histogram.add(50);
+        }
+        expect(histogram.size() == RollingHistogram::kWindow, "window overflowed");
+        expect(near(histogram.percentile(0.99), 50), "old samples still in the window");
+
+        histogram.add(0);
+        expect(histogram.percentile(0.0) == 0, "zero not kept in its own bucket");
+        histogram.add(UINT64_MAX);
+        expect(histogram.percentile(1.0) > 100000, "huge sample not in the top bucket");
+    }
+
+    {
+        FrameProfiler profiler;
+        const std::size_t fast = profiler.add_phase("fast");
+        const std::size_t slow = profiler.add_phase("slow");
+        for (int i = 0; i < 50; ++i) {
+            profiler.record(fast, std::chrono::microseconds(20));
+            profiler.record(slow, std::chrono::milliseconds(3));
+            profiler.record_bytes(4096);
+        }
+        profiler.record(slow, std::chrono::microseconds(-5));
+        profiler.record(7, std::chrono::seconds(1));
+        const auto summary = profiler.summary();
+        expect(summary.size() == 2 && summary[0].name == "fast" && summary[1].name == "slow", "phases not in order");
+        expect(near(summary[0].p50_us, 20) && near(summary[1].p50_us, 3000), "unexpected phase percentiles");
+        expect(near(profiler.bytes_percentile(0.99), 4096) && profiler.frames() == 50, "unexpected byte percentiles");
+
+        {
+            FrameProfiler::Scope scope(profiler, fast);
+        }
+        expect(profiler.summary()[0].p50_us <= 25, "empty scope took longer than a phase");
+    }
+
+    // The counting buffer passes output through unchanged.
+    {
+        std::ostringstream sink;
+        CountingStreambuf counter(sink.rdbuf());
+        std::ostream out(&counter);
+        expect(counter.last_flush() == FrameProfiler::Clock::time_point{}, "flush recorded before any");
+        out << "frame" << '!' << std::string(1000, 'x');
+        out.flush();
+        expect(sink.str() == "frame!" + std::string(1000, 'x'), "output altered");
+        expect(counter.take_bytes() == 1006, "unexpected byte count");
+        expect(counter.take_bytes() == 0, "bytes not reset");
+        expect(counter.last_flush() != FrameProfiler::Clock::time_point{}, "flush not recorded");
+        counter.take_flush_time();
+        expect(counter.take_flush_time() == FrameProfiler::Clock::duration{}, "flush time not reset");
+    }
+
+    return tracker::test::finish("frame profiler");
+}
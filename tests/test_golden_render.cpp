@@ -0,0 +1,555 @@
+#include "offline_renderer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <libopenmpt/libopenmpt.hpp>
+
+// Golden-render regression harness.
+//
+// Every case renders a deterministic signal through the offline path and
+// records two fingerprints of the float PCM:
+//   * an exact FNV-1a hash of the sample bit patterns, and
+//   * a loudness signature: RMS of kSignatureSegments equal slices in
+//     0.1 dB buckets, matched with a tolerance of kSignatureTolerance buckets.
+// A case passes when the exact hash matches, or (unless --exact is given)
+// when every signature bucket is within tolerance. Module cases go through
+// OfflineRenderer and so depend on the libopenmpt build: a mismatch is only
+// a warning when the references name a different libopenmpt version, and a
+// case without a reference always fails.
+//
+//   golden_render_tests <references>            compare
+//   golden_render_tests <references> --exact    require bit-exact output
+//   golden_render_tests <references> --update   rewrite the references
+
+using namespace tracker;
+
+namespace {
+
+constexpr int kSampleRate = 48000;
+constexpr std::size_t kChunkFrames = 4096;
+constexpr std::size_t kSignatureSegments = 32;
+constexpr int kSignatureTolerance = 2;
+
+struct Fingerprint {
+    std::size_t frames{0};
+    std::uint64_t exact_hash{0};
+    std::vector<int> signature;
+};
+
+struct Reference {
+    Fingerprint fingerprint;
+};
+
+struct Case {
+    std::string name;
+    bool depends_on_library{false};
+    std::vector<float> pcm;
+    std::string error;
+};
+
+const std::array<std::pair<AudioEffect, const char *>, 7> kEffects = {{
+    {AudioEffect::None, "none"},
+    {AudioEffect::BassBoost, "bassboost"},
+    {AudioEffect::Echo, "echo"},
+    {AudioEffect::Reverb, "reverb"},
+    {AudioEffect::Flanger, "flanger"},
+    {AudioEffect::Phaser, "phaser"},
+    {AudioEffect::Chorus, "chorus"},
+}};
+
+const std::array<std::pair<int, const char *>, 4> kProfiles = {{
+    {1, "nearest"},
+    {2, "linear"},
+    {4, "cubic"},
+    {8, "sinc"},
+}};
+
+std::uint64_t fnv1a(const std::vector<float> &pcm) {
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    for (float sample : pcm) {
+        std::uint32_t bits;
+        std::memcpy(&bits, &sample, sizeof(bits));
+        for (int i = 0; i < 4; ++i) {
+            hash ^= (bits >> (i * 8)) & 0xFF;
+            hash *= 0x100000001b3ull;
+        }
+    }
+    return hash;
+}
+
+Fingerprint fingerprint(const std::vector<float> &pcm) {
+    Fingerprint result;
+    result.frames = pcm.size() / 2;
+    result.exact_hash = fnv1a(pcm);
+    result.signature.resize(kSignatureSegments, -1200);
+
+    for (std::size_t segment = 0; segment < kSignatureSegments; ++segment) {
+        std::size_t begin = result.frames * segment / kSignatureSegments;
+        std::size_t end = result.frames * (segment + 1) / kSignatureSegments;
+        if (end <= begin) {
+            continue;
+        }
+        double sum = 0.0;
+        for (std::size_t frame = begin; frame < end; ++frame) {
+            double mono = 0.5 * (static_cast<double>(pcm[frame * 2]) + static_cast<double>(pcm[frame * 2 + 1]));
+            sum += mono * mono;
+        }
+        double rms = std::sqrt(sum / static_cast<double>(end - begin));
+        double db = rms > 1e-6 ? 20.0 * std::log10(rms) : -120.0;
+        result.signature[segment] = static_cast<int>(std::lround(std::max(db, -120.0) * 10.0));
+    }
+    return result;
+}
+
+bool signature_within_tolerance(const Fingerprint &a, const Fingerprint &b) {
+    if (a.frames != b.frames || a.signature.size() != b.signature.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.signature.size(); ++i) {
+        if (std::abs(a.signature[i] - b.signature[i]) > kSignatureTolerance) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// --- Synthetic signal -------------------------------------------------------
+
+std::vector<float> render_synthetic(AudioEffect effect) {
+    const std::size_t total_frames = static_cast<std::size_t>(kSampleRate) * 2;
+    std::vector<float> pcm;
+    pcm.reserve(total_frames * 2);
+
+    AudioEffects effects(kSampleRate);
+    std::vector<float> chunk(kChunkFrames * 2);
+    std::uint32_t noise = 0x12345678u;
+
+    for (std::size_t start = 0; start < total_frames; start += kChunkFrames) {
+        std::size_t frames = std::min(kChunkFrames, total_frames - start);
+        for (std::size_t i = 0; i < frames; ++i) {
+            double t = static_cast<double>(start + i) / kSampleRate;
+            noise = noise * 1664525u + 1013904223u;
+            float burst = ((start + i) % 12000 < 600) ? static_cast<float>(noise >> 8) / 16777216.0f - 0.5f : 0.0f;
+            float tone = static_cast<float>(0.3 * std::sin(2.0 * M_PI * 110.0 * t) +
+                                            0.2 * std::sin(2.0 * M_PI * 440.0 * t) +
+                                            0.05 * std::sin(2.0 * M_PI * 3000.0 * t));
+            chunk[i * 2] = tone + burst * 0.4f;
+            chunk[i * 2 + 1] = tone * 0.8f - burst * 0.3f;
+        }
+        effects.apply_effects(chunk.data(), frames, effect);
+        pcm.insert(pcm.end(), chunk.begin(), chunk.begin() + static_cast<std::ptrdiff_t>(frames * 2));
+    }
+    return pcm;
+}
+
+// --- Generated ProTracker modules ------------------------------------------
+
+struct ModNote {
+    int period{0};
+    int sample{0};
+    int effect{0};
+    int param{0};
+};
+
+using ModPattern = std::array<std::array<ModNote, 4>, 64>;
+
+struct ModSample {
+    std::string name;
+    std::vector<std::int8_t> data;
+    int volume{64};
+    bool loop{false};
+};
+
+void put_be16(std::vector<std::uint8_t> &out, int value) {
+    out.push_back(static_cast<std::uint8_t>((value >> 8) & 0xFF));
+    out.push_back(static_cast<std::uint8_t>(value & 0xFF));
+}
+
+std::vector<std::uint8_t> build_mod(const std::string &title, const std::vector<ModSample> &samples,
+                                    const std::vector<ModPattern> &patterns, const std::vector<int> &orders) {
+    std::vector<std::uint8_t> out;
+    std::string padded_title = title;
+    padded_title.resize(20, '\0');
+    out.insert(out.end(), padded_title.begin(), padded_title.end());
+
+    for (std::size_t i = 0; i < 31; ++i) {
+        std::string name = i < samples.size() ? samples[i].name : std::string();
+        name.resize(22, '\0');
+        out.insert(out.end(), name.begin(), name.end());
+        if (i < samples.size()) {
+            int words = static_cast<int>(samples[i].data.size() / 2);
+            put_be16(out, words);
+            out.push_back(0);
+            out.push_back(static_cast<std::uint8_t>(samples[i].volume));
+            put_be16(out, 0);
+            put_be16(out, samples[i].loop ? words : 1);
+        } else {
+            put_be16(out, 0);
+            out.push_back(0);
+            out.push_back(0);
+            put_be16(out, 0);
+            put_be16(out, 1);
+        }
+    }
+
+    out.push_back(static_cast<std::uint8_t>(orders.size()));
+    out.push_back(0x7F);
+    for (std::size_t i = 0; i < 128; ++i) {
+        out.push_back(static_cast<std::uint8_t>(i < orders.size() ? orders[i] : 0));
+    }
+    out.insert(out.end(), {'M', '.', 'K', '.'});
+
+    for (const auto &pattern : patterns) {
+        for (const auto &row : pattern) {
+            for (const auto &note : row) {
+                out.push_back(static_cast<std::uint8_t>((note.sample & 0xF0) | ((note.period >> 8) & 0x0F)));
+                out.push_back(static_cast<std::uint8_t>(note.period & 0xFF));
+                out.push_back(static_cast<std::uint8_t>(((note.sample & 0x0F) << 4) | (note.effect & 0x0F)));
+                out.push_back(static_cast<std::uint8_t>(note.param));
+            }
+        }
+    }
+
+    for (const auto &sample : samples) {
+        for (std::int8_t value : sample.data) {
+            out.push_back(static_cast<std::uint8_t>(value));
+        }
+    }
+    return out;
+}
+
+std::vector<ModSample> make_samples() {
+    std::vector<ModSample> samples(4);
+
+    samples[0].name = "square";
+    samples[0].loop = true;
+    for (int i = 0; i < 64; ++i) {
+        samples[0].data.push_back(static_cast<std::int8_t>(i < 32 ? 60 : -60));
+    }
+
+    samples[1].name = "sine";
+    samples[1].loop = true;
+    for (int i = 0; i < 64; ++i) {
+        samples[1].data.push_back(static_cast<std::int8_t>(std::lround(100.0 * std::sin(2.0 * M_PI * i / 64.0))));
+    }
+
+    samples[2].name = "noise";
+    samples[2].volume = 48;
+    std::uint32_t state = 0xC0FFEEu;
+    for (int i = 0; i < 2048; ++i) {
+        state = state * 1103515245u + 12345u;
+        int value = (static_cast<int>((state >> 16) & 0xFF) - 128) * (2048 - i) / 2048;
+        samples[2].data.push_back(static_cast<std::int8_t>(value));
+    }
+
+    samples[3].name = "saw";
+    samples[3].loop = true;
+    for (int i = 0; i < 64; ++i) {
+        samples[3].data.push_back(static_cast<std::int8_t>(i * 4 - 128));
+    }
+
+    return samples;
+}
+
+constexpr std::array<int, 12> kPeriodsOctave2 = {428, 404, 381, 360, 339, 320, 302, 285, 269, 254, 240, 226};
+
+int period(int octave, int semitone) {
+    int value = kPeriodsOctave2[static_cast<std::size_t>(semitone)];
+    if (octave == 1) {
+        return value * 2;
+    }
+    if (octave == 3) {
+        return value / 2;
+    }
+    return value;
+}
+
+std::vector<std::uint8_t> make_melody_module() {
+    ModPattern pattern{};
+    const std::array<int, 8> melody = {0, 4, 7, 11, 12, 7, 4, 2};
+    for (int row = 0; row < 64; row += 4) {
+        int step = melody[static_cast<std::size_t>((row / 4) % 8)];
+        pattern[static_cast<std::size_t>(row)][0] = {period(step >= 12 ? 3 : 2, step % 12), 1, 0, 0};
+        if (row % 16 == 0) {
+            pattern[static_cast<std::size_t>(row)][1] = {period(1, (row / 16) % 2 == 0 ? 0 : 5), 4, 0, 0};
+        }
+        pattern[static_cast<std::size_t>(row + 2)][2] = {period(2, (step + 4) % 12), 2, 0xC, 32};
+    }
+    pattern[0][3] = {0, 0, 0xF, 5};
+    return build_mod("golden melody", make_samples(), {pattern}, {0});
+}
+
+std::vector<std::uint8_t> make_effects_module() {
+    ModPattern pattern{};
+    pattern[0][0] = {period(2, 0), 1, 0x0, 0x37};
+    for (int row = 1; row < 16; ++row) {
+        pattern[static_cast<std::size_t>(row)][0] = {0, 0, 0x0, 0x37};
+    }
+    pattern[0][1] = {period(2, 7), 2, 0x4, 0x48};
+    for (int row = 1; row < 32; ++row) {
+        pattern[static_cast<std::size_t>(row)][1] = {0, 0, 0x4, 0x00};
+    }
+    pattern[16][0] = {period(1, 0), 4, 0x0, 0x00};
+    pattern[20][0] = {period(3, 0), 0, 0x3, 0x08};
+    for (int row = 21; row < 40; ++row) {
+        pattern[static_cast<std::size_t>(row)][0] = {0, 0, 0x3, 0x00};
+    }
+    pattern[32][2] = {period(2, 4), 1, 0xC, 64};
+    for (int row = 33; row < 64; ++row) {
+        pattern[static_cast<std::size_t>(row)][2] = {0, 0, 0xA, 0x02};
+    }
+    pattern[48][3] = {period(2, 9), 2, 0x8, 0x20};
+    pattern[56][3] = {period(2, 9), 2, 0x8, 0xE0};
+    pattern[0][3] = {0, 0, 0xF, 4};
+    return build_mod("golden effects", make_samples(), {pattern}, {0});
+}
+
+std::vector<std::uint8_t> make_drums_module() {
+    ModPattern beat{};
+    ModPattern fill{};
+    for (int row = 0; row < 64; row += 8) {
+        beat[static_cast<std::size_t>(row)][0] = {period(1, 0), 3, 0, 0};
+        beat[static_cast<std::size_t>(row + 4)][1] = {period(3, 0), 3, 0xC, 24};
+    }
+    for (int row = 0; row < 64; row += 2) {
+        fill[static_cast<std::size_t>(row)][row % 4 == 0 ? 0 : 1] = {period(row % 8 < 4 ? 2 : 3, row % 12), 3, 0, 0};
+        fill[static_cast<std::size_t>(row)][2] = {period(1, (row / 8) % 12), 4, 0xC, 40};
+    }
+    beat[0][3] = {0, 0, 0xF, 3};
+    fill[0][3] = {0, 0, 0xF, 3};
+    return build_mod("golden drums", make_samples(), {beat, fill}, {0, 1, 0});
+}
+
+// --- Reference file ---------------------------------------------------------
+
+std::string signature_to_string(const std::vector<int> &signature) {
+    std::ostringstream oss;
+    for (std::size_t i = 0; i < signature.size(); ++i) {
+        oss << (i ? "," : "") << signature[i];
+    }
+    return oss.str();
+}
+
+std::vector<int> signature_from_string(const std::string &text) {
+    std::vector<int> signature;
+    std::istringstream iss(text);
+    std::string token;
+    while (std::getline(iss, token, ',')) {
+        signature.push_back(std::stoi(token));
+    }
+    return signature;
+}
+
+bool load_references(const std::filesystem::path &path, std::string &library_version,
+                     std::map<std::string, Reference> &references) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream iss(line);
+        std::string key;
+        iss >> key;
+        if (key == "libopenmpt") {
+            iss >> library_version;
+            continue;
+        }
+        Reference reference;
+        std::string hash;
+        std::string signature;
+        iss >> reference.fingerprint.frames >> hash >> signature;
+        reference.fingerprint.exact_hash = std::stoull(hash, nullptr, 16);
+        reference.fingerprint.signature = signature_from_string(signature);
+        references[key] = reference;
+    }
+    return true;
+}
+
+bool save_references(const std::filesystem::path &path, const std::string &library_version,
+                     const std::vector<Case> &cases) {
+    std::ofstream file(path);
+    if (!file) {
+        return false;
+    }
+    file << "# cli-modplayer golden render references (regenerate with --update)\n";
+    file << "# <case> <frames> <fnv1a64 of float PCM> <per-segment RMS in 0.1 dB>\n";
+    file << "libopenmpt " << library_version << "\n";
+    for (const auto &c : cases) {
+        if (!c.error.empty()) {
+            continue;
+        }
+        Fingerprint fp = fingerprint(c.pcm);
+        file << c.name << ' ' << fp.frames << ' ' << std::hex << std::setw(16) << std::setfill('0')
+             << fp.exact_hash << std::dec << ' ' << signature_to_string(fp.signature) << '\n';
+    }
+    return true;
+}
+
+std::string library_version() {
+    try {
+        return openmpt::string::get("library_version");
+    } catch (...) {
+        return "unknown";
+    }
+}
+
+std::vector<Case> render_cases(const std::filesystem::path &work_dir) {
+    std::vector<Case> cases;
+
+    for (const auto &[effect, effect_name] : kEffects) {
+        Case c;
+        c.name = std::string("synthetic/") + effect_name;
+        c.pcm = render_synthetic(effect);
+        cases.push_back(std::move(c));
+    }
+
+    const std::vector<std::pair<std::string, std::vector<std::uint8_t>>> modules = {
+        {"melody", make_melody_module()},
+        {"effects", make_effects_module()},
+        {"drums", make_drums_module()},
+    };
+
+    for (const auto &[module_name, bytes] : modules) {
+        auto module_path = work_dir / (module_name + ".mod");
+        {
+            std::ofstream out(module_path, std::ios::binary);
+            out.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        }
+
+        for (const auto &[filter_length, profile_name] : kProfiles) {
+            for (const auto &[effect, effect_name] : kEffects) {
+                Case c;
+                c.name = module_name + "/" + profile_name + "/" + effect_name;
+                c.depends_on_library = true;
+
+                ExportOptions options;
+                options.sample_rate = kSampleRate;
+                options.channels = 2;
+                options.effect = effect;
+                options.interpolation_filter_length = filter_length;
+
+                OfflineRenderer renderer(module_path.string());
+                if (!renderer.render(options, c.pcm, c.error) && c.error.empty()) {
+                    c.error = "render failed";
+                }
+                cases.push_back(std::move(c));
+            }
+        }
+    }
+
+    return cases;
+}
+
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "usage: golden_render_tests <references> [--update] [--exact]" << std::endl;
+        return 2;
+    }
+
+    const std::filesystem::path reference_path = argv[1];
+    bool update = false;
+    bool exact = false;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--update") update = true;
+        else if (arg == "--exact") exact = true;
+    }
+
+    auto work_dir = std::filesystem::temp_directory_path() / "cli-modplayer-golden";
+    std::filesystem::create_directories(work_dir);
+
+    const std::string version = library_version();
+    std::vector<Case> cases = render_cases(work_dir);
+    std::filesystem::remove_all(work_dir);
+
+    int failures = 0;
+    for (const auto &c : cases) {
+        if (!c.error.empty()) {
+            std::cout << "FAIL     " << c.name << ": " << c.error << std::endl;
+            ++failures;
+        }
+    }
+
+    if (update) {
+        if (!save_references(reference_path, version, cases)) {
+            std::cerr << "Unable to write " << reference_path << std::endl;
+            return 1;
+        }
+        std::cout << "Wrote " << cases.size() << " references to " << reference_path << std::endl;
+        return failures == 0 ? 0 : 1;
+    }
+
+    std::string reference_version;
+    std::map<std::string, Reference> references;
+    if (!load_references(reference_path, reference_version, references)) {
+        std::cerr << "Unable to read " << reference_path << std::endl;
+        return 1;
+    }
+    const bool library_differs = !reference_version.empty() && reference_version != version;
+    if (library_differs) {
+        std::cout << "note: references were recorded with libopenmpt " << reference_version << ", running "
+                  << version << "; module mismatches are reported as warnings" << std::endl;
+    }
+
+    int passed = 0;
+    int tolerated = 0;
+    int missing = 0;
+    int warnings = 0;
+    for (const auto &c : cases) {
+        if (!c.error.empty()) {
+            continue;
+        }
+        auto it = references.find(c.name);
+        if (it == references.end()) {
+            // A case without a reference guards nothing; record it with --update.
+            std::cout << "MISSING  " << c.name << std::endl;
+            ++missing;
+            ++failures;
+            continue;
+        }
+
+        Fingerprint actual = fingerprint(c.pcm);
+        const Fingerprint &expected = it->second.fingerprint;
+        if (actual.frames == expected.frames && actual.exact_hash == expected.exact_hash) {
+            ++passed;
+            continue;
+        }
+        if (!exact && signature_within_tolerance(actual, expected)) {
+            std::cout << "TOLERATE " << c.name << " (not bit-exact, within " << kSignatureTolerance
+                      << " x 0.1 dB per segment)" << std::endl;
+            ++tolerated;
+            continue;
+        }
+
+        const bool warn_only = c.depends_on_library && library_differs;
+        std::cout << (warn_only ? "WARN     " : "FAIL     ") << c.name << ": frames " << actual.frames << " vs "
+                  << expected.frames << ", signature " << signature_to_string(actual.signature) << std::endl;
+        if (warn_only) {
+            ++warnings;
+        } else {
+            ++failures;
+        }
+    }
+
+    std::cout << passed << " exact, " << tolerated << " within tolerance, " << warnings << " warnings, "
+              << missing << " without reference, " << failures << " failed" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
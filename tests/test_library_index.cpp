@@ -0,0 +1,359 @@
+#include "library_indexer.hpp"
+#include "test_support.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <unistd.h>
+
+using tracker::LibraryIndex;
+using tracker::LibraryIndexer;
+using tracker::LibraryRecord;
+using tracker::test::expect;
+
+namespace {
+
+void write_file(const std::filesystem::path& path, const std::string& contents) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << contents;
+}
+
+// Files starting with "MOD" parse; the rest of the first line is the title.
+bool fake_reader(const std::uint8_t* data, std::size_t size, LibraryRecord& record, std::string& error_message) {
+    std::string text(reinterpret_cast<const char*>(data), size);
+    if (text.rfind("MOD", 0) != 0) {
+        error_message = "not a module";
+        return false;
+    }
+    record.title = text.substr(3, text.find('\n') == std::string::npos ? std::string::npos : text.find('\n') - 3);
+    record.format = "mod";
+    record.tracker = "Fake Tracker";
+    record.channels = 4;
+    record.patterns = static_cast<std::uint16_t>(size);
+    record.duration_ms = 1000;
+    return true;
+}
+
+}
+
+int main() {
+    namespace fs = std::filesystem;
+    const fs::path root = fs::temp_directory_path() / ("library_index_test_" + std::to_string(::getpid()));
+    fs::remove_all(root);
+    fs::create_directories(root / "music" / "nested");
+    const fs::path index_path = root / "cache" / "library.idx";
+
+    const std::size_t module_count = 300;
+    for (std::size_t i = 0; i < module_count; ++i) {
+        write_file(root / "music" / ("song" + std::to_string(i) + ".mod"), "MODSong " + std::to_string(i) + "\n");
+    }
+    write_file(root / "music" / "nested" / "broken.xm", "garbage");
+    write_file(root / "music" / "notes.txt", "MODignored");
+
+    std::atomic<std::size_t> parse_calls{0};
+    LibraryIndexer indexer([&parse_calls](const std::uint8_t* data, std::size_t size, LibraryRecord& record,
+                                          std::string& error_message) {
+        ++parse_calls;
+        return fake_reader(data, size, record, error_message);
+    });
+
+    std::string error;
+    LibraryIndex empty;
+    std::vector<LibraryRecord> records;
+    expect(indexer.update({root / "music"}, empty, records, error), "initial index failed: " + error);
+    expect(records.size() == module_count + 1, "unexpected record count " + std::to_string(records.size()));
+    expect(indexer.stats().parsed == module_count && indexer.stats().failed == 1, "unexpected parse counts");
+    expect(LibraryIndex::write(index_path, records, error), "write failed: " + error);
+
+    LibraryIndex index;
+    expect(index.open(index_path, error), "open failed: " + error);
+    expect(index.size() == module_count + 1, "mapped record count mismatch");
+    for (std::size_t i = 1; i < index.size(); ++i) {
+        expect(index.entry(i - 1).path < index.entry(i).path, "records not sorted by path");
+    }
+
+    const std::string song7 = (root / "music" / "song7.mod").string();
+    auto found = index.find(song7);
+    expect(found.has_value(), "song7 not found");
+    if (found) {
+        auto entry = index.entry(*found);
+        expect(entry.title == "Song 7", "title not stored: " + std::string(entry.title));
+        expect(entry.tracker == "Fake Tracker" && entry.channels == 4 && entry.duration_ms == 1000,
+               "metadata not stored");
+        expect(entry.flags & LibraryRecord::kMetadataValid, "valid flag missing");
+        expect(entry.content_hash != 0 && entry.size == std::string("MODSong 7\n").size(), "size/hash missing");
+    }
+    auto broken = index.find((root / "music" / "nested" / "broken.xm").string());
+    expect(broken && !(index.entry(*broken).flags & LibraryRecord::kMetadataValid), "broken file not recorded");
+    expect(!index.find((root / "music" / "notes.txt").string()), "non-module file indexed");
+
+    // Unchanged files are reused from the mapping; only touched files reparse.
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    write_file(root / "music" / "song7.mod", "MODRenamed Song\n");
+    fs::remove(root / "music" / "song8.mod");
+    write_file(root / "music" / "nested" / "new.it", "MODFresh\n");
+
+    parse_calls = 0;
+    expect(indexer.update({root / "music"}, index, records, error), "incremental index failed: " + error);
+    expect(parse_calls == 2, "expected 2 reparses, got " + std::to_string(parse_calls));
+    expect(indexer.stats().reused == module_count - 2 + 1, "unexpected reuse count");
+    expect(indexer.stats().removed == 1, "removed file not counted");
+    expect(LibraryIndex::write(index_path, records, error), "rewrite failed: " + error);
+
+    // The old mapping survives the rename; reopening picks up the new file.
+    expect(index.entry(*index.find(song7)).title == "Song 7", "old mapping changed under reader");
+    expect(index.open(index_path, error), "reopen failed: " + error);
+    expect(index.size() == module_count + 1, "record count after update");
+    expect(index.find(song7) && index.entry(*index.find(song7)).title == "Renamed Song", "changed file not reparsed");
+    expect(!index.find((root / "music" / "song8.mod").string()), "deleted file still indexed");
+
+    // Content detection probes every file once and records the verdict.
+    auto detector = std::make_shared<tracker::ModuleDetector>(
+        [](const std::uint8_t* header, std::size_t size, std::uint64_t) {
+            return size >= 3 && std::string(reinterpret_cast<const char*>(header), 3) == "MOD"
+                       ? tracker::ProbeResult::Module
+                       : tracker::ProbeResult::NotModule;
+        });
+    indexer.set_detector(detector);
+    write_file(root / "music" / "nested" / "mod.amiga_tune", "MODAmiga\n");
+    write_file(root / "music" / "cover.jpg", "JFIF");
+    parse_calls = 0;
+    expect(indexer.update({root / "music"}, index, records, error), "content index failed: " + error);
+    expect(indexer.stats().not_modules == 2, "non-modules not recorded");
+    expect(parse_calls == module_count + 2, "extension-only records should be reparsed once");
+    expect(LibraryIndex::write(index_path, records, error), "content rewrite failed: " + error);
+    expect(index.open(index_path, error), "content reopen failed: " + error);
+
+    auto cover = index.find((root / "music" / "cover.jpg").string());
+    expect(cover && !LibraryRecord::is_listed_module(index.entry(*cover).flags), "cover.jpg should be a non-module");
+    auto amiga = index.find((root / "music" / "nested" / "mod.amiga_tune").string());
+    expect(amiga && LibraryRecord::is_listed_module(index.entry(*amiga).flags) &&
+               index.entry(*amiga).title == "Amiga",
+           "prefix-named module not detected");
+    broken = index.find((root / "music" / "nested" / "broken.xm").string());
+    expect(broken && !LibraryRecord::is_listed_module(index.entry(*broken).flags),
+           "garbage with module extension should not be listed");
+
+    const std::size_t probes_before = detector->probes_run();
+    parse_calls = 0;
+    expect(indexer.update({root / "music"}, index, records, error), "cached content index failed: " + error);
+    expect(detector->probes_run() == probes_before && parse_calls == 0, "unchanged files probed again");
+    expect(indexer.stats().reused == module_count + 4, "unexpected reuse count with detection");
+
+    // Watcher changes update only the touched paths; nothing else is stat'd.
+    {
+        using tracker::DirectoryChange;
+        fs::remove(root / "music" / "song0.mod");
+        write_file(root / "music" / "song1.mod", "MODRetitled\n");
+        fs::create_directories(root / "music" / "dropped");
+        write_file(root / "music" / "dropped" / "one.mod", "MODOne\n");
+        write_file(root / "music" / "dropped" / "two.mod", "MODTwo\n");
+        fs::remove_all(root / "music" / "nested");
+
+        const std::vector<DirectoryChange> changes = {
+            {root / "music" / "song0.mod", DirectoryChange::Kind::Removed, false},
+            {root / "music" / "song1.mod", DirectoryChange::Kind::Upsert, false},
+            {root / "music" / "dropped", DirectoryChange::Kind::Upsert, true},
+            {root / "music" / "nested", DirectoryChange::Kind::Removed, true},
+        };
+        parse_calls = 0;
+        expect(indexer.apply_changes(index, changes, records, error), "apply_changes failed: " + error);
+        expect(parse_calls == 3, "expected 3 parses for changes, got " + std::to_string(parse_calls));
+        expect(indexer.stats().files_seen == 3 && indexer.stats().removed == 4,
+               "unexpected change stats: removed " + std::to_string(indexer.stats().removed));
+        expect(LibraryIndex::write(index_path, records, error), "change rewrite failed: " + error);
+        expect(index.open(index_path, error), "change reopen failed: " + error);
+        expect(index.size() == module_count + 4 - 4 + 2, "record count after changes " + std::to_string(index.size()));
+        expect(!index.find((root / "music" / "song0.mod").string()), "removed file kept");
+        expect(!index.find((root / "music" / "nested" / "new.it").string()), "removed directory contents kept");
+        auto retitled = index.find((root / "music" / "song1.mod").string());
+        expect(retitled && index.entry(*retitled).title == "Retitled", "upserted file not reparsed");
+        expect(index.find((root / "music" / "dropped" / "two.mod").string()).has_value(), "new directory not walked");
+        expect(index.find((root / "music" / "song2.mod").string()).has_value(), "unchanged record dropped");
+    }
+
+    // Duplicates are confirmed by size, then head/tail, then full contents.
+    {
+        fs::create_directories(root / "dups" / "a");
+        fs::create_directories(root / "dups" / "b");
+        std::string large = "MODLarge\n" + std::string(20000, 'x');
+        std::string middle_differs = large;
+        middle_differs[10000] = 'y';
+        std::string head_differs = large;
+        head_differs[5] = 'y';
+        write_file(root / "dups" / "a" / "large.mod", large);
+        write_file(root / "dups" / "b" / "copy of large.mod", large);
+        write_file(root / "dups" / "b" / "large.xm", large);
+        write_file(root / "dups" / "middle.mod", middle_differs);
+        write_file(root / "dups" / "head.mod", head_differs);
+        write_file(root / "dups" / "small.mod", "MODSmall\n");
+        write_file(root / "dups" / "a" / "small.s3m", "MODSmall\n");
+        write_file(root / "dups" / "unique.mod", "MODUnique\n");
+
+        LibraryIndexer dedup_indexer(fake_reader);
+        LibraryIndex none;
+        std::vector<LibraryRecord> dedup_records;
+        expect(dedup_indexer.update({root / "dups"}, none, dedup_records, error), "dedup index failed: " + error);
+        const auto& groups = dedup_indexer.duplicates();
+        expect(groups.size() == 2, "expected 2 duplicate groups, got " + std::to_string(groups.size()));
+        if (groups.size() == 2) {
+            expect(groups[0].paths.size() == 3 && groups[0].reclaimable_bytes() == 2 * large.size(),
+                   "large group should come first with two spare copies");
+            expect(groups[1].paths.size() == 2, "small files not grouped");
+        }
+        expect(dedup_indexer.stats().duplicate_files == 5 &&
+                   dedup_indexer.stats().reclaimable_bytes == 2 * large.size() + std::string("MODSmall\n").size(),
+               "unexpected duplicate totals");
+
+        // Fresh content hashes from the parse stand in for a second read.
+        tracker::DuplicateFinder finder(2);
+        finder.find(dedup_records);
+        expect(finder.stats().size_matches == 7, "unexpected size matches " + std::to_string(finder.stats().size_matches));
+        expect(finder.stats().partial_matches == 6, "head difference should be ruled out by the partial hash");
+        expect(finder.stats().hashes_reused == 4 && finder.stats().full_hashed == 0, "indexed hashes not reused");
+        expect(finder.stats().groups == 2, "stats disagree with groups");
+
+        for (auto& record : dedup_records) {
+            record.content_hash = 0;
+        }
+        finder.find(dedup_records);
+        expect(finder.stats().full_hashed == 4 && finder.stats().groups == 2, "full hashing without index hashes");
+
+        const fs::path dedup_path = root / "cache" / "dups.idx";
+        expect(LibraryIndex::write(dedup_path, dedup_records, error), "dedup write failed: " + error);
+        LibraryIndex dedup_index;
+        expect(dedup_index.open(dedup_path, error), "dedup open failed: " + error);
+        const auto stored = tracker::DuplicateFinder::groups_from_index(dedup_index);
+        expect(stored.size() == 2 && stored[0].paths.size() == 3 && stored[1].paths.size() == 2,
+               "stored groups do not round-trip");
+        auto unique = dedup_index.find((root / "dups" / "unique.mod").string());
+        expect(unique && dedup_index.entry(*unique).duplicate_group == 0, "unique file grouped");
+    }
+
+    // The pool runs every item exactly once even with uneven item costs.
+    {
+        tracker::WorkStealingPool pool(4);
+        std::vector<std::atomic<int>> visits(1000);
+        pool.run(visits.size(), [&visits](std::size_t index, std::size_t) {
+            if (index < 10) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+            ++visits[index];
+        });
+        bool once = true;
+        for (const auto& count : visits) {
+            once = once && count.load() == 1;
+        }
+        expect(once, "work-stealing pool skipped or repeated an item");
+    }
+
+    // The memory cap bounds how many file bytes are resident at once.
+    {
+        std::vector<tracker::DetectionCandidate> candidates;
+        for (std::size_t i = 0; i < 64; ++i) {
+            tracker::DetectionCandidate candidate;
+            candidate.path = root / "music" / ("song" + std::to_string(i + 100) + ".mod");
+            candidate.size = fs::file_size(candidate.path);
+            candidates.push_back(candidate);
+        }
+        tracker::ExtractorOptions options;
+        options.threads = 4;
+        options.memory_cap_bytes = 40;
+        tracker::MetadataExtractor extractor(fake_reader, options);
+        std::vector<LibraryRecord> extracted;
+        extractor.extract(candidates, 0, extracted);
+        expect(extracted.size() == candidates.size() && extractor.stats().parsed == candidates.size(),
+               "extractor did not parse every file");
+        expect(extracted[5].path == candidates[5].path.string() && extracted[5].title == "Song 105",
+               "extracted records out of order");
+        expect(extractor.stats().peak_bytes_in_flight <= options.memory_cap_bytes, "memory cap exceeded");
+        expect(extractor.stats().files_per_second() > 0.0, "files/second not reported");
+    }
+
+    // With envelopes on, modules indexed without one are parsed once more
+    // and the levels survive the round trip through the index.
+    {
+        std::atomic<std::size_t> envelope_calls{0};
+        LibraryIndexer envelope_indexer([&envelope_calls](const std::uint8_t* data, std::size_t size,
+                                                          LibraryRecord& record, std::string& error_message) {
+            ++envelope_calls;
+            record.flags |= LibraryRecord::kEnvelopeChecked;
+            if (!fake_reader(data, size, record, error_message)) {
+                return false;
+            }
+            record.envelope = std::string("\x00\x80\xff", 3);
+            return true;
+        });
+        envelope_indexer.set_envelopes(true);
+        const fs::path envelope_path = root / "cache" / "envelopes.idx";
+        std::vector<LibraryRecord> envelope_records;
+        expect(envelope_indexer.update({root / "music"}, index, envelope_records, error),
+               "envelope index failed: " + error);
+        const bool all_checked =
+            std::all_of(envelope_records.begin(), envelope_records.end(), [](const LibraryRecord& record) {
+                return (record.flags & LibraryRecord::kEnvelopeChecked) ||
+                       !LibraryRecord::is_listed_module(record.flags);
+            });
+        expect(envelope_calls > 0 && all_checked, "modules without envelopes not reparsed");
+        expect(LibraryIndex::write(envelope_path, envelope_records, error), "envelope write failed: " + error);
+
+        LibraryIndex envelope_index;
+        expect(envelope_index.open(envelope_path, error), "envelope index open failed: " + error);
+        auto song = envelope_index.find(song7);
+        expect(song && envelope_index.entry(*song).envelope == std::string_view("\x00\x80\xff", 3),
+               "envelope not stored");
+
+        envelope_calls = 0;
+        expect(envelope_indexer.update({root / "music"}, envelope_index, envelope_records, error),
+               "second envelope index failed: " + error);
+        expect(envelope_calls == 0, "checked records reparsed: " + std::to_string(envelope_calls));
+    }
+
+    // A root that cannot be read keeps its records instead of losing them.
+    {
+        fs::create_directories(root / "extra");
+        write_file(root / "extra" / "a.mod", "MODExtra A\n");
+        write_file(root / "extra" / "b.mod", "MODExtra B\n");
+        const fs::path roots_path = root / "cache" / "roots.idx";
+        std::vector<LibraryRecord> root_records;
+        expect(indexer.update({root / "music", root / "extra"}, index, root_records, error),
+               "two-root index failed: " + error);
+        const std::size_t full_count = root_records.size();
+        expect(LibraryIndex::write(roots_path, root_records, error), "two-root write failed: " + error);
+        LibraryIndex roots_index;
+        expect(roots_index.open(roots_path, error), "two-root open failed: " + error);
+
+        fs::rename(root / "extra", root / "extra_offline");
+        expect(indexer.update({root / "music", root / "extra"}, roots_index, root_records, error),
+               "index with an unreadable root failed: " + error);
+        expect(indexer.stats().failed_roots == 1 && error.find("extra") != std::string::npos,
+               "unreadable root not reported: " + error);
+        expect(indexer.stats().removed == 0 && root_records.size() == full_count,
+               "unreadable root dropped records: removed " + std::to_string(indexer.stats().removed));
+        const std::string extra_a = (root / "extra" / "a.mod").string();
+        expect(std::any_of(root_records.begin(), root_records.end(),
+                           [&](const LibraryRecord& record) {
+                               return record.path == extra_a && record.title == "Extra A";
+                           }),
+               "unreadable root lost its metadata");
+
+        expect(!indexer.update({root / "extra"}, roots_index, root_records, error), "only root unreadable accepted");
+        fs::rename(root / "extra_offline", root / "extra");
+    }
+
+    write_file(root / "corrupt.idx", std::string(100, 'z'));
+    expect(!index.open(root / "corrupt.idx", error), "corrupt index accepted");
+    expect(!index.is_open(), "failed open left index mapped");
+
+    fs::remove_all(root);
+
+    return tracker::test::finish("library index");
+}
@@ -0,0 +1,167 @@
+#include "library_query.hpp"
+#include "test_support.hpp"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using tracker::LibraryColumns;
+using tracker::LibraryIndex;
+using tracker::LibraryQuery;
+using tracker::LibraryRecord;
+using tracker::QueryField;
+using tracker::QueryOp;
+using tracker::test::expect;
+
+namespace {
+
+LibraryRecord make_record(const std::string& path, const std::string& title, const std::string& artist,
+                          const std::string& format, const std::string& tracker, std::uint16_t channels,
+                          std::uint32_t duration_ms) {
+    LibraryRecord record;
+    record.path = path;
+    record.title = title;
+    record.artist = artist;
+    record.format = format;
+    record.tracker = tracker;
+    record.channels = channels;
+    record.patterns = static_cast<std::uint16_t>(channels * 4);
+    record.duration_ms = duration_ms;
+    record.size = duration_ms / 10;
+    record.flags = LibraryRecord::kMetadataValid;
+    return record;
+}
+
+std::vector<std::string> run(const LibraryIndex& index, const LibraryColumns& columns, const std::string& text) {
+    LibraryQuery query;
+    std::string error;
+    std::vector<std::string> paths;
+    if (!LibraryQuery::parse(text, query, error)) {
+        expect(false, "query '" + text + "' failed to parse: " + error);
+        return paths;
+    }
+    for (std::uint32_t row : columns.execute(query)) {
+        paths.emplace_back(index.entry(row).path);
+    }
+    return paths;
+}
+
+void test_parse() {
+    LibraryQuery query;
+    std::string error;
+    expect(LibraryQuery::parse("ch=4 format:MOD duration<3:00 artist~\"Purple Motion\" sort:-duration limit:5 debris",
+                               query, error),
+           "full query parses: " + error);
+    expect(query.predicates.size() == 4, "four predicates");
+    if (query.predicates.size() == 4) {
+        expect(query.predicates[0].field == QueryField::Channels && query.predicates[0].number == 4, "channel predicate");
+        expect(query.predicates[1].op == QueryOp::Contains && query.predicates[1].text == "mod",
+               "field:value means contains for text and values are lowercased");
+        expect(query.predicates[2].op == QueryOp::Less && query.predicates[2].number == 180000, "m:ss durations");
+        expect(query.predicates[3].text == "purple motion", "quoted values keep their spaces");
+    }
+    expect(query.sort_field == QueryField::Duration && query.descending, "descending sort");
+    expect(query.limit == 5, "limit");
+    expect(query.words.size() == 1 && query.words[0] == "debris", "bare words are kept");
+
+    expect(LibraryQuery::parse("size>=1.5mb duration>90s length<=2m", query, error), "units parse: " + error);
+    if (query.predicates.size() == 3) {
+        expect(query.predicates[0].number == 1572864, "size suffixes");
+        expect(query.predicates[1].number == 90000, "seconds suffix");
+        expect(query.predicates[2].number == 120000, "minutes suffix");
+    }
+
+    expect(!LibraryQuery::parse("bpm=125", query, error), "unknown fields are rejected");
+    expect(!LibraryQuery::parse("artist<b", query, error), "text fields reject ordering");
+    expect(!LibraryQuery::parse("channels~4", query, error), "numeric fields reject contains");
+    expect(!LibraryQuery::parse("duration<soon", query, error), "bad durations are rejected");
+
+    expect(LibraryQuery::is_structured("ch=4"), "field terms are structured");
+    expect(LibraryQuery::is_structured("space sort:title"), "sort terms are structured");
+    expect(!LibraryQuery::is_structured("space debris"), "plain words go to fuzzy search");
+    expect(!LibraryQuery::is_structured("mix:final"), "unknown names stay fuzzy");
+}
+
+}
+
+int main() {
+    namespace fs = std::filesystem;
+    const fs::path root = fs::temp_directory_path() / ("library_query_test_" + std::to_string(::getpid()));
+    fs::remove_all(root);
+    const fs::path index_path = root / "library.idx";
+
+    test_parse();
+
+    const char* artists[] = {"Purple Motion", "Skaven", "Jester", "Lizardking", "Necros", "Captain", "Jogeir Liljedahl"};
+    const char* formats[] = {"mod", "s3m", "xm", "it"};
+    const char* trackers[] = {"ProTracker", "Scream Tracker 3", "FastTracker 2", "Impulse Tracker"};
+    const std::size_t filler_count = 2000;
+    std::vector<LibraryRecord> records;
+    records.reserve(filler_count + 5);
+    for (std::size_t i = 0; i < filler_count; ++i) {
+        const std::size_t kind = i % 4;
+        records.push_back(make_record("/mods/filler/f" + std::to_string(i) + "." + formats[kind],
+                                      "Filler " + std::to_string(i), artists[i % 7], formats[kind], trackers[kind],
+                                      static_cast<std::uint16_t>(4 + 4 * (i % 8)),
+                                      static_cast<std::uint32_t>(200000 + i % 400000)));
+    }
+    records.push_back(make_record("/mods/captain/space_debris.mod", "Space Debris", "Captain", "mod", "ProTracker", 4,
+                                  352000));
+    records.push_back(make_record("/mods/jester/stardust.mod", "Stardust Memories", "Jester", "mod", "ProTracker", 4,
+                                  170000));
+    records.push_back(make_record("/mods/jester/elysium.mod", "Elysium", "Jester", "mod", "ProTracker", 4, 150000));
+    // Indexed with --no-duration, or the render failed: length unknown.
+    records.push_back(make_record("/mods/jester/untimed.mod", "Untimed", "Jester", "mod", "ProTracker", 4, 0));
+    LibraryRecord probed = make_record("/mods/other/readme.mod", "", "Jester", "mod", "ProTracker", 4, 1000);
+    probed.flags |= LibraryRecord::kProbed;
+    records.push_back(probed);
+
+    std::string error;
+    expect(LibraryIndex::write(index_path, records, error), "write failed: " + error);
+    LibraryIndex index;
+    expect(index.open(index_path, error), "open failed: " + error);
+
+    LibraryColumns columns(index);
+    expect(columns.size() == records.size(), "one row per record");
+    expect(columns.distinct_artists() == 7, "artists are dictionary encoded");
+
+    auto paths = run(index, columns, "channels=4 format=mod duration<3:00 artist=jester");
+    expect(paths.size() == 2, "the short 4-channel Jester MODs match");
+    if (paths.size() == 2) {
+        expect(paths[0] == "/mods/jester/elysium.mod" && paths[1] == "/mods/jester/stardust.mod",
+               "results default to path order");
+    }
+
+    paths = run(index, columns, "path~/mods/jester/ duration!=2:30");
+    expect(paths.size() == 1 && paths[0] == "/mods/jester/stardust.mod", "unknown durations never compare");
+    paths = run(index, columns, "duration=0");
+    expect(paths.empty(), "unknown durations are not zero-length");
+
+    paths = run(index, columns, "channels=4 format=mod duration<3:00 artist=jester sort:-duration");
+    expect(paths.size() == 2 && paths[0] == "/mods/jester/stardust.mod", "descending duration sort");
+
+    paths = run(index, columns, "tracker~protracker debris");
+    expect(paths.size() == 1 && paths[0] == "/mods/captain/space_debris.mod", "bare words match titles");
+
+    paths = run(index, columns, "artist=jester title=\"\"");
+    expect(paths.empty(), "probed non-modules are never listed");
+
+    paths = run(index, columns, "format!=mod limit:10 sort:-size");
+    expect(paths.size() == 10, "limit caps the results");
+
+    paths = run(index, columns, "ch=4 format=mod duration<=4:00 artist~purple");
+    for (const auto& path : paths) {
+        auto found = index.find(path);
+        const auto entry = index.entry(*found);
+        expect(entry.channels == 4 && entry.format == "mod" && entry.duration_ms <= 240000 &&
+                   entry.artist == "Purple Motion",
+               "every row satisfies the predicates");
+    }
+    expect(!paths.empty(), "filler rows match the scan");
+
+    fs::remove_all(root);
+
+    return tracker::test::finish("library query");
+}
@@ -0,0 +1,112 @@
+#include "library_search.hpp"
+#include "test_support.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+using tracker::LibraryIndex;
+using tracker::LibraryRecord;
+using tracker::LibrarySearchIndex;
+using tracker::LibrarySearcher;
+using tracker::test::expect;
+
+namespace {
+
+LibraryRecord make_record(const std::string& path, const std::string& title, const std::string& artist) {
+    LibraryRecord record;
+    record.path = path;
+    record.title = title;
+    record.artist = artist;
+    return record;
+}
+
+bool contains_path(const std::vector<tracker::SearchResult>& results, const std::string& path) {
+    for (const auto& result : results) {
+        if (result.path == path) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}
+
+int main() {
+    namespace fs = std::filesystem;
+    const fs::path root = fs::temp_directory_path() / ("library_search_test_" + std::to_string(::getpid()));
+    fs::remove_all(root);
+    const fs::path index_path = root / "library.idx";
+
+    const char* words[] = {"space", "debris", "cyber", "night", "acid", "dream", "chip", "tune", "mega", "blast",
+                           "funk", "lazer", "ocean", "drift", "metal", "storm"};
+    const std::size_t filler_count = 2000;
+    std::vector<LibraryRecord> records;
+    records.reserve(filler_count + 4);
+    for (std::size_t i = 0; i < filler_count; ++i) {
+        std::string title = std::string(words[i % 16]) + " " + words[(i / 16) % 16] + " " + std::to_string(i);
+        records.push_back(make_record("/mods/filler/f" + std::to_string(i) + ".xm", title,
+                                      std::string("Artist ") + words[(i / 256) % 16]));
+    }
+    records.push_back(make_record("/mods/captain/space_debris.mod", "Space Debris", "Captain"));
+    records.push_back(make_record("/mods/jogeir/cream_of_the_earth.mod", "Cream of the Earth", "Jogeir Liljedahl"));
+    records.push_back(make_record("/mods/purple/unreal2.s3m", "Unreal ][ - The 2nd Reality", "Purple Motion"));
+    records.push_back(make_record("/mods/lizardking/ZM.it", "", "Lizardking"));
+
+    std::string error;
+    expect(LibraryIndex::write(index_path, records, error), "write failed: " + error);
+    auto library = std::make_shared<LibraryIndex>();
+    expect(library->open(index_path, error), "open failed: " + error);
+
+    LibrarySearchIndex index(library);
+    expect(index.size() == records.size(), "search index size mismatch");
+
+    auto results = index.search("space debris", 10);
+    expect(!results.empty() && results.front().path == "/mods/captain/space_debris.mod",
+           "exact file name match should rank first");
+
+    results = index.search("Cream Eart", 10);
+    expect(!results.empty() && results.front().title == "Cream of the Earth", "title words should match");
+
+    results = index.search("purple motoin", 10);
+    expect(contains_path(results, "/mods/purple/unreal2.s3m"), "typo in artist should still match");
+
+    results = index.search("zm", 10);
+    expect(!results.empty() && results.front().path == "/mods/lizardking/ZM.it",
+           "short query should use the subsequence scan");
+
+    expect(index.search("qqqxxzz", 10).empty(), "unrelated query should not match");
+    expect(index.search("tune", 5).size() == 5, "limit not applied");
+
+    LibrarySearcher searcher;
+    searcher.load(index_path);
+    searcher.submit("spa");
+    searcher.submit("space deb");
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(20);
+    bool got_results = false;
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (searcher.poll() && !searcher.results().empty() &&
+            searcher.results().front().path == "/mods/captain/space_debris.mod") {
+            got_results = true;
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    expect(got_results, "background searcher did not deliver latest query");
+    expect(searcher.ready() && searcher.indexed_count() == records.size(), "searcher not ready");
+
+    LibrarySearcher missing;
+    missing.load(root / "missing.idx");
+    while (missing.error_message().empty() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    expect(!missing.ready() && !missing.error_message().empty(), "missing index should report an error");
+
+    fs::remove_all(root);
+
+    return tracker::test::finish("library search");
+}
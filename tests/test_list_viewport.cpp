@@ -0,0 +1,21 @@
+#include "list_viewport.hpp"
+#include "test_support.hpp"
+
+using tracker::ListViewport;
+using tracker::test::expect;
+
+int main() {
+    ListViewport viewport;
+    viewport.update(1000, 0, 20);
+    expect(viewport.first() == 0 && viewport.end(1000, 4) == 24, "initial window");
+    viewport.update(1000, 25, 20);
+    expect(viewport.first() == 6, "window should follow selection down");
+    viewport.update(1000, 10, 20);
+    expect(viewport.first() == 6, "window should not move while selection is visible");
+    viewport.update(1000, 2, 20);
+    expect(viewport.first() == 2 && viewport.begin(4) == 0, "window should follow selection up");
+    viewport.update(10, 9, 20);
+    expect(viewport.first() == 0 && viewport.end(10, 4) == 10, "short list should start at the top");
+
+    return tracker::test::finish("list viewport");
+}
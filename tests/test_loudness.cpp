@@ -0,0 +1,122 @@
+#include "loudness.hpp"
+#include "spill_buffer.hpp"
+#include "test_support.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using tracker::LoudnessMeter;
+using tracker::PeakLimiter;
+using tracker::SpillBuffer;
+using tracker::test::expect;
+
+namespace {
+
+constexpr int kRate = 48000;
+constexpr double kPi = 3.14159265358979323846;
+
+std::vector<float> stereo_sine(double frequency, double amplitude, double seconds, double phase = 0.0) {
+    const std::size_t frames = static_cast<std::size_t>(seconds * kRate);
+    std::vector<float> samples(frames * 2);
+    for (std::size_t i = 0; i < frames; ++i) {
+        const float value = static_cast<float>(amplitude * std::sin(2.0 * kPi * frequency * i / kRate + phase));
+        samples[i * 2] = value;
+        samples[i * 2 + 1] = value;
+    }
+    return samples;
+}
+
+double measure(const std::vector<float>& samples, LoudnessMeter& meter) {
+    for (std::size_t offset = 0; offset < samples.size(); offset += 4096 * 2) {
+        const std::size_t count = std::min<std::size_t>(4096 * 2, samples.size() - offset);
+        meter.process(samples.data() + offset, count / 2);
+    }
+    return meter.integrated_lufs();
+}
+
+}
+
+int main() {
+    // EBU Tech 3341 reference: a 1 kHz stereo sine at -23 dBFS reads -23 LUFS.
+    {
+        LoudnessMeter meter(kRate);
+        double lufs = measure(stereo_sine(1000.0, std::pow(10.0, -23.0 / 20.0), 20.0), meter);
+        expect(std::fabs(lufs + 23.0) < 0.1, "1 kHz sine at -23 dBFS measured " + std::to_string(lufs));
+    }
+
+    // Gating ignores silence, so padding the tone must not lower the reading.
+    {
+        std::vector<float> signal = stereo_sine(1000.0, std::pow(10.0, -23.0 / 20.0), 10.0);
+        signal.resize(signal.size() * 2, 0.0f);
+        LoudnessMeter meter(kRate);
+        double lufs = measure(signal, meter);
+        expect(std::fabs(lufs + 23.0) < 0.1, "gated tone with silence measured " + std::to_string(lufs));
+    }
+
+    {
+        LoudnessMeter meter(kRate);
+        double lufs = measure(std::vector<float>(kRate * 2 * 2, 0.0f), meter);
+        expect(std::isinf(lufs) && lufs < 0.0, "silence should measure -inf LUFS");
+    }
+
+    // A quarter-rate sine sampled 45 degrees off its crest has sample peaks
+    // 3 dB under the true peak; the oversampled detector must recover it.
+    {
+        LoudnessMeter meter(kRate);
+        measure(stereo_sine(kRate / 4.0, 0.5, 1.0, kPi / 4.0), meter);
+        double expected = tracker::gain_to_decibels(0.5);
+        expect(std::fabs(meter.true_peak_db() - expected) < 0.5,
+               "true peak measured " + std::to_string(meter.true_peak_db()) + " dB");
+    }
+
+    // The limiter holds the ceiling and leaves quiet passages untouched.
+    {
+        std::vector<float> signal = stereo_sine(440.0, 0.1, 1.0);
+        std::vector<float> loud = stereo_sine(440.0, 1.0, 1.0);
+        signal.insert(signal.end(), loud.begin(), loud.end());
+        const std::size_t total_frames = signal.size() / 2;
+
+        const float ceiling = 0.5f;
+        PeakLimiter limiter(kRate, ceiling);
+        std::vector<float> output(signal.size());
+        for (std::size_t frame = 0; frame < total_frames; frame += 4096) {
+            const std::size_t count = std::min<std::size_t>(4096, total_frames - frame);
+            limiter.process(signal.data(), total_frames, frame, count, 2.0f, output.data() + frame * 2);
+        }
+
+        // Only the first half second counts as quiet, well clear of the lookahead.
+        const std::size_t quiet_samples = static_cast<std::size_t>(kRate);
+        float quiet_peak = 0.0f;
+        float loud_peak = 0.0f;
+        for (std::size_t i = 0; i < output.size(); ++i) {
+            float& peak = i < quiet_samples ? quiet_peak : loud_peak;
+            peak = std::max(peak, std::fabs(output[i]));
+        }
+        expect(loud_peak <= ceiling + 1e-6f, "limiter exceeded ceiling: " + std::to_string(loud_peak));
+        expect(std::fabs(quiet_peak - 0.2f) < 1e-3f, "limiter touched quiet passage: " + std::to_string(quiet_peak));
+    }
+
+    // Spill buffers grow past their initial capacity and read back intact.
+    {
+        SpillBuffer spill;
+        std::string error_message;
+        expect(spill.open(16, error_message), "spill open failed: " + error_message);
+        std::vector<float> chunk(1000);
+        for (int pass = 0; pass < 10; ++pass) {
+            std::fill(chunk.begin(), chunk.end(), static_cast<float>(pass));
+            expect(spill.append(chunk.data(), chunk.size(), error_message), "spill append failed: " + error_message);
+        }
+        spill.prepare_for_read();
+        expect(spill.size() == 10000, "spill size mismatch");
+        bool intact = true;
+        for (std::size_t i = 0; i < spill.size(); ++i) {
+            intact = intact && spill.data()[i] == static_cast<float>(i / 1000);
+        }
+        expect(intact, "spill contents corrupted");
+    }
+
+    return tracker::test::finish("loudness");
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tracker::test {
+
+inline void put_be16(std::vector<std::uint8_t>& out, int value) {
+    out.push_back(static_cast<std::uint8_t>((value >> 8) & 0xFF));
+    out.push_back(static_cast<std::uint8_t>(value & 0xFF));
+}
+
+// Four-channel M.K. module: one looped square sample, a note on every row
+// of a single pattern, repeated for order_count orders (7.68 s each).
+inline std::vector<std::uint8_t> make_square_module(int order_count) {
+    std::vector<std::uint8_t> out;
+    std::string title = "preview test";
+    title.resize(20, '\0');
+    out.insert(out.end(), title.begin(), title.end());
+    for (int i = 0; i < 31; ++i) {
+        out.insert(out.end(), 22, 0);
+        put_be16(out, i == 0 ? 32 : 0);
+        out.push_back(0);
+        out.push_back(i == 0 ? 64 : 0);
+        put_be16(out, 0);
+        put_be16(out, i == 0 ? 32 : 1);
+    }
+    out.push_back(static_cast<std::uint8_t>(order_count));
+    out.push_back(0x7F);
+    out.insert(out.end(), 128, 0);
+    out.insert(out.end(), {'M', '.', 'K', '.'});
+    for (int row = 0; row < 64; ++row) {
+        const int period = row % 2 == 0 ? 428 : 320;
+        out.push_back(static_cast<std::uint8_t>((period >> 8) & 0x0F));
+        out.push_back(static_cast<std::uint8_t>(period & 0xFF));
+        out.push_back(0x10);
+        out.push_back(0);
+        out.insert(out.end(), 12, 0);
+    }
+    for (int i = 0; i < 64; ++i) {
+        out.push_back(static_cast<std::uint8_t>(i < 32 ? 100 : -100));
+    }
+    return out;
+}
+
+}
@@ -0,0 +1,59 @@
+#include "pattern_cache.hpp"
+#include "test_support.hpp"
+
+#include <string>
+
+using tracker::PatternCache;
+using tracker::test::expect;
+
+namespace {
+
+std::string cell_text(int pattern, int row, int channel) {
+    return "P" + std::to_string(pattern) + "R" + std::to_string(row) + "C" + std::to_string(channel);
+}
+
+}
+
+int main() {
+    {
+        PatternCache cache(3);
+        cache.begin_pattern(4);
+        for (int row = 0; row < 4; ++row) {
+            for (int channel = 0; channel < 3; ++channel) {
+                cache.add_cell(cell_text(0, row, channel));
+            }
+        }
+        cache.begin_pattern(0);
+        cache.begin_pattern(2);
+        for (int row = 0; row < 2; ++row) {
+            for (int channel = 0; channel < 3; ++channel) {
+                cache.add_cell(row == 1 && channel == 2 ? "" : cell_text(2, row, channel));
+            }
+        }
+        cache.set_orders({2, 0, 0, 254, 9});
+
+        expect(cache.num_patterns() == 3 && cache.channels() == 3, "unexpected shape");
+        expect(cache.num_rows(0) == 4 && cache.num_rows(1) == 0 && cache.num_rows(2) == 2 && cache.num_rows(3) == 0,
+               "unexpected row counts");
+        expect(cache.cell(0, 3, 2) == "P0R3C2" && cache.cell(2, 0, 0) == "P2R0C0", "cell text mixed up");
+        expect(cache.cell(2, 1, 2).empty() && cache.cell(2, 1, 1) == "P2R1C1", "empty cell shifted its neighbours");
+        expect(cache.cell(0, 4, 0).empty() && cache.cell(0, 0, 3).empty() && cache.cell(1, 0, 0).empty() &&
+                   cache.cell(-1, 0, 0).empty(),
+               "out of range cell returned text");
+        expect(cache.num_orders() == 5 && cache.order_pattern(0) == 2 && cache.order_pattern(1) == 0, "orders lost");
+        expect(cache.order_pattern(3) == -1 && cache.order_pattern(4) == -1 && cache.order_pattern(5) == -1,
+               "separator or missing pattern not reported as -1");
+    }
+
+    // A pattern cut short, e.g. by a cancelled build, has no cells rather
+    // than another pattern's.
+    {
+        PatternCache cache(2);
+        cache.begin_pattern(8);
+        cache.add_cell("only");
+        expect(cache.cell(0, 0, 0) == "only" && cache.cell(0, 0, 1).empty() && cache.cell(0, 7, 1).empty(),
+               "partial pattern read past its cells");
+    }
+
+    return tracker::test::finish("pattern cache");
+}
@@ -0,0 +1,204 @@
+#include "playlist.hpp"
+#include "test_support.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using tracker::Playlist;
+using tracker::RepeatMode;
+using tracker::test::expect;
+
+namespace {
+
+void write_text(const std::filesystem::path& path, const std::string& text) {
+    std::ofstream file(path, std::ios::binary);
+    file << text;
+}
+
+Playlist numbered(std::size_t count, std::uint64_t seed = 1) {
+    Playlist playlist(seed);
+    for (std::size_t i = 0; i < count; ++i) {
+        playlist.add("/music/track" + std::to_string(i) + ".mod");
+    }
+    return playlist;
+}
+
+void test_sequential_order() {
+    Playlist playlist = numbered(3);
+    expect(playlist.peek_next() == 0u, "an unstarted playlist begins at the first entry");
+    expect(playlist.advance() == 0u, "advance starts at entry 0");
+    expect(playlist.peek_next() == 1u, "peek_next sees entry 1");
+    expect(playlist.advance() == 1u, "advance moves to entry 1");
+    expect(playlist.advance() == 2u, "advance moves to entry 2");
+    expect(!playlist.peek_next(), "repeat off stops after the last entry");
+    expect(!playlist.advance(), "advance past the end returns nothing");
+    expect(playlist.current() == 2u, "the last entry stays current");
+
+    playlist.set_repeat(RepeatMode::All);
+    expect(playlist.peek_next() == 0u, "repeat all wraps to the first entry");
+    expect(playlist.advance() == 0u, "advance wraps");
+    expect(playlist.previous() == 2u, "previous wraps back under repeat all");
+
+    playlist.set_repeat(RepeatMode::One);
+    expect(playlist.peek_next() == 2u, "repeat one replays the current entry");
+    expect(playlist.advance() == 2u, "advance keeps the entry under repeat one");
+    expect(playlist.next() == 0u, "an explicit skip ignores repeat one");
+}
+
+void test_shuffle_plays_each_entry_once() {
+    constexpr std::size_t kCount = 20;
+    Playlist playlist = numbered(kCount, 42);
+    playlist.set_shuffle(true);
+    playlist.set_repeat(RepeatMode::All);
+
+    std::vector<std::size_t> played;
+    for (std::size_t i = 0; i < kCount * 5; ++i) {
+        auto expected = playlist.peek_next();
+        auto next = playlist.advance();
+        expect(next.has_value() && next == expected, "peek_next predicts advance under shuffle");
+        played.push_back(*next);
+    }
+
+    for (std::size_t pass = 0; pass < 5; ++pass) {
+        std::set<std::size_t> seen(played.begin() + static_cast<std::ptrdiff_t>(pass * kCount),
+                                   played.begin() + static_cast<std::ptrdiff_t>((pass + 1) * kCount));
+        expect(seen.size() == kCount, "each shuffle pass plays every entry once");
+    }
+    for (std::size_t i = 1; i < played.size(); ++i) {
+        expect(played[i] != played[i - 1], "shuffle never plays the same entry twice in a row");
+    }
+    std::vector<std::size_t> identity(kCount);
+    for (std::size_t i = 0; i < kCount; ++i) {
+        identity[i] = i;
+    }
+    expect(!std::equal(identity.begin(), identity.end(), played.begin()), "shuffle changes the order");
+}
+
+void test_shuffle_keeps_current_and_edits() {
+    Playlist playlist = numbered(6, 7);
+    playlist.select(3);
+    playlist.set_shuffle(true);
+    expect(playlist.current() == 3u, "enabling shuffle keeps the current entry");
+    expect(playlist.position() == 1u, "the current entry opens the shuffled pass");
+
+    playlist.add("/music/late.mod");
+    std::set<std::size_t> rest;
+    while (auto next = playlist.advance()) {
+        rest.insert(*next);
+    }
+    expect(rest.size() == 6 && !rest.count(3), "an entry added mid-pass is still played");
+
+    Playlist sequential = numbered(4);
+    sequential.select(1);
+    expect(sequential.remove(1), "removing the current entry succeeds");
+    expect(!sequential.current(), "the removed entry is no longer current");
+    expect(sequential.peek_next() == 1u, "playback continues with the entry that followed");
+    expect(sequential.entries()[1].path == "/music/track2.mod", "entries shift down after removal");
+    expect(sequential.remove(0) && sequential.advance() == 0u, "removal before the cursor keeps the next entry");
+}
+
+void test_m3u_and_pls_round_trip(const std::filesystem::path& root) {
+    std::filesystem::create_directories(root / "mods");
+    write_text(root / "list.m3u",
+               "\xEF\xBB\xBF#EXTM3U\r\n"
+               "#EXTINF:123,Space Debris\r\n"
+               "mods/space_debris.mod\r\n"
+               "\r\n"
+               "http://example.com/stream.mod\r\n"
+               "file:///tmp/with%20space.xm\r\n");
+
+    Playlist playlist(1);
+    std::string error;
+    expect(playlist.load(root / "list.m3u", error), "m3u loads: " + error);
+    expect(playlist.size() == 2, "remote urls are skipped");
+    if (playlist.size() == 2) {
+        expect(playlist.entries()[0].path == root / "mods/space_debris.mod", "relative m3u paths resolve against the playlist");
+        expect(playlist.entries()[0].title == "Space Debris", "EXTINF titles are kept");
+        expect(playlist.entries()[1].path == "/tmp/with space.xm", "file urls are decoded");
+    }
+
+    expect(playlist.save(root / "copy.pls", error), "pls saves: " + error);
+    Playlist reloaded(1);
+    expect(reloaded.load(root / "copy.pls", error), "pls loads: " + error);
+    expect(reloaded.size() == 2, "pls round trip keeps every entry");
+    if (reloaded.size() == 2) {
+        expect(reloaded.entries()[0].path == root / "mods/space_debris.mod", "pls round trip keeps paths");
+        expect(reloaded.entries()[0].title == "Space Debris", "pls round trip keeps titles");
+    }
+
+    std::ifstream saved(root / "copy.pls");
+    std::string contents((std::istreambuf_iterator<char>(saved)), std::istreambuf_iterator<char>());
+    expect(contents.find("File1=mods/space_debris.mod") != std::string::npos, "entries under the playlist are saved relative");
+
+    expect(playlist.save(root / "copy.m3u8", error), "m3u saves: " + error);
+    Playlist m3u(1);
+    expect(m3u.load(root / "copy.m3u8", error) && m3u.size() == 2, "m3u round trip keeps every entry");
+
+    write_text(root / "odd.pls",
+               "[playlist]\n"
+               "File99999999999=mods/overflow.mod\n"
+               "File-1=mods/negative.mod\n"
+               "File2x=mods/junk.mod\n"
+               "File2=mods/space_debris.mod\n"
+               "NumberOfEntries=4\n");
+    Playlist odd(1);
+    expect(odd.load(root / "odd.pls", error), "pls with bad keys loads: " + error);
+    expect(odd.size() == 1 && odd.entries()[0].path == root / "mods/space_debris.mod",
+           "pls keys with overlong or malformed numbers are skipped");
+
+    expect(!playlist.load(root / "missing.m3u", error), "a missing playlist fails to load");
+    expect(Playlist::is_playlist_file("a.PLS") && Playlist::is_playlist_file("b.m3u8"), "playlist extensions are recognised");
+    expect(!Playlist::is_playlist_file("c.mod"), "modules are not playlists");
+}
+
+void test_add_directory(const std::filesystem::path& root) {
+    std::filesystem::path dir = root / "album";
+    std::filesystem::create_directories(dir / "disc2");
+    write_text(dir / "track10.mod", "x");
+    write_text(dir / "track2.xm", "x");
+    write_text(dir / "notes.txt", "x");
+    write_text(dir / "disc2" / "track1.it", "x");
+
+    Playlist playlist(1);
+    expect(playlist.add_directory(dir) == 3, "add_directory finds the modules recursively");
+    if (playlist.size() == 3) {
+        expect(playlist.entries()[0].path == dir / "disc2" / "track1.it", "subdirectories sort by name");
+        expect(playlist.entries()[1].path == dir / "track2.xm", "numbers sort naturally");
+        expect(playlist.entries()[2].path == dir / "track10.mod", "track10 follows track2");
+    }
+
+    Playlist flat(1);
+    expect(flat.add_directory(dir, false) == 2, "non-recursive add_directory stays in the directory");
+    expect(flat.find(dir / "track2.xm") == 0u, "find locates an entry by path");
+}
+
+}
+
+int main() {
+    std::filesystem::path root = std::filesystem::temp_directory_path() /
+                                 ("playlist-test-" + std::to_string(::getpid()));
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root);
+
+    test_sequential_order();
+    test_shuffle_plays_each_entry_once();
+    test_shuffle_keeps_current_and_edits();
+    test_m3u_and_pls_round_trip(root);
+    test_add_directory(root);
+
+    RepeatMode mode = RepeatMode::Off;
+    expect(Playlist::parse_repeat_mode("ALL", mode) && mode == RepeatMode::All, "repeat modes parse case-insensitively");
+    expect(!Playlist::parse_repeat_mode("sometimes", mode), "unknown repeat modes are rejected");
+
+    std::filesystem::remove_all(root);
+
+    return tracker::test::finish("playlist");
+}
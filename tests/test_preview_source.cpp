@@ -0,0 +1,126 @@
+#include "preview_source.hpp"
+#include "test_modules.hpp"
+#include "test_support.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using tracker::PreviewSource;
+using tracker::test::expect;
+
+namespace {
+
+// Drives render() the way the output thread does, until frames arrive.
+bool render_until_playing(PreviewSource& source, std::vector<float>& buffer, std::size_t& first_block) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (source.render(buffer.data(), buffer.size() / 2) > 0) {
+            return true;
+        }
+        ++first_block;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+}
+
+int main() {
+    namespace fs = std::filesystem;
+    const fs::path root = fs::temp_directory_path() / ("preview_source_test_" + std::to_string(::getpid()));
+    fs::remove_all(root);
+    fs::create_directories(root);
+
+    const auto module = tracker::test::make_square_module(40);
+    for (int i = 0; i < 20; ++i) {
+        std::ofstream file(root / ("song" + std::to_string(i) + ".mod"), std::ios::binary);
+        file.write(reinterpret_cast<const char*>(module.data()), static_cast<std::streamsize>(module.size()));
+    }
+    std::ofstream(root / "broken.mod", std::ios::binary) << "not a module";
+
+    // The debounce never runs out on its own here; settle() stands in for
+    // the selection coming to rest, so nothing depends on timing.
+    PreviewSource source(48000, std::chrono::hours(1));
+    std::vector<float> buffer(480 * 2);
+
+    {
+        std::size_t silent_blocks = 0;
+        source.request(root / "song0.mod");
+        source.settle();
+        expect(render_until_playing(source, buffer, silent_blocks), "preview never started");
+        expect(source.playing_path() == root / "song0.mod", "wrong file playing");
+        expect(std::fabs(buffer[0]) < 0.01f, "preview did not fade in");
+    }
+
+    // Scrolling past files only loads where the selection comes to rest.
+    {
+        const std::size_t loads_before = source.loads_completed();
+        for (int i = 1; i < 20; ++i) {
+            source.request(root / ("song" + std::to_string(i) + ".mod"));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        expect(source.playing_path() == root / "song0.mod" && source.loading(),
+               "a request loaded before the selection settled");
+        source.settle();
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (source.playing_path() != root / "song19.mod" && std::chrono::steady_clock::now() < deadline) {
+            source.render(buffer.data(), buffer.size() / 2);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        expect(source.playing_path() == root / "song19.mod", "final selection not playing");
+        expect(source.loads_completed() - loads_before == 1,
+               "scrolling loaded " + std::to_string(source.loads_completed() - loads_before) + " files");
+    }
+
+    // Once started, every block is filled from the module.
+    {
+        double energy = 0.0;
+        for (int block = 0; block < 10; ++block) {
+            expect(source.render(buffer.data(), buffer.size() / 2) == buffer.size() / 2, "short render");
+            for (float sample : buffer) {
+                energy += static_cast<double>(sample) * sample;
+            }
+        }
+        expect(energy > 1.0, "preview is silent");
+    }
+
+    // Unreadable modules report an error and stop the previous preview.
+    {
+        source.request(root / "broken.mod");
+        source.settle();
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (source.error_message().empty() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        expect(!source.error_message().empty(), "broken module not reported");
+        expect(source.playing_path().empty(), "previous preview kept playing");
+        expect(source.render(buffer.data(), buffer.size() / 2) == 0 && buffer[0] == 0.0f, "expected silence");
+    }
+
+    {
+        source.request(root / "song3.mod");
+        source.settle();
+        std::size_t silent_blocks = 0;
+        expect(render_until_playing(source, buffer, silent_blocks), "preview after error never started");
+        source.stop();
+        source.settle();
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!source.playing_path().empty() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        expect(source.playing_path().empty() && source.render(buffer.data(), buffer.size() / 2) == 0,
+               "stop did not silence the preview");
+    }
+
+    fs::remove_all(root);
+
+    return tracker::test::finish("preview source");
+}
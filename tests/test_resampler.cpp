@@ -0,0 +1,95 @@
+#include "resampler.hpp"
+#include "test_support.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using tracker::Resampler;
+using tracker::ResamplerQuality;
+using tracker::test::expect;
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+std::vector<float> stereo_sine(double frequency, int rate, std::size_t frames) {
+    std::vector<float> samples(frames * 2);
+    for (std::size_t i = 0; i < frames; ++i) {
+        const float value = static_cast<float>(0.5 * std::sin(2.0 * kPi * frequency * i / rate));
+        samples[i * 2] = value;
+        samples[i * 2 + 1] = -value;
+    }
+    return samples;
+}
+
+std::vector<float> resample(Resampler& resampler, const std::vector<float>& input, std::size_t chunk_frames) {
+    std::vector<float> output;
+    const std::size_t frames = input.size() / 2;
+    for (std::size_t frame = 0; frame < frames; frame += chunk_frames) {
+        resampler.process(input.data() + frame * 2, std::min(chunk_frames, frames - frame), output);
+    }
+    resampler.flush(output);
+    return output;
+}
+
+// Worst deviation from the ideal sine, skipping the filter's edge transients.
+double error_db(const std::vector<float>& output, double frequency, int rate) {
+    const std::size_t frames = output.size() / 2;
+    const std::size_t margin = static_cast<std::size_t>(rate / 100);
+    double worst = 0.0;
+    for (std::size_t i = margin; i + margin < frames; ++i) {
+        const double ideal = 0.5 * std::sin(2.0 * kPi * frequency * i / rate);
+        worst = std::max(worst, std::fabs(output[i * 2] - ideal));
+        worst = std::max(worst, std::fabs(output[i * 2 + 1] + ideal));
+    }
+    return 20.0 * std::log10(std::max(worst, 1e-12) / 0.5);
+}
+
+double rms_db(const std::vector<float>& output, int rate) {
+    const std::size_t margin = static_cast<std::size_t>(rate / 100) * 2;
+    double sum = 0.0;
+    for (std::size_t i = margin; i + margin < output.size(); ++i) {
+        sum += static_cast<double>(output[i]) * output[i];
+    }
+    const double count = static_cast<double>(output.size() - 2 * margin);
+    return 10.0 * std::log10(std::max(sum / count, 1e-24) / 0.125);
+}
+
+}
+
+int main() {
+    struct Conversion {
+        int input_rate;
+        int output_rate;
+    };
+    const Conversion conversions[] = {{96000, 48000}, {96000, 44100}, {48000, 44100}, {44100, 48000}};
+
+    for (const auto& conversion : conversions) {
+        const std::string label = std::to_string(conversion.input_rate) + "->" + std::to_string(conversion.output_rate);
+        const auto input = stereo_sine(1000.0, conversion.input_rate, static_cast<std::size_t>(conversion.input_rate));
+
+        Resampler resampler(conversion.input_rate, conversion.output_rate, 2, ResamplerQuality::Balanced);
+        const auto output = resample(resampler, input, 4096);
+        expect(output.size() / 2 == static_cast<std::size_t>(conversion.output_rate),
+               label + " produced " + std::to_string(output.size() / 2) + " frames");
+
+        const double error = error_db(output, 1000.0, conversion.output_rate);
+        expect(error < -70.0, label + " passband error " + std::to_string(error) + " dB");
+
+        Resampler odd_chunks(conversion.input_rate, conversion.output_rate, 2, ResamplerQuality::Balanced);
+        expect(resample(odd_chunks, input, 333) == output, label + " output depends on chunk size");
+    }
+
+    // A tone above the output Nyquist must be rejected rather than aliased.
+    {
+        const auto input = stereo_sine(30000.0, 96000, 96000);
+        Resampler resampler(96000, 44100, 2, ResamplerQuality::Best);
+        const double level = rms_db(resample(resampler, input, 4096), 44100);
+        expect(level < -90.0, "30 kHz tone leaked at " + std::to_string(level) + " dB");
+    }
+
+    return tracker::test::finish("resampler");
+}
@@ -0,0 +1,106 @@
+#include "song_envelope.hpp"
+#include "test_support.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using tracker::SongEnvelope;
+using tracker::test::expect;
+
+namespace {
+
+// A full-scale square wave for the first half, then silence.
+std::vector<float> loud_then_silent(std::size_t frames) {
+    std::vector<float> samples(frames, 0.0f);
+    for (std::size_t i = 0; i < frames / 2; ++i) {
+        samples[i] = (i / 10) % 2 == 0 ? 1.0f : -1.0f;
+    }
+    return samples;
+}
+
+}
+
+int main() {
+    {
+        SongEnvelope envelope;
+        expect(envelope.finish().empty(), "empty envelope has levels");
+    }
+
+    // Levels follow the signal regardless of how the render is chunked.
+    {
+        const std::vector<float> samples = loud_then_silent(SongEnvelope::kSampleRate * 60);
+        SongEnvelope whole;
+        whole.add(samples.data(), samples.size());
+        SongEnvelope chunked;
+        for (std::size_t offset = 0; offset < samples.size(); offset += 4093) {
+            chunked.add(samples.data() + offset, std::min<std::size_t>(4093, samples.size() - offset));
+        }
+        const auto levels = whole.finish();
+        expect(levels.size() == SongEnvelope::kBuckets, "unexpected bucket count " + std::to_string(levels.size()));
+        expect(levels == chunked.finish(), "chunking changed the envelope");
+        expect(levels.front() == 255 && levels[SongEnvelope::kBuckets / 2 - 1] == 255, "full scale not at 255");
+        expect(levels[SongEnvelope::kBuckets / 2 + 1] == 0 && levels.back() == 0, "silence not at 0");
+    }
+
+    // -24 dBFS RMS lands halfway up the -48..0 dB scale.
+    {
+        const float amplitude = static_cast<float>(std::pow(10.0, -24.0 / 20.0));
+        std::vector<float> samples(SongEnvelope::kSampleRate * 10);
+        for (std::size_t i = 0; i < samples.size(); ++i) {
+            samples[i] = i % 2 == 0 ? amplitude : -amplitude;
+        }
+        SongEnvelope envelope;
+        envelope.add(samples.data(), samples.size());
+        const auto levels = envelope.finish();
+        expect(std::all_of(levels.begin(), levels.end(), [](std::uint8_t level) { return level >= 126 && level <= 129; }),
+               "unexpected level for -24 dBFS: " + std::to_string(levels.front()));
+    }
+
+    // Songs shorter than one block per bucket still fill every bucket.
+    {
+        std::vector<float> samples(SongEnvelope::kSampleRate, 0.5f);
+        SongEnvelope envelope;
+        envelope.add(samples.data(), samples.size());
+        const auto levels = envelope.finish();
+        expect(levels.size() == SongEnvelope::kBuckets && levels.back() > 0, "short song left empty buckets");
+    }
+
+    // Resampling keeps the loudest bucket of each column.
+    {
+        std::vector<std::uint8_t> levels(SongEnvelope::kBuckets, 10);
+        levels[37] = 200;
+        const auto narrow = SongEnvelope::resample(levels, 16);
+        expect(narrow.size() == 16 && narrow[37 * 16 / SongEnvelope::kBuckets] == 200, "peak lost when narrowing");
+        expect(std::count(narrow.begin(), narrow.end(), 200) == 1, "peak spread to other columns");
+        const auto wide = SongEnvelope::resample(levels, 300);
+        expect(wide.size() == 300 && std::count(wide.begin(), wide.end(), 200) >= 2, "peak lost when widening");
+        expect(SongEnvelope::resample({}, 10).empty() && SongEnvelope::resample(levels, 0).empty(),
+               "resampling nothing produced columns");
+    }
+
+    expect(std::string(SongEnvelope::glyph(0)) == " " && std::string(SongEnvelope::glyph(1)) == "▁" &&
+               std::string(SongEnvelope::glyph(255)) == "█",
+           "unexpected glyphs");
+
+    // A five-minute song at the envelope rate is a few milliseconds of work
+    // on top of the render itself.
+    {
+        const std::vector<float> samples = loud_then_silent(SongEnvelope::kSampleRate * 300);
+        const auto start = std::chrono::steady_clock::now();
+        SongEnvelope envelope;
+        envelope.add(samples.data(), samples.size());
+        const auto levels = envelope.finish();
+        const double elapsed_ms =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        expect(levels.size() == SongEnvelope::kBuckets, "long song envelope incomplete");
+        std::cout << "Envelope of 300 s at " << SongEnvelope::kSampleRate << " Hz: " << elapsed_ms << " ms"
+                  << std::endl;
+    }
+
+    return tracker::test::finish("song envelope");
+}
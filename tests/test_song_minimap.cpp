@@ -0,0 +1,74 @@
+#include "song_minimap.hpp"
+#include "test_support.hpp"
+
+#include <iostream>
+#include <string>
+
+using tracker::PatternCache;
+using tracker::SongMinimap;
+using tracker::test::expect;
+
+namespace {
+
+// A pattern whose row r has notes in the first notes_at(r) channels.
+template <typename NotesAt>
+void add_pattern(PatternCache& cache, int rows, NotesAt notes_at) {
+    cache.begin_pattern(rows);
+    for (int row = 0; row < rows; ++row) {
+        for (int channel = 0; channel < cache.channels(); ++channel) {
+            cache.add_cell(channel < notes_at(row) ? "C-5 01 ... ..." : "... .. ... A0F");
+        }
+    }
+}
+
+}
+
+int main() {
+    {
+        PatternCache cache(4);
+        // Full in the first quarter only.
+        add_pattern(cache, 64, [](int row) { return row < 16 ? 4 : 0; });
+        // One note per row throughout.
+        add_pattern(cache, 64, [](int) { return 1; });
+        // Empty, and shorter than there are blocks.
+        add_pattern(cache, 2, [](int) { return 0; });
+        cache.set_orders({0, 1, 254, 0, 2, 7});
+
+        SongMinimap minimap(cache);
+        expect(minimap.num_orders() == 6, "unexpected order count");
+        expect(minimap.level(0, 0) == 255 && minimap.level(0, 1) == 0 && minimap.level(0, 3) == 0,
+               "busy block not at full scale");
+        expect(minimap.level(1, 0) > 0 && minimap.level(1, 0) < 80 && minimap.level(1, 0) == minimap.level(1, 3),
+               "steady pattern not level: " + std::to_string(minimap.level(1, 0)));
+        expect(minimap.level(3, 0) == minimap.level(0, 0), "repeated pattern differs");
+        expect(minimap.is_separator(2) && minimap.is_separator(5) && !minimap.is_separator(4) &&
+                   !minimap.is_separator(0) && !minimap.is_separator(6),
+               "separators not marked");
+        expect(minimap.level(2, 0) == 0 && minimap.level(4, 0) == 0 && minimap.level(4, 3) == 0,
+               "empty order shows activity");
+        expect(minimap.level(-1, 0) == 0 && minimap.level(6, 0) == 0 && minimap.level(0, 4) == 0,
+               "out of range order shows activity");
+    }
+
+    // A single note stays visible next to a much busier block.
+    {
+        PatternCache cache(32);
+        add_pattern(cache, 64, [](int) { return 32; });
+        add_pattern(cache, 64, [](int row) { return row == 0 ? 1 : 0; });
+        cache.set_orders({0, 1});
+        SongMinimap minimap(cache);
+        expect(minimap.level(1, 0) >= 1 && minimap.level(1, 1) == 0, "lone note lost");
+    }
+
+    {
+        SongMinimap empty;
+        expect(empty.num_orders() == 0 && empty.level(0, 0) == 0, "empty minimap has orders");
+        expect(SongMinimap(PatternCache(0)).num_orders() == 0, "minimap of nothing has orders");
+    }
+
+    expect(std::string(SongMinimap::glyph(0)) == " " && std::string(SongMinimap::glyph(1)) == "░" &&
+               std::string(SongMinimap::glyph(255)) == "█",
+           "unexpected glyphs");
+
+    return tracker::test::finish("song minimap");
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+
+namespace tracker::test {
+
+// Checks keep going after a failure so one run reports every broken case.
+inline int failures = 0;
+
+inline void expect(bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "FAIL: " << message << std::endl;
+        ++failures;
+    }
+}
+
+// Exit code for main: prints the summary for the named suite.
+inline int finish(const std::string& suite) {
+    if (failures > 0) {
+        std::cerr << failures << " " << suite << " test(s) failed." << std::endl;
+        return 1;
+    }
+    std::cout << "All " << suite << " tests passed." << std::endl;
+    return 0;
+}
+
+}